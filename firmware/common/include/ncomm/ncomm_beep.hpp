@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ncomm/ncomm_spsc.hpp"
+
+namespace ncomm {
+
+// ===== Beep feedback (MCU2 headset output, architecture 4.2) =====
+// Locally synthesised confirmation tones mixed into the headset (RX) output.
+//
+// Synth: 32-bit phase accumulator (NCO) into a 256-entry Q15 sine table with
+// linear interpolation (error < -80 dBc), linear attack / release in Q15 per
+// sample. A tone is a preset of up to BEEP_MAX_NOTES notes with gaps.
+//
+// Mixer: render() runs where output blocks are produced (playout DMA
+// callback): the stream block is scaled by the duck gain while a tone plays
+// (following its envelope), the tone is added and the sum saturated to Q15.
+// Tones are requested from the main loop through a lock-free queue and
+// start at an absolute output sample position, so the onset is sample exact
+// whatever the block size; render() never waits or allocates.
+//
+// Contexts: start() from one producer (main loop), render() from one
+// consumer (output ISR). presets() is configuration: change while idle.
+
+static constexpr uint32_t BEEP_RATE = 16000;
+static constexpr uint8_t BEEP_MAX_NOTES = 3;
+static constexpr uint32_t BEEP_ASAP = 0xFFFFFFFFu; // after the tone playing, else at once
+static constexpr uint32_t BEEP_CHAIN_GAP_MS = 40;  // between a tone and the BEEP_ASAP one after it
+
+enum class BeepTone : uint8_t {
+  CMD_DETECTED = 0,
+  SR_CONFIRMED,
+  SR_REJECTED,     // lower, different tone
+  SESSION_ACTIVE,
+  SESSION_CLOSED,
+  SESSION_TIMEOUT, // timeout tone
+  COUNT,
+};
+static constexpr uint8_t BEEP_TONES = (uint8_t)BeepTone::COUNT;
+
+struct BeepNote {
+  uint16_t hz = 0;     // 0 = rest
+  uint16_t ms = 0;
+  uint16_t gap_ms = 0; // silence after the note
+};
+
+struct BeepPreset {
+  BeepNote note[BEEP_MAX_NOTES];
+  uint8_t notes = 0;
+  int16_t level = 8192;   // Q15 peak (-12 dBFS)
+  uint8_t attack_ms = 5;
+  uint8_t release_ms = 10;
+  int16_t duck = 8192;    // Q15 stream gain under the tone (-12 dB), 32767 = no ducking
+};
+
+// Factory presets, one per BeepTone.
+const BeepPreset& beep_default_preset(BeepTone tone);
+
+class BeepMixer {
+public:
+  void init();
+
+  // Queue tone to start at output sample `at` (absolute, as passed to
+  // render()); a position already rendered starts at once (counted late)
+  // and an explicit position replaces the tone playing. BEEP_ASAP follows
+  // the tone playing (e.g. CMD_DETECTED, then the SR result). False if the
+  // queue is full.
+  bool start(BeepTone tone, uint32_t at = BEEP_ASAP);
+
+  // Output block of n samples whose first sample is at position pos: mixes
+  // the active tone into buf (stream audio, or zeros) in place.
+  void render(int16_t* buf, uint32_t n, uint32_t pos);
+
+  bool active() const { return state_ != State::IDLE; }
+  BeepPreset* presets() { return presets_; }
+
+  struct Stats {
+    uint32_t started = 0;
+    uint32_t late = 0;     // start position already rendered
+    uint32_t replaced = 0; // tone cut (or queued tone dropped) by the next one
+    uint32_t dropped = 0;  // start(): queue full
+  };
+  const Stats& stats() const { return stats_; }
+
+private:
+  enum class State : uint8_t { IDLE, WAIT, ATTACK, SUSTAIN, RELEASE, GAP };
+  struct Request {
+    uint8_t tone;
+    uint32_t at;
+  };
+
+  BeepPreset presets_[BEEP_TONES];
+  SpscQueue<Request, 4> req_;
+
+  Request next_{};        // BEEP_ASAP request waiting for the tone playing
+  bool has_next_ = false;
+  State state_ = State::IDLE;
+  const BeepPreset* cur_ = nullptr;
+  uint32_t at_ = 0;       // WAIT: start position
+  uint8_t note_ = 0;
+  uint32_t left_ = 0;     // samples left in the state
+  uint32_t attack_ = 0;   // current note, samples
+  uint32_t sustain_ = 0;
+  uint32_t release_ = 0;
+  uint32_t gap_ = 0;
+  uint32_t phase_ = 0;
+  uint32_t inc_ = 0;
+  int32_t env_ = 0;       // Q15
+  int32_t env_step_ = 0;
+  int32_t rel_step_ = 0;
+  Stats stats_{};
+
+  void take_requests_(uint32_t pos);
+  void schedule_(const Request& r, uint32_t pos);
+  void begin_note_();
+  void next_state_();
+  uint32_t synth_(int16_t* buf, uint32_t n);
+};
+
+} // namespace ncomm
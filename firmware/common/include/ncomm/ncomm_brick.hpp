@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ncomm/ncomm_frame_pool.hpp"
+
+namespace ncomm {
+
+// ===== 256 -> 240 brick repacker (Sensory KWS input) =====
+// MCU1 sends 16 ms frames (256 samples @ 16 kHz); the KWS engine consumes
+// 15 ms bricks (240 samples). Instead of copying every sample into a 2 s float
+// sensoryBuffer, the repacker keeps references to the last few pool frames and
+// hands out 240-sample views made of up to BRICK_MAX_SEGS spans that point
+// straight into the pool blocks. With 256-sample frames 14 of 16 bricks cross
+// a frame border, so the split is resolved where the data has to be touched
+// anyway: to_float() writes one contiguous float brick from the spans.
+// Consumers that need contiguous int16 call contiguous(), which gathers a
+// split brick into a 240-sample wrap scratch.
+//
+// Input frames must be at 16 kHz (stream rate 0) and >= 80 samples (a brick
+// then spans at most MAX_FRAMES frames); each carries the link audio header
+// (AUDIO_HDR_SIZE) followed by PCM16LE. Main loop only.
+
+static constexpr uint16_t BRICK_SAMPLES = 240;
+
+static constexpr uint8_t BRICK_MAX_SEGS = 3; // frames down to 120 samples
+
+struct BrickView {
+  const int16_t* seg[BRICK_MAX_SEGS]{}; // 2-byte aligned spans, in order
+  uint16_t len[BRICK_MAX_SEGS]{};       // sum = BRICK_SAMPLES
+  uint8_t segs = 0;
+  uint32_t frame_index = 0;             // link frame holding the first sample
+  uint16_t offset = 0;                  // first sample within that frame
+};
+
+class BrickRepacker {
+public:
+  static constexpr uint8_t MAX_FRAMES = 4; // frames held (pool blocks pinned)
+
+  struct Stats {
+    uint32_t frames = 0;
+    uint32_t bricks = 0;
+    uint32_t bricks_split = 0;   // bricks across a frame border (2+ spans)
+    uint32_t gathers = 0;        // split bricks copied by contiguous()
+    uint32_t gaps = 0;           // frame_index discontinuities (not concealed)
+    uint32_t overflows = 0;      // oldest frame dropped: consumer too slow
+    uint32_t bad_frames = 0;     // header / length mismatch
+  };
+
+  // Hold a frame (copies the handle, not the samples).
+  void push(const FrameRef& f);
+
+  // Next brick if BRICK_SAMPLES are buffered. The view stays valid until the
+  // next call to next(), push() or reset().
+  bool next(BrickView* out);
+
+  // Contiguous int16 brick: points into the frame if the view has one span,
+  // otherwise gathers into the scratch. Valid as long as the view.
+  const int16_t* contiguous(const BrickView& v);
+
+  // Samples buffered and not yet handed out.
+  uint32_t pending() const { return pending_; }
+
+  void reset();
+
+  const Stats& stats() const { return stats_; }
+  void stats_reset() { stats_ = {}; }
+
+private:
+  struct Slot {
+    FrameRef ref;
+    const int16_t* pcm = nullptr;
+    uint16_t samples = 0;
+    uint32_t frame_index = 0;
+  };
+
+  void drop_head_();
+  void retire_();
+  static void gather_(const BrickView& v, int16_t* dst);
+
+  Slot slots_[MAX_FRAMES];
+  uint8_t head_ = 0;   // oldest held frame
+  uint8_t count_ = 0;
+  uint16_t pos_ = 0;   // next sample, relative to the head frame (may run past it until retire_)
+  uint32_t pending_ = 0;
+  uint32_t next_index_ = 0;
+  bool have_index_ = false;
+
+  alignas(8) int16_t scratch_[BRICK_SAMPLES]{};
+  Stats stats_{};
+};
+
+// out[i] = in[i] * scale. Two samples per 32-bit load, 8 per iteration; any
+// alignment of in (views into frames are only 2-byte aligned).
+void int16_to_float(const int16_t* in, float* out, uint32_t n, float scale = 1.0f);
+
+// Whole brick to BRICK_SAMPLES contiguous floats (joins the spans).
+void to_float(const BrickView& v, float* out, float scale = 1.0f);
+
+} // namespace ncomm
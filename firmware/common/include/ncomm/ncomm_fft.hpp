@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ncomm {
+
+// ===== Real FFT (float, radix-2) =====
+// N-point real transform computed as an N/2-point complex FFT plus the
+// split step. Output layout follows CMSIS arm_rfft_fast_f32 so a CMSIS-DSP
+// build can swap it in: x[0] = Re X[0], x[1] = Re X[N/2], x[2k], x[2k+1] =
+// Re, Im X[k] for k = 1 .. N/2-1. Tables are built by init() (float sin/cos
+// from double, once); the object is then read-only and can be shared.
+
+namespace fft_detail {
+void init_tables(uint32_t n, float* tw_c, float* tw_r, uint16_t* rev);
+void rfft(float* x, uint32_t n, const float* tw_c, const float* tw_r, const uint16_t* rev);
+void init_tables_q31(uint32_t n, int32_t* tw_c, int32_t* tw_r, uint16_t* rev);
+void rfft_q31(int32_t* x, uint32_t n, const int32_t* tw_c, const int32_t* tw_r, const uint16_t* rev);
+}
+
+template <uint32_t N>
+class RealFft {
+  static_assert(N >= 16 && N <= 4096 && (N & (N - 1)) == 0, "RealFft size must be a power of two");
+
+public:
+  static constexpr uint32_t size() { return N; }
+  static constexpr uint32_t bins() { return N / 2 + 1; }
+
+  void init() { fft_detail::init_tables(N, tw_c_, tw_r_, rev_); }
+
+  // In place, x holds N reals on entry.
+  void forward(float* x) const { fft_detail::rfft(x, N, tw_c_, tw_r_, rev_); }
+
+  // |X[k]|^2 for k = 0 .. N/2 from a forward() result.
+  static void power(const float* x, float* pow) {
+    pow[0] = x[0] * x[0];
+    pow[N / 2] = x[1] * x[1];
+    for (uint32_t k = 1; k < N / 2; k++) pow[k] = x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+  }
+
+private:
+  float tw_c_[N / 2];          // N/4 (cos, sin) pairs of the N/2-point complex FFT
+  float tw_r_[2 * (N / 4 + 1)]; // split twiddles W_N^k, k = 0 .. N/4
+  uint16_t rev_[N / 2];         // bit reversal of the complex FFT
+};
+
+// ===== Real FFT (Q31, radix-2) =====
+// Same algorithm and output layout as RealFft, in 32-bit fixed point with a
+// 64-bit product per multiply (SMULL on M7). Every butterfly stage and the
+// split step halve the data, so the output is X / N (arm_rfft_q31
+// convention) and nothing overflows as long as |x| < 2^30 on entry.
+template <uint32_t N>
+class RealFftQ31 {
+  static_assert(N >= 16 && N <= 4096 && (N & (N - 1)) == 0, "RealFftQ31 size must be a power of two");
+
+public:
+  static constexpr uint32_t size() { return N; }
+  static constexpr uint32_t bins() { return N / 2 + 1; }
+
+  void init() { fft_detail::init_tables_q31(N, tw_c_, tw_r_, rev_); }
+
+  // In place, x holds N values |x| < 2^30 on entry; out = X / N.
+  void forward(int32_t* x) const { fft_detail::rfft_q31(x, N, tw_c_, tw_r_, rev_); }
+
+private:
+  int32_t tw_c_[N / 2];
+  int32_t tw_r_[2 * (N / 4 + 1)];
+  uint16_t rev_[N / 2];
+};
+
+} // namespace ncomm
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "ncomm/ncomm_protocol.hpp"
+#include "ncomm/ncomm_spsc.hpp"
+
+namespace ncomm {
+
+// ===== Fixed-block frame pool with intrusive refcounts =====
+// One block holds one received link frame (header fields + payload up to
+// MAX_PAYLOAD). The RX ISR takes a block, parses straight into it and hands it
+// to the main loop; every consumer that keeps the frame (playout, KWS, SR,
+// forwarding) holds a FrameRef. The block returns to the pool when the last
+// reference goes. Bounded memory, no heap, no payload copies.
+//
+// Contexts: alloc() is the only ISR-side call. References are taken and
+// dropped in the main loop only, so the free list is a plain SPSC ring
+// (producer = release in main, consumer = alloc in the ISR).
+
+class FramePool;
+
+struct FrameBlock {
+  FramePool* pool;
+  std::atomic<uint16_t> refs;
+  uint8_t index;
+
+  uint8_t msg_type;
+  uint8_t msg_id;
+  uint16_t len;
+  alignas(4) uint8_t payload[MAX_PAYLOAD];
+};
+
+class FramePool {
+public:
+  static constexpr uint32_t MAX_BLOCKS = 32;
+
+  struct Stats {
+    uint32_t allocs = 0;
+    uint32_t exhausted = 0; // alloc() found no free block
+    uint32_t in_use_max = 0;
+  };
+
+  // Main context, before the ISR runs. count <= MAX_BLOCKS.
+  void init(FrameBlock* blocks, uint8_t count) {
+    blocks_ = blocks;
+    count_ = (count > MAX_BLOCKS) ? (uint8_t)MAX_BLOCKS : count;
+    while (free_.pop(nullptr)) {}
+    for (uint8_t i = 0; i < count_; i++) {
+      blocks_[i].pool = this;
+      blocks_[i].refs.store(0, std::memory_order_relaxed);
+      blocks_[i].index = i;
+      free_.push(i);
+    }
+    free_.reset_stats();
+    stats_ = {};
+  }
+
+  // Free block with refs = 1, nullptr when the pool is exhausted.
+  FrameBlock* alloc() {
+    uint8_t idx = 0;
+    if (!free_.pop(&idx)) {
+      stats_.exhausted++;
+      return nullptr;
+    }
+    FrameBlock* b = &blocks_[idx];
+    b->refs.store(1, std::memory_order_relaxed);
+    b->len = 0;
+
+    stats_.allocs++;
+    const uint32_t used = count_ - free_.size();
+    if (used > stats_.in_use_max) stats_.in_use_max = used;
+    return b;
+  }
+
+  void add_ref(FrameBlock* b) {
+    b->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release(FrameBlock* b) {
+    if (b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) free_.push(b->index);
+  }
+
+  uint32_t capacity() const { return count_; }
+  uint32_t available() const { return free_.size(); }
+  const Stats& stats() const { return stats_; }
+  void stats_reset() {
+    stats_ = {};
+    stats_.in_use_max = count_ - free_.size();
+  }
+
+private:
+  FrameBlock* blocks_ = nullptr;
+  uint8_t count_ = 0;
+  SpscQueue<uint8_t, MAX_BLOCKS> free_;
+  Stats stats_{};
+};
+
+// Counted handle to a pool block (main loop only). Copy = add_ref.
+class FrameRef {
+public:
+  FrameRef() = default;
+  ~FrameRef() { reset(); }
+
+  // Take over a reference that is already counted (e.g. from alloc()).
+  static FrameRef adopt(FrameBlock* b) {
+    FrameRef r;
+    r.b_ = b;
+    return r;
+  }
+
+  FrameRef(const FrameRef& o) : b_(o.b_) {
+    if (b_) b_->pool->add_ref(b_);
+  }
+  FrameRef(FrameRef&& o) noexcept : b_(o.b_) { o.b_ = nullptr; }
+
+  FrameRef& operator=(const FrameRef& o) {
+    if (this != &o) {
+      if (o.b_) o.b_->pool->add_ref(o.b_);
+      reset();
+      b_ = o.b_;
+    }
+    return *this;
+  }
+  FrameRef& operator=(FrameRef&& o) noexcept {
+    if (this != &o) {
+      reset();
+      b_ = o.b_;
+      o.b_ = nullptr;
+    }
+    return *this;
+  }
+
+  void reset() {
+    if (b_) b_->pool->release(b_);
+    b_ = nullptr;
+  }
+
+  explicit operator bool() const { return b_ != nullptr; }
+  const FrameBlock* get() const { return b_; }
+  const FrameBlock* operator->() const { return b_; }
+
+  const uint8_t* data() const { return b_ ? b_->payload : nullptr; }
+  uint16_t size() const { return b_ ? b_->len : 0; }
+
+private:
+  FrameBlock* b_ = nullptr;
+};
+
+} // namespace ncomm
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ncomm/ncomm_brick.hpp"
+#include "ncomm/ncomm_fft.hpp"
+
+namespace ncomm {
+
+// ===== Keyword spotting (MCU2) =====
+// KwsEngine is what the MCU2 main loop drives: one 240-sample brick at a time
+// (the Sensory brick, see ncomm_brick.hpp), and it reports a command plus the
+// audio segment it was found in. Sensory TrulyHandsfree implements it with an
+// adapter around SensoryProcessData(); TinyKws below is the in-tree engine
+// used where Sensory is not available (lab, host builds, host tests).
+//
+// Commands follow the state machine: 1..3 start (connect / alpha / bravo),
+// 4 = disconnect. Segment positions are absolute 16 kHz sample positions, the
+// same numbering as ncomm::SpeechRing, so SR reads the segment from the ring.
+
+static constexpr uint8_t KWS_COMMANDS = 4;
+static constexpr uint8_t KWS_CLASSES = KWS_COMMANDS + 1; // 0 = filler / silence
+
+struct KwsResult {
+  uint8_t cmd_id = 0;      // 1..KWS_COMMANDS
+  uint8_t score = 0;       // peak smoothed posterior, 0..255
+  uint32_t seg_start = 0;  // first sample of the command
+  uint32_t seg_end = 0;    // one past the last sample
+  uint32_t trigger_pos = 0; // audio position when the posterior crossed the threshold
+};
+
+// A command still being decided (speculative SR work): a candidate whose
+// posterior is rising but below the trigger, or a triggered command that is
+// not endpointed yet. The segment is provisional.
+struct KwsPending {
+  uint8_t cmd_id = 0;
+  bool triggered = false; // false: candidate, may be dropped without a result
+  bool ended = false;     // speech stopped at seg_end (hangover running); it
+                          // is the endpoint unless speech resumes
+  uint32_t seg_start = 0;
+  uint32_t seg_end = 0;   // speech end so far
+};
+
+class KwsEngine {
+public:
+  virtual void reset() = 0;
+
+  // brick = 240 samples @ 16 kHz, first sample at absolute position pos.
+  // True when a command was detected and its segment endpointed.
+  virtual bool process(const BrickView& brick, uint32_t pos, KwsResult* out) = 0;
+
+  // State after the last process(): false when nothing is being decided, or
+  // for engines that do not expose it (e.g. an engine that only reports
+  // finished results).
+  virtual bool pending(KwsPending* out) const {
+    (void)out;
+    return false;
+  }
+
+  virtual const char* name() const = 0;
+  virtual uint32_t ram_bytes() const = 0; // engine state (RAM), excl. model constants
+
+protected:
+  ~KwsEngine() = default; // statically allocated engines only
+};
+
+// ---- Decision stages (shared by engines that produce per-class posteriors) ----
+
+struct KwsConfig {
+  float trigger = 0.80f;        // smoothed posterior that accepts a command
+  uint8_t smooth = 4;           // inferences in the posterior moving average (<= 8)
+  uint8_t infer_every = 2;      // feature frames (bricks) per inference
+  uint16_t refractory_ms = 1000; // no new trigger this long after one
+  uint8_t on_db = 9;            // endpointer: speech if frame energy > floor + on_db
+  uint8_t off_db = 6;           // endpointer: silence if below floor + off_db
+  uint16_t hangover_ms = 150;   // silence that ends the command
+  uint16_t max_tail_ms = 600;   // endpoint at the latest this long after the trigger
+  uint16_t backoff_ms = 270;    // audio kept before the detected speech start (Sensory BACKOFF_MS)
+  float candidate = 0.50f;      // smoothed posterior that reports a candidate (pending())
+};
+
+// Moving average of the class posteriors, trigger on the best command with
+// a refractory lockout.
+class KwsDecoder {
+public:
+  static constexpr uint8_t MAX_SMOOTH = 8;
+
+  void init(const KwsConfig& cfg);
+  void reset();
+
+  // Posteriors of one inference (sum 1). Returns the command that triggered
+  // (0 = none); *score = smoothed posterior of the best command.
+  uint8_t push(const float post[KWS_CLASSES], uint32_t pos, float* score);
+
+  // Smoothed posterior of a class after the last push().
+  float smoothed(uint8_t cls) const { return n_ ? sum_[cls] / (float)n_ : 0.0f; }
+
+  // Best command if its smoothed posterior is at least cfg.candidate and
+  // it may still trigger (not in the lockout), else 0.
+  uint8_t candidate() const;
+
+private:
+  KwsConfig cfg_{};
+  float hist_[MAX_SMOOTH][KWS_CLASSES]{};
+  float sum_[KWS_CLASSES]{};
+  uint8_t n_ = 0;
+  uint8_t at_ = 0;
+  uint8_t best_ = 0;
+  uint32_t lockout_end_ = 0;
+  bool locked_ = false;
+};
+
+// Energy endpointer over feature frames: tracks the noise floor, finds the
+// start of the speech run that contains the trigger, ends it after hangover.
+class KwsEndpointer {
+public:
+  static constexpr uint8_t HISTORY = 64; // frames looked back for the start (960 ms)
+
+  void init(const KwsConfig& cfg, uint16_t frame_samples);
+  void reset();
+
+  // One frame: energy in dB, frame covers [pos, pos + frame_samples).
+  void push(float energy_db, uint32_t pos);
+
+  // The decoder triggered on the last frame.
+  void trigger(uint8_t cmd, float score, uint32_t pos);
+  bool active() const { return cmd_ != 0; }
+
+  // Segment done (after push()): fills out and returns true once.
+  bool done(KwsResult* out);
+
+  // Provisional segment of the triggered command, or of candidate cmd (the
+  // speech run that the trigger would take) when none is triggered.
+  bool pending(uint8_t candidate, KwsPending* out) const;
+
+  float floor_db() const { return floor_; }
+
+private:
+  KwsConfig cfg_{};
+  uint16_t frame_ = 240;
+  float floor_ = 0.0f;
+  bool floor_set_ = false;
+  float e_[HISTORY]{};
+  uint8_t at_ = 0;     // next history slot
+  uint8_t count_ = 0;
+  uint32_t last_pos_ = 0;
+
+  uint8_t cmd_ = 0;
+  float score_ = 0.0f;
+  uint32_t trig_pos_ = 0;
+  uint32_t start_ = 0;
+  uint32_t quiet_from_ = 0;
+  uint32_t end_ = 0;
+  uint16_t quiet_ = 0;   // consecutive silent frames
+  uint16_t tail_ = 0;    // frames since trigger
+  bool finished_ = false;
+
+  uint32_t run_start_() const; // start of the speech run ending at the last frame
+};
+
+// ---- TinyKws: MFCC + int8 DS-CNN ----
+// Front end per brick: 30 ms frame (previous + current brick), Hamming,
+// 512-point FFT, 40 mel bands 20..4000 Hz, log, DCT-II -> 10 MFCC, quantised
+// to int8 into a 64-frame (960 ms) feature ring. Every infer_every frames the
+// DS-CNN (Hello Edge layout) runs on the window:
+//   conv 10x4 /2 -> 32x5xC, KWS_DS_BLOCKS x (dw 3x3 + pw 1x1), avg pool, FC.
+// Activations are int8 NHWC with zero point 0; weights int8, bias int32,
+// per-channel requantisation (Q31 multiplier + shift, CMSIS-NN convention).
+
+static constexpr uint16_t KWS_FRAMES = 64;
+static constexpr uint8_t KWS_MFCC = 10;
+static constexpr uint8_t KWS_MEL = 40;
+static constexpr uint8_t KWS_CH = 32;
+static constexpr uint8_t KWS_DS_BLOCKS = 3;
+static constexpr uint8_t KWS_CONV_T = 10; // conv1 kernel (time x mfcc)
+static constexpr uint8_t KWS_CONV_F = 4;
+static constexpr uint16_t KWS_OUT_T = KWS_FRAMES / 2; // after stride 2
+static constexpr uint8_t KWS_OUT_F = KWS_MFCC / 2;
+
+struct KwsRequant {
+  const int32_t* mult; // per output channel, Q31 in [2^30, 2^31)
+  const int8_t* shift; // per output channel, left shift (negative = right)
+};
+
+struct KwsModel {
+  float in_scale;                 // mfcc = q * in_scale
+  const int8_t* conv1_w;          // [KWS_CH][KWS_CONV_T][KWS_CONV_F]
+  const int32_t* conv1_b;         // [KWS_CH]
+  KwsRequant conv1_q;
+  struct Ds {
+    const int8_t* dw_w;           // [3][3][KWS_CH]
+    const int32_t* dw_b;
+    KwsRequant dw_q;
+    const int8_t* pw_w;           // [KWS_CH out][KWS_CH in]
+    const int32_t* pw_b;
+    KwsRequant pw_q;
+  } ds[KWS_DS_BLOCKS];
+  const int8_t* fc_w;             // [KWS_CLASSES][KWS_CH]
+  const int32_t* fc_b;
+  float fc_scale;                 // logit = (acc + b) * fc_scale
+  bool trained;                   // false: placeholder weights, posteriors meaningless
+};
+
+// Deterministic untrained weights with realistic shapes and scales: exercises
+// the full compute path (cost and RAM are those of a trained model) but never
+// triggers. Replace with a generated model header once one is trained.
+const KwsModel* kws_placeholder_model();
+// RAM the placeholder tables take (a generated model keeps them in flash)
+uint32_t kws_placeholder_model_bytes();
+
+// Q31 multiplier + shift for a real scale (model generation / placeholder).
+void kws_quantize_multiplier(double scale, int32_t* mult, int8_t* shift);
+
+class TinyKws final : public KwsEngine {
+public:
+  void init(const KwsModel* model, const KwsConfig& cfg = KwsConfig{});
+
+  void reset() override;
+  bool process(const BrickView& brick, uint32_t pos, KwsResult* out) override;
+  bool pending(KwsPending* out) const override { return ep_.pending(dec_.candidate(), out); }
+  const char* name() const override { return "tinykws"; }
+  uint32_t ram_bytes() const override { return (uint32_t)sizeof(*this); }
+
+  // Last inference (for tuning / telemetry).
+  const float* posteriors() const { return post_; }
+  const KwsDecoder& decoder() const { return dec_; }
+  uint32_t inferences() const { return inferences_; }
+
+private:
+  static constexpr uint16_t FRAME = 2 * BRICK_SAMPLES; // 480 = 30 ms
+  static constexpr uint16_t NFFT = 512;
+
+  void mfcc_(float* frame, int8_t* out, float* energy_db);
+  void infer_();
+
+  const KwsModel* model_ = nullptr;
+  KwsConfig cfg_{};
+  KwsDecoder dec_;
+  KwsEndpointer ep_;
+
+  RealFft<NFFT> fft_;
+  float window_[FRAME];
+  // Triangular mel bands over the FFT bins: bin k rises in band mel_band_[k]
+  // with weight mel_w_[k] and falls in band mel_band_[k] - 1 with 1 - mel_w_[k]
+  int8_t mel_band_[NFFT / 2 + 1]; // -1: outside 20..4000 Hz
+  float mel_w_[NFFT / 2 + 1];
+  float dct_[KWS_MFCC][KWS_MEL];
+
+  int16_t prev_[BRICK_SAMPLES];
+  float fbuf_[NFFT];
+  float pow_[NFFT / 2 + 1];
+
+  int8_t feat_[2 * KWS_FRAMES][KWS_MFCC]; // written twice: any 64-frame window is contiguous
+  uint32_t frames_ = 0;
+
+  int8_t act_a_[KWS_OUT_T * KWS_OUT_F * KWS_CH];
+  int8_t act_b_[KWS_OUT_T * KWS_OUT_F * KWS_CH];
+  float post_[KWS_CLASSES]{};
+  uint32_t inferences_ = 0;
+};
+
+} // namespace ncomm
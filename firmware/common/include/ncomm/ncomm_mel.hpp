@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ncomm/ncomm_fft.hpp"
+#include "ncomm/ncomm_speech.hpp"
+
+namespace ncomm {
+
+// ===== SR log-mel front end (MCU2) =====
+// Replaces the model_svc_melspec_win_0_5 TFLite model (spec 6.5.4): same
+// framing (N_FFT 1024, hop 300, no centring: 8000 samples -> 24 frames) and
+// the definition the model was exported from (librosa melspectrogram):
+//   periodic Hann, power spectrum, 64 Slaney mel bands 0..8000 Hz with Slaney
+//   area normalisation, ln(mel + 1e-6); input scaled to +-1.
+// Output layout is the encoder input: [MEL_BINS][frames] (spec 6.5.5).
+// Neither path needs an interpreter arena: tables + one frame buffer,
+// ram_bytes() in total.
+//
+// MelFrontEnd (float, used on MCU2): int16 x (Hann / 32768) window, float
+// RealFft, sparse float filterbank with the Slaney norm folded in (only the
+// non-zero bins of each triangle), logf. The M7 has a single-precision FPU.
+// MelFrontEndQ31 (fixed point, for cores without an FPU): Q15 window with a
+// block shift to 30 bits, Q31 real FFT, power >> 17 (uint64), Q15 filterbank,
+// fixed-point log2 (64-entry table); float only for the 64 outputs.
+// Window, FFT, filterbank and CMVN run from ITCM (NCOMM_FAST_CODE).
+//
+// Speed: no target cycle counts yet. On the host the float frame is faster
+// (~15 vs ~20 us, -O2) and closer to the double reference (< 1 vs 13 mnat);
+// test/test_mel.cpp fails if MelFrontEnd becomes slower than MelFrontEndQ31.
+
+static constexpr uint16_t MEL_NFFT = 1024;
+static constexpr uint16_t MEL_HOP = 300;
+static constexpr uint8_t MEL_BINS = 64;
+static constexpr uint16_t MEL_WINDOW_SAMPLES = 8000; // SR encoder input (500 ms)
+static constexpr uint8_t MEL_WINDOW_FRAMES = (MEL_WINDOW_SAMPLES - MEL_NFFT) / MEL_HOP + 1; // 24
+
+static constexpr float MEL_LOG_EPS = 1e-6f;
+// Per-utterance variance floor (std 0.1 nat): steady bins (tones, hum) must
+// not be blown up to unit variance from rounding-level spread
+static constexpr float MEL_CMVN_VAR_FLOOR = 1e-2f;
+
+// Frames of hop MEL_HOP that fit in n samples.
+constexpr uint32_t mel_frames(uint32_t n) { return (n < MEL_NFFT) ? 0 : (n - MEL_NFFT) / MEL_HOP + 1; }
+
+struct MelFraming;
+
+class MelFrontEnd {
+public:
+  void init();
+
+  // One frame of MEL_NFFT samples given as up to two spans (na + nb =
+  // MEL_NFFT; b may be null when na = MEL_NFFT). out[k * stride] = log-mel k.
+  void frame(const int16_t* a, uint32_t na, const int16_t* b, float* out, uint32_t stride);
+
+  // All frames over [pos, pos + n) of the ring into out[MEL_BINS][max_frames].
+  // Returns frames written (0 if the span is no longer buffered).
+  uint32_t compute(const SpeechRing& ring, uint32_t pos, uint32_t n, float* out, uint32_t max_frames);
+
+  // Frame at view sample i / all frames of a looped view (same output as the
+  // physical looping copy). False / frames written if the audio is gone.
+  bool frame(const LoopedSpan& v, uint32_t i, float* out, uint32_t stride);
+  uint32_t compute(const LoopedSpan& v, float* out, uint32_t max_frames);
+
+  uint32_t ram_bytes() const { return (uint32_t)sizeof(*this); }
+
+  // Non-zero filterbank weights: every bin lies in at most two bands
+  static constexpr uint16_t MAX_WEIGHTS = 2 * (MEL_NFFT / 2 + 1);
+
+private:
+  friend struct MelFraming; // framing shared with MelFrontEndQ31 (ncomm_mel.cpp)
+
+  RealFft<MEL_NFFT> fft_;
+  float window_[MEL_NFFT];          // periodic Hann / 32768
+  uint16_t f_lo_[MEL_BINS];         // first FFT bin of band k
+  uint16_t f_len_[MEL_BINS];        // non-zero bins
+  uint16_t f_off_[MEL_BINS];        // into f_w_
+  float f_w_[MAX_WEIGHTS];          // triangle weights x Slaney norm
+  float buf_[MEL_NFFT];
+  float pow_[MEL_NFFT / 2 + 1];
+
+  uint32_t window_run_(const int16_t* x, uint32_t at, uint32_t n);
+  void finish_(uint32_t peak, float* out, uint32_t stride);
+};
+
+// Fixed-point variant, same interface and output definition.
+class MelFrontEndQ31 {
+public:
+  void init();
+  void frame(const int16_t* a, uint32_t na, const int16_t* b, float* out, uint32_t stride);
+  uint32_t compute(const SpeechRing& ring, uint32_t pos, uint32_t n, float* out, uint32_t max_frames);
+  bool frame(const LoopedSpan& v, uint32_t i, float* out, uint32_t stride);
+  uint32_t compute(const LoopedSpan& v, float* out, uint32_t max_frames);
+
+  uint32_t ram_bytes() const { return (uint32_t)sizeof(*this); }
+
+  static constexpr uint16_t MAX_WEIGHTS = MelFrontEnd::MAX_WEIGHTS;
+
+private:
+  friend struct MelFraming;
+
+  RealFftQ31<MEL_NFFT> fft_;
+  int16_t window_[MEL_NFFT];        // Q15 periodic Hann
+  uint16_t f_lo_[MEL_BINS];
+  uint16_t f_len_[MEL_BINS];
+  uint16_t f_off_[MEL_BINS];
+  uint16_t f_w_[MAX_WEIGHTS];       // Q15 triangle weights
+  float f_log2c_[MEL_BINS];         // log2 of Slaney norm + fixed-point scale
+  int32_t buf_[MEL_NFFT];
+  uint64_t pow_[MEL_NFFT / 2 + 1];
+
+  uint32_t window_run_(const int16_t* x, uint32_t at, uint32_t n);
+  void finish_(uint32_t peak, float* out, uint32_t stride);
+};
+
+// ===== Streaming log-mel frames (MCU2) =====
+// Computes frames while speech is arriving instead of after the command
+// buffer is complete, so at decision time SR only gathers frames and runs the
+// encoder. Frames sit on a fixed hop grid of absolute sample positions
+// (g, g + MEL_HOP, ...; the same positions as SpeechRing) and are kept in a
+// ring of MEL_STREAM_FRAMES, frame-major.
+//
+// update() is called from the main loop after new audio: while `active` (VAD
+// on) it computes every grid frame that is complete in the speech ring, at
+// most `budget` per call; while idle it only moves the grid along, staying
+// MEL_STREAM_PREROLL samples behind the head, so a VAD onset first computes
+// that pre-roll (VAD latency, MCU1 pre-roll, KWS endpoint walk-back).
+//
+// A segment [pos, pos + n) uses the grid frames inside it: the first one
+// starts less than MEL_HOP (19 ms) after pos, below the resolution of the
+// KWS endpointer (one 240-sample brick).
+// Single context (main loop).
+
+static constexpr uint32_t MEL_STREAM_FRAMES = 128;   // 2.4 s of hops >= the speech ring
+static constexpr uint32_t MEL_STREAM_PREROLL = 4800; // 300 ms
+static constexpr uint32_t MEL_STREAM_BUDGET = 4;     // frames per update() call
+
+class MelStream {
+public:
+  // fe is shared with the decision path (its scratch buffers are only used
+  // inside a call)
+  void init(MelFrontEnd* fe);
+  void reset(uint32_t head);
+
+  // Returns frames computed by this call.
+  uint32_t update(const SpeechRing& ring, bool active, uint32_t budget = MEL_STREAM_BUDGET);
+
+  // Encoder input for [pos, pos + n): out[MEL_BINS][max_frames], frames on
+  // the grid. Cached frames are copied; missing ones (not computed yet, VAD
+  // off, evicted) are computed now from the ring. Returns frames written,
+  // hits = how many came from the cache.
+  uint32_t segment(const SpeechRing& ring, uint32_t pos, uint32_t n, float* out,
+                   uint32_t max_frames, uint32_t* hits = nullptr);
+
+  // Encoder input for a looped view (SR packet): frames inside the first
+  // period come from the cache when v starts on the grid, frames that run
+  // into the loop are computed through the view. Returns frames written.
+  uint32_t looped(const LoopedSpan& v, float* out, uint32_t max_frames, uint32_t* hits = nullptr);
+
+  // Cached frames inside [pos, pos + n) (what segment() would not recompute).
+  uint32_t cached(uint32_t pos, uint32_t n) const;
+
+  // Absolute position of the next grid frame (the oldest one not computed).
+  uint32_t next_pos() const { return next_pos_; }
+  uint32_t ram_bytes() const { return (uint32_t)sizeof(*this); }
+
+  struct Stats {
+    uint32_t frames = 0;   // computed by update()
+    uint32_t skipped = 0;  // grid frames passed without computing (idle, overrun)
+    uint32_t hits = 0;     // segment(): frames from the cache
+    uint32_t misses = 0;   // segment(): frames computed at decision time
+  };
+  const Stats& stats() const { return stats_; }
+
+private:
+  MelFrontEnd* fe_ = nullptr;
+  uint32_t next_pos_ = 0;   // grid position of frame next_idx_
+  uint32_t next_idx_ = 0;   // frame counter (slot = idx % MEL_STREAM_FRAMES)
+  uint32_t valid_from_ = 0; // first computed frame index after the last gap
+  Stats stats_{};
+  float frames_[MEL_STREAM_FRAMES][MEL_BINS];
+
+  // Frame index of the first grid position >= pos, frames in [pos, pos + n)
+  uint32_t first_idx_(uint32_t pos, uint32_t n, uint32_t* count) const;
+  bool is_cached_(uint32_t idx) const;
+};
+
+// ===== SR packets from a KWS command segment (spec 6.5.3) =====
+// Each packet is an encoder window of MEL_WINDOW_SAMPLES, a LoopedSpan over
+// the speech ring instead of a looping copy into a voice buffer:
+//   A  n < SR_MIN_SAMPLES       : no packet (SR = false)
+//   B  n <= MEL_WINDOW_SAMPLES  : the segment looped to the window
+//   C  n > MEL_WINDOW_SAMPLES   : the first window, then the rest looped
+// Packets start on the MelStream hop grid (grid = any grid position, e.g.
+// MelStream::next_pos()), < MEL_HOP after the nominal start, so their
+// in-period frames are the streamed ones. A scenario C rest shorter than
+// SR_MIN_SAMPLES is dropped like scenario A.
+static constexpr uint32_t SR_MIN_SAMPLES = 4000; // 250 ms
+static constexpr uint8_t SR_MAX_PACKETS = 2;
+
+// First position >= pos on the grid through `grid`.
+uint32_t mel_grid_align(uint32_t pos, uint32_t grid);
+// Returns the packet count (0..SR_MAX_PACKETS) written to out.
+uint8_t mel_sr_packets(const SpeechRing& ring, uint32_t pos, uint32_t n, uint32_t grid, LoopedSpan* out);
+
+// Cepstral mean (and variance) normalisation over [MEL_BINS][frames], row
+// stride `stride`, in place. mean / inv_std: global statistics shipped with
+// the encoder; null = per-utterance statistics of these frames.
+void mel_cmvn(float* mel, uint32_t frames, uint32_t stride, bool variance,
+              const float* mean = nullptr, const float* inv_std = nullptr);
+
+// Slaney mel triangle k at FFT bin `bin` (0 outside) and its area norm
+// 2 / (f_hi - f_lo); shared by both front ends' tables and the references.
+double mel_slaney_weight(uint32_t band, uint32_t bin, double* norm);
+
+} // namespace ncomm
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===== Memory placement (STM32H743, both MCU1 and MCU2 linker scripts) =====
+//
+//   NCOMM_FAST_CODE  function in ITCM (0x00000000, 64K): zero wait state,
+//                    no I-cache dependence. Copied from flash by ncomm_mem_init().
+//                    Flash <-> ITCM calls are out of BL range; ld inserts veneers.
+//   NCOMM_FAST_DATA  zero-initialised buffer/state in DTCM (0x20000000, 128K):
+//                    single cycle, never cached, CPU only (DMA1/2 cannot reach it).
+//   NCOMM_FAST_INIT  initialised table in DTCM (copied from flash at startup).
+//   NCOMM_DMA_BUF    DMA1/DMA2 buffer in RAM_D2 (0x30000000), 32-byte aligned so
+//                    cache maintenance by address never touches a neighbour.
+//
+// Host builds (no __arm__) get plain placement so the modules still compile.
+
+#if defined(__arm__) && !defined(NCOMM_HOST)
+#define NCOMM_FAST_CODE __attribute__((section(".itcm_text"), noinline))
+#define NCOMM_FAST_DATA __attribute__((section(".dtcm_bss"), aligned(32)))
+#define NCOMM_FAST_INIT __attribute__((section(".dtcm_data"), aligned(4)))
+#define NCOMM_DMA_BUF   __attribute__((section(".dma_buffer"), aligned(32)))
+#else
+#define NCOMM_FAST_CODE
+#define NCOMM_FAST_DATA __attribute__((aligned(32)))
+#define NCOMM_FAST_INIT
+#define NCOMM_DMA_BUF   __attribute__((aligned(32)))
+#endif
+
+// Copy .itcm_text / .dtcm_data from flash and zero .dtcm_bss.
+// Called from Reset_Handler after .data/.bss init, before constructors.
+void ncomm_mem_init(void);
+
+#if defined(NCOMM_MEM_BENCH)
+// ===== Placement benchmark =====
+// Proxy, not the production functions: a function lives in one section only,
+// so a copy of their loops (bitwise CRC16-CCITT-FALSE over one audio frame as
+// in ncomm_crc16.c, plus the capture HPF / abs-sum VAD energy) is built twice,
+// once in flash and once in ITCM. The real ncomm_crc16_ccitt_false() and
+// process_fused() run from ITCM; their own cycles are in the NCOMM_PROFILE
+// zones (parser, ve).
+typedef struct {
+    uint32_t flash_cold;  // flash copy, I-cache invalidated first (if enabled)
+    uint32_t flash_warm;  // flash copy, best of N
+    uint32_t itcm;        // ITCM copy, best of N
+} ncomm_mem_bench_t;
+
+void ncomm_mem_bench(ncomm_mem_bench_t* out, uint16_t iterations);
+#endif // NCOMM_MEM_BENCH
+
+#ifdef __cplusplus
+}
+#endif
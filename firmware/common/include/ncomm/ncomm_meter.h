@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__ARM_FEATURE_DSP) && defined(__arm__) && !defined(NCOMM_HOST)
+#include "stm32h7xx.h"
+#define NCOMM_METER_SIMD 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===== Peak / RMS meters folded into existing sample loops =====
+// The caller keeps two registers per port inside its loop and feeds packed
+// int16 pairs (lane 0 = even sample, lane 1 = odd sample):
+//
+//   uint32_t pk2 = 0; int64_t ss = 0;
+//   ... pk2 = ncomm_meter_pk2(pk2, pair); ss = ncomm_meter_ss2(ss, pair); ...
+//   ncomm_meter_add(&m, pk2, ss, n);
+//
+// On M7: peak = QSUB16 + SSUB16/SEL (|x|) + SSUB16/SEL (max), sum of squares
+// = one SMLALD, i.e. ~6 instructions per pair, no extra memory traffic.
+
+typedef struct {
+    uint32_t peak;   // max |x| (0..32767, -32768 saturates)
+    uint64_t sumsq;
+    uint32_t n;
+} ncomm_meter_t;
+
+static inline uint32_t ncomm_meter_pack(int16_t a, int16_t b) {
+    return (uint32_t)(uint16_t)a | ((uint32_t)(uint16_t)b << 16);
+}
+
+// Per-lane running max of |x|
+static inline uint32_t ncomm_meter_pk2(uint32_t pk2, uint32_t pair) {
+#if defined(NCOMM_METER_SIMD)
+    const uint32_t neg = __QSUB16(0, pair);
+    (void)__SSUB16(pair, neg);
+    const uint32_t a = __SEL(pair, neg);
+    (void)__SSUB16(a, pk2);
+    return __SEL(a, pk2);
+#else
+    int32_t x0 = (int16_t)(pair & 0xFFFF);
+    int32_t x1 = (int16_t)(pair >> 16);
+    x0 = (x0 < 0) ? -x0 : x0;
+    x1 = (x1 < 0) ? -x1 : x1;
+    if (x0 > 32767) x0 = 32767;
+    if (x1 > 32767) x1 = 32767;
+    uint32_t p0 = pk2 & 0xFFFF;
+    uint32_t p1 = pk2 >> 16;
+    if ((uint32_t)x0 > p0) p0 = (uint32_t)x0;
+    if ((uint32_t)x1 > p1) p1 = (uint32_t)x1;
+    return p0 | (p1 << 16);
+#endif
+}
+
+// Sum of squares of both lanes
+static inline int64_t ncomm_meter_ss2(int64_t ss, uint32_t pair) {
+#if defined(NCOMM_METER_SIMD)
+    return (int64_t)__SMLALD(pair, pair, (uint64_t)ss);
+#else
+    const int32_t x0 = (int16_t)(pair & 0xFFFF);
+    const int32_t x1 = (int16_t)(pair >> 16);
+    return ss + (int64_t)x0 * x0 + (int64_t)x1 * x1;
+#endif
+}
+
+static inline void ncomm_meter_add(ncomm_meter_t* m, uint32_t pk2, int64_t ss, uint32_t n) {
+    const uint32_t p0 = pk2 & 0xFFFF;
+    const uint32_t p1 = pk2 >> 16;
+    const uint32_t pk = (p0 > p1) ? p0 : p1;
+    if (pk > m->peak) m->peak = pk;
+    m->sumsq += (uint64_t)ss;
+    m->n += n;
+}
+
+// Single sample (odd tails)
+static inline void ncomm_meter_add1(ncomm_meter_t* m, int16_t x) {
+    int32_t a = x;
+    a = (a < 0) ? -a : a;
+    if (a > 32767) a = 32767;
+    if ((uint32_t)a > m->peak) m->peak = (uint32_t)a;
+    m->sumsq += (uint64_t)((int32_t)x * x);
+    m->n++;
+}
+
+// RMS over the accumulated window (linear, 0..32767)
+uint16_t ncomm_meter_rms(const ncomm_meter_t* m);
+
+#ifdef __cplusplus
+}
+#endif
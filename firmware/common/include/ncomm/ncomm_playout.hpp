@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "ncomm/ncomm_spsc.hpp"
+
+namespace ncomm {
+
+// ===== Playout (MCU2 DAC output, one buffer per output channel) =====
+// Adaptive jitter buffer between the link (16 kHz chunks, pushed from the
+// main loop as frames are dispatched) and the DAC (blocks pulled by the
+// output DMA callback). Positions are output clock samples: the DAC sample
+// counter of the output engine, so latencies are exact in samples.
+//
+// Depth control: playback starts (prefill) once the buffer holds target()
+// samples beyond the block. An underrun (data resumes after a gap shorter
+// than idle_ms) raises the target by step_ms; a window of decay_ms without
+// underrun lowers it to what the window actually needed (never below
+// min_ms plus one block: the chunk / pull phase slides as the clocks drift),
+// and samples beyond target + block are dropped with a short cross-fade
+// (trimmed) once at least 1 ms is in excess.
+//
+// Concealment: on an underrun the last 10 ms of output are repeated with a
+// linear fade to silence over conceal_ms; playback resumes with a fade-in.
+// A gap longer than idle_ms is a stream stop (PTT / VAD off): silence and
+// prefill again, not an underrun.
+//
+// Latency: each pushed chunk is tagged with its arrival time; when its first
+// sample is pulled the arrival -> DAC delay is known (lat_*_us). Capture ->
+// DAC adds the MCU1 chunk (16 ms) and the link transfer, both constant.
+//
+// Clock drift (ASRC): MCU1 captures and the DAC plays on different crystals.
+// Chunks pushed with their source position (capture samples, from the link
+// frame_index) feed a drift fit: per block of PLAYOUT_FIT_CHUNKS chunks the
+// earliest arrival relative to the source position (lower envelope, link
+// delays only ever add), and a least-squares slope over the blocks with
+// forgetting (~32 s). The slope is the drift in ppm. pull() then reads the
+// ring at a fractional step of 1 / (1 + drift) per output sample through a
+// cubic Lagrange fractional-delay filter (Farrow form, 4 taps), plus a slow
+// correction that holds the mean chunk latency (depth free of the chunk /
+// block phase) where it settled after the last start / trim. The depth does
+// not walk, so it stays at the adapted minimum without periodic trims or
+// underruns. A jump of the arrival offset by more than 100 ms (stream stop,
+// stream config change) restarts the fit; the last estimate stays in use
+// meanwhile.
+//
+// Contexts: push() from one producer (main loop), pull() from one consumer
+// (output ISR); stats are written by pull() only, except overflow and
+// drift_ppb.
+
+static constexpr uint32_t PLAYOUT_RING = 4096;    // samples (256 ms), power of two
+static constexpr uint32_t PLAYOUT_PERIOD = 160;   // concealment repeat (10 ms)
+static constexpr uint32_t PLAYOUT_FADE = 32;      // fade-in / trim cross-fade (2 ms)
+static constexpr uint32_t PLAYOUT_MAX_BLOCK = 256;
+static constexpr uint32_t PLAYOUT_NO_SRC = 0xFFFFFFFFu; // push(): no source position
+static constexpr uint32_t PLAYOUT_FIT_CHUNKS = 32;      // drift fit block (~0.5 s of chunks)
+
+struct PlayoutConfig {
+  uint16_t min_ms = 2;      // target floor (spare beyond the block)
+  uint16_t max_ms = 96;     // target ceiling
+  uint16_t start_ms = 16;   // initial target
+  uint16_t step_ms = 8;     // raise per underrun
+  uint16_t decay_ms = 4000; // window without underrun before lowering
+  uint16_t idle_ms = 80;    // no data this long: stream stopped
+  uint16_t conceal_ms = 20; // fade of the repeated period
+  bool asrc = true;         // drift compensation (needs source positions)
+};
+
+class PlayoutBuffer {
+public:
+  void init(const PlayoutConfig& cfg = PlayoutConfig{});
+
+  // Producer: n samples at 16 kHz that arrived at output position now; src
+  // is the position of pcm[0] on the source (capture) clock, in samples, or
+  // PLAYOUT_NO_SRC. Samples that do not fit are dropped (overflow). False if
+  // any dropped.
+  bool push(const int16_t* pcm, uint32_t n, uint32_t now, uint32_t src = PLAYOUT_NO_SRC);
+
+  // Consumer: n <= PLAYOUT_MAX_BLOCK samples, out[0] reaches the DAC at pos.
+  void pull(int16_t* out, uint32_t n, uint32_t pos);
+
+  uint32_t depth() const { return wr_.load(std::memory_order_acquire) - rd_.load(std::memory_order_relaxed); }
+  uint32_t target() const { return target_; }
+  bool playing() const { return state_ == State::PLAY; }
+  // Source clock against the output clock, parts per billion (> 0: source
+  // faster); 0 until the first fit.
+  int32_t drift_ppb() const { return stats_.drift_ppb; }
+
+  struct Stats {
+    uint32_t pushed = 0;      // samples
+    uint32_t overflow = 0;    // samples dropped at push (producer)
+    uint32_t starts = 0;      // prefill completed
+    uint32_t stops = 0;       // stream stopped (gap > idle_ms)
+    uint32_t underruns = 0;   // gap < idle_ms, concealed
+    uint32_t concealed = 0;   // samples synthesised
+    uint32_t trimmed = 0;     // samples dropped to lower the depth
+    uint32_t trims = 0;       // trim events (cross-fades)
+    uint32_t lat_last_us = 0; // arrival -> DAC, last chunk
+    uint32_t lat_min_us = 0;
+    uint32_t lat_max_us = 0;
+    uint32_t lat_avg_us = 0;  // EMA (1/16)
+    uint32_t depth_max = 0;   // samples, at pull
+    int32_t drift_ppb = 0;    // drift estimate (producer)
+    int32_t ratio_ppb = 0;    // applied read rate - 1: drift + depth correction
+    uint32_t fits = 0;        // drift fit restarts
+  };
+  const Stats& stats() const { return stats_; }
+  void stats_reset();
+
+private:
+  enum class State : uint8_t { IDLE, PLAY, CONCEAL };
+  struct Tag {
+    uint32_t start; // ring index of the chunk's first sample
+    uint32_t arrival;
+  };
+
+  PlayoutConfig cfg_{};
+  int16_t ring_[PLAYOUT_RING];
+  std::atomic<uint32_t> wr_{0}; // producer
+  std::atomic<uint32_t> rd_{0}; // consumer
+  SpscQueue<Tag, 32> tags_;
+
+  State state_ = State::IDLE;
+  uint32_t target_ = 0;         // samples beyond the block
+  uint32_t gap_ = 0;            // samples concealed / silent since data ran out
+  uint32_t fade_in_ = 0;        // samples of fade-in left
+  uint32_t trim_ = 0;           // samples to drop at the next read
+  uint32_t win_ = 0;            // samples pulled in the decay window
+  uint32_t win_min_ = 0;        // min spare depth in the window
+  bool win_underrun_ = false;
+  int16_t hist_[PLAYOUT_PERIOD]; // last output period (concealment source)
+  uint32_t hist_at_ = 0;
+  uint64_t lat_ema_ = 0;        // us << 4
+
+  // ASRC (consumer): read position = rd_ + frac_ / 2^32
+  uint32_t frac_ = 0;
+  int32_t step_ = 0;            // Q32, read step - 1 (signed)
+  int32_t avg_ = -1;            // mean chunk latency, samples << 8, -1 = none yet
+  int32_t ref_ = -1;            // mean depth to hold (<< 8), -1 = not latched
+  uint32_t settle_ = 0;         // samples before ref_ is latched
+  std::atomic<int32_t> ff_{0};  // Q32 step from the drift estimate (producer)
+
+  // Drift fit (producer)
+  bool fit_on_ = false;
+  uint32_t src0_ = 0;
+  uint32_t at0_ = 0;
+  int32_t last_y_ = 0;          // arrival - source offset of the last chunk
+  uint32_t blk_n_ = 0;
+  int32_t blk_x_ = 0;
+  int32_t blk_y_ = 0;           // block minimum
+  uint32_t fit_blocks_ = 0;
+  double s0_ = 0, sx_ = 0, sy_ = 0, sxx_ = 0, sxy_ = 0;
+
+  Stats stats_{};
+
+  uint32_t read_(int16_t* out, uint32_t n, uint32_t* first);
+  void conceal_(int16_t* out, uint32_t n);
+  void remember_(const int16_t* out, uint32_t n);
+  void tag_latency_(uint32_t rd, uint32_t n, uint32_t pos);
+  void adapt_(uint32_t spare, uint32_t n);
+  void fit_(uint32_t src, uint32_t at);
+  void fit_reset_(uint32_t src, uint32_t at);
+  void servo_(uint32_t n);
+  int16_t tap_(uint32_t rd, uint32_t frac) const;
+};
+
+// Stereo 16-bit samples into 32-bit I2S slots (Philips, MSB first): left
+// then right, sample in the upper half.
+void playout_pack_i2s32(const int16_t* left, const int16_t* right, uint32_t* out, uint32_t n);
+
+} // namespace ncomm
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__arm__) && !defined(NCOMM_HOST)
+#include "stm32h7xx.h"
+#else
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===== Cycle clock =====
+// One free-running timestamp for the profiler, the scheduler, telemetry and
+// benches: DWT->CYCCNT at SystemCoreClock on the target, monotonic ns on the
+// host. 32-bit, wraps: subtract as uint32_t, accumulate in 64 bits.
+//
+// ncomm_cycles_init() enables the counter and is called once from main().
+// Library code only reads it (reads 0 deltas if nobody enabled it).
+
+static inline void ncomm_cycles_init(void) {
+#if defined(__arm__) && !defined(NCOMM_HOST)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static inline uint32_t ncomm_cycles_now(void) {
+#if defined(__arm__) && !defined(NCOMM_HOST)
+    return DWT->CYCCNT;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+static inline uint64_t ncomm_cycles_to_ns(uint64_t cycles) {
+#if defined(__arm__) && !defined(NCOMM_HOST)
+    return cycles * 1000u / (SystemCoreClock / 1000000u);
+#else
+    return cycles;
+#endif
+}
+
+static inline uint32_t ncomm_cycles_to_us(uint32_t cycles) {
+#if defined(__arm__) && !defined(NCOMM_HOST)
+    return cycles / (SystemCoreClock / 1000000u);
+#else
+    return cycles / 1000u;
+#endif
+}
+
+// ===== Scoped-zone cycle profiler (DWT->CYCCNT) =====
+// Build with -DNCOMM_PROFILE to enable. Without it every macro below expands to
+// nothing and ProfileScope is not instantiated: zero code, zero RAM.
+//
+// Per zone and per report window: count, min, avg, max and p99. p99 comes from a
+// log histogram with 4 buckets per octave and is reported as the bucket upper
+// bound, so it may read up to 25% high.
+//
+//   C:    NCOMM_PROF_BEGIN(NCOMM_PZ_VAD); ... NCOMM_PROF_END(NCOMM_PZ_VAD);
+//   C++:  { NCOMM_PROF_SCOPE(NCOMM_PZ_KWS); ... }
+
+// Fixed zone table, shared by both MCUs so desktop tooling decodes one id space.
+// TIMER_A / TIMER_B follow the desktop requirements (section 3.6).
+typedef enum {
+    NCOMM_PZ_VAD      = 0, // MCU1 TIMER_A: VAD decision per chunk
+    NCOMM_PZ_VE       = 1, // MCU1 TIMER_B: capture conditioning / VE per chunk
+    NCOMM_PZ_KWS      = 2, // MCU2 TIMER_A
+    NCOMM_PZ_SR       = 3, // MCU2 TIMER_B
+    NCOMM_PZ_PLAYOUT  = 4, // I2S period render (ISR)
+    NCOMM_PZ_RESAMPLE = 5, // stream rate conversion per chunk
+    NCOMM_PZ_PARSER   = 6, // link frame parse + dispatch
+    NCOMM_PZ_COUNT
+} ncomm_prof_zone_t;
+
+#define NCOMM_PROF_HIST_BUCKETS 96 // exact below 8, then 4 per octave up to 2^25 cycles
+
+// ===== EVT_PROFILE (0xA4) payload =====
+//   ver(1)=1, zone_count(1), window_ms(2 LE), core_mhz(2 LE), reserved(2)
+//   then zone_count records of NCOMM_PROF_REC_SIZE bytes:
+//   zone(1), reserved(1), count(2 LE, saturating), min, avg, max, p99 (4 LE each, cycles)
+#define NCOMM_PROF_VER       1
+#define NCOMM_PROF_HDR_SIZE  8
+#define NCOMM_PROF_REC_SIZE  20
+#define NCOMM_PROF_MAX_PAYLOAD (NCOMM_PROF_HDR_SIZE + NCOMM_PZ_COUNT * NCOMM_PROF_REC_SIZE)
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t avg;
+    uint32_t max;
+    uint32_t p99;
+} ncomm_prof_rec_t;
+
+const char* ncomm_prof_zone_name(uint8_t zone);
+
+#if defined(NCOMM_PROFILE)
+
+static inline uint32_t ncomm_prof_now(void) {
+    return ncomm_cycles_now();
+}
+
+// Clear the table (the counter itself is ncomm_cycles_init(), from main).
+void ncomm_prof_init(void);
+
+// ISR-safe (short critical section).
+void ncomm_prof_record(uint8_t zone, uint32_t cycles);
+
+// Read one zone of the current window (count == 0 if idle). Does not reset.
+void ncomm_prof_get(uint8_t zone, ncomm_prof_rec_t* out);
+
+// Start a new window for all zones.
+void ncomm_prof_reset(void);
+
+// Close the current window for all zones, serialise active zones as an
+// EVT_PROFILE payload and reset. Returns payload length (0 if cap too small).
+uint16_t ncomm_prof_snapshot(uint8_t* payload, uint16_t cap, uint16_t window_ms);
+
+#define NCOMM_PROF_BEGIN(z) const uint32_t ncomm_prof_t0_##z = ncomm_prof_now()
+#define NCOMM_PROF_END(z)   ncomm_prof_record((z), ncomm_prof_now() - ncomm_prof_t0_##z)
+
+#else
+
+#define NCOMM_PROF_BEGIN(z) do { } while (0)
+#define NCOMM_PROF_END(z)   do { } while (0)
+
+#endif
+
+#ifdef __cplusplus
+}
+
+#if defined(NCOMM_PROFILE)
+namespace ncomm {
+
+class ProfileScope {
+ public:
+  explicit ProfileScope(ncomm_prof_zone_t zone) : zone_(zone), t0_(ncomm_prof_now()) {}
+  ~ProfileScope() { ncomm_prof_record(zone_, ncomm_prof_now() - t0_); }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  ncomm_prof_zone_t zone_;
+  uint32_t t0_;
+};
+
+} // namespace ncomm
+
+#define NCOMM_PROF_SCOPE(z) ::ncomm::ProfileScope ncomm_prof_scope_##z(z)
+#else
+#define NCOMM_PROF_SCOPE(z) do { } while (0)
+#endif
+
+#endif
@@ -7,13 +7,15 @@ namespace ncomm {
 
 // ===== UART Protocol v1.4.0 framing =====
 // SOF: 0xAA 0x55
-// Header: msg_type (1), msg_id (1), payload_len (uint16 LE)
+// Header: VER (1), TYPE (1), FLAGS (1), SEQ (1), LEN (uint16 LE)
 // CRC16: CRC16-CCITT-FALSE over header+payload (poly 0x1021, init 0xFFFF), LE in frame
 
 static constexpr uint8_t SOF0 = 0xAA;
 static constexpr uint8_t SOF1 = 0x55;
 
-static constexpr size_t HEADER_SIZE = 4;
+static constexpr uint8_t PROTO_VER = 0x01;
+
+static constexpr size_t HEADER_SIZE = 6;
 static constexpr size_t CRC_SIZE = 2;
 
 static constexpr uint16_t CRC16_INIT = 0xFFFF;
@@ -24,22 +26,68 @@ static constexpr size_t MAX_PAYLOAD = 576;
 
 // ---- Message types (subset for MVP-0) ----
 enum class MsgType : uint8_t {
-  CMD_PING          = 0x10,
-  CMD_RESET         = 0x11,
-  CMD_SET_MODE      = 0x12,
+  CMD_PING          = 0x01,
+  CMD_GET_INFO      = 0x02,
+  CMD_SET_MODE      = 0x10,
+  CMD_SET_STREAMS   = 0x11,
+  CMD_RESET         = 0x12,
   CMD_SET_VAD_CFG   = 0x13,
-  CMD_SET_STREAMS   = 0x14,
 
   EVT_PONG          = 0x80,
-  EVT_RESET_ACK     = 0x85,
-  EVT_VAD           = 0x84,
+  EVT_INFO          = 0x81,
   EVT_MODE_ACK      = 0x82,
   EVT_STREAMS_ACK   = 0x83,
+  EVT_VAD           = 0x84,
+  EVT_RESET_ACK     = 0x85,
   EVT_VAD_CFG_ACK   = 0x86,
   EVT_ERROR         = 0x87,
 
   EVT_RX_AUDIO_FRAME = 0x90,
   EVT_TX_AUDIO_FRAME = 0x91,
+
+  // Debug telemetry (0xA2..0xAF)
+  EVT_VAD_MAP       = 0xA2,
+  EVT_AUDIO_LEVELS  = 0xA3,
+  EVT_PROFILE       = 0xA4,
+};
+
+// ---- Audio frame payload (as sent by MCU1) ----
+// stream_id(1), channels(1), samples(2 LE), frame_index(4 LE), PCM16LE[samples]
+// samples is per 16 ms chunk at the stream rate (256/192/128 for 16/12/8 kHz).
+static constexpr size_t AUDIO_HDR_SIZE = 8;
+
+// ---- EVT_VAD_MAP payload (28 bytes) ----
+// chunk_index(4) vad_map(8) state_map(8) preroll_fill(1) preroll_cap(1)
+// start_age(1) stop_age(1) true_run(1) false_run(1) flags(1) reserved(1)
+// Maps: bit0 = chunk_index, bit k = chunk_index - k. Ages: 0xFF = outside the map.
+static constexpr size_t VAD_MAP_SIZE = 28;
+
+struct VadMap {
+  uint32_t chunk_index = 0;
+  uint64_t vad_map = 0;
+  uint64_t state_map = 0;
+  uint8_t preroll_fill = 0;
+  uint8_t preroll_cap = 0;
+  uint8_t start_age = 0xFF;
+  uint8_t stop_age = 0xFF;
+  uint8_t true_run = 0;
+  uint8_t false_run = 0;
+  uint8_t flags = 0; // bit0 = VAD state, bit1 = sent on change, bit2 = periodic
+};
+
+// ---- EVT_AUDIO_LEVELS payload (24 bytes) ----
+// chunk_index(4) window_chunks(1) flags(1) reserved(2)
+// then peak(2 LE) rms(2 LE) for In1, In2, Out1 (radio), Out2 (headset); linear int16 magnitude
+static constexpr size_t AUDIO_LEVELS_SIZE = 24;
+
+enum LevelPort : uint8_t { LEVEL_IN1 = 0, LEVEL_IN2 = 1, LEVEL_OUT1 = 2, LEVEL_OUT2 = 3, LEVEL_PORTS = 4 };
+
+struct AudioLevels {
+  uint32_t chunk_index = 0;
+  uint8_t window_chunks = 0;
+  uint8_t flags = 0; // bit0 = In2 noise gate closed, bit1 = In2 not captured (silence)
+  uint16_t peak[LEVEL_PORTS]{};
+  uint16_t rms[LEVEL_PORTS]{};
 };
 
 // ---- Mode / Stream enums ----
@@ -58,25 +106,32 @@ enum class Ptt : uint8_t {
 enum class StreamSelect : uint8_t {
   STREAM_MIC_RAW = 1, // MIC -> TX_AUDIO_OUT direction
   STREAM_RX_RAW  = 2, // RX_RADIO_IN -> RX_STREAM_OUT direction
+  STREAM_RX_MIC  = 3, // STANDBY: RX_STREAM_OUT monitoring + MIC for KWS (spec 8.3 example)
 };
 
 // ---- CRC16-CCITT-FALSE ----
+// Byte step, for parsers that checksum on the fly (start from CRC16_INIT)
+inline uint16_t crc16_ccitt_false_update(uint16_t crc, uint8_t byte) {
+  crc ^= (uint16_t)byte << 8;
+  for (int b = 0; b < 8; b++) {
+    crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_POLY) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
 inline uint16_t crc16_ccitt_false(const uint8_t* data, size_t len) {
   uint16_t crc = CRC16_INIT;
-  for (size_t i = 0; i < len; i++) {
-    crc ^= (uint16_t)data[i] << 8;
-    for (int b = 0; b < 8; b++) {
-      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_POLY) : (uint16_t)(crc << 1);
-    }
-  }
+  for (size_t i = 0; i < len; i++) crc = crc16_ccitt_false_update(crc, data[i]);
   return crc;
 }
 
 // ---- Frame builder helper ----
 struct Frame {
   uint8_t  sof[2] = {SOF0, SOF1};
+  uint8_t  ver      = PROTO_VER;
   uint8_t  msg_type = 0;
-  uint8_t  msg_id   = 0;
+  uint8_t  flags    = 0;
+  uint8_t  msg_id   = 0; // SEQ
   uint16_t payload_len = 0; // LE on wire
   // payload follows
   // crc follows (LE)
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===== Per-stream sample rate (CMD_SET_STREAMS rx_rate / tx_rate) =====
+// 0 keeps the v1.4.0 default so older MCU2 builds (reserved = 0) still get 16 kHz.
+typedef enum {
+    NCOMM_RATE_16K = 0,
+    NCOMM_RATE_8K  = 1,
+    NCOMM_RATE_12K = 2,
+} ncomm_rate_t;
+
+static inline uint16_t ncomm_rate_hz(uint8_t rate) {
+    switch (rate) {
+        case NCOMM_RATE_8K:  return 8000;
+        case NCOMM_RATE_12K: return 12000;
+        default:             return 16000;
+    }
+}
+
+// Samples per 16 ms chunk at the given rate: 256 / 192 / 128
+static inline uint16_t ncomm_rate_chunk_samples(uint8_t rate) {
+    return (uint16_t)(ncomm_rate_hz(rate) / 1000u * 16u);
+}
+
+// ===== Rational polyphase FIR resampler (L/M), int16 in/out =====
+// Prototype: Blackman windowed sinc of L*taps coefficients, cutoff at 0.9 of
+// the lower Nyquist, split into L branches (Q15). Output n uses branch
+// (n*M) mod L, so only non-zero products are computed.
+//
+//   MCU1 decimators:   16k -> 8k  (L=1, M=2),  16k -> 12k (L=3, M=4)
+//   MCU2 interpolators: 8k -> 16k (L=2, M=1),  12k -> 16k (L=4, M=3)
+//
+// Analytic estimate, not measured: NCOMM_RS_TAPS MACs per output sample
+// (2 per SMLAD on M7), i.e. 16k->8k: 128 kMAC/s, 16k->12k: 192 kMAC/s,
+// 8k/12k->16k: 256 kMAC/s. The measured cost is profile zone
+// NCOMM_PZ_RESAMPLE (MCU1 EVT_PROFILE, MCU2 profiler) on a NCOMM_PROFILE build.
+
+#define NCOMM_RS_TAPS  16 // taps per polyphase branch (even: SMLAD pairs)
+#define NCOMM_RS_MAX_L 4
+
+typedef struct {
+    uint8_t L;
+    uint8_t M;
+    uint8_t phase;      // current branch, >= L means "need next input"
+    uint8_t hist_pos;
+    int16_t coef[NCOMM_RS_MAX_L][NCOMM_RS_TAPS] __attribute__((aligned(4)));
+    // Delay line stored twice so hist[pos .. pos+TAPS-1] is always contiguous,
+    // newest sample first.
+    int16_t hist[2 * NCOMM_RS_TAPS] __attribute__((aligned(4)));
+} ncomm_resampler_t;
+
+// Returns false for unsupported ratios (L > NCOMM_RS_MAX_L, L or M == 0).
+bool ncomm_resampler_init(ncomm_resampler_t* rs, uint8_t L, uint8_t M);
+void ncomm_resampler_reset(ncomm_resampler_t* rs);
+
+// MCU1 side: 16 kHz -> rate. MCU2 side: rate -> 16 kHz. 16 kHz is L=M=1.
+bool ncomm_resampler_init_decim(ncomm_resampler_t* rs, uint8_t rate);
+bool ncomm_resampler_init_interp(ncomm_resampler_t* rs, uint8_t rate);
+
+static inline bool ncomm_resampler_is_bypass(const ncomm_resampler_t* rs) {
+    return rs->L == rs->M;
+}
+
+// Consume n_in samples, write at most out_cap samples. Returns samples written.
+// A 16 ms chunk always maps to a whole chunk at the other rate.
+uint16_t ncomm_resampler_process(ncomm_resampler_t* rs, const int16_t* in, uint16_t n_in,
+                                 int16_t* out, uint16_t out_cap);
+
+#ifdef __cplusplus
+}
+#endif
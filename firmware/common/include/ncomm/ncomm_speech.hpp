@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ncomm {
+
+// ===== Rolling speech buffer (MCU2), native int16 =====
+// Last ~2 s of the 16 kHz KWS/SR input as received (PCM16), addressed by an
+// absolute sample position that only grows (uint32, wraps after ~74 h; all
+// arithmetic is modular). Consumers convert while they read:
+//   read_float()    -> float run, for engines that take float input
+//   read_windowed() -> float run multiplied by an analysis window, the input
+//                      stage of the mel front end (one pass, no float copy)
+// int16 -> float is exact for every sample value, so converting on read gives
+// bit-identical floats to converting on receipt; only the storage halves.
+//
+// Storage is external (AXI SRAM on MCU2), capacity a power of two.
+// Single context (main loop).
+
+static constexpr uint32_t SPEECH_RING_SAMPLES = 32768; // 2.048 s, 64 KB
+
+struct SpeechSpan {
+  const int16_t* seg[2]{};
+  uint32_t len[2]{};
+  uint32_t total() const { return len[0] + len[1]; }
+};
+
+class SpeechRing {
+public:
+  // capacity must be a power of two
+  void init(int16_t* storage, uint32_t capacity);
+  void reset();
+
+  void write(const int16_t* pcm, uint32_t n);
+
+  // Positions [oldest(), head()) are readable.
+  uint32_t head() const { return head_; }
+  uint32_t oldest() const { return (filled_ < cap_) ? head_ - filled_ : head_ - cap_; }
+  uint32_t available(uint32_t pos) const;
+  uint32_t capacity() const { return cap_; }
+
+  // Up to n samples from pos as at most two contiguous spans (clipped to what
+  // is still buffered). Spans stay valid until the next write().
+  SpeechSpan span(uint32_t pos, uint32_t n) const;
+
+  // Copy out; return samples produced (0 if pos is no longer buffered).
+  uint32_t read(uint32_t pos, int16_t* out, uint32_t n) const;
+  uint32_t read_float(uint32_t pos, float* out, uint32_t n, float scale = 1.0f) const;
+  uint32_t read_windowed(uint32_t pos, const float* window, float* out, uint32_t n,
+                         float scale = 1.0f) const;
+
+private:
+  int16_t* buf_ = nullptr;
+  uint32_t cap_ = 0;
+  uint32_t mask_ = 0;
+  uint32_t head_ = 0;   // absolute position of the next sample written
+  uint32_t filled_ = 0; // saturates at cap_
+};
+
+// ===== Looped view (SR scenarios B / C, spec 6.5.3) =====
+// The period [pos, pos + period) of a ring repeated to `length` samples:
+// view sample i is ring[pos + i % period]. Stands in for the looping copy
+// into an encoder-sized voice buffer; readers take it as contiguous runs
+// straight from the ring. Valid while the period is still buffered.
+class LoopedSpan {
+public:
+  LoopedSpan() = default;
+  LoopedSpan(const SpeechRing& ring, uint32_t pos, uint32_t period, uint32_t length)
+      : ring_(&ring), pos_(pos), period_(period), len_(period ? length : 0) {}
+
+  uint32_t length() const { return len_; }
+  uint32_t period() const { return period_; }
+  uint32_t pos() const { return pos_; }
+  bool valid() const { return ring_ && period_ && ring_->available(pos_) >= period_; }
+
+  // Longest contiguous run of at most n samples from view sample i: *p
+  // points into the ring. 0 past the end or if the audio is gone.
+  uint32_t run(uint32_t i, uint32_t n, const int16_t** p) const;
+  // Copy out (tests / engines that need a buffer); returns samples produced.
+  uint32_t read(uint32_t i, int16_t* out, uint32_t n) const;
+
+private:
+  const SpeechRing* ring_ = nullptr;
+  uint32_t pos_ = 0;
+  uint32_t period_ = 0;
+  uint32_t len_ = 0;
+};
+
+} // namespace ncomm
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ncomm {
+
+// ===== Lock-free single-producer / single-consumer ring =====
+// One producer context (typically an ISR) and one consumer context (main
+// loop); no critical sections. Indices run free (uint32 wrap) and the slot is
+// index & (N - 1), so all N slots are usable.
+//
+// Ordering: the producer fills a slot, then publishes it with a release store
+// of tail_; the consumer reads tail_ with acquire before touching the slot,
+// and hands it back with a release store of head_, which the producer reads
+// with acquire before reusing it. On Cortex-M7 each acquire/release is a
+// plain LDR/STR plus DMB, which also orders the slot writes against the
+// M7 write buffer. Single core only (no cache maintenance on the slots).
+//
+// In-place use avoids a copy for large entries:
+//   producer:  if (T* s = q.claim()) { fill(*s); q.publish(); }
+//   consumer:  while (T* s = q.front()) { use(*s); q.pop(); }
+template <typename T, uint32_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue depth must be a power of two");
+  static_assert(std::atomic<uint32_t>::is_always_lock_free, "SpscQueue needs lock-free 32-bit atomics");
+
+public:
+  static constexpr uint32_t capacity() { return N; }
+
+  // ---- producer ----
+
+  // Free slot to fill in place, nullptr when full (counted as a drop).
+  T* claim() {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= N) {
+      drops_.store(drops_.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &buf_[tail & (N - 1u)];
+  }
+
+  // Make the slot returned by claim() visible to the consumer.
+  void publish() {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed) + 1u;
+    tail_.store(tail, std::memory_order_release);
+
+    const uint32_t used = tail - head_.load(std::memory_order_relaxed);
+    if (used > high_water_.load(std::memory_order_relaxed)) {
+      high_water_.store(used, std::memory_order_relaxed);
+    }
+  }
+
+  bool push(const T& v) {
+    T* s = claim();
+    if (!s) return false;
+    *s = v;
+    publish();
+    return true;
+  }
+
+  // ---- consumer ----
+
+  // Oldest published entry, nullptr when empty. Valid until pop().
+  T* front() {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+    return &buf_[head & (N - 1u)];
+  }
+
+  void pop() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+  }
+
+  bool pop(T* out) {
+    T* s = front();
+    if (!s) return false;
+    if (out) *out = *s;
+    pop();
+    return true;
+  }
+
+  // ---- either side (snapshot) ----
+  uint32_t size() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+
+  uint32_t high_water() const { return high_water_.load(std::memory_order_relaxed); }
+  uint32_t drops() const { return drops_.load(std::memory_order_relaxed); }
+
+  // Consumer side; a concurrent producer update may survive the reset.
+  void reset_stats() {
+    high_water_.store(size(), std::memory_order_relaxed);
+    drops_.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<uint32_t> head_{0};       // written by the consumer
+  std::atomic<uint32_t> tail_{0};       // written by the producer
+  std::atomic<uint32_t> high_water_{0}; // producer
+  std::atomic<uint32_t> drops_{0};      // producer
+  T buf_[N]{};
+};
+
+} // namespace ncomm
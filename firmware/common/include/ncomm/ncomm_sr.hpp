@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ncomm/ncomm_voiceid.hpp"
+#include "ncomm/ncomm_store.hpp"
+
+namespace ncomm {
+
+// ===== SR scoring (MCU2) =====
+// Predictor of spec 6.5.6 for 1:N identification: one query embedding is
+// scored against every enrolled template in one pass and the best voices are
+// returned with their Weibull-calibrated distance.
+
+static constexpr uint16_t SR_EMB_DIM = VOICEID_EMB_DIM;
+static constexpr uint16_t SR_MAX_TEMPLATES = 256; // MCU2 index capacity (64 KB Q15)
+static constexpr uint8_t SR_TOPK_MAX = 8;
+static constexpr int16_t SR_NO_VOICE = -1;
+
+// ---- Weibull calibration of cosine distance ----
+// CDF(d) = 1 - exp(-(d / scale)^shape), fitted per voice on the distances of
+// its enrollment embeddings to the centroid. shape = 0: not fitted, CDF 0.
+struct SrWeibull {
+  float shape = 0.0f;
+  float scale = 0.0f;
+};
+
+float sr_weibull_cdf(const SrWeibull& w, float distance);
+
+// Maximum-likelihood fit (shape by bisection on the score equation). Needs
+// n >= 2 distances > 0 that are not all equal; false leaves *out unfitted.
+bool sr_weibull_fit(const float* distance, uint32_t n, SrWeibull* out);
+
+// ---- Template index ----
+// Pre-normalised templates as Q15 rows (unit length -> |x| < 1); one query
+// streams over all of them. For unit vectors every partial dot product is
+// bounded by 2^30 (Cauchy-Schwarz), so the int32 accumulator never
+// overflows; cos = acc / 32767^2. On the M7 the dot product is SMLAD on
+// halfword pairs, two templates per pass sharing the query loads.
+// Rows are either owned (add(): external [capacity][SR_EMB_DIM] storage,
+// AXI SRAM on MCU2) or referenced in place (add_ref(): e.g. a record in
+// flash); the scan goes through a row pointer table. Single context.
+
+struct SrMatch {
+  uint16_t slot = 0;
+  int16_t voice_id = SR_NO_VOICE;
+  float cos = 0.0f;
+  float distance = 1.0f; // 1 - cos
+  float cdf = 0.0f;      // Weibull of the voice (0 if not fitted)
+};
+
+// Best k (<= SR_TOPK_MAX) voices by score, keeping the best template of each
+// voice, best first. Template indexes feed it one score per slot.
+class SrTopK {
+public:
+  explicit SrTopK(uint8_t k) : k_(k > SR_TOPK_MAX ? SR_TOPK_MAX : k) {}
+
+  void offer(uint16_t slot, uint8_t voice_id, int32_t score);
+
+  uint8_t size() const { return n_; }
+  uint16_t slot(uint8_t j) const { return slot_[j]; }
+  uint8_t voice(uint8_t j) const { return voice_[j]; }
+  int32_t score(uint8_t j) const { return score_[j]; }
+
+private:
+  uint8_t k_;
+  uint8_t n_ = 0;
+  int32_t score_[SR_TOPK_MAX];
+  uint16_t slot_[SR_TOPK_MAX];
+  uint8_t voice_[SR_TOPK_MAX];
+};
+
+class EmbeddingIndex {
+public:
+  void init(int16_t* rows, uint8_t* voice, uint16_t capacity);
+  void clear() { size_ = 0; }
+
+  // L2-normalises and stores emb; returns the slot or -1 when full / zero.
+  int32_t add(const float* emb, uint8_t voice_id);
+  // Links a Q15 unit row used in place (not copied); it must stay valid
+  // while the slot exists. Returns the slot or -1 when full.
+  int32_t add_ref(const int16_t* row, uint8_t voice_id);
+  // Removes every template of a voice (order of the rest is kept).
+  uint16_t remove_voice(uint8_t voice_id);
+
+  uint16_t size() const { return size_; }
+  uint16_t capacity() const { return cap_; }
+  const int16_t* row(uint16_t slot) const { return rowp_[slot]; }
+  uint8_t voice(uint16_t slot) const { return voice_[slot]; }
+
+  // Normalise + quantise a query; false for a zero vector.
+  static bool quantize(const float* emb, int16_t* q);
+
+  // acc[i] = q . row(i), i < size() (cos = acc / 32767^2)
+  void score_all(const int16_t* q, int32_t* acc) const;
+
+  // Best k (<= SR_TOPK_MAX) voices, best template per voice, best first.
+  // Fills cos / distance / slot / voice_id; returns how many.
+  uint8_t top_k(const int16_t* q, uint8_t k, SrMatch* out) const;
+
+private:
+  int16_t* rows_ = nullptr; // owned rows: slot i at rows_[i * SR_EMB_DIM]
+  uint8_t* voice_ = nullptr;
+  uint16_t cap_ = 0;
+  uint16_t size_ = 0;
+  const int16_t* rowp_[SR_MAX_TEMPLATES];
+
+  int16_t* own_(uint16_t slot) const { return rows_ ? &rows_[(uint32_t)slot * SR_EMB_DIM] : nullptr; }
+};
+
+// ---- Enrollment (spec 6.5.7) ----
+// centroid = L2-normalised mean of the L2-normalised embeddings (n x SR_EMB_DIM);
+// false if any of them is zero.
+bool sr_enroll_centroid(const float* emb, uint32_t n, float* centroid);
+// Weibull fit on the distances of (up to 32) embeddings to a centroid as the
+// index scores it (1 - e . c for unit e);
+// unfitted for a single / identical utterance.
+void sr_enroll_weibull(const float* emb, uint32_t n, const float* centroid, SrWeibull* w);
+
+// ---- Stored voices (enrollment store records) ----
+// Format-tagged record of one voice, written by SrClassifier::save_voice()
+// and attached with attach_voice(): [SrVoiceRecord][data], data = Q15 row
+// (int16_t[SR_EMB_DIM], used in place) or PQ code (copied).
+static constexpr uint8_t SR_REC_Q15 = 1;
+static constexpr uint8_t SR_REC_PQ = 2;
+
+struct SrVoiceRecord {
+  uint8_t format;
+  uint8_t voice_id;
+  uint16_t bytes; // data bytes after the header
+  SrWeibull w;
+};
+static constexpr uint16_t SR_REC_MAX = (uint16_t)(sizeof(SrVoiceRecord) + SR_EMB_DIM * sizeof(int16_t));
+static_assert(sizeof(SrVoiceRecord) % 4 == 0, "keeps the Q15 row word aligned in a record");
+
+// ---- Classifier interface (spec 6.5.6: replaceable) ----
+
+struct SrParams {
+  float d_t = 0.47f;  // cosine distance threshold
+  float cdf_t = 1.0f; // Weibull CDF threshold (1.0 = off)
+};
+
+struct SrDecision {
+  bool is_known = false;
+  int16_t voice_id = SR_NO_VOICE;
+  float distance = 1.0f;
+  float cdf = 0.0f;
+};
+
+class SrClassifier {
+public:
+  virtual void reset() = 0; // forget every voice
+
+  // Enrollment: n embeddings (n x SR_EMB_DIM floats) of one voice.
+  virtual bool add_voice(const float* emb, uint32_t n, uint8_t voice_id) = 0;
+  // Restore a stored voice (centroid + calibration), e.g. from flash.
+  virtual bool load_voice(const float* centroid, const SrWeibull& w, uint8_t voice_id) = 0;
+
+  virtual SrDecision classify(const float* emb) = 0;
+
+  // Persistence: serialise a voice into rec (SR_REC_MAX bytes); returns the
+  // record length, 0 if the voice is unknown. attach_voice() may use rec in
+  // place: it must stay valid while the voice is loaded (re-attach when the
+  // store moves records, RecordStore::generation()).
+  virtual uint16_t save_voice(uint8_t voice_id, uint8_t* rec) const = 0;
+  virtual bool attach_voice(const uint8_t* rec, uint16_t len) = 0;
+
+  // Cosine distance threshold of is_known (SR_THRESHOLD)
+  virtual float threshold() const = 0;
+  virtual const char* name() const = 0;
+
+protected:
+  ~SrClassifier() = default; // statically allocated classifiers only
+};
+
+// Baseline: cosine against voice centroids + Weibull (spec 6.5.6), on the
+// Q15 index. add_voice() stores the L2-normalised mean and fits the Weibull
+// on the enrollment distances; top_k() serves 1:N identification.
+class CosineWeibullClassifier final : public SrClassifier {
+public:
+  void init(int16_t* rows, uint8_t* voice, uint16_t capacity, const SrParams& params = SrParams{});
+
+  void reset() override;
+  bool add_voice(const float* emb, uint32_t n, uint8_t voice_id) override;
+  bool load_voice(const float* centroid, const SrWeibull& w, uint8_t voice_id) override;
+  SrDecision classify(const float* emb) override;
+  uint16_t save_voice(uint8_t voice_id, uint8_t* rec) const override;
+  bool attach_voice(const uint8_t* rec, uint16_t len) override;
+  float threshold() const override { return params_.d_t; }
+  const char* name() const override { return "cosine+weibull"; }
+
+  // Best k voices with Weibull CDF filled in; returns how many.
+  uint8_t top_k(const float* emb, uint8_t k, SrMatch* out);
+
+  const EmbeddingIndex& index() const { return index_; }
+  const SrWeibull& weibull(uint8_t voice_id) const { return weibull_[voice_id]; }
+  SrParams& params() { return params_; }
+
+private:
+  SrParams params_{};
+  EmbeddingIndex index_;
+  SrWeibull weibull_[256];
+  int16_t query_[SR_EMB_DIM];
+};
+
+// Enrollment store glue: voice_id is the record key.
+bool sr_store_voice(RecordStore& store, const SrClassifier& cls, uint8_t voice_id);
+// Resets cls and attaches every stored voice (in place); returns how many.
+uint16_t sr_restore_voices(const RecordStore& store, SrClassifier& cls);
+
+} // namespace ncomm
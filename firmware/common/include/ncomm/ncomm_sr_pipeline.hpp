@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ncomm/ncomm_mel.hpp"
+#include "ncomm/ncomm_sr.hpp"
+#include "ncomm/ncomm_voiceid.hpp"
+
+namespace ncomm {
+
+// ===== SR decision (MCU2, spec 6.5.3 / 6.5.9) =====
+// KWS command segment -> packets (mel_sr_packets: scenario A / B / C) ->
+// log-mel frames of each packet (MelStream::looped: streamed frames plus the
+// ones running into the loop, read through the LoopedSpan, no voice buffer)
+// -> mel_cmvn -> encoder -> classifier. Scenario C encodes both packets and
+// combines them (SrCombine), unless the early-exit policy decides on packet
+// 1 alone (SrEarlyExit).
+//
+// Speculation: while KWS is still deciding (KwsEngine::pending()), packets of
+// the provisional segment whose span can no longer change are encoded ahead
+// (speculate()), one encoder pass per call. verify() takes an embedding from
+// that cache when the final packet has the same start and period (same
+// frames, so the same embedding bit for bit) and encodes the rest; cancel()
+// drops the cache when the candidate goes away without a command.
+// Single context (main loop); shares the MelFrontEnd with the MelStream.
+
+enum class SrCombine : uint8_t {
+  MEAN, // classify the normalised mean of both embeddings
+  BEST, // the packet with the smaller distance
+  BOTH, // known only if both packets are known as the same voice
+};
+
+// Scenario C early exit: decide on packet 1 when its distance is outside
+// [threshold - band, threshold + band] (threshold = SrClassifier::threshold(),
+// SR_THRESHOLD): clearly known -> accept, clearly far -> reject, without the
+// second encoder pass. Inside the band both packets are combined as usual.
+struct SrEarlyExit {
+  bool enabled = false;
+  float band = 0.20f; // cosine distance (test/test_sr_pipeline.cpp)
+};
+
+// True if packet 1's decision d stands on its own under policy p.
+bool sr_exit_early(const SrEarlyExit& p, float threshold, const SrDecision& d);
+
+// Scenario C decision from both packets (d1 = classify(emb1)); emb1 is used
+// as scratch.
+SrDecision sr_combine(SrClassifier& cls, SrCombine c, float* emb1, const float* emb2, const SrDecision& d1);
+
+struct SrResult {
+  SrDecision decision;
+  uint8_t packets = 0;     // 0: scenario A (too short) or nothing to run
+  uint8_t encoded = 0;     // packets through the encoder (1 after an early exit)
+  uint8_t speculated = 0;  // packets taken from the speculative cache instead
+  bool early_exit = false;
+  uint8_t mel_frames = 0;  // over all encoded packets
+  uint8_t mel_hits = 0;    // of those, taken from the stream cache
+  uint32_t us = 0;         // verify() time
+};
+
+static constexpr uint8_t SR_SPEC_SLOTS = 3; // scenario B or C packets of one segment + 1
+
+class SrPipeline {
+public:
+  void init(MelStream* mel, VoiceIdEncoder* enc, SrClassifier* cls);
+
+  // Verifies [pos, pos + n) of ring. False if no packet ran to the end
+  // (scenario A, audio gone, no model): out->decision is then unknown.
+  bool verify(const SpeechRing& ring, uint32_t pos, uint32_t n, SrResult* out);
+
+  // Provisional segment [pos, pos + n) of a command still being decided;
+  // ended: speech stopped at pos + n (KwsPending::ended), so looped packets
+  // are final unless it resumes. Encodes at most one final packet not cached
+  // yet; returns the packets encoded (0 / 1).
+  uint8_t speculate(const SpeechRing& ring, uint32_t pos, uint32_t n, bool ended);
+  // No command: drops the speculative embeddings.
+  void cancel();
+
+  SrCombine& combine() { return combine_; }
+  SrEarlyExit& early_exit() { return exit_; }
+  uint32_t ram_bytes() const { return (uint32_t)sizeof(*this); }
+
+  struct Stats {
+    uint32_t runs = 0;
+    uint32_t too_short = 0;   // scenario A
+    uint32_t two_packets = 0; // scenario C
+    uint32_t failed = 0;      // audio gone / no model
+    uint32_t known = 0;
+    uint32_t early_accept = 0; // scenario C decided on packet 1
+    uint32_t early_reject = 0;
+    uint32_t packet_us = 0;    // last packet: mel + CMVN + encoder
+    uint32_t saved_us = 0;     // second passes skipped, each at that decision's packet 1
+                               // cost (a cached packet 1: its speculative pass)
+    uint32_t spec_packets = 0;   // speculative encoder passes
+    uint32_t spec_used = 0;      // of those, taken by verify()
+    uint32_t spec_wasted = 0;    // segment changed (not taken, evicted)
+    uint32_t spec_cancelled = 0; // dropped by cancel()
+    uint32_t spec_us = 0;        // speculative encoder time, total
+  };
+  const Stats& stats() const { return stats_; }
+
+private:
+  MelStream* mel_ = nullptr;
+  VoiceIdEncoder* enc_ = nullptr;
+  SrClassifier* cls_ = nullptr;
+  SrCombine combine_ = SrCombine::MEAN;
+  SrEarlyExit exit_{};
+  Stats stats_{};
+  float mel_buf_[MEL_BINS * MEL_WINDOW_FRAMES];
+  float emb_[SR_MAX_PACKETS][SR_EMB_DIM];
+
+  struct SpecSlot {
+    uint32_t pos;
+    uint32_t period;
+    bool valid;
+    uint32_t us; // encoder pass that produced emb
+    float emb[SR_EMB_DIM];
+  };
+  SpecSlot spec_[SR_SPEC_SLOTS]{};
+  uint8_t spec_next_ = 0; // round-robin victim
+  uint8_t spec_live_ = 0; // valid slots
+
+  bool decide_(const SpeechRing& ring, uint32_t pos, uint32_t n, SrResult* out);
+  // *us: mel + CMVN + encoder time of this packet (cached: when it was speculated)
+  bool embed_(const LoopedSpan& v, float* emb, SrResult* out, uint32_t* us);
+  bool packet_(const LoopedSpan& v, float* emb, SrResult* out, uint32_t* us); // cache, else embed_()
+  SpecSlot* spec_find_(const LoopedSpan& v);
+  uint32_t spec_drop_(); // returns the slots dropped
+};
+
+} // namespace ncomm
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ncomm/ncomm_sr.hpp"
+
+namespace ncomm {
+
+// ===== PQ template storage (MCU2, optional) =====
+// Product-quantised SR templates for the embedding DB budget of SR spec 14
+// (< 20 KB): a unit template is split into SR_PQ_M subvectors of SR_PQ_SUB
+// dims, each stored as the 8-bit index of its nearest codeword, i.e. 16 B
+// instead of 512 B (float) / 256 B (Q15 index). Subspaces are interleaved
+// (subspace m = dims m, m + M, m + 2M, ...) so the embedding's leading,
+// high-variance dims are spread over all codebooks.
+//
+// Scoring is asymmetric (the query stays exact): per query a distance table
+// lut[m][c] = q_m . codeword[m][c] (Q15) is built once, then every template
+// costs SR_PQ_M table lookups; cos ~ sum / 32767. Enrollment encodes the
+// centroid (nearest codeword per subspace, L2).
+//
+// The codebook is trained offline on a speaker corpus and, like model
+// weights, only referenced through a const pointer (flash, 64 KB).
+
+static constexpr uint8_t SR_PQ_M = 16;                     // subspaces = code bytes
+static constexpr uint8_t SR_PQ_SUB = SR_EMB_DIM / SR_PQ_M; // dims per subspace
+static constexpr uint16_t SR_PQ_K = 256;                   // codewords per subspace
+static constexpr uint16_t SR_PQ_MAX_TEMPLATES = 1024;
+// Codes + voice ids at capacity (17 KB) plus the per-voice Weibull (2 KB)
+static constexpr uint32_t SR_PQ_DB_BYTES =
+    (uint32_t)SR_PQ_MAX_TEMPLATES * (SR_PQ_M + 1u) + 256u * (uint32_t)sizeof(SrWeibull);
+
+static_assert(SR_EMB_DIM % SR_PQ_M == 0 && SR_PQ_SUB % 2 == 0, "subvectors are read as halfword pairs");
+
+struct PqCodebook {
+  const int16_t* cw; // [SR_PQ_M][SR_PQ_K][SR_PQ_SUB], Q15, |codeword| <= 1;
+                     // element i of subspace m is dim i * SR_PQ_M + m
+  bool trained;      // false: placeholder, codes are coarse
+};
+
+// Deterministic untrained codebook (random codewords at the typical subvector
+// scale of a unit embedding; constexpr table in flash). Replace with a
+// generated codebook trained on the encoder's embeddings.
+const PqCodebook* pq_placeholder_codebook();
+
+class PqIndex {
+public:
+  void init(const PqCodebook* cb, uint8_t* codes, uint8_t* voice, uint16_t capacity);
+  void clear() { size_ = 0; }
+
+  // L2-normalise emb and encode it into code[SR_PQ_M]; false for a zero vector.
+  bool encode(const float* emb, uint8_t* code) const;
+  // Reconstruction (codewords, unnormalised) of a code.
+  void decode(const uint8_t* code, float* emb) const;
+
+  // Encodes and stores emb; returns the slot or -1 when full / zero.
+  int32_t add(const float* emb, uint8_t voice_id);
+  // Stores an already encoded template (e.g. restored from flash).
+  int32_t add_code(const uint8_t* code, uint8_t voice_id);
+  uint16_t remove_voice(uint8_t voice_id);
+
+  uint16_t size() const { return size_; }
+  uint16_t capacity() const { return cap_; }
+  const uint8_t* code(uint16_t slot) const { return &codes_[(uint32_t)slot * SR_PQ_M]; }
+  uint8_t voice(uint16_t slot) const { return voice_[slot]; }
+  const PqCodebook* codebook() const { return cb_; }
+
+  // Builds the distance table for a query; false for a zero vector.
+  bool set_query(const float* emb);
+
+  // acc[i] ~ 32767 * cos(query, template i), i < size()
+  void score_all(int32_t* acc) const;
+
+  // As EmbeddingIndex::top_k, against the last set_query().
+  uint8_t top_k(uint8_t k, SrMatch* out) const;
+
+private:
+  const PqCodebook* cb_ = nullptr;
+  uint8_t* codes_ = nullptr;
+  uint8_t* voice_ = nullptr;
+  uint16_t cap_ = 0;
+  uint16_t size_ = 0;
+  int16_t lut_[SR_PQ_M * SR_PQ_K]; // 8 KB
+
+  int32_t score_(const uint8_t* code) const;
+};
+
+// Cosine + Weibull on PQ templates. The Weibull is fitted on the distances
+// to the encoded centroid, i.e. on the scores the index will produce.
+class PqWeibullClassifier final : public SrClassifier {
+public:
+  void init(const PqCodebook* cb, uint8_t* codes, uint8_t* voice, uint16_t capacity,
+            const SrParams& params = SrParams{});
+
+  void reset() override;
+  bool add_voice(const float* emb, uint32_t n, uint8_t voice_id) override;
+  bool load_voice(const float* centroid, const SrWeibull& w, uint8_t voice_id) override;
+  SrDecision classify(const float* emb) override;
+  uint16_t save_voice(uint8_t voice_id, uint8_t* rec) const override;
+  bool attach_voice(const uint8_t* rec, uint16_t len) override;
+  float threshold() const override { return params_.d_t; }
+  const char* name() const override { return "pq+weibull"; }
+
+  uint8_t top_k(const float* emb, uint8_t k, SrMatch* out);
+
+  const PqIndex& index() const { return index_; }
+  const SrWeibull& weibull(uint8_t voice_id) const { return weibull_[voice_id]; }
+  SrParams& params() { return params_; }
+
+private:
+  SrParams params_{};
+  PqIndex index_;
+  SrWeibull weibull_[256];
+};
+
+} // namespace ncomm
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ncomm {
+
+// ===== Record store (MCU2 internal flash) =====
+// Log-structured key -> record store on a pair of flash sectors, for data
+// that must survive reset (SR enrollment, SR spec 16).
+//
+// Layout: one sector is active; it starts with a sector header (sequence
+// number, erase count) and records are appended after it, each a header
+// flash word followed by the payload, padded to whole flash words. The
+// latest record of a key wins; a tombstone removes it. A record's payload
+// words are programmed first and its header word last, so a record exists
+// only once it is complete (header CRC + payload CRC): a power cut leaves at
+// most unreferenced words, which mount skips.
+//
+// Wear levelling: when the active sector is full the live records are copied
+// to the other sector (erased first), whose header is written last; the old
+// sector stays valid until then and is only erased at the next compaction.
+// Sectors alternate, every word is programmed once per cycle.
+//
+// Reads are memory mapped: get() returns a pointer into flash, used in place
+// (e.g. Q15 templates scored from flash). Pointers stay valid until the next
+// put()/remove() that compacts: generation() changes when records move.
+//
+// Single context (main loop); program/erase block for the flash operation.
+
+static constexpr uint32_t STORE_WORD = 32;         // H7 flash word (256 bit + ECC), programmed once
+static constexpr uint16_t STORE_MAX_RECORD = 1024; // payload bytes
+static constexpr uint16_t STORE_KEYS = 256;
+
+// Flash sector pair as seen by the store. program() writes one erased flash
+// word (offset aligned to STORE_WORD).
+class FlashDevice {
+public:
+  virtual const uint8_t* base(uint8_t sector) const = 0; // memory-mapped read
+  virtual uint32_t sector_size() const = 0;
+  virtual bool erase(uint8_t sector) = 0;
+  virtual bool program(uint8_t sector, uint32_t offset, const uint8_t* word) = 0;
+
+protected:
+  ~FlashDevice() = default; // statically allocated devices only
+};
+
+class RecordStore {
+public:
+  // Finds the active sector (valid header, highest sequence) and indexes its
+  // records; formats the pair if neither sector is valid.
+  bool mount(FlashDevice* dev);
+  // Erases both sectors and starts an empty store.
+  bool format();
+
+  // Atomic insert / replace: the old record stays current until the new one
+  // is complete. Compacts when the active sector is full; false if the live
+  // records plus this one do not fit a sector, or on a flash error.
+  bool put(uint8_t key, const void* data, uint16_t len);
+  bool remove(uint8_t key);
+
+  // Payload in flash, nullptr if the key is absent.
+  const uint8_t* get(uint8_t key, uint16_t* len) const;
+  bool has(uint8_t key) const { return off_[key] != 0; }
+
+  uint16_t count() const { return count_; }
+  uint32_t generation() const { return gen_; }
+  uint32_t free_bytes() const;
+  uint32_t erase_count(uint8_t sector) const { return erases_[sector & 1u]; }
+
+  struct Stats {
+    uint32_t puts = 0;
+    uint32_t compactions = 0;
+    uint32_t skipped_words = 0; // mount: words not part of a valid record (power cut / corruption)
+    uint32_t flash_errors = 0;
+  };
+  const Stats& stats() const { return stats_; }
+
+private:
+  FlashDevice* dev_ = nullptr;
+  uint8_t active_ = 0;
+  uint32_t seq_ = 0;     // sector sequence of the active sector
+  uint32_t wr_ = 0;      // next free offset in the active sector
+  uint32_t erases_[2] = {};
+  uint32_t gen_ = 0;
+  uint16_t count_ = 0;
+  uint32_t off_[STORE_KEYS] = {}; // record offset in the active sector, 0 = absent
+  Stats stats_{};
+
+  bool append_(uint8_t sector, uint32_t* wr, uint8_t type, uint8_t key, const uint8_t* data, uint16_t len);
+  bool write_header_(uint8_t sector, uint32_t seq, uint32_t erases);
+  bool compact_(uint32_t need);
+  void index_(uint8_t sector);
+  uint32_t live_bytes_() const;
+};
+
+// Record footprint in flash (header word + padded payload)
+constexpr uint32_t store_record_span(uint16_t len) {
+  return STORE_WORD + ((uint32_t)len + STORE_WORD - 1u) / STORE_WORD * STORE_WORD;
+}
+
+} // namespace ncomm
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ncomm/ncomm_mel.hpp"
+
+namespace ncomm {
+
+// ===== VoiceID encoder (MCU2), int8 =====
+// d-vector for SR (spec 6.5.5): log-mel [64][24] (mel_cmvn applied) ->
+// 128-dim L2-normalised embedding. TDNN (x-vector class) layout:
+//   TDNN1  k5 d1   64 -> 128   24 -> 20 frames
+//   TDNN2  k3 d2  128 -> 128   20 -> 16
+//   TDNN3  k3 d3  128 -> 128   16 -> 10
+//   TDNN4  k1     128 -> 256   10 -> 10
+//   stats pooling (mean, std over time) -> 512
+//   FC     512 -> 128 (linear), dequantised to float, L2 norm
+// Activations int8 time-major [T][C] with zero point 0 (ReLU outputs);
+// weights int8 per output channel [Cout][K][Cin], bias int32, per-channel
+// requantisation (Q31 multiplier + shift, CMSIS-NN convention, as TinyKws).
+// Kernels: s8 dot products two output channels at a time with SXTB16 +
+// SMLAD on the M7 (plain C elsewhere, bit-identical results).
+//
+// Weights are only referenced through the model's const pointers, never
+// copied: a generated model (and the placeholder) sits in .rodata, i.e.
+// read straight from flash. RAM is the engine object: a fixed two-buffer
+// activation arena (VOICEID_ARENA_BYTES, planned at compile time).
+
+static constexpr uint16_t VOICEID_EMB_DIM = 128;
+static constexpr uint8_t VOICEID_TDNN_LAYERS = 4;
+static constexpr uint16_t VOICEID_POOL_DIM = 512; // mean + std of TDNN4
+
+struct VoiceIdShape {
+  uint8_t k;      // taps
+  uint8_t dil;    // dilation
+  uint16_t cin;
+  uint16_t cout;
+  uint16_t t_in;
+  uint16_t t_out;
+};
+
+constexpr VoiceIdShape voiceid_shape(uint32_t layer) {
+  return (layer == 0) ? VoiceIdShape{5, 1, MEL_BINS, 128, MEL_WINDOW_FRAMES, MEL_WINDOW_FRAMES - 4}
+       : (layer == 1) ? VoiceIdShape{3, 2, 128, 128, 20, 16}
+       : (layer == 2) ? VoiceIdShape{3, 3, 128, 128, 16, 10}
+                      : VoiceIdShape{1, 1, 128, 256, 10, 10};
+}
+
+// Arena plan: layer i reads buffer i % 2 and writes (i + 1) % 2; the input
+// lands in buffer 0, pooling reads the last TDNN output and writes the other
+// buffer.
+constexpr uint32_t voiceid_act_bytes(uint32_t layer) { // output of layer, -1 = input
+  return (layer == 0xFFFFFFFFu) ? (uint32_t)MEL_WINDOW_FRAMES * MEL_BINS
+       : (uint32_t)voiceid_shape(layer).t_out * voiceid_shape(layer).cout;
+}
+constexpr uint32_t voiceid_buf_bytes(uint32_t buf) {
+  uint32_t m = (buf == 0) ? voiceid_act_bytes(0xFFFFFFFFu) : 0;
+  for (uint32_t l = 0; l < VOICEID_TDNN_LAYERS; l++) {
+    if (((l + 1u) & 1u) == buf && voiceid_act_bytes(l) > m) m = voiceid_act_bytes(l);
+  }
+  if (((VOICEID_TDNN_LAYERS + 1u) & 1u) == buf && VOICEID_POOL_DIM > m) m = VOICEID_POOL_DIM;
+  return (m + 3u) & ~3u;
+}
+static constexpr uint32_t VOICEID_ARENA_BYTES = voiceid_buf_bytes(0) + voiceid_buf_bytes(1);
+
+struct VoiceIdLayer {
+  const int8_t* w;     // [cout][k][cin]
+  const int32_t* b;    // [cout]
+  const int32_t* mult; // [cout], Q31 in [2^30, 2^31)
+  const int8_t* shift; // [cout], left shift (negative = right)
+};
+
+struct VoiceIdModel {
+  float in_scale;                          // mel = q * in_scale (after CMVN)
+  VoiceIdLayer tdnn[VOICEID_TDNN_LAYERS];
+  const int8_t* fc_w;                      // [VOICEID_EMB_DIM][VOICEID_POOL_DIM]
+  const int32_t* fc_b;
+  const float* fc_scale;                   // emb = (acc + b) * fc_scale[c]
+  bool trained;                            // false: placeholder, embeddings meaningless
+};
+
+// Weight bytes of the int8 model (flash)
+uint32_t voiceid_weight_bytes();
+
+// Deterministic untrained weights with the real shapes and per-channel
+// scales (constexpr tables in flash; requantisation tables, 3 KB, in RAM).
+// Replace with a generated model source once one is trained.
+const VoiceIdModel* voiceid_placeholder_model();
+
+class VoiceIdEncoder {
+public:
+  void init(const VoiceIdModel* model);
+
+  // mel[k * stride + t], k < MEL_BINS, t < MEL_WINDOW_FRAMES (mel_cmvn
+  // applied) -> emb[VOICEID_EMB_DIM], unit length. False without a model.
+  bool encode(const float* mel, uint32_t stride, float* emb);
+
+  const VoiceIdModel* model() const { return model_; }
+  uint32_t ram_bytes() const { return (uint32_t)sizeof(*this); }
+
+private:
+  const VoiceIdModel* model_ = nullptr;
+  int8_t arena_[VOICEID_ARENA_BYTES];
+};
+
+} // namespace ncomm
@@ -0,0 +1,213 @@
+#include "ncomm/ncomm_beep.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "ncomm/ncomm_mem.h"
+
+#if defined(__ARM_FEATURE_DSP) && !defined(NCOMM_HOST)
+#include "stm32h7xx.h" // __SSAT
+#endif
+
+namespace ncomm {
+
+static constexpr uint32_t SAMPLES_PER_MS = BEEP_RATE / 1000u;
+static constexpr uint32_t SINE_BITS = 8;
+static constexpr uint32_t SINE_SIZE = 1u << SINE_BITS;
+
+// One period plus a guard entry for the interpolation; DTCM (read by the output ISR)
+static int16_t s_sine[SINE_SIZE + 1] NCOMM_FAST_DATA;
+static bool s_sine_ready = false;
+
+static inline int16_t sat16(int32_t v) {
+#if defined(__ARM_FEATURE_DSP) && !defined(NCOMM_HOST)
+  return (int16_t)__SSAT(v, 16);
+#else
+  return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+#endif
+}
+
+// Confirmations rise, refusals and endings fall; SR_REJECTED and the timeout
+// are low and long enough to tell apart without looking.
+static const BeepPreset BEEP_PRESETS[BEEP_TONES] = {
+    // CMD_DETECTED: short tick
+    {{{1000, 60, 0}}, 1},
+    // SR_CONFIRMED: rising pair
+    {{{880, 70, 20}, {1320, 90, 0}}, 2},
+    // SR_REJECTED: two low buzzes
+    {{{330, 120, 60}, {330, 120, 0}}, 2, 9830},
+    // SESSION_ACTIVE: single high
+    {{{1320, 80, 0}}, 1},
+    // SESSION_CLOSED: falling pair
+    {{{1320, 70, 20}, {880, 90, 0}}, 2},
+    // SESSION_TIMEOUT: falling triple
+    {{{660, 80, 30}, {550, 80, 30}, {440, 140, 0}}, 3},
+};
+
+const BeepPreset& beep_default_preset(BeepTone tone) {
+  const uint8_t t = (uint8_t)tone;
+  return BEEP_PRESETS[t < BEEP_TONES ? t : 0];
+}
+
+void BeepMixer::init() {
+  if (!s_sine_ready) {
+    for (uint32_t i = 0; i <= SINE_SIZE; i++) {
+      s_sine[i] = (int16_t)std::lround(32767.0 * std::sin(6.283185307179586 * (double)i / SINE_SIZE));
+    }
+    s_sine_ready = true;
+  }
+  for (uint8_t t = 0; t < BEEP_TONES; t++) presets_[t] = BEEP_PRESETS[t];
+  while (req_.pop(nullptr)) {
+  }
+  has_next_ = false;
+  state_ = State::IDLE;
+  cur_ = nullptr;
+  env_ = 0;
+  stats_ = {};
+}
+
+bool BeepMixer::start(BeepTone tone, uint32_t at) {
+  if ((uint8_t)tone >= BEEP_TONES) return false;
+  if (!req_.push(Request{(uint8_t)tone, at})) {
+    stats_.dropped++;
+    return false;
+  }
+  return true;
+}
+
+void BeepMixer::schedule_(const Request& r, uint32_t pos) {
+  if (state_ != State::IDLE && state_ != State::WAIT) stats_.replaced++;
+  cur_ = &presets_[r.tone];
+  note_ = 0;
+  env_ = 0;
+  at_ = pos;
+  if (r.at != BEEP_ASAP) {
+    if ((int32_t)(r.at - pos) < 0) stats_.late++;
+    else at_ = r.at;
+  }
+  state_ = State::WAIT;
+  stats_.started++;
+}
+
+void BeepMixer::take_requests_(uint32_t pos) {
+  Request r;
+  while (req_.pop(&r)) {
+    if (r.at == BEEP_ASAP && state_ != State::IDLE) {
+      if (has_next_) stats_.replaced++;
+      next_ = r;
+      has_next_ = true;
+      continue;
+    }
+    has_next_ = false;
+    schedule_(r, pos);
+  }
+}
+
+void BeepMixer::begin_note_() {
+  const BeepNote& nt = cur_->note[note_];
+  const uint32_t len = nt.ms * SAMPLES_PER_MS;
+  gap_ = nt.gap_ms * SAMPLES_PER_MS;
+  attack_ = cur_->attack_ms * SAMPLES_PER_MS;
+  if (attack_ > len / 2u) attack_ = len / 2u;
+  release_ = cur_->release_ms * SAMPLES_PER_MS;
+  if (release_ > len - attack_) release_ = len - attack_;
+  sustain_ = len - attack_ - release_;
+  env_ = 0;
+  if (!nt.hz) {
+    // Rest: the whole note is a gap
+    gap_ += len;
+    attack_ = sustain_ = release_ = 0;
+  }
+  phase_ = 0;
+  inc_ = (uint32_t)(((uint64_t)nt.hz << 32) / BEEP_RATE);
+  env_step_ = attack_ ? (int32_t)(32767u / attack_) : 0;
+  state_ = State::ATTACK;
+  left_ = attack_;
+}
+
+// Advances past finished (or empty) states
+void BeepMixer::next_state_() {
+  while (left_ == 0 && state_ != State::IDLE) {
+    switch (state_) {
+      case State::ATTACK:
+        env_ = 32767;
+        state_ = State::SUSTAIN;
+        left_ = sustain_;
+        break;
+      case State::SUSTAIN:
+        state_ = State::RELEASE;
+        left_ = release_;
+        rel_step_ = release_ ? (env_ + (int32_t)release_ - 1) / (int32_t)release_ : 0;
+        break;
+      case State::RELEASE:
+        env_ = 0;
+        state_ = State::GAP;
+        left_ = gap_;
+        break;
+      case State::GAP:
+        if (++note_ < cur_->notes) begin_note_();
+        else state_ = State::IDLE;
+        break;
+      default:
+        state_ = State::IDLE;
+        break;
+    }
+  }
+}
+
+// Mixes up to n samples of the current state; returns the samples consumed.
+uint32_t BeepMixer::synth_(int16_t* buf, uint32_t n) {
+  const uint32_t m = n < left_ ? n : left_;
+  left_ -= m;
+  if (state_ == State::GAP) return m;
+
+  const int32_t step = state_ == State::ATTACK ? env_step_ : (state_ == State::RELEASE ? -rel_step_ : 0);
+  const int32_t level = cur_->level;
+  const int32_t duck = 32767 - cur_->duck;
+  int32_t env = env_;
+  uint32_t ph = phase_;
+  const uint32_t inc = inc_;
+  for (uint32_t i = 0; i < m; i++) {
+    env += step;
+    env = env < 0 ? 0 : (env > 32767 ? 32767 : env);
+    // Table entry (top 8 bits) + linear interpolation on the next 16
+    const uint32_t k = ph >> (32u - SINE_BITS);
+    const int32_t fr = (int32_t)((ph >> (16u - SINE_BITS)) & 0xFFFFu);
+    const int32_t a = s_sine[k];
+    const int32_t s = a + (((s_sine[k + 1u] - a) * fr) >> 16);
+    ph += inc;
+    const int32_t tone = (((s * env) >> 15) * level) >> 15;
+    const int32_t g = 32768 - ((duck * env) >> 15); // Q15, 32768 = unity (no ducking is exact)
+    buf[i] = sat16(((buf[i] * g) >> 15) + tone);
+  }
+  env_ = env;
+  phase_ = ph;
+  return m;
+}
+
+NCOMM_FAST_CODE void BeepMixer::render(int16_t* buf, uint32_t n, uint32_t pos) {
+  take_requests_(pos);
+  uint32_t i = 0;
+  while (i < n) {
+    if (state_ == State::IDLE) {
+      if (!has_next_) return;
+      has_next_ = false;
+      schedule_(Request{next_.tone, pos + i + BEEP_CHAIN_GAP_MS * SAMPLES_PER_MS}, pos + i);
+    }
+    if (state_ == State::WAIT) {
+      const int32_t d = (int32_t)(at_ - (pos + i));
+      if (d > 0) {
+        if ((uint32_t)d >= n - i) return;
+        i += (uint32_t)d;
+      }
+      note_ = 0;
+      begin_note_();
+      next_state_();
+      continue;
+    }
+    i += synth_(buf + i, n - i);
+    next_state_();
+  }
+}
+
+} // namespace ncomm
@@ -0,0 +1,151 @@
+#include "ncomm/ncomm_brick.hpp"
+
+#include <cstring>
+
+namespace ncomm {
+
+static inline uint16_t rd_le16(const uint8_t* p) { return (uint16_t)p[0] | ((uint16_t)p[1] << 8); }
+static inline uint32_t rd_le32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void BrickRepacker::drop_head_() {
+  slots_[head_].ref.reset();
+  slots_[head_].pcm = nullptr;
+  slots_[head_].samples = 0;
+  head_ = (uint8_t)((head_ + 1u) % MAX_FRAMES);
+  count_--;
+}
+
+// Release frames whose samples were all handed out (deferred so the last view
+// stays valid until the next call).
+void BrickRepacker::retire_() {
+  while (count_ && pos_ >= slots_[head_].samples) {
+    pos_ = (uint16_t)(pos_ - slots_[head_].samples);
+    drop_head_();
+  }
+}
+
+void BrickRepacker::push(const FrameRef& f) {
+  const uint8_t* p = f.data();
+  const uint16_t len = f.size();
+  const uint16_t samples = (len >= AUDIO_HDR_SIZE) ? rd_le16(&p[2]) : 0;
+  if (samples == 0 || len < AUDIO_HDR_SIZE + 2u * samples) {
+    stats_.bad_frames++;
+    return;
+  }
+
+  const uint32_t idx = rd_le32(&p[4]);
+  if (have_index_ && idx != next_index_) stats_.gaps++;
+  next_index_ = idx + 1u;
+  have_index_ = true;
+
+  retire_();
+  if (count_ == MAX_FRAMES) {
+    pending_ -= slots_[head_].samples - pos_;
+    pos_ = 0;
+    drop_head_();
+    stats_.overflows++;
+  }
+
+  Slot& s = slots_[(head_ + count_) % MAX_FRAMES];
+  s.ref = f;
+  // Pool payloads are 4-byte aligned, the audio header is 8 bytes
+  s.pcm = reinterpret_cast<const int16_t*>(p + AUDIO_HDR_SIZE);
+  s.samples = samples;
+  s.frame_index = idx;
+  count_++;
+  pending_ += samples;
+  stats_.frames++;
+}
+
+bool BrickRepacker::next(BrickView* out) {
+  retire_();
+  if (pending_ < BRICK_SAMPLES || !out) return false;
+
+  out->frame_index = slots_[head_].frame_index;
+  out->offset = pos_;
+  out->segs = 0;
+
+  uint16_t got = 0;
+  uint16_t off = pos_;
+  for (uint8_t k = 0; k < count_ && got < BRICK_SAMPLES; k++) {
+    const Slot& s = slots_[(head_ + k) % MAX_FRAMES];
+    uint16_t take = (uint16_t)(s.samples - off);
+    if (take > BRICK_SAMPLES - got) take = (uint16_t)(BRICK_SAMPLES - got);
+    if (out->segs == BRICK_MAX_SEGS) {
+      // Frames shorter than BRICK_SAMPLES / BRICK_MAX_SEGS: spans so far plus
+      // the rest go to the scratch
+      gather_(*out, scratch_);
+      for (uint8_t j = k; j < count_ && got < BRICK_SAMPLES; j++) {
+        const Slot& r = slots_[(head_ + j) % MAX_FRAMES];
+        uint16_t t = (uint16_t)(r.samples - off);
+        if (t > BRICK_SAMPLES - got) t = (uint16_t)(BRICK_SAMPLES - got);
+        std::memcpy(&scratch_[got], r.pcm + off, t * sizeof(int16_t));
+        got = (uint16_t)(got + t);
+        off = 0;
+      }
+      out->seg[0] = scratch_;
+      out->len[0] = BRICK_SAMPLES;
+      out->segs = 1;
+      stats_.gathers++;
+      break;
+    }
+    out->seg[out->segs] = s.pcm + off;
+    out->len[out->segs] = take;
+    out->segs++;
+    got = (uint16_t)(got + take);
+    off = 0;
+  }
+  if (out->segs > 1) stats_.bricks_split++;
+
+  pos_ = (uint16_t)(pos_ + BRICK_SAMPLES);
+  pending_ -= BRICK_SAMPLES;
+  stats_.bricks++;
+  return true;
+}
+
+void BrickRepacker::gather_(const BrickView& v, int16_t* dst) {
+  uint16_t at = 0;
+  for (uint8_t k = 0; k < v.segs; k++) {
+    std::memcpy(&dst[at], v.seg[k], v.len[k] * sizeof(int16_t));
+    at = (uint16_t)(at + v.len[k]);
+  }
+}
+
+const int16_t* BrickRepacker::contiguous(const BrickView& v) {
+  if (v.segs == 1) return v.seg[0];
+  gather_(v, scratch_);
+  stats_.gathers++;
+  return scratch_;
+}
+
+void BrickRepacker::reset() {
+  while (count_) drop_head_();
+  head_ = 0;
+  pos_ = 0;
+  pending_ = 0;
+  have_index_ = false;
+}
+
+void int16_to_float(const int16_t* in, float* out, uint32_t n, float scale) {
+  uint32_t i = 0;
+  for (; i + 8u <= n; i += 8u) {
+    uint32_t w[4];
+    std::memcpy(w, in + i, sizeof(w)); // LDR x4 on M7 (unaligned allowed), one vector load on host
+    for (uint32_t k = 0; k < 4u; k++) {
+      out[i + 2u * k]      = (float)(int16_t)(w[k] & 0xFFFFu) * scale;
+      out[i + 2u * k + 1u] = (float)(int16_t)(w[k] >> 16) * scale;
+    }
+  }
+  for (; i < n; i++) out[i] = (float)in[i] * scale;
+}
+
+void to_float(const BrickView& v, float* out, float scale) {
+  for (uint8_t k = 0; k < v.segs; k++) {
+    int16_to_float(v.seg[k], out, v.len[k], scale);
+    out += v.len[k];
+  }
+}
+
+} // namespace ncomm
@@ -0,0 +1,186 @@
+#include "ncomm/ncomm_fft.hpp"
+
+#include <cmath>
+
+#include "ncomm/ncomm_mem.h"
+
+namespace ncomm {
+namespace fft_detail {
+
+static constexpr double TWO_PI = 6.283185307179586476925;
+
+void init_tables(uint32_t n, float* tw_c, float* tw_r, uint16_t* rev) {
+  const uint32_t m = n / 2; // complex FFT size
+  for (uint32_t j = 0; j < m / 2; j++) {
+    tw_c[2 * j]     = (float)std::cos(TWO_PI * j / m);
+    tw_c[2 * j + 1] = (float)std::sin(TWO_PI * j / m);
+  }
+  for (uint32_t k = 0; k <= n / 4; k++) {
+    tw_r[2 * k]     = (float)std::cos(TWO_PI * k / n);
+    tw_r[2 * k + 1] = (float)std::sin(TWO_PI * k / n);
+  }
+  uint32_t bits = 0;
+  while ((1u << bits) < m) bits++;
+  for (uint32_t i = 0; i < m; i++) {
+    uint32_t r = 0;
+    for (uint32_t b = 0; b < bits; b++) r |= ((i >> b) & 1u) << (bits - 1u - b);
+    rev[i] = (uint16_t)r;
+  }
+}
+
+// Iterative radix-2 DIT, forward (e^{-i..}), z = m interleaved complex values.
+NCOMM_FAST_CODE static void cfft(float* z, uint32_t m, const float* tw, const uint16_t* rev) {
+  for (uint32_t i = 0; i < m; i++) {
+    const uint32_t r = rev[i];
+    if (r > i) {
+      const float re = z[2 * i], im = z[2 * i + 1];
+      z[2 * i] = z[2 * r];
+      z[2 * i + 1] = z[2 * r + 1];
+      z[2 * r] = re;
+      z[2 * r + 1] = im;
+    }
+  }
+  for (uint32_t len = 2; len <= m; len <<= 1) {
+    const uint32_t half = len >> 1;
+    const uint32_t step = m / len;
+    for (uint32_t base = 0; base < m; base += len) {
+      for (uint32_t j = 0; j < half; j++) {
+        const float wr = tw[2 * j * step];
+        const float wi = -tw[2 * j * step + 1];
+        float* a = &z[2 * (base + j)];
+        float* b = &z[2 * (base + j + half)];
+        const float tr = b[0] * wr - b[1] * wi;
+        const float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+NCOMM_FAST_CODE void rfft(float* x, uint32_t n, const float* tw_c, const float* tw_r, const uint16_t* rev) {
+  const uint32_t m = n / 2;
+  cfft(x, m, tw_c, rev); // z[j] = x[2j] + i x[2j+1]
+
+  // DC and Nyquist are real
+  const float z0r = x[0], z0i = x[1];
+  x[0] = z0r + z0i;
+  x[1] = z0r - z0i;
+
+  // X[k] = E + W^k O, X[m-k] = conj(E - W^k O),
+  // E = (Z[k] + conj Z[m-k]) / 2, O = (Z[k] - conj Z[m-k]) / 2i
+  for (uint32_t k = 1; k <= m / 2; k++) {
+    float* a = &x[2 * k];
+    float* b = &x[2 * (m - k)];
+    const float er = 0.5f * (a[0] + b[0]);
+    const float ei = 0.5f * (a[1] - b[1]);
+    const float or_ = 0.5f * (a[1] + b[1]);
+    const float oi = -0.5f * (a[0] - b[0]);
+    const float wr = tw_r[2 * k];
+    const float wi = -tw_r[2 * k + 1];
+    const float tr = wr * or_ - wi * oi;
+    const float ti = wr * oi + wi * or_;
+    a[0] = er + tr;
+    a[1] = ei + ti;
+    if (b != a) {
+      b[0] = er - tr;
+      b[1] = -(ei - ti);
+    }
+  }
+}
+
+// ----- Q31 -----
+
+static inline int32_t to_q31(double v) {
+  const double q = v * 2147483648.0;
+  if (q >= 2147483647.0) return 2147483647;
+  if (q <= -2147483648.0) return (int32_t)-2147483647 - 1;
+  return (int32_t)std::lround(q);
+}
+
+void init_tables_q31(uint32_t n, int32_t* tw_c, int32_t* tw_r, uint16_t* rev) {
+  const uint32_t m = n / 2;
+  for (uint32_t j = 0; j < m / 2; j++) {
+    tw_c[2 * j]     = to_q31(std::cos(TWO_PI * j / m));
+    tw_c[2 * j + 1] = to_q31(std::sin(TWO_PI * j / m));
+  }
+  for (uint32_t k = 0; k <= n / 4; k++) {
+    tw_r[2 * k]     = to_q31(std::cos(TWO_PI * k / n));
+    tw_r[2 * k + 1] = to_q31(std::sin(TWO_PI * k / n));
+  }
+  uint32_t bits = 0;
+  while ((1u << bits) < m) bits++;
+  for (uint32_t i = 0; i < m; i++) {
+    uint32_t r = 0;
+    for (uint32_t b = 0; b < bits; b++) r |= ((i >> b) & 1u) << (bits - 1u - b);
+    rev[i] = (uint16_t)r;
+  }
+}
+
+// Complex magnitudes stay below the entry bound: |a +- bw| < 2B, halved.
+NCOMM_FAST_CODE static void cfft_q31(int32_t* z, uint32_t m, const int32_t* tw, const uint16_t* rev) {
+  for (uint32_t i = 0; i < m; i++) {
+    const uint32_t r = rev[i];
+    if (r > i) {
+      const int32_t re = z[2 * i], im = z[2 * i + 1];
+      z[2 * i] = z[2 * r];
+      z[2 * i + 1] = z[2 * r + 1];
+      z[2 * r] = re;
+      z[2 * r + 1] = im;
+    }
+  }
+  for (uint32_t len = 2; len <= m; len <<= 1) {
+    const uint32_t half = len >> 1;
+    const uint32_t step = m / len;
+    for (uint32_t base = 0; base < m; base += len) {
+      for (uint32_t j = 0; j < half; j++) {
+        const int64_t wr = tw[2 * j * step];
+        const int64_t wi = -(int64_t)tw[2 * j * step + 1];
+        int32_t* a = &z[2 * (base + j)];
+        int32_t* b = &z[2 * (base + j + half)];
+        // t = b * w in Q31 (one rounding)
+        const int64_t tr = (b[0] * wr - b[1] * wi + (1ll << 30)) >> 31;
+        const int64_t ti = (b[0] * wi + b[1] * wr + (1ll << 30)) >> 31;
+        const int64_t ar = a[0], ai = a[1];
+        a[0] = (int32_t)((ar + tr) >> 1);
+        a[1] = (int32_t)((ai + ti) >> 1);
+        b[0] = (int32_t)((ar - tr) >> 1);
+        b[1] = (int32_t)((ai - ti) >> 1);
+      }
+    }
+  }
+}
+
+NCOMM_FAST_CODE void rfft_q31(int32_t* x, uint32_t n, const int32_t* tw_c, const int32_t* tw_r, const uint16_t* rev) {
+  const uint32_t m = n / 2;
+  cfft_q31(x, m, tw_c, rev);
+
+  const int64_t z0r = x[0], z0i = x[1];
+  x[0] = (int32_t)((z0r + z0i) >> 1);
+  x[1] = (int32_t)((z0r - z0i) >> 1);
+
+  // As the float split, halved: X/2 = (E + W^k O) / 2
+  for (uint32_t k = 1; k <= m / 2; k++) {
+    int32_t* a = &x[2 * k];
+    int32_t* b = &x[2 * (m - k)];
+    const int64_t er = ((int64_t)a[0] + b[0]) >> 1;
+    const int64_t ei = ((int64_t)a[1] - b[1]) >> 1;
+    const int64_t or_ = ((int64_t)a[1] + b[1]) >> 1;
+    const int64_t oi = -(((int64_t)a[0] - b[0]) >> 1);
+    const int64_t wr = tw_r[2 * k];
+    const int64_t wi = -(int64_t)tw_r[2 * k + 1];
+    const int64_t tr = (wr * or_ - wi * oi + (1ll << 30)) >> 31;
+    const int64_t ti = (wr * oi + wi * or_ + (1ll << 30)) >> 31;
+    a[0] = (int32_t)((er + tr) >> 1);
+    a[1] = (int32_t)((ei + ti) >> 1);
+    if (b != a) {
+      b[0] = (int32_t)((er - tr) >> 1);
+      b[1] = (int32_t)(-((ei - ti) >> 1));
+    }
+  }
+}
+
+} // namespace fft_detail
+} // namespace ncomm
@@ -0,0 +1,506 @@
+#include "ncomm/ncomm_kws.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace ncomm {
+
+static constexpr uint32_t SAMPLES_PER_MS = 16;
+
+// ===== Decoder =====
+
+void KwsDecoder::init(const KwsConfig& cfg) {
+  cfg_ = cfg;
+  if (cfg_.smooth == 0) cfg_.smooth = 1;
+  if (cfg_.smooth > MAX_SMOOTH) cfg_.smooth = MAX_SMOOTH;
+  reset();
+}
+
+void KwsDecoder::reset() {
+  std::memset(hist_, 0, sizeof(hist_));
+  std::memset(sum_, 0, sizeof(sum_));
+  n_ = 0;
+  at_ = 0;
+  best_ = 0;
+  locked_ = false;
+}
+
+uint8_t KwsDecoder::push(const float post[KWS_CLASSES], uint32_t pos, float* score) {
+  if (n_ < cfg_.smooth) n_++;
+  for (uint8_t c = 0; c < KWS_CLASSES; c++) hist_[at_][c] = post[c];
+  at_ = (uint8_t)((at_ + 1u) % cfg_.smooth);
+  // Re-sum instead of add/subtract: no drift, at most 8 x 5 adds
+  for (uint8_t c = 0; c < KWS_CLASSES; c++) {
+    float s = 0.0f;
+    for (uint8_t k = 0; k < n_; k++) s += hist_[k][c];
+    sum_[c] = s;
+  }
+
+  uint8_t best = 1;
+  for (uint8_t c = 2; c < KWS_CLASSES; c++) {
+    if (sum_[c] > sum_[best]) best = c;
+  }
+  best_ = best;
+  const float s = smoothed(best);
+  if (score) *score = s;
+
+  if (locked_) {
+    if ((int32_t)(pos - lockout_end_) < 0) return 0;
+    locked_ = false;
+  }
+  if (n_ == cfg_.smooth && s >= cfg_.trigger) {
+    locked_ = true;
+    lockout_end_ = pos + cfg_.refractory_ms * SAMPLES_PER_MS;
+    return best;
+  }
+  return 0;
+}
+
+uint8_t KwsDecoder::candidate() const {
+  if (locked_ || n_ < cfg_.smooth || !best_) return 0;
+  return smoothed(best_) >= cfg_.candidate ? best_ : 0;
+}
+
+// ===== Endpointer =====
+
+void KwsEndpointer::init(const KwsConfig& cfg, uint16_t frame_samples) {
+  cfg_ = cfg;
+  frame_ = frame_samples ? frame_samples : BRICK_SAMPLES;
+  reset();
+}
+
+void KwsEndpointer::reset() {
+  floor_ = 0.0f;
+  floor_set_ = false;
+  at_ = 0;
+  count_ = 0;
+  cmd_ = 0;
+  finished_ = false;
+}
+
+void KwsEndpointer::push(float energy_db, uint32_t pos) {
+  // Noise floor: follows down at once, up at 0.05 dB per frame (~3 dB/s)
+  if (!floor_set_ || energy_db < floor_) {
+    floor_ = energy_db;
+    floor_set_ = true;
+  } else {
+    floor_ += 0.05f;
+  }
+  e_[at_] = energy_db;
+  at_ = (uint8_t)((at_ + 1u) % HISTORY);
+  if (count_ < HISTORY) count_++;
+  last_pos_ = pos;
+
+  if (!cmd_ || finished_) return;
+  tail_++;
+  if (energy_db < floor_ + cfg_.off_db) {
+    if (quiet_ == 0) quiet_from_ = pos;
+    quiet_++;
+  } else {
+    quiet_ = 0;
+  }
+  const uint32_t hang = (cfg_.hangover_ms * SAMPLES_PER_MS + frame_ - 1u) / frame_;
+  if (quiet_ >= hang || (uint32_t)tail_ * frame_ >= cfg_.max_tail_ms * SAMPLES_PER_MS) {
+    end_ = quiet_ ? quiet_from_ : pos + frame_;
+    finished_ = true;
+  }
+}
+
+uint32_t KwsEndpointer::run_start_() const {
+  // Walk back over the speech run that ends at the last frame; gaps shorter
+  // than the hangover (stops inside a word) do not end it
+  const uint32_t hang = (cfg_.hangover_ms * SAMPLES_PER_MS + frame_ - 1u) / frame_;
+  uint32_t back = 0;
+  uint32_t gap = 0;
+  for (uint32_t i = 0; i < count_; i++) {
+    const float e = e_[(at_ + HISTORY - 1u - i) % HISTORY];
+    if (e > floor_ + cfg_.on_db) {
+      back = i;
+      gap = 0;
+    } else if (++gap > hang) {
+      break;
+    }
+  }
+  return last_pos_ - back * frame_ - cfg_.backoff_ms * SAMPLES_PER_MS;
+}
+
+void KwsEndpointer::trigger(uint8_t cmd, float score, uint32_t pos) {
+  start_ = run_start_();
+
+  cmd_ = cmd;
+  score_ = score;
+  trig_pos_ = pos;
+  quiet_ = 0;
+  tail_ = 0;
+  finished_ = false;
+}
+
+bool KwsEndpointer::pending(uint8_t candidate, KwsPending* out) const {
+  if (finished_ || !count_) return false;
+  if (cmd_) {
+    out->cmd_id = cmd_;
+    out->triggered = true;
+    out->seg_start = start_;
+    out->ended = quiet_ > 0;
+    out->seg_end = quiet_ ? quiet_from_ : last_pos_ + frame_;
+    return true;
+  }
+  if (!candidate) return false;
+  // Not triggered: the quiet run at the end of the history stands in for
+  // the one push() would track
+  uint32_t quiet = 0;
+  while (quiet < count_ && e_[(at_ + HISTORY - 1u - quiet) % HISTORY] < floor_ + cfg_.off_db) quiet++;
+  out->cmd_id = candidate;
+  out->triggered = false;
+  out->seg_start = run_start_();
+  out->ended = quiet > 0;
+  out->seg_end = last_pos_ + frame_ - quiet * frame_;
+  return true;
+}
+
+bool KwsEndpointer::done(KwsResult* out) {
+  if (!cmd_ || !finished_) return false;
+  if (out) {
+    out->cmd_id = cmd_;
+    const float s = score_ * 255.0f + 0.5f;
+    out->score = (uint8_t)(s > 255.0f ? 255.0f : s);
+    out->seg_start = start_;
+    out->seg_end = end_;
+    out->trigger_pos = trig_pos_;
+  }
+  cmd_ = 0;
+  finished_ = false;
+  return true;
+}
+
+// ===== Quantised DS-CNN kernels =====
+
+void kws_quantize_multiplier(double scale, int32_t* mult, int8_t* shift) {
+  if (scale <= 0.0) {
+    *mult = 0;
+    *shift = 0;
+    return;
+  }
+  int e = 0;
+  const double q = std::frexp(scale, &e); // scale = q * 2^e, q in [0.5, 1)
+  int64_t m = (int64_t)std::llround(q * 2147483648.0);
+  if (m == (int64_t)1 << 31) {
+    m >>= 1;
+    e++;
+  }
+  if (e < -30) { // below what requant() can shift: flush to zero
+    m = 0;
+    e = 0;
+  }
+  *mult = (int32_t)m;
+  *shift = (int8_t)(e > 30 ? 30 : e);
+}
+
+// acc * mult * 2^(shift - 31), rounded, then ReLU into int8 [0, 127]
+static inline int8_t requant_relu(int32_t acc, int32_t mult, int8_t shift) {
+  const int32_t s = 31 - shift; // 1 .. 61
+  const int64_t p = (int64_t)acc * mult + ((int64_t)1 << (s - 1));
+  int32_t v = (int32_t)(p >> s);
+  if (v < 0) v = 0;
+  if (v > 127) v = 127;
+  return (int8_t)v;
+}
+
+// in [KWS_FRAMES][KWS_MFCC] -> out [KWS_OUT_T][KWS_OUT_F][KWS_CH],
+// kernel 10x4, stride 2x2, SAME padding (4/4 in time, 1/1 in frequency)
+static void conv1(const int8_t* in, const KwsModel& m, int8_t* out) {
+  for (uint32_t ot = 0; ot < KWS_OUT_T; ot++) {
+    const int32_t t0 = (int32_t)(ot * 2u) - 4;
+    for (uint32_t of = 0; of < KWS_OUT_F; of++) {
+      const int32_t f0 = (int32_t)(of * 2u) - 1;
+      int8_t* o = &out[(ot * KWS_OUT_F + of) * KWS_CH];
+      for (uint32_t c = 0; c < KWS_CH; c++) {
+        const int8_t* w = &m.conv1_w[c * KWS_CONV_T * KWS_CONV_F];
+        int32_t acc = m.conv1_b[c];
+        for (int32_t kt = 0; kt < KWS_CONV_T; kt++) {
+          const int32_t t = t0 + kt;
+          if (t < 0 || t >= (int32_t)KWS_FRAMES) continue;
+          const int8_t* row = &in[t * KWS_MFCC];
+          for (int32_t kf = 0; kf < KWS_CONV_F; kf++) {
+            const int32_t f = f0 + kf;
+            if (f < 0 || f >= (int32_t)KWS_MFCC) continue;
+            acc += (int32_t)row[f] * w[kt * KWS_CONV_F + kf];
+          }
+        }
+        o[c] = requant_relu(acc, m.conv1_q.mult[c], m.conv1_q.shift[c]);
+      }
+    }
+  }
+}
+
+// Depthwise 3x3, stride 1, SAME; channel innermost so the inner loop is
+// contiguous in both input and weights
+static void dwconv(const int8_t* in, const KwsModel::Ds& l, int8_t* out) {
+  int32_t acc[KWS_CH];
+  for (int32_t t = 0; t < (int32_t)KWS_OUT_T; t++) {
+    for (int32_t f = 0; f < (int32_t)KWS_OUT_F; f++) {
+      for (uint32_t c = 0; c < KWS_CH; c++) acc[c] = l.dw_b[c];
+      for (int32_t dt = -1; dt <= 1; dt++) {
+        const int32_t tt = t + dt;
+        if (tt < 0 || tt >= (int32_t)KWS_OUT_T) continue;
+        for (int32_t df = -1; df <= 1; df++) {
+          const int32_t ff = f + df;
+          if (ff < 0 || ff >= (int32_t)KWS_OUT_F) continue;
+          const int8_t* x = &in[(tt * KWS_OUT_F + ff) * KWS_CH];
+          const int8_t* w = &l.dw_w[((dt + 1) * 3 + (df + 1)) * KWS_CH];
+          for (uint32_t c = 0; c < KWS_CH; c++) acc[c] += (int32_t)x[c] * w[c];
+        }
+      }
+      int8_t* o = &out[(t * KWS_OUT_F + f) * KWS_CH];
+      for (uint32_t c = 0; c < KWS_CH; c++) o[c] = requant_relu(acc[c], l.dw_q.mult[c], l.dw_q.shift[c]);
+    }
+  }
+}
+
+static void pwconv(const int8_t* in, const KwsModel::Ds& l, int8_t* out) {
+  for (uint32_t p = 0; p < (uint32_t)KWS_OUT_T * KWS_OUT_F; p++) {
+    const int8_t* x = &in[p * KWS_CH];
+    int8_t* o = &out[p * KWS_CH];
+    for (uint32_t co = 0; co < KWS_CH; co++) {
+      const int8_t* w = &l.pw_w[co * KWS_CH];
+      int32_t acc = l.pw_b[co];
+      for (uint32_t ci = 0; ci < KWS_CH; ci++) acc += (int32_t)x[ci] * w[ci];
+      o[co] = requant_relu(acc, l.pw_q.mult[co], l.pw_q.shift[co]);
+    }
+  }
+}
+
+// ===== TinyKws =====
+
+static float hz_to_mel(float hz) { return 1127.0f * std::log(1.0f + hz / 700.0f); }
+static float mel_to_hz(float mel) { return 700.0f * (std::exp(mel / 1127.0f) - 1.0f); }
+
+void TinyKws::init(const KwsModel* model, const KwsConfig& cfg) {
+  model_ = model;
+  cfg_ = cfg;
+  if (cfg_.infer_every == 0) cfg_.infer_every = 1;
+  dec_.init(cfg_);
+  ep_.init(cfg_, BRICK_SAMPLES);
+  fft_.init();
+
+  constexpr double PI = 3.14159265358979323846;
+  for (uint32_t i = 0; i < FRAME; i++) {
+    window_[i] = (float)(0.54 - 0.46 * std::cos(2.0 * PI * i / (FRAME - 1u)));
+  }
+
+  // KWS_MEL + 2 edges evenly spaced on the mel scale
+  float edge[KWS_MEL + 2];
+  const float lo = hz_to_mel(20.0f), hi = hz_to_mel(4000.0f);
+  for (uint32_t j = 0; j < KWS_MEL + 2u; j++) {
+    edge[j] = mel_to_hz(lo + (hi - lo) * (float)j / (float)(KWS_MEL + 1u));
+  }
+  for (uint32_t k = 0; k <= NFFT / 2u; k++) {
+    const float hz = (float)k * 16000.0f / (float)NFFT;
+    mel_band_[k] = -1;
+    mel_w_[k] = 0.0f;
+    for (uint32_t j = 0; j < KWS_MEL + 1u; j++) {
+      if (hz >= edge[j] && hz < edge[j + 1]) {
+        mel_band_[k] = (int8_t)j;
+        mel_w_[k] = (hz - edge[j]) / (edge[j + 1] - edge[j]);
+        break;
+      }
+    }
+  }
+
+  // Orthonormal DCT-II
+  for (uint32_t i = 0; i < KWS_MFCC; i++) {
+    const double norm = std::sqrt((i == 0 ? 1.0 : 2.0) / KWS_MEL);
+    for (uint32_t mb = 0; mb < KWS_MEL; mb++) {
+      dct_[i][mb] = (float)(norm * std::cos(PI * i * (mb + 0.5) / KWS_MEL));
+    }
+  }
+
+  reset();
+}
+
+void TinyKws::reset() {
+  dec_.reset();
+  ep_.reset();
+  std::memset(prev_, 0, sizeof(prev_));
+  std::memset(feat_, 0, sizeof(feat_));
+  std::memset(post_, 0, sizeof(post_));
+  frames_ = 0;
+}
+
+// frame: NFFT windowed samples, transformed in place
+void TinyKws::mfcc_(float* frame, int8_t* out, float* energy_db) {
+  fft_.forward(frame);
+  RealFft<NFFT>::power(frame, pow_);
+
+  float mel[KWS_MEL] = {};
+  float total = 0.0f;
+  for (uint32_t k = 0; k <= NFFT / 2u; k++) {
+    const float p = pow_[k];
+    total += p;
+    const int32_t b = mel_band_[k];
+    if (b < 0) continue;
+    const float w = mel_w_[k];
+    if (b < (int32_t)KWS_MEL) mel[b] += w * p;
+    if (b >= 1) mel[b - 1] += (1.0f - w) * p;
+  }
+  for (uint32_t mb = 0; mb < KWS_MEL; mb++) mel[mb] = std::log(mel[mb] + 1e-9f);
+  *energy_db = 10.0f * std::log10(total + 1e-9f);
+
+  const float inv = 1.0f / model_->in_scale;
+  for (uint32_t i = 0; i < KWS_MFCC; i++) {
+    float c = 0.0f;
+    for (uint32_t mb = 0; mb < KWS_MEL; mb++) c += dct_[i][mb] * mel[mb];
+    float q = std::nearbyint(c * inv);
+    if (q < -128.0f) q = -128.0f;
+    if (q > 127.0f) q = 127.0f;
+    out[i] = (int8_t)q;
+  }
+}
+
+void TinyKws::infer_() {
+  const KwsModel& m = *model_;
+  // oldest of the last KWS_FRAMES frames; its run of KWS_FRAMES rows is contiguous
+  const int8_t* win = feat_[frames_ % KWS_FRAMES];
+
+  conv1(win, m, act_a_);
+  for (uint32_t b = 0; b < KWS_DS_BLOCKS; b++) {
+    dwconv(act_a_, m.ds[b], act_b_);
+    pwconv(act_b_, m.ds[b], act_a_);
+  }
+
+  constexpr uint32_t P = (uint32_t)KWS_OUT_T * KWS_OUT_F;
+  int32_t pooled[KWS_CH];
+  for (uint32_t c = 0; c < KWS_CH; c++) {
+    int32_t s = 0;
+    for (uint32_t p = 0; p < P; p++) s += act_a_[p * KWS_CH + c];
+    pooled[c] = (s + (int32_t)(P / 2u)) / (int32_t)P;
+  }
+
+  float logit[KWS_CLASSES];
+  float mx = -1e30f;
+  for (uint32_t k = 0; k < KWS_CLASSES; k++) {
+    int32_t acc = m.fc_b[k];
+    for (uint32_t c = 0; c < KWS_CH; c++) acc += pooled[c] * m.fc_w[k * KWS_CH + c];
+    logit[k] = (float)acc * m.fc_scale;
+    if (logit[k] > mx) mx = logit[k];
+  }
+  float sum = 0.0f;
+  for (uint32_t k = 0; k < KWS_CLASSES; k++) {
+    post_[k] = std::exp(logit[k] - mx);
+    sum += post_[k];
+  }
+  for (uint32_t k = 0; k < KWS_CLASSES; k++) post_[k] /= sum;
+  inferences_++;
+}
+
+bool TinyKws::process(const BrickView& brick, uint32_t pos, KwsResult* out) {
+  if (!model_) return false;
+
+  // 30 ms frame = previous brick + this one, scaled to +-1, windowed, zero padded
+  constexpr float SCALE = 1.0f / 32768.0f;
+  int16_to_float(prev_, fbuf_, BRICK_SAMPLES, SCALE);
+  to_float(brick, fbuf_ + BRICK_SAMPLES, SCALE);
+  for (uint32_t i = 0; i < FRAME; i++) fbuf_[i] *= window_[i];
+  std::memset(&fbuf_[FRAME], 0, (NFFT - FRAME) * sizeof(float));
+
+  uint16_t at = 0;
+  for (uint8_t k = 0; k < brick.segs; k++) {
+    std::memcpy(&prev_[at], brick.seg[k], brick.len[k] * sizeof(int16_t));
+    at = (uint16_t)(at + brick.len[k]);
+  }
+
+  const uint32_t row = frames_ % KWS_FRAMES;
+  float energy_db = 0.0f;
+  mfcc_(fbuf_, feat_[row], &energy_db);
+  std::memcpy(feat_[row + KWS_FRAMES], feat_[row], KWS_MFCC);
+  frames_++;
+  ep_.push(energy_db, pos);
+
+  if (frames_ >= KWS_FRAMES && (frames_ % cfg_.infer_every) == 0) {
+    infer_();
+    float score = 0.0f;
+    const uint32_t end = pos + BRICK_SAMPLES;
+    const uint8_t cmd = dec_.push(post_, end, &score);
+    if (cmd && !ep_.active()) ep_.trigger(cmd, score, end);
+  }
+  return ep_.done(out);
+}
+
+// ===== Placeholder model =====
+
+struct PlaceholderModel {
+  int8_t conv1_w[KWS_CH * KWS_CONV_T * KWS_CONV_F];
+  int32_t conv1_b[KWS_CH];
+  int32_t conv1_m[KWS_CH];
+  int8_t conv1_s[KWS_CH];
+  struct {
+    int8_t dw_w[9 * KWS_CH];
+    int32_t dw_b[KWS_CH];
+    int32_t dw_m[KWS_CH];
+    int8_t dw_s[KWS_CH];
+    int8_t pw_w[KWS_CH * KWS_CH];
+    int32_t pw_b[KWS_CH];
+    int32_t pw_m[KWS_CH];
+    int8_t pw_s[KWS_CH];
+  } ds[KWS_DS_BLOCKS];
+  int8_t fc_w[KWS_CLASSES * KWS_CH];
+  int32_t fc_b[KWS_CLASSES];
+};
+
+static PlaceholderModel s_ph;
+static KwsModel s_ph_model;
+static bool s_ph_ready = false;
+
+static void fill_weights(int8_t* w, uint32_t n, uint32_t* seed) {
+  for (uint32_t i = 0; i < n; i++) {
+    *seed = *seed * 1664525u + 1013904223u;
+    w[i] = (int8_t)((int32_t)(*seed >> 25) - 64); // uniform -64..63
+  }
+}
+
+// Output scale for uniform int8 weights (sd ~37) and inputs of sd ~in_sd:
+// keeps the pre-ReLU sd near 48 LSB
+static void fill_requant(int32_t* mult, int8_t* shift, uint32_t fan_in, double in_sd) {
+  const double scale = 48.0 / (std::sqrt((double)fan_in) * 37.0 * in_sd);
+  for (uint32_t c = 0; c < KWS_CH; c++) kws_quantize_multiplier(scale, &mult[c], &shift[c]);
+}
+
+uint32_t kws_placeholder_model_bytes() { return (uint32_t)sizeof(PlaceholderModel); }
+
+const KwsModel* kws_placeholder_model() {
+  if (s_ph_ready) return &s_ph_model;
+  uint32_t seed = 0x4B575331u;
+  PlaceholderModel& p = s_ph;
+  KwsModel& m = s_ph_model;
+
+  fill_weights(p.conv1_w, sizeof(p.conv1_w), &seed);
+  std::memset(p.conv1_b, 0, sizeof(p.conv1_b));
+  fill_requant(p.conv1_m, p.conv1_s, KWS_CONV_T * KWS_CONV_F, 16.0);
+  m.in_scale = 0.5f;
+  m.conv1_w = p.conv1_w;
+  m.conv1_b = p.conv1_b;
+  m.conv1_q = {p.conv1_m, p.conv1_s};
+
+  for (uint32_t b = 0; b < KWS_DS_BLOCKS; b++) {
+    auto& d = p.ds[b];
+    fill_weights(d.dw_w, sizeof(d.dw_w), &seed);
+    fill_weights(d.pw_w, sizeof(d.pw_w), &seed);
+    std::memset(d.dw_b, 0, sizeof(d.dw_b));
+    std::memset(d.pw_b, 0, sizeof(d.pw_b));
+    fill_requant(d.dw_m, d.dw_s, 9, 28.0);
+    fill_requant(d.pw_m, d.pw_s, KWS_CH, 28.0);
+    m.ds[b] = {d.dw_w, d.dw_b, {d.dw_m, d.dw_s}, d.pw_w, d.pw_b, {d.pw_m, d.pw_s}};
+  }
+
+  fill_weights(p.fc_w, sizeof(p.fc_w), &seed);
+  std::memset(p.fc_b, 0, sizeof(p.fc_b));
+  m.fc_w = p.fc_w;
+  m.fc_b = p.fc_b;
+  m.fc_scale = 0.0f; // uniform posteriors (0.2): never reaches the trigger
+  m.trained = false;
+
+  s_ph_ready = true;
+  return &s_ph_model;
+}
+
+} // namespace ncomm
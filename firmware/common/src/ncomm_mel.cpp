@@ -0,0 +1,466 @@
+#include "ncomm/ncomm_mel.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "ncomm/ncomm_mem.h"
+
+namespace ncomm {
+
+static constexpr double SAMPLE_RATE = 16000.0;
+static constexpr double PI = 3.14159265358979323846;
+static constexpr uint32_t POW_SHIFT = 17; // |X|^2 < 2^61 -> < 2^44, x30 bins x Q15 fits uint64
+
+// ---- Slaney mel scale (librosa htk=False) ----
+
+static double hz_to_mel(double hz) {
+  const double f_sp = 200.0 / 3.0;
+  if (hz < 1000.0) return hz / f_sp;
+  return 1000.0 / f_sp + std::log(hz / 1000.0) / (std::log(6.4) / 27.0);
+}
+
+static double mel_to_hz(double mel) {
+  const double f_sp = 200.0 / 3.0;
+  const double min_log_mel = 1000.0 / f_sp;
+  if (mel < min_log_mel) return mel * f_sp;
+  return 1000.0 * std::exp((std::log(6.4) / 27.0) * (mel - min_log_mel));
+}
+
+static double mel_edge(uint32_t j) {
+  const double lo = hz_to_mel(0.0), hi = hz_to_mel(SAMPLE_RATE / 2.0);
+  return mel_to_hz(lo + (hi - lo) * (double)j / (double)(MEL_BINS + 1));
+}
+
+double mel_slaney_weight(uint32_t band, uint32_t bin, double* norm) {
+  const double f0 = mel_edge(band), f1 = mel_edge(band + 1), f2 = mel_edge(band + 2);
+  if (norm) *norm = 2.0 / (f2 - f0);
+  const double f = (double)bin * SAMPLE_RATE / (double)MEL_NFFT;
+  const double lower = (f - f0) / (f1 - f0);
+  const double upper = (f2 - f) / (f2 - f1);
+  const double w = (lower < upper) ? lower : upper;
+  return (w > 0.0) ? w : 0.0;
+}
+
+// ---- Fixed-point log2 ----
+
+static int32_t s_log2_tab[65]; // log2(1 + i/64), Q16
+static bool s_log2_ready = false;
+
+static void log2_init() {
+  if (s_log2_ready) return;
+  for (uint32_t i = 0; i <= 64; i++) {
+    s_log2_tab[i] = (int32_t)std::lround(std::log2(1.0 + i / 64.0) * 65536.0);
+  }
+  s_log2_ready = true;
+}
+
+static inline uint32_t clz64(uint64_t v) {
+  const uint32_t hi = (uint32_t)(v >> 32);
+  return hi ? (uint32_t)__builtin_clz(hi) : 32u + (uint32_t)__builtin_clz((uint32_t)v);
+}
+
+// log2(v) in Q16 for v > 0; error < 5e-5
+static inline int32_t log2_q16(uint64_t v) {
+  const int32_t e = 63 - (int32_t)clz64(v);
+  const uint32_t t = (e >= 30) ? (uint32_t)(v >> (e - 30)) : (uint32_t)(v << (30 - e)); // [2^30, 2^31)
+  const uint32_t f = t - (1u << 30);
+  const uint32_t i = f >> 24;
+  const uint32_t fr = f & 0xFFFFFFu;
+  const int32_t a = s_log2_tab[i], b = s_log2_tab[i + 1];
+  return (e << 16) + a + (int32_t)(((int64_t)(b - a) * fr) >> 24);
+}
+
+// ---- Framing (both front ends) ----
+// window_run_() windows samples [at, at + n) of the frame into buf_ and
+// returns the OR of magnitudes (block shift, fixed point only); finish_()
+// transforms and writes the 64 outputs.
+
+struct MelFraming {
+  template <class FE>
+  static void frame(FE& fe, const int16_t* a, uint32_t na, const int16_t* b, float* out, uint32_t stride) {
+    uint32_t peak = fe.window_run_(a, 0, na);
+    if (na < MEL_NFFT) peak |= fe.window_run_(b, na, MEL_NFFT - na);
+    fe.finish_(peak, out, stride);
+  }
+
+  template <class FE>
+  static bool frame(FE& fe, const LoopedSpan& v, uint32_t i, float* out, uint32_t stride) {
+    uint32_t peak = 0, at = 0;
+    while (at < MEL_NFFT) {
+      const int16_t* p = nullptr;
+      const uint32_t m = v.run(i + at, MEL_NFFT - at, &p);
+      if (!m) return false;
+      peak |= fe.window_run_(p, at, m);
+      at += m;
+    }
+    fe.finish_(peak, out, stride);
+    return true;
+  }
+
+  template <class FE>
+  static uint32_t compute(FE& fe, const SpeechRing& ring, uint32_t pos, uint32_t n, float* out, uint32_t max_frames) {
+    uint32_t frames = mel_frames(n);
+    if (frames > max_frames) frames = max_frames;
+    for (uint32_t i = 0; i < frames; i++) {
+      const SpeechSpan sp = ring.span(pos + i * MEL_HOP, MEL_NFFT);
+      if (sp.total() != MEL_NFFT) return i;
+      frame(fe, sp.seg[0], sp.len[0], sp.seg[1], out + i, max_frames);
+    }
+    return frames;
+  }
+
+  template <class FE>
+  static uint32_t compute(FE& fe, const LoopedSpan& v, float* out, uint32_t max_frames) {
+    uint32_t frames = mel_frames(v.length());
+    if (frames > max_frames) frames = max_frames;
+    for (uint32_t i = 0; i < frames; i++) {
+      if (!frame(fe, v, i * MEL_HOP, out + i, max_frames)) return i;
+    }
+    return frames;
+  }
+};
+
+// ---- Front end (float) ----
+
+void MelFrontEnd::init() {
+  fft_.init();
+  for (uint32_t i = 0; i < MEL_NFFT; i++) {
+    window_[i] = (float)((0.5 - 0.5 * std::cos(2.0 * PI * i / MEL_NFFT)) / 32768.0); // periodic
+  }
+
+  uint16_t off = 0;
+  for (uint32_t k = 0; k < MEL_BINS; k++) {
+    double norm = 0.0;
+    (void)mel_slaney_weight(k, 0, &norm);
+    f_lo_[k] = 0;
+    f_len_[k] = 0;
+    f_off_[k] = off;
+    for (uint32_t bin = 0; bin <= MEL_NFFT / 2u && off < MAX_WEIGHTS; bin++) {
+      const double w = mel_slaney_weight(k, bin, nullptr);
+      if (w <= 0.0) continue;
+      if (f_len_[k] == 0) f_lo_[k] = (uint16_t)bin;
+      // triangles are convex: bins between lo and here are all non-zero
+      f_len_[k] = (uint16_t)(bin - f_lo_[k] + 1u);
+      f_w_[off++] = (float)(w * norm);
+    }
+  }
+}
+
+NCOMM_FAST_CODE uint32_t MelFrontEnd::window_run_(const int16_t* x, uint32_t at, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) buf_[at + i] = (float)x[i] * window_[at + i];
+  return 0;
+}
+
+NCOMM_FAST_CODE void MelFrontEnd::finish_(uint32_t, float* out, uint32_t stride) {
+  fft_.forward(buf_);
+  RealFft<MEL_NFFT>::power(buf_, pow_);
+  for (uint32_t k = 0; k < MEL_BINS; k++) {
+    const float* p = &pow_[f_lo_[k]];
+    const float* w = &f_w_[f_off_[k]];
+    float acc = 0.0f;
+    for (uint32_t j = 0; j < f_len_[k]; j++) acc += p[j] * w[j];
+    out[k * stride] = std::log(acc + MEL_LOG_EPS);
+  }
+}
+
+void MelFrontEnd::frame(const int16_t* a, uint32_t na, const int16_t* b, float* out, uint32_t stride) {
+  MelFraming::frame(*this, a, na, b, out, stride);
+}
+
+bool MelFrontEnd::frame(const LoopedSpan& v, uint32_t i, float* out, uint32_t stride) {
+  return MelFraming::frame(*this, v, i, out, stride);
+}
+
+uint32_t MelFrontEnd::compute(const SpeechRing& ring, uint32_t pos, uint32_t n, float* out, uint32_t max_frames) {
+  return MelFraming::compute(*this, ring, pos, n, out, max_frames);
+}
+
+uint32_t MelFrontEnd::compute(const LoopedSpan& v, float* out, uint32_t max_frames) {
+  return MelFraming::compute(*this, v, out, max_frames);
+}
+
+// ---- Front end (fixed point) ----
+
+void MelFrontEndQ31::init() {
+  log2_init();
+  fft_.init();
+  for (uint32_t i = 0; i < MEL_NFFT; i++) {
+    const double w = 0.5 - 0.5 * std::cos(2.0 * PI * i / MEL_NFFT); // periodic
+    const long q = std::lround(w * 32768.0);
+    window_[i] = (int16_t)(q > 32767 ? 32767 : q);
+  }
+
+  uint16_t off = 0;
+  for (uint32_t k = 0; k < MEL_BINS; k++) {
+    double norm = 0.0;
+    (void)mel_slaney_weight(k, 0, &norm);
+    f_lo_[k] = 0;
+    f_len_[k] = 0;
+    f_off_[k] = off;
+    for (uint32_t bin = 0; bin <= MEL_NFFT / 2u && off < MAX_WEIGHTS; bin++) {
+      const double w = mel_slaney_weight(k, bin, nullptr);
+      if (w <= 0.0) continue;
+      if (f_len_[k] == 0) f_lo_[k] = (uint16_t)bin;
+      // triangles are convex: bins between lo and here are all non-zero
+      f_len_[k] = (uint16_t)(bin - f_lo_[k] + 1u);
+      const long q = std::lround(w * 32768.0);
+      f_w_[off++] = (uint16_t)(q > 32767 ? 32767 : (q < 1 ? 1 : q));
+    }
+    // mel = acc * norm * N^2 * 2^(POW_SHIFT - 15 - 60 - 2s), s = block shift
+    f_log2c_[k] = (float)(std::log2(norm) + 2.0 * std::log2((double)MEL_NFFT) +
+                          (double)POW_SHIFT - 15.0 - 60.0);
+  }
+}
+
+// Window (Q15 x int16 -> < 2^30) samples [at, at + n) of the frame; returns
+// the OR of magnitudes for the block shift.
+NCOMM_FAST_CODE uint32_t MelFrontEndQ31::window_run_(const int16_t* x, uint32_t at, uint32_t n) {
+  uint32_t peak = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    const int32_t v = (int32_t)x[i] * window_[at + i];
+    buf_[at + i] = v;
+    const uint32_t m = (uint32_t)(v < 0 ? -v : v);
+    peak |= m;
+  }
+  return peak;
+}
+
+NCOMM_FAST_CODE void MelFrontEndQ31::finish_(uint32_t peak, float* out, uint32_t stride) {
+  const float ln_eps = std::log(MEL_LOG_EPS);
+  if (peak == 0) {
+    for (uint32_t k = 0; k < MEL_BINS; k++) out[k * stride] = ln_eps;
+    return;
+  }
+  // OR of magnitudes has the same top bit as the max
+  const int32_t s = __builtin_clz(peak) - 2;
+  if (s > 0) {
+    for (uint32_t i = 0; i < MEL_NFFT; i++) buf_[i] = (int32_t)((uint32_t)buf_[i] << s);
+  }
+
+  fft_.forward(buf_);
+
+  pow_[0] = ((uint64_t)((int64_t)buf_[0] * buf_[0])) >> POW_SHIFT;
+  pow_[MEL_NFFT / 2] = ((uint64_t)((int64_t)buf_[1] * buf_[1])) >> POW_SHIFT;
+  for (uint32_t k = 1; k < MEL_NFFT / 2u; k++) {
+    const int64_t re = buf_[2 * k], im = buf_[2 * k + 1];
+    pow_[k] = (uint64_t)(re * re + im * im) >> POW_SHIFT;
+  }
+
+  const float ln2 = 0.69314718f;
+  for (uint32_t k = 0; k < MEL_BINS; k++) {
+    const uint64_t* p = &pow_[f_lo_[k]];
+    const uint16_t* w = &f_w_[f_off_[k]];
+    uint64_t acc = 0;
+    for (uint32_t j = 0; j < f_len_[k]; j++) acc += p[j] * w[j];
+
+    float v = ln_eps;
+    if (acc) {
+      const float l2 = (float)log2_q16(acc) * (1.0f / 65536.0f) + f_log2c_[k] - 2.0f * (float)s;
+      v = l2 * ln2;
+      // ln(mel + eps): the eps term matters only within ~9 nats of the floor
+      if (v < ln_eps + 9.0f) v += std::log1p(std::exp(ln_eps - v));
+    }
+    out[k * stride] = v;
+  }
+}
+
+void MelFrontEndQ31::frame(const int16_t* a, uint32_t na, const int16_t* b, float* out, uint32_t stride) {
+  MelFraming::frame(*this, a, na, b, out, stride);
+}
+
+bool MelFrontEndQ31::frame(const LoopedSpan& v, uint32_t i, float* out, uint32_t stride) {
+  return MelFraming::frame(*this, v, i, out, stride);
+}
+
+uint32_t MelFrontEndQ31::compute(const SpeechRing& ring, uint32_t pos, uint32_t n, float* out, uint32_t max_frames) {
+  return MelFraming::compute(*this, ring, pos, n, out, max_frames);
+}
+
+uint32_t MelFrontEndQ31::compute(const LoopedSpan& v, float* out, uint32_t max_frames) {
+  return MelFraming::compute(*this, v, out, max_frames);
+}
+
+// ---- Streaming frames ----
+
+static_assert((MEL_STREAM_FRAMES & (MEL_STREAM_FRAMES - 1u)) == 0, "MEL_STREAM_FRAMES must be a power of two");
+
+void MelStream::init(MelFrontEnd* fe) {
+  fe_ = fe;
+  stats_ = {};
+  reset(0);
+}
+
+void MelStream::reset(uint32_t head) {
+  next_pos_ = head;
+  next_idx_ = 0;
+  valid_from_ = 0;
+}
+
+uint32_t MelStream::update(const SpeechRing& ring, bool active, uint32_t budget) {
+  if (!fe_) return 0;
+  const uint32_t head = ring.head();
+  if ((int32_t)(head - next_pos_) < 0) reset(head); // ring was reset under us
+
+  if (!active) {
+    // Idle: no frames, the grid trails the head by the pre-roll
+    while (head - next_pos_ > MEL_STREAM_PREROLL) {
+      next_pos_ += MEL_HOP;
+      next_idx_++;
+      valid_from_ = next_idx_;
+      stats_.skipped++;
+    }
+    return 0;
+  }
+
+  uint32_t done = 0;
+  while (done < budget && head - next_pos_ >= MEL_NFFT) {
+    const SpeechSpan sp = ring.span(next_pos_, MEL_NFFT);
+    if (sp.total() == MEL_NFFT) {
+      fe_->frame(sp.seg[0], sp.len[0], sp.seg[1], frames_[next_idx_ & (MEL_STREAM_FRAMES - 1u)], 1);
+      done++;
+      stats_.frames++;
+    } else {
+      valid_from_ = next_idx_ + 1u; // overrun: the audio is gone, leave a gap
+      stats_.skipped++;
+    }
+    next_pos_ += MEL_HOP;
+    next_idx_++;
+  }
+  return done;
+}
+
+uint32_t MelStream::first_idx_(uint32_t pos, uint32_t n, uint32_t* count) const {
+  // Grid frame j starts at next_pos_ - (next_idx_ - j) * MEL_HOP
+  const int32_t d = (int32_t)(next_pos_ - pos);
+  uint32_t idx, off;
+  if (d >= 0) {
+    const uint32_t back = (uint32_t)d / MEL_HOP;
+    idx = next_idx_ - back;
+    off = (uint32_t)d - back * MEL_HOP;
+  } else {
+    const uint32_t ahead = ((uint32_t)-d + MEL_HOP - 1u) / MEL_HOP;
+    idx = next_idx_ + ahead;
+    off = ahead * MEL_HOP - (uint32_t)-d;
+  }
+  *count = (n < off + MEL_NFFT) ? 0 : (n - off - MEL_NFFT) / MEL_HOP + 1u;
+  return idx;
+}
+
+bool MelStream::is_cached_(uint32_t idx) const {
+  const uint32_t age = next_idx_ - idx;
+  return age >= 1u && age <= MEL_STREAM_FRAMES && (int32_t)(idx - valid_from_) >= 0;
+}
+
+uint32_t MelStream::cached(uint32_t pos, uint32_t n) const {
+  uint32_t count;
+  const uint32_t first = first_idx_(pos, n, &count);
+  uint32_t hits = 0;
+  for (uint32_t i = 0; i < count; i++) hits += is_cached_(first + i) ? 1u : 0u;
+  return hits;
+}
+
+uint32_t MelStream::segment(const SpeechRing& ring, uint32_t pos, uint32_t n, float* out,
+                            uint32_t max_frames, uint32_t* hits) {
+  uint32_t count;
+  const uint32_t first = first_idx_(pos, n, &count);
+  if (count > max_frames) count = max_frames;
+  const uint32_t first_pos = next_pos_ - (next_idx_ - first) * MEL_HOP;
+
+  uint32_t h = 0, i = 0;
+  for (; i < count; i++) {
+    const uint32_t idx = first + i;
+    if (is_cached_(idx)) {
+      const float* src = frames_[idx & (MEL_STREAM_FRAMES - 1u)];
+      for (uint32_t k = 0; k < MEL_BINS; k++) out[k * max_frames + i] = src[k];
+      h++;
+      continue;
+    }
+    if (!fe_) break;
+    const SpeechSpan sp = ring.span(first_pos + i * MEL_HOP, MEL_NFFT);
+    if (sp.total() != MEL_NFFT) break;
+    fe_->frame(sp.seg[0], sp.len[0], sp.seg[1], out + i, max_frames);
+  }
+  stats_.hits += h;
+  stats_.misses += i - h;
+  if (hits) *hits = h;
+  return i;
+}
+
+uint32_t MelStream::looped(const LoopedSpan& v, float* out, uint32_t max_frames, uint32_t* hits) {
+  uint32_t count = mel_frames(v.length());
+  if (count > max_frames) count = max_frames;
+
+  uint32_t h = 0, i = 0;
+  for (; i < count; i++) {
+    const uint32_t at = i * MEL_HOP;
+    // Inside the first period a view frame is the ring frame at pos + at
+    if (at + MEL_NFFT <= v.period()) {
+      uint32_t on_grid;
+      const uint32_t idx = first_idx_(v.pos() + at, MEL_NFFT, &on_grid);
+      if (on_grid && is_cached_(idx)) {
+        const float* src = frames_[idx & (MEL_STREAM_FRAMES - 1u)];
+        for (uint32_t k = 0; k < MEL_BINS; k++) out[k * max_frames + i] = src[k];
+        h++;
+        continue;
+      }
+    }
+    if (!fe_ || !fe_->frame(v, at, out + i, max_frames)) break;
+  }
+  stats_.hits += h;
+  stats_.misses += i - h;
+  if (hits) *hits = h;
+  return i;
+}
+
+// ---- SR packets ----
+
+uint32_t mel_grid_align(uint32_t pos, uint32_t grid) {
+  int32_t r = (int32_t)(grid - pos) % (int32_t)MEL_HOP;
+  if (r < 0) r += (int32_t)MEL_HOP;
+  return pos + (uint32_t)r;
+}
+
+uint8_t mel_sr_packets(const SpeechRing& ring, uint32_t pos, uint32_t n, uint32_t grid, LoopedSpan* out) {
+  const uint32_t start = mel_grid_align(pos, grid);
+  const uint32_t skip = start - pos;
+  if (n < skip + SR_MIN_SAMPLES) return 0; // scenario A
+  n -= skip;
+  if (n <= MEL_WINDOW_SAMPLES) {           // scenario B
+    out[0] = LoopedSpan(ring, start, n, MEL_WINDOW_SAMPLES);
+    return 1;
+  }
+  // Scenario C: one plain window, then the rest (from the grid) looped
+  out[0] = LoopedSpan(ring, start, MEL_WINDOW_SAMPLES, MEL_WINDOW_SAMPLES);
+  const uint32_t pos2 = mel_grid_align(start + MEL_WINDOW_SAMPLES, grid);
+  const uint32_t used = pos2 - start;
+  if (n < used + SR_MIN_SAMPLES) return 1;
+  const uint32_t rest = n - used;
+  out[1] = LoopedSpan(ring, pos2, rest < MEL_WINDOW_SAMPLES ? rest : MEL_WINDOW_SAMPLES, MEL_WINDOW_SAMPLES);
+  return 2;
+}
+
+NCOMM_FAST_CODE void mel_cmvn(float* mel, uint32_t frames, uint32_t stride, bool variance, const float* mean, const float* inv_std) {
+  if (!frames) return;
+  for (uint32_t k = 0; k < MEL_BINS; k++) {
+    float* row = &mel[k * stride];
+    float mu, is;
+    if (mean) {
+      mu = mean[k];
+      is = (variance && inv_std) ? inv_std[k] : 1.0f;
+    } else {
+      float s = 0.0f;
+      for (uint32_t i = 0; i < frames; i++) s += row[i];
+      mu = s / (float)frames;
+      is = 1.0f;
+      if (variance) {
+        float v = 0.0f;
+        for (uint32_t i = 0; i < frames; i++) v += (row[i] - mu) * (row[i] - mu);
+        v /= (float)frames;
+        is = 1.0f / std::sqrt(v > MEL_CMVN_VAR_FLOOR ? v : MEL_CMVN_VAR_FLOOR);
+      }
+    }
+    for (uint32_t i = 0; i < frames; i++) row[i] = (row[i] - mu) * is;
+  }
+}
+
+} // namespace ncomm
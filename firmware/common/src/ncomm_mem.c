@@ -0,0 +1,102 @@
+#include "ncomm/ncomm_mem.h"
+#include "ncomm/ncomm_profile.h"
+
+#if defined(__arm__) && !defined(NCOMM_HOST)
+#include "stm32h7xx.h"
+
+// Linker script symbols (STM32H743ZITX_FLASH.ld)
+extern uint32_t _siitcm, _sitcm, _eitcm;
+extern uint32_t _sidtcm_data, _sdtcm_data, _edtcm_data;
+extern uint32_t _sdtcm_bss, _edtcm_bss;
+
+// Runs before constructors: plain word loops, no libc.
+static void copy_words(uint32_t* dst, const uint32_t* src, const uint32_t* end) {
+    while (dst < end) *dst++ = *src++;
+}
+
+void ncomm_mem_init(void) {
+    copy_words(&_sitcm, &_siitcm, &_eitcm);
+    copy_words(&_sdtcm_data, &_sidtcm_data, &_edtcm_data);
+    for (uint32_t* p = &_sdtcm_bss; p < &_edtcm_bss; p++) *p = 0;
+    __DSB();
+    __ISB();
+}
+#else
+void ncomm_mem_init(void) {}
+#endif
+
+#if defined(NCOMM_MEM_BENCH)
+// ===== Placement benchmark (proxy kernel, see ncomm_mem.h) =====
+#define BENCH_FRAME_BYTES (8 + 512) // EVT_AUDIO_FRAME header + 256 samples
+#define BENCH_SAMPLES     256
+
+// Data in DTCM for both runs, so only the instruction fetch path differs.
+static uint8_t s_bench_frame[BENCH_FRAME_BYTES] NCOMM_FAST_DATA;
+static int16_t s_bench_pcm[BENCH_SAMPLES] NCOMM_FAST_DATA;
+
+static inline __attribute__((always_inline)) uint32_t bench_kernel(const uint8_t* frame, uint16_t len,
+                                                                   const int16_t* pcm, uint16_t n) {
+    // CRC16-CCITT-FALSE, bitwise (same loop as ncomm_crc16.c)
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)frame[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            if (crc & 0x8000) crc = (uint16_t)((crc << 1) ^ 0x1021);
+            else crc = (uint16_t)(crc << 1);
+        }
+    }
+
+    // DC-block HPF + abs sum (capture / VAD front)
+    int32_t x1 = 0, y1 = 0;
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        const int32_t x = pcm[i];
+        const int32_t y = x - x1 + (int32_t)(((int64_t)32604 * y1) >> 15);
+        x1 = x;
+        y1 = y;
+        sum += (uint32_t)((y < 0) ? -y : y);
+    }
+    return crc ^ sum;
+}
+
+NCOMM_FAST_CODE static uint32_t kernel_itcm(const uint8_t* frame, uint16_t len, const int16_t* pcm, uint16_t n) {
+    return bench_kernel(frame, len, pcm, n);
+}
+
+__attribute__((noinline)) static uint32_t kernel_flash(const uint8_t* frame, uint16_t len, const int16_t* pcm, uint16_t n) {
+    return bench_kernel(frame, len, pcm, n);
+}
+
+static volatile uint32_t s_bench_sink;
+
+void ncomm_mem_bench(ncomm_mem_bench_t* out, uint16_t iterations) {
+    if (!out) return;
+    if (iterations == 0) iterations = 1;
+
+    for (uint16_t i = 0; i < BENCH_FRAME_BYTES; i++) s_bench_frame[i] = (uint8_t)(i * 37u + 11u);
+    for (uint16_t i = 0; i < BENCH_SAMPLES; i++) s_bench_pcm[i] = (int16_t)((i * 2531u) ^ 0x5A5Au);
+
+#if defined(__arm__) && !defined(NCOMM_HOST)
+    if (SCB->CCR & SCB_CCR_IC_Msk) SCB_InvalidateICache();
+#endif
+    uint32_t t0 = ncomm_cycles_now();
+    s_bench_sink = kernel_flash(s_bench_frame, BENCH_FRAME_BYTES, s_bench_pcm, BENCH_SAMPLES);
+    out->flash_cold = ncomm_cycles_now() - t0;
+
+    uint32_t best_flash = 0xFFFFFFFFu;
+    uint32_t best_itcm = 0xFFFFFFFFu;
+    for (uint16_t it = 0; it < iterations; it++) {
+        t0 = ncomm_cycles_now();
+        s_bench_sink = kernel_flash(s_bench_frame, BENCH_FRAME_BYTES, s_bench_pcm, BENCH_SAMPLES);
+        uint32_t dt = ncomm_cycles_now() - t0;
+        if (dt < best_flash) best_flash = dt;
+
+        t0 = ncomm_cycles_now();
+        s_bench_sink = kernel_itcm(s_bench_frame, BENCH_FRAME_BYTES, s_bench_pcm, BENCH_SAMPLES);
+        dt = ncomm_cycles_now() - t0;
+        if (dt < best_itcm) best_itcm = dt;
+    }
+    out->flash_warm = best_flash;
+    out->itcm = best_itcm;
+}
+#endif // NCOMM_MEM_BENCH
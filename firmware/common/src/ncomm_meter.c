@@ -0,0 +1,26 @@
+#include "ncomm/ncomm_meter.h"
+
+// Bitwise integer square root, 16 iterations for a 32-bit argument.
+static uint32_t isqrt32(uint32_t v) {
+    uint32_t r = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+uint16_t ncomm_meter_rms(const ncomm_meter_t* m) {
+    if (!m || m->n == 0) return 0;
+    // mean square <= 32768^2 = 2^30, fits 32 bits
+    const uint64_t ms = m->sumsq / m->n;
+    const uint32_t r = isqrt32((ms > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t)ms);
+    return (uint16_t)((r > 32767u) ? 32767u : r);
+}
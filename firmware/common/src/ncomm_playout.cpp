@@ -0,0 +1,340 @@
+#include "ncomm/ncomm_playout.hpp"
+
+#include <cstring>
+
+#include "ncomm/ncomm_mem.h"
+
+namespace ncomm {
+
+static constexpr uint32_t SAMPLES_PER_MS = 16;
+static constexpr uint32_t MASK = PLAYOUT_RING - 1u;
+static constexpr uint32_t MAX_TRIM = 256; // per decay window
+static constexpr uint32_t MIN_TRIM = 16;  // smaller excess is not worth a cross-fade
+
+// ASRC
+static constexpr uint32_t TAPS_AHEAD = 2;                // x[n+1], x[n+2]; x[n-1] stays in the ring
+static constexpr int32_t FIT_RESYNC = 100 * SAMPLES_PER_MS;
+static constexpr uint32_t FIT_MIN_BLOCKS = 32;           // ~16 s before the first estimate
+static constexpr double FIT_FORGET = 1.0 - 1.0 / 64.0;   // per block, ~32 s memory
+static constexpr double MAX_RATIO = 1e-3;                // |drift| <= 1000 ppm
+static constexpr uint32_t SETTLE = 1000 * SAMPLES_PER_MS; // after a start, before holding the depth
+static constexpr int32_t SERVO_PPB = 2000;               // per sample of depth error (tau ~30 s)
+static constexpr int32_t SERVO_MAX_PPB = 100000;         // 100 ppm
+
+static_assert((PLAYOUT_RING & MASK) == 0, "PLAYOUT_RING must be a power of two");
+
+static inline uint32_t samples_to_us(uint32_t s) { return s * 125u / 2u; }
+
+void PlayoutBuffer::init(const PlayoutConfig& cfg) {
+  cfg_ = cfg;
+  wr_.store(0, std::memory_order_relaxed);
+  rd_.store(0, std::memory_order_relaxed);
+  while (tags_.pop(nullptr)) {
+  }
+  state_ = State::IDLE;
+  target_ = cfg_.start_ms * SAMPLES_PER_MS;
+  gap_ = 0;
+  fade_in_ = 0;
+  trim_ = 0;
+  win_ = 0;
+  win_min_ = 0xFFFFFFFFu;
+  win_underrun_ = false;
+  std::memset(hist_, 0, sizeof(hist_));
+  hist_at_ = 0;
+  lat_ema_ = 0;
+  frac_ = 0;
+  step_ = 0;
+  avg_ = -1;
+  ref_ = -1;
+  settle_ = 0;
+  ff_.store(0, std::memory_order_relaxed);
+  fit_on_ = false;
+  stats_ = {};
+}
+
+void PlayoutBuffer::stats_reset() {
+  stats_ = {};
+  lat_ema_ = 0;
+}
+
+bool PlayoutBuffer::push(const int16_t* pcm, uint32_t n, uint32_t now, uint32_t src) {
+  if (src != PLAYOUT_NO_SRC && cfg_.asrc) fit_(src, now);
+  const uint32_t wr = wr_.load(std::memory_order_relaxed);
+  // One slot stays free: the sample before the read point is an ASRC tap
+  const uint32_t free = PLAYOUT_RING - 1u - (wr - rd_.load(std::memory_order_acquire));
+  const uint32_t m = n < free ? n : free;
+  stats_.pushed += m;
+  stats_.overflow += n - m;
+  if (!m) return false;
+  const uint32_t at = wr & MASK;
+  const uint32_t first = (PLAYOUT_RING - at) < m ? (PLAYOUT_RING - at) : m;
+  std::memcpy(&ring_[at], pcm, first * sizeof(int16_t));
+  std::memcpy(ring_, pcm + first, (m - first) * sizeof(int16_t));
+  tags_.push(Tag{wr, now});
+  wr_.store(wr + m, std::memory_order_release);
+  return m == n;
+}
+
+// Latency of every chunk whose first sample is in [rd, rd + n); tags of
+// samples already skipped (trim) are dropped.
+void PlayoutBuffer::tag_latency_(uint32_t rd, uint32_t n, uint32_t pos) {
+  while (Tag* t = tags_.front()) {
+    const int32_t off = (int32_t)(t->start - rd);
+    if (off >= (int32_t)n) break;
+    if (off >= 0) {
+      const uint32_t lat = pos + (uint32_t)off - t->arrival;
+      // Mean depth for the ASRC: chunk latency does not alias with the
+      // chunk / block phase the way the ring depth does
+      avg_ = avg_ < 0 ? (int32_t)(lat << 8) : avg_ + (((int32_t)(lat << 8) - avg_) >> 4);
+      const uint32_t us = samples_to_us(lat);
+      stats_.lat_last_us = us;
+      if (!stats_.lat_min_us || us < stats_.lat_min_us) stats_.lat_min_us = us;
+      if (us > stats_.lat_max_us) stats_.lat_max_us = us;
+      lat_ema_ = lat_ema_ ? lat_ema_ - (lat_ema_ >> 4) + us : (uint64_t)us << 4;
+      stats_.lat_avg_us = (uint32_t)(lat_ema_ >> 4);
+    }
+    tags_.pop();
+  }
+}
+
+// Sample at read position rd + frac / 2^32: 4-tap cubic Lagrange
+// interpolation x[-1..2] in Farrow form (3 multiply-adds in mu per sample).
+// frac == 0 is the sample itself.
+int16_t PlayoutBuffer::tap_(uint32_t rd, uint32_t frac) const {
+  if (!frac) return ring_[rd & MASK];
+  const float xm1 = ring_[(rd - 1u) & MASK];
+  const float x0 = ring_[rd & MASK];
+  const float x1 = ring_[(rd + 1u) & MASK];
+  const float x2 = ring_[(rd + 2u) & MASK];
+  const float mu = (float)(frac >> 8) * (1.0f / 16777216.0f);
+  const float c1 = x1 - (1.0f / 3.0f) * xm1 - 0.5f * x0 - (1.0f / 6.0f) * x2;
+  const float c2 = 0.5f * (xm1 + x1) - x0;
+  const float c3 = (1.0f / 6.0f) * (x2 - xm1) + 0.5f * (x0 - x1);
+  const float y = ((c3 * mu + c2) * mu + c1) * mu + x0;
+  const int32_t v = (int32_t)(y + (y >= 0.0f ? 0.5f : -0.5f));
+  return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+// Up to n samples at the ASRC step (one source sample per output sample
+// when step_ == 0 and frac_ == 0: a plain copy); stops when the taps run
+// past the data. Applies a pending trim (cross-fade from the current read
+// point to the one trim_ samples later) and the fade-in. *first: ring index
+// the kept samples start at (after the trim).
+uint32_t PlayoutBuffer::read_(int16_t* out, uint32_t n, uint32_t* first) {
+  uint32_t rd = rd_.load(std::memory_order_relaxed);
+  uint32_t d = wr_.load(std::memory_order_acquire) - rd;
+  uint32_t skip = 0;
+  if (trim_ && d >= trim_ + n + PLAYOUT_FADE + TAPS_AHEAD) {
+    skip = trim_;
+    stats_.trimmed += trim_;
+    stats_.trims++;
+    if (ref_ >= 0) {
+      ref_ -= (int32_t)(trim_ << 8);
+      avg_ -= (int32_t)(trim_ << 8);
+    }
+  }
+  trim_ = 0;
+  *first = rd + skip;
+
+  uint32_t frac = frac_;
+  const uint32_t step = (uint32_t)step_;
+  const bool up = step_ >= 0;
+  uint32_t k = 0;
+  for (; k < n; k++) {
+    if (d < (frac ? TAPS_AHEAD + 1u : 1u)) break;
+    int32_t s = tap_(rd, frac);
+    if (skip) {
+      const int32_t b = tap_(rd + skip, frac);
+      s = (s * (int32_t)(PLAYOUT_FADE - k) + b * (int32_t)k) / (int32_t)PLAYOUT_FADE;
+      if (k + 1u == PLAYOUT_FADE) {
+        rd += skip;
+        d -= skip;
+        skip = 0;
+      }
+    }
+    out[k] = (int16_t)s;
+    // Advance 1 + step / 2^32 source samples: 0, 1 or 2 whole ones
+    const uint32_t f = frac + step;
+    const uint32_t adv = up ? (f < frac ? 2u : 1u) : (f > frac ? 0u : 1u);
+    frac = f;
+    rd += adv;
+    d -= adv;
+  }
+  frac_ = frac;
+  for (uint32_t i = 0; fade_in_ && i < k; i++, fade_in_--) {
+    const int32_t g = (int32_t)(PLAYOUT_FADE - fade_in_);
+    out[i] = (int16_t)((out[i] * g) / (int32_t)PLAYOUT_FADE);
+  }
+  rd_.store(rd, std::memory_order_release);
+  return k;
+}
+
+// Last period repeated, linear fade to silence over conceal_ms
+void PlayoutBuffer::conceal_(int16_t* out, uint32_t n) {
+  const uint32_t len = cfg_.conceal_ms * SAMPLES_PER_MS;
+  for (uint32_t i = 0; i < n; i++, gap_++) {
+    if (gap_ >= len) {
+      out[i] = 0;
+      continue;
+    }
+    const int32_t s = hist_[(hist_at_ + gap_) % PLAYOUT_PERIOD];
+    out[i] = (int16_t)(s * (int32_t)(len - gap_) / (int32_t)len);
+    stats_.concealed++;
+  }
+}
+
+void PlayoutBuffer::remember_(const int16_t* out, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    hist_[hist_at_] = out[i];
+    hist_at_ = hist_at_ + 1u == PLAYOUT_PERIOD ? 0u : hist_at_ + 1u;
+  }
+}
+
+// Decay window: lower the target to what the window needed and trim the
+// spare depth beyond it (half per window). The spare is seen at pulls only;
+// as the clocks drift the pulls slide through the chunk phase and the same
+// buffer shows up to a block less, so a block stays on top of the floor.
+void PlayoutBuffer::adapt_(uint32_t spare, uint32_t n) {
+  if (spare < win_min_) win_min_ = spare;
+  win_ += n;
+  if (win_ < (uint32_t)cfg_.decay_ms * SAMPLES_PER_MS) return;
+  const uint32_t floor = cfg_.min_ms * SAMPLES_PER_MS + n;
+  if (!win_underrun_ && win_min_ != 0xFFFFFFFFu && win_min_ >= floor + 2u * MIN_TRIM) {
+    uint32_t excess = (win_min_ - floor) / 2u;
+    if (excess > MAX_TRIM) excess = MAX_TRIM;
+    trim_ = excess;
+    target_ = target_ > floor + excess ? target_ - excess : floor;
+  }
+  win_ = 0;
+  win_min_ = 0xFFFFFFFFu;
+  win_underrun_ = false;
+}
+
+void PlayoutBuffer::fit_reset_(uint32_t src, uint32_t at) {
+  fit_on_ = true;
+  src0_ = src;
+  at0_ = at;
+  last_y_ = 0;
+  blk_n_ = 0;
+  fit_blocks_ = 0;
+  s0_ = sx_ = sy_ = sxx_ = sxy_ = 0;
+  stats_.fits++;
+}
+
+// Producer: one chunk, source position src arrived at output position at.
+// y = arrival - source position drifts by -ratio per source sample on top
+// of the link delay; the block minima sit on the zero-delay line.
+void PlayoutBuffer::fit_(uint32_t src, uint32_t at) {
+  if (!fit_on_) fit_reset_(src, at);
+  int32_t x = (int32_t)(src - src0_);
+  int32_t y = (int32_t)(at - at0_) - x;
+  if (x < 0 || y - last_y_ > FIT_RESYNC || last_y_ - y > FIT_RESYNC) {
+    fit_reset_(src, at);
+    x = 0;
+    y = 0;
+  }
+  last_y_ = y;
+  if (!blk_n_ || y < blk_y_) {
+    blk_x_ = x;
+    blk_y_ = y;
+  }
+  if (++blk_n_ < PLAYOUT_FIT_CHUNKS) return;
+  blk_n_ = 0;
+
+  const double bx = blk_x_, by = blk_y_;
+  s0_ = s0_ * FIT_FORGET + 1.0;
+  sx_ = sx_ * FIT_FORGET + bx;
+  sy_ = sy_ * FIT_FORGET + by;
+  sxx_ = sxx_ * FIT_FORGET + bx * bx;
+  sxy_ = sxy_ * FIT_FORGET + bx * by;
+  if (++fit_blocks_ < FIT_MIN_BLOCKS) return;
+  const double den = s0_ * sxx_ - sx_ * sx_;
+  if (den <= 0.0) return;
+  const double slope = (s0_ * sxy_ - sx_ * sy_) / den; // output per source sample - 1
+  double ratio = 1.0 / (1.0 + slope) - 1.0;            // source per output sample - 1
+  if (ratio > MAX_RATIO) ratio = MAX_RATIO;
+  if (ratio < -MAX_RATIO) ratio = -MAX_RATIO;
+  stats_.drift_ppb = (int32_t)(ratio * 1e9 + (ratio >= 0.0 ? 0.5 : -0.5));
+  ff_.store((int32_t)(ratio * 4294967296.0), std::memory_order_relaxed);
+}
+
+// Consumer: read step = drift estimate + correction of the mean depth
+// (chunk latency) towards ref_ (latched SETTLE after a start, moved by trims).
+void PlayoutBuffer::servo_(uint32_t n) {
+  if (!cfg_.asrc) return;
+  if (ref_ < 0) {
+    settle_ = settle_ > n ? settle_ - n : 0u;
+    if (!settle_ && avg_ >= 0) ref_ = avg_;
+  }
+  int32_t corr = 0; // ppb
+  if (ref_ >= 0) {
+    corr = (int32_t)(((int64_t)(avg_ - ref_) * SERVO_PPB) >> 8);
+    if (corr > SERVO_MAX_PPB) corr = SERVO_MAX_PPB;
+    if (corr < -SERVO_MAX_PPB) corr = -SERVO_MAX_PPB;
+  }
+  step_ = ff_.load(std::memory_order_relaxed) + (int32_t)(((int64_t)corr << 32) / 1000000000);
+  stats_.ratio_ppb = (int32_t)(((int64_t)step_ * 1000000000) >> 32);
+}
+
+NCOMM_FAST_CODE void PlayoutBuffer::pull(int16_t* out, uint32_t n, uint32_t pos) {
+  if (n > PLAYOUT_MAX_BLOCK) n = PLAYOUT_MAX_BLOCK;
+  const uint32_t d = depth();
+  if (d > stats_.depth_max) stats_.depth_max = d;
+  // Samples the read needs beyond the block: the ASRC taps ahead
+  const uint32_t ahead = cfg_.asrc ? TAPS_AHEAD + 1u : 0u;
+
+  if (state_ != State::PLAY) {
+    // Resuming after an underrun waits for the deeper target it implies
+    const uint32_t max = cfg_.max_ms * SAMPLES_PER_MS;
+    uint32_t need = target_;
+    if (state_ == State::CONCEAL) need = need + cfg_.step_ms * SAMPLES_PER_MS > max ? max : need + cfg_.step_ms * SAMPLES_PER_MS;
+    if (d < n + ahead + need) {
+      if (state_ == State::CONCEAL) {
+        conceal_(out, n);
+        if (gap_ >= (uint32_t)cfg_.idle_ms * SAMPLES_PER_MS) {
+          state_ = State::IDLE;
+          stats_.stops++;
+        }
+      } else {
+        std::memset(out, 0, n * sizeof(int16_t));
+      }
+      return;
+    }
+    if (state_ == State::CONCEAL) {
+      // Data back within idle_ms: an underrun, buffer deeper from now on
+      stats_.underruns++;
+      win_underrun_ = true;
+      target_ = need;
+    } else {
+      stats_.starts++;
+    }
+    state_ = State::PLAY;
+    fade_in_ = PLAYOUT_FADE;
+    trim_ = 0;
+    avg_ = -1;
+    ref_ = -1;
+    settle_ = SETTLE;
+  }
+
+  servo_(n);
+  uint32_t first;
+  const uint32_t k = read_(out, n, &first);
+  tag_latency_(first, rd_.load(std::memory_order_relaxed) - first, pos);
+  remember_(out, k);
+  if (k < n) {
+    gap_ = 0;
+    conceal_(out + k, n - k);
+    state_ = State::CONCEAL;
+    return;
+  }
+  adapt_(d >= n + ahead ? d - n - ahead : 0u, n);
+}
+
+void playout_pack_i2s32(const int16_t* left, const int16_t* right, uint32_t* out, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    out[2u * i] = (uint32_t)(uint16_t)left[i] << 16;
+    out[2u * i + 1u] = (uint32_t)(uint16_t)right[i] << 16;
+  }
+}
+
+} // namespace ncomm
@@ -0,0 +1,168 @@
+#include "ncomm/ncomm_profile.h"
+
+#include <string.h>
+
+static const char* const k_zone_names[NCOMM_PZ_COUNT] = {
+    "vad", "ve", "kws", "sr", "playout", "resample", "parser",
+};
+
+const char* ncomm_prof_zone_name(uint8_t zone) {
+    return (zone < NCOMM_PZ_COUNT) ? k_zone_names[zone] : "?";
+}
+
+#if defined(NCOMM_PROFILE)
+
+#include "ncomm/ncomm_mem.h"
+
+typedef struct {
+    uint32_t count;
+    uint32_t sum;
+    uint32_t min;
+    uint32_t max;
+    uint16_t hist[NCOMM_PROF_HIST_BUCKETS];
+} zone_t;
+
+static zone_t s_zones[NCOMM_PZ_COUNT] NCOMM_FAST_DATA;
+
+#if defined(__arm__) && !defined(NCOMM_HOST)
+static inline uint32_t irq_save(void) {
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask) {
+    __set_PRIMASK(primask);
+}
+
+static inline uint32_t msb32(uint32_t v) {
+    return 31u - __CLZ(v);
+}
+#else
+static inline uint32_t irq_save(void) { return 0; }
+static inline void irq_restore(uint32_t primask) { (void)primask; }
+
+static inline uint32_t msb32(uint32_t v) {
+    return 31u - (uint32_t)__builtin_clz(v);
+}
+#endif
+
+// 0..7 exact; above: 4 buckets per octave (two bits under the MSB)
+static inline uint32_t bucket_of(uint32_t v) {
+    if (v < 8u) return v;
+    const uint32_t msb = msb32(v);
+    const uint32_t idx = 8u + (msb - 3u) * 4u + ((v >> (msb - 2u)) & 3u);
+    return (idx < NCOMM_PROF_HIST_BUCKETS) ? idx : NCOMM_PROF_HIST_BUCKETS - 1u;
+}
+
+static inline uint32_t bucket_upper(uint32_t idx) {
+    if (idx < 8u) return idx;
+    const uint32_t msb = 3u + (idx - 8u) / 4u;
+    const uint32_t sub = (idx - 8u) % 4u;
+    return ((4u + sub + 1u) << (msb - 2u)) - 1u;
+}
+
+static void zone_clear(zone_t* z) {
+    memset(z, 0, sizeof(*z));
+    z->min = 0xFFFFFFFFu;
+}
+
+void ncomm_prof_init(void) {
+    ncomm_prof_reset();
+}
+
+NCOMM_FAST_CODE void ncomm_prof_record(uint8_t zone, uint32_t cycles) {
+    if (zone >= NCOMM_PZ_COUNT) return;
+    zone_t* z = &s_zones[zone];
+    const uint32_t b = bucket_of(cycles);
+
+    const uint32_t pm = irq_save();
+    z->count++;
+    z->sum += cycles;
+    if (cycles < z->min) z->min = cycles;
+    if (cycles > z->max) z->max = cycles;
+    if (z->hist[b] != 0xFFFFu) z->hist[b]++;
+    irq_restore(pm);
+}
+
+void ncomm_prof_get(uint8_t zone, ncomm_prof_rec_t* out) {
+    memset(out, 0, sizeof(*out));
+    if (zone >= NCOMM_PZ_COUNT) return;
+
+    zone_t z;
+    const uint32_t pm = irq_save();
+    z = s_zones[zone];
+    irq_restore(pm);
+
+    if (z.count == 0) return;
+    out->count = z.count;
+    out->min = z.min;
+    out->max = z.max;
+    out->avg = z.sum / z.count;
+
+    // p99: first bucket where the cumulative count reaches ceil(0.99 * n)
+    uint32_t n = 0;
+    for (uint32_t b = 0; b < NCOMM_PROF_HIST_BUCKETS; b++) n += z.hist[b];
+    const uint32_t target = n - n / 100u;
+    uint32_t acc = 0;
+    out->p99 = z.max;
+    for (uint32_t b = 0; b < NCOMM_PROF_HIST_BUCKETS; b++) {
+        acc += z.hist[b];
+        if (acc >= target) {
+            const uint32_t up = bucket_upper(b);
+            out->p99 = (up < z.max) ? up : z.max;
+            break;
+        }
+    }
+}
+
+void ncomm_prof_reset(void) {
+    for (uint8_t i = 0; i < NCOMM_PZ_COUNT; i++) {
+        const uint32_t pm = irq_save();
+        zone_clear(&s_zones[i]);
+        irq_restore(pm);
+    }
+}
+
+static inline void wr_le16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void wr_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+uint16_t ncomm_prof_snapshot(uint8_t* payload, uint16_t cap, uint16_t window_ms) {
+    if (!payload || cap < NCOMM_PROF_MAX_PAYLOAD) return 0;
+
+#if defined(__arm__) && !defined(NCOMM_HOST)
+    const uint16_t mhz = (uint16_t)(SystemCoreClock / 1000000u);
+#else
+    const uint16_t mhz = 0;
+#endif
+
+    uint8_t* p = payload + NCOMM_PROF_HDR_SIZE;
+    uint8_t active = 0;
+    for (uint8_t zone = 0; zone < NCOMM_PZ_COUNT; zone++) {
+        ncomm_prof_rec_t r;
+        ncomm_prof_get(zone, &r);
+        if (r.count == 0) continue;
+        p[0] = zone;
+        p[1] = 0;
+        wr_le16(&p[2], (uint16_t)((r.count > 0xFFFFu) ? 0xFFFFu : r.count));
+        wr_le32(&p[4], r.min);
+        wr_le32(&p[8], r.avg);
+        wr_le32(&p[12], r.max);
+        wr_le32(&p[16], r.p99);
+        p += NCOMM_PROF_REC_SIZE;
+        active++;
+    }
+    ncomm_prof_reset();
+
+    payload[0] = NCOMM_PROF_VER;
+    payload[1] = active;
+    wr_le16(&payload[2], window_ms);
+    wr_le16(&payload[4], mhz);
+    payload[6] = 0;
+    payload[7] = 0;
+    return (uint16_t)(p - payload);
+}
+
+#endif
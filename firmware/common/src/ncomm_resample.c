@@ -0,0 +1,119 @@
+#include "ncomm/ncomm_resample.h"
+#include "ncomm/ncomm_mem.h"
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__ARM_FEATURE_DSP)
+#include "cmsis_compiler.h"
+#endif
+
+static inline int16_t sat16(int32_t v) {
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
+
+// Prototype design: h[i], i = 0 .. L*T-1, at the upsampled rate L*fs_in.
+// Gain L restores amplitude lost by zero insertion.
+static void design(ncomm_resampler_t* rs) {
+    const uint16_t L = rs->L;
+    const uint16_t M = rs->M;
+    const uint16_t N = (uint16_t)(L * NCOMM_RS_TAPS);
+    const float fc = 0.9f * 0.5f / (float)((L > M) ? L : M); // cycles per (upsampled) sample
+    const float mid = 0.5f * (float)(N - 1);
+    const float pi = 3.14159265f;
+
+    for (uint16_t i = 0; i < N; i++) {
+        const float t = (float)i - mid;
+        const float sinc = (t == 0.0f) ? 2.0f * fc : sinf(2.0f * pi * fc * t) / (pi * t);
+        const float w = 0.42f - 0.5f * cosf(2.0f * pi * (float)i / (float)(N - 1))
+                      + 0.08f * cosf(4.0f * pi * (float)i / (float)(N - 1));
+        const float h = sinc * w * (float)L;
+        int32_t q = (int32_t)lrintf(h * 32768.0f);
+        // branch p holds h[p + k*L], k = 0 .. T-1
+        rs->coef[i % L][i / L] = sat16(q);
+    }
+}
+
+bool ncomm_resampler_init(ncomm_resampler_t* rs, uint8_t L, uint8_t M) {
+    if (!rs || L == 0 || M == 0 || L > NCOMM_RS_MAX_L) return false;
+    memset(rs, 0, sizeof(*rs));
+    rs->L = L;
+    rs->M = M;
+    if (L != M) design(rs);
+    ncomm_resampler_reset(rs);
+    return true;
+}
+
+void ncomm_resampler_reset(ncomm_resampler_t* rs) {
+    memset(rs->hist, 0, sizeof(rs->hist));
+    rs->hist_pos = 0;
+    rs->phase = rs->L; // first output needs one input
+}
+
+bool ncomm_resampler_init_decim(ncomm_resampler_t* rs, uint8_t rate) {
+    switch (rate) {
+        case NCOMM_RATE_8K:  return ncomm_resampler_init(rs, 1, 2);
+        case NCOMM_RATE_12K: return ncomm_resampler_init(rs, 3, 4);
+        default:             return ncomm_resampler_init(rs, 1, 1);
+    }
+}
+
+bool ncomm_resampler_init_interp(ncomm_resampler_t* rs, uint8_t rate) {
+    switch (rate) {
+        case NCOMM_RATE_8K:  return ncomm_resampler_init(rs, 2, 1);
+        case NCOMM_RATE_12K: return ncomm_resampler_init(rs, 4, 3);
+        default:             return ncomm_resampler_init(rs, 1, 1);
+    }
+}
+
+static inline void push(ncomm_resampler_t* rs, int16_t x) {
+    uint8_t pos = rs->hist_pos;
+    pos = (pos == 0) ? (uint8_t)(NCOMM_RS_TAPS - 1) : (uint8_t)(pos - 1);
+    rs->hist[pos] = x;
+    rs->hist[pos + NCOMM_RS_TAPS] = x;
+    rs->hist_pos = pos;
+}
+
+static inline int16_t dot(const int16_t* c, const int16_t* x) {
+    int32_t acc = 1 << 14; // rounding
+#if defined(__ARM_FEATURE_DSP)
+    // x may be 2-byte aligned only (hist_pos odd): unaligned LDR is fine on M7
+    for (uint16_t k = 0; k < NCOMM_RS_TAPS; k += 2) {
+        uint32_t cc, xx;
+        memcpy(&cc, &c[k], 4);
+        memcpy(&xx, &x[k], 4);
+        acc = (int32_t)__SMLAD(cc, xx, (uint32_t)acc);
+    }
+#else
+    for (uint16_t k = 0; k < NCOMM_RS_TAPS; k++) acc += (int32_t)c[k] * x[k];
+#endif
+    return sat16(acc >> 15);
+}
+
+NCOMM_FAST_CODE uint16_t ncomm_resampler_process(ncomm_resampler_t* rs, const int16_t* in, uint16_t n_in,
+                                 int16_t* out, uint16_t out_cap) {
+    if (ncomm_resampler_is_bypass(rs)) {
+        const uint16_t n = (n_in < out_cap) ? n_in : out_cap;
+        if (out != in) memmove(out, in, (size_t)n * sizeof(int16_t));
+        return n;
+    }
+
+    const uint8_t L = rs->L;
+    const uint8_t M = rs->M;
+    uint16_t i = 0;
+    uint16_t o = 0;
+
+    for (;;) {
+        // consume inputs first so a full output block never strands one
+        while (rs->phase >= L) {
+            if (i >= n_in) return o;
+            push(rs, in[i++]);
+            rs->phase = (uint8_t)(rs->phase - L);
+        }
+        if (o >= out_cap) return o;
+        out[o++] = dot(rs->coef[rs->phase], &rs->hist[rs->hist_pos]);
+        rs->phase = (uint8_t)(rs->phase + M);
+    }
+}
@@ -0,0 +1,114 @@
+#include "ncomm/ncomm_speech.hpp"
+
+#include <cstring>
+
+#include "ncomm/ncomm_brick.hpp"
+
+namespace ncomm {
+
+void SpeechRing::init(int16_t* storage, uint32_t capacity) {
+  buf_ = storage;
+  cap_ = (storage && capacity && (capacity & (capacity - 1u)) == 0) ? capacity : 0;
+  mask_ = cap_ ? cap_ - 1u : 0;
+  reset();
+}
+
+void SpeechRing::reset() {
+  head_ = 0;
+  filled_ = 0;
+}
+
+void SpeechRing::write(const int16_t* pcm, uint32_t n) {
+  if (!cap_ || !pcm || !n) return;
+  if (n > cap_) {
+    // only the newest cap_ samples survive
+    head_ += n - cap_;
+    pcm += n - cap_;
+    n = cap_;
+  }
+  const uint32_t at = head_ & mask_;
+  const uint32_t first = (cap_ - at < n) ? cap_ - at : n;
+  std::memcpy(&buf_[at], pcm, first * sizeof(int16_t));
+  std::memcpy(buf_, pcm + first, (n - first) * sizeof(int16_t));
+  head_ += n;
+  filled_ = (cap_ - filled_ < n) ? cap_ : filled_ + n;
+}
+
+uint32_t SpeechRing::available(uint32_t pos) const {
+  const uint32_t behind = head_ - pos; // modular: > filled_ if pos is too old or in the future
+  return (behind <= filled_) ? behind : 0;
+}
+
+SpeechSpan SpeechRing::span(uint32_t pos, uint32_t n) const {
+  SpeechSpan s;
+  const uint32_t avail = available(pos);
+  if (n > avail) n = avail;
+  if (!n) return s;
+  const uint32_t at = pos & mask_;
+  const uint32_t first = (cap_ - at < n) ? cap_ - at : n;
+  s.seg[0] = &buf_[at];
+  s.len[0] = first;
+  if (n > first) {
+    s.seg[1] = buf_;
+    s.len[1] = n - first;
+  }
+  return s;
+}
+
+uint32_t SpeechRing::read(uint32_t pos, int16_t* out, uint32_t n) const {
+  const SpeechSpan s = span(pos, n);
+  if (!out) return 0;
+  std::memcpy(out, s.seg[0], s.len[0] * sizeof(int16_t));
+  std::memcpy(out + s.len[0], s.seg[1], s.len[1] * sizeof(int16_t));
+  return s.total();
+}
+
+uint32_t SpeechRing::read_float(uint32_t pos, float* out, uint32_t n, float scale) const {
+  const SpeechSpan s = span(pos, n);
+  if (!out) return 0;
+  int16_to_float(s.seg[0], out, s.len[0], scale);
+  int16_to_float(s.seg[1], out + s.len[0], s.len[1], scale);
+  return s.total();
+}
+
+// (float)x * scale * w: same rounding as converting first and windowing the
+// float copy, without the copy.
+static void int16_window(const int16_t* in, const float* w, float* out, uint32_t n, float scale) {
+  for (uint32_t i = 0; i < n; i++) out[i] = ((float)in[i] * scale) * w[i];
+}
+
+uint32_t SpeechRing::read_windowed(uint32_t pos, const float* window, float* out, uint32_t n,
+                                   float scale) const {
+  const SpeechSpan s = span(pos, n);
+  if (!out || !window) return 0;
+  int16_window(s.seg[0], window, out, s.len[0], scale);
+  int16_window(s.seg[1], window + s.len[0], out + s.len[0], s.len[1], scale);
+  return s.total();
+}
+
+// ===== Looped view =====
+
+uint32_t LoopedSpan::run(uint32_t i, uint32_t n, const int16_t** p) const {
+  if (!ring_ || i >= len_) return 0;
+  if (n > len_ - i) n = len_ - i;
+  const uint32_t j = i % period_;
+  if (n > period_ - j) n = period_ - j;
+  const SpeechSpan s = ring_->span(pos_ + j, n);
+  if (s.total() != n) return 0;
+  *p = s.seg[0];
+  return s.len[0];
+}
+
+uint32_t LoopedSpan::read(uint32_t i, int16_t* out, uint32_t n) const {
+  uint32_t done = 0;
+  while (done < n) {
+    const int16_t* p = nullptr;
+    const uint32_t m = run(i + done, n - done, &p);
+    if (!m) break;
+    std::memcpy(out + done, p, m * sizeof(int16_t));
+    done += m;
+  }
+  return done;
+}
+
+} // namespace ncomm
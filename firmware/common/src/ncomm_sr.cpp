@@ -0,0 +1,335 @@
+#include "ncomm/ncomm_sr.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_FEATURE_DSP) && !defined(NCOMM_HOST)
+#include "stm32h7xx.h" // __SMLAD
+#define NCOMM_SR_SIMD 1
+#endif
+
+namespace ncomm {
+
+static_assert(SR_EMB_DIM % 2 == 0, "Q15 rows are read as halfword pairs");
+
+static constexpr float Q15_SQ = 32767.0f * 32767.0f;
+
+// ===== Weibull =====
+
+float sr_weibull_cdf(const SrWeibull& w, float distance) {
+  if (w.shape <= 0.0f || w.scale <= 0.0f || distance <= 0.0f) return 0.0f;
+  return 1.0f - std::exp(-std::pow(distance / w.scale, w.shape));
+}
+
+// MLE: g(k) = sum d^k ln d / sum d^k - 1/k - mean ln d = 0 is increasing in k
+static double weibull_g(const float* d, uint32_t n, double k, double mean_ln) {
+  double a = 0.0, b = 0.0;
+  for (uint32_t i = 0; i < n; i++) {
+    const double p = std::pow((double)d[i], k);
+    a += p * std::log((double)d[i]);
+    b += p;
+  }
+  return a / b - 1.0 / k - mean_ln;
+}
+
+bool sr_weibull_fit(const float* d, uint32_t n, SrWeibull* out) {
+  if (!d || !out || n < 2) return false;
+  double mean_ln = 0.0;
+  float lo_d = d[0], hi_d = d[0];
+  for (uint32_t i = 0; i < n; i++) {
+    if (!(d[i] > 0.0f)) return false;
+    mean_ln += std::log((double)d[i]);
+    lo_d = (d[i] < lo_d) ? d[i] : lo_d;
+    hi_d = (d[i] > hi_d) ? d[i] : hi_d;
+  }
+  if (hi_d - lo_d <= 1e-6f * hi_d) return false;
+  mean_ln /= n;
+
+  double lo = 0.05, hi = 100.0;
+  if (weibull_g(d, n, lo, mean_ln) > 0.0 || weibull_g(d, n, hi, mean_ln) < 0.0) return false;
+  for (int it = 0; it < 60; it++) {
+    const double mid = 0.5 * (lo + hi);
+    if (weibull_g(d, n, mid, mean_ln) < 0.0) lo = mid;
+    else hi = mid;
+  }
+  const double k = 0.5 * (lo + hi);
+  double s = 0.0;
+  for (uint32_t i = 0; i < n; i++) s += std::pow((double)d[i], k);
+  out->shape = (float)k;
+  out->scale = (float)std::pow(s / n, 1.0 / k);
+  return true;
+}
+
+// ===== Index =====
+
+static inline uint32_t rd32(const int16_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+// acc0 = q . r0, acc1 = q . r1 over SR_EMB_DIM; the query word is loaded once
+static inline void dot2_q15(const int16_t* q, const int16_t* r0, const int16_t* r1, int32_t* acc0, int32_t* acc1) {
+#if defined(NCOMM_SR_SIMD)
+  uint32_t a0 = 0, a1 = 0;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i += 4) {
+    const uint32_t x0 = rd32(q + i), x1 = rd32(q + i + 2);
+    a0 = __SMLAD(x0, rd32(r0 + i), a0);
+    a0 = __SMLAD(x1, rd32(r0 + i + 2), a0);
+    a1 = __SMLAD(x0, rd32(r1 + i), a1);
+    a1 = __SMLAD(x1, rd32(r1 + i + 2), a1);
+  }
+  *acc0 = (int32_t)a0;
+  *acc1 = (int32_t)a1;
+#else
+  int32_t a0 = 0, a1 = 0;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) {
+    a0 += (int32_t)q[i] * r0[i];
+    a1 += (int32_t)q[i] * r1[i];
+  }
+  *acc0 = a0;
+  *acc1 = a1;
+#endif
+}
+
+void EmbeddingIndex::init(int16_t* rows, uint8_t* voice, uint16_t capacity) {
+  rows_ = rows;
+  voice_ = voice;
+  cap_ = voice ? (capacity < SR_MAX_TEMPLATES ? capacity : SR_MAX_TEMPLATES) : 0;
+  size_ = 0;
+}
+
+bool EmbeddingIndex::quantize(const float* emb, int16_t* q) {
+  float e = 0.0f;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) e += emb[i] * emb[i];
+  if (!(e > 0.0f)) return false;
+  const float g = 32767.0f / std::sqrt(e);
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) {
+    long v = std::lround(emb[i] * g);
+    v = (v > 32767) ? 32767 : (v < -32767 ? -32767 : v);
+    q[i] = (int16_t)v;
+  }
+  return true;
+}
+
+int32_t EmbeddingIndex::add(const float* emb, uint8_t voice_id) {
+  int16_t* r = own_(size_);
+  if (size_ >= cap_ || !r || !quantize(emb, r)) return -1;
+  rowp_[size_] = r;
+  voice_[size_] = voice_id;
+  return size_++;
+}
+
+int32_t EmbeddingIndex::add_ref(const int16_t* row, uint8_t voice_id) {
+  if (size_ >= cap_ || !row) return -1;
+  rowp_[size_] = row;
+  voice_[size_] = voice_id;
+  return size_++;
+}
+
+uint16_t EmbeddingIndex::remove_voice(uint8_t voice_id) {
+  uint16_t w = 0;
+  for (uint16_t r = 0; r < size_; r++) {
+    if (voice_[r] == voice_id) continue;
+    if (w != r) {
+      // Owned rows live at their slot: move the data, not just the pointer
+      if (rows_ && rowp_[r] == own_(r)) {
+        std::memcpy(own_(w), own_(r), SR_EMB_DIM * sizeof(int16_t));
+        rowp_[w] = own_(w);
+      } else {
+        rowp_[w] = rowp_[r];
+      }
+      voice_[w] = voice_[r];
+    }
+    w++;
+  }
+  const uint16_t removed = (uint16_t)(size_ - w);
+  size_ = w;
+  return removed;
+}
+
+void EmbeddingIndex::score_all(const int16_t* q, int32_t* acc) const {
+  uint16_t i = 0;
+  for (; i + 1u < size_; i += 2) dot2_q15(q, row(i), row((uint16_t)(i + 1u)), &acc[i], &acc[i + 1]);
+  if (i < size_) {
+    int32_t dummy;
+    dot2_q15(q, row(i), row(i), &acc[i], &dummy);
+  }
+}
+
+void SrTopK::offer(uint16_t slot, uint8_t voice_id, int32_t score) {
+  uint8_t at = n_;
+  for (uint8_t j = 0; j < n_; j++) {
+    if (voice_[j] == voice_id) { at = j; break; }
+  }
+  if (at < n_) {
+    if (score <= score_[at]) return;
+  } else if (n_ < k_) {
+    at = n_++;
+  } else {
+    if (!k_ || score <= score_[n_ - 1]) return;
+    at = (uint8_t)(n_ - 1);
+  }
+  while (at > 0 && score_[at - 1] < score) {
+    score_[at] = score_[at - 1];
+    slot_[at] = slot_[at - 1];
+    voice_[at] = voice_[at - 1];
+    at--;
+  }
+  score_[at] = score;
+  slot_[at] = slot;
+  voice_[at] = voice_id;
+}
+
+uint8_t EmbeddingIndex::top_k(const int16_t* q, uint8_t k, SrMatch* out) const {
+  if (!out) return 0;
+  SrTopK top(k);
+  uint16_t i = 0;
+  for (; i + 1u < size_; i += 2) {
+    int32_t a0, a1;
+    dot2_q15(q, row(i), row((uint16_t)(i + 1u)), &a0, &a1);
+    top.offer(i, voice_[i], a0);
+    top.offer((uint16_t)(i + 1u), voice_[i + 1u], a1);
+  }
+  if (i < size_) {
+    int32_t a0, a1;
+    dot2_q15(q, row(i), row(i), &a0, &a1);
+    top.offer(i, voice_[i], a0);
+  }
+
+  for (uint8_t j = 0; j < top.size(); j++) {
+    out[j].slot = top.slot(j);
+    out[j].voice_id = top.voice(j);
+    out[j].cos = (float)top.score(j) / Q15_SQ;
+    out[j].distance = 1.0f - out[j].cos;
+    out[j].cdf = 0.0f;
+  }
+  return top.size();
+}
+
+// ===== Enrollment =====
+
+bool sr_enroll_centroid(const float* emb, uint32_t n, float* c) {
+  if (!emb || !n || !c) return false;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) c[i] = 0.0f;
+  for (uint32_t j = 0; j < n; j++) {
+    const float* e = &emb[j * SR_EMB_DIM];
+    float s = 0.0f;
+    for (uint32_t i = 0; i < SR_EMB_DIM; i++) s += e[i] * e[i];
+    if (!(s > 0.0f)) return false;
+    const float g = 1.0f / std::sqrt(s);
+    for (uint32_t i = 0; i < SR_EMB_DIM; i++) c[i] += e[i] * g;
+  }
+  float cn = 0.0f;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) cn += c[i] * c[i];
+  if (!(cn > 0.0f)) return false;
+  const float g = 1.0f / std::sqrt(cn);
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) c[i] *= g;
+  return true;
+}
+
+void sr_enroll_weibull(const float* emb, uint32_t n, const float* c, SrWeibull* w) {
+  // EMBEDDINGS_PER_CENTROID_COUNT = 20
+  float d[32];
+  const uint32_t m = (n < 32u) ? n : 32u;
+  for (uint32_t j = 0; j < m; j++) {
+    const float* e = &emb[j * SR_EMB_DIM];
+    float dot = 0.0f, s = 0.0f;
+    for (uint32_t i = 0; i < SR_EMB_DIM; i++) {
+      dot += e[i] * c[i];
+      s += e[i] * e[i];
+    }
+    d[j] = 1.0f - dot / std::sqrt(s);
+  }
+  *w = SrWeibull{};
+  (void)sr_weibull_fit(d, m, w);
+}
+
+// ===== Baseline classifier =====
+
+void CosineWeibullClassifier::init(int16_t* rows, uint8_t* voice, uint16_t capacity, const SrParams& params) {
+  params_ = params;
+  index_.init(rows, voice, capacity);
+  reset();
+}
+
+void CosineWeibullClassifier::reset() {
+  index_.clear();
+  for (auto& w : weibull_) w = SrWeibull{};
+}
+
+bool CosineWeibullClassifier::load_voice(const float* centroid, const SrWeibull& w, uint8_t voice_id) {
+  index_.remove_voice(voice_id);
+  if (index_.add(centroid, voice_id) < 0) return false;
+  weibull_[voice_id] = w;
+  return true;
+}
+
+bool CosineWeibullClassifier::add_voice(const float* emb, uint32_t n, uint8_t voice_id) {
+  float c[SR_EMB_DIM];
+  if (!sr_enroll_centroid(emb, n, c)) return false;
+  SrWeibull w;
+  sr_enroll_weibull(emb, n, c, &w);
+  return load_voice(c, w, voice_id);
+}
+
+uint16_t CosineWeibullClassifier::save_voice(uint8_t voice_id, uint8_t* rec) const {
+  for (uint16_t s = 0; s < index_.size(); s++) {
+    if (index_.voice(s) != voice_id) continue;
+    const SrVoiceRecord h = {SR_REC_Q15, voice_id, SR_EMB_DIM * sizeof(int16_t), weibull_[voice_id]};
+    std::memcpy(rec, &h, sizeof(h));
+    std::memcpy(rec + sizeof(h), index_.row(s), h.bytes);
+    return (uint16_t)(sizeof(h) + h.bytes);
+  }
+  return 0;
+}
+
+bool CosineWeibullClassifier::attach_voice(const uint8_t* rec, uint16_t len) {
+  SrVoiceRecord h;
+  if (!rec || len < sizeof(h)) return false;
+  std::memcpy(&h, rec, sizeof(h));
+  if (h.format != SR_REC_Q15 || h.bytes != SR_EMB_DIM * sizeof(int16_t) || len < sizeof(h) + h.bytes) return false;
+  index_.remove_voice(h.voice_id);
+  if (index_.add_ref((const int16_t*)(const void*)(rec + sizeof(h)), h.voice_id) < 0) return false;
+  weibull_[h.voice_id] = h.w;
+  return true;
+}
+
+uint8_t CosineWeibullClassifier::top_k(const float* emb, uint8_t k, SrMatch* out) {
+  if (!EmbeddingIndex::quantize(emb, query_)) return 0;
+  const uint8_t n = index_.top_k(query_, k, out);
+  for (uint8_t j = 0; j < n; j++) out[j].cdf = sr_weibull_cdf(weibull_[(uint8_t)out[j].voice_id], out[j].distance);
+  return n;
+}
+
+SrDecision CosineWeibullClassifier::classify(const float* emb) {
+  SrDecision d;
+  SrMatch m;
+  if (top_k(emb, 1, &m) == 0) return d;
+  d.voice_id = m.voice_id;
+  d.distance = m.distance;
+  d.cdf = m.cdf;
+  d.is_known = (m.distance <= params_.d_t) && (m.cdf <= params_.cdf_t);
+  return d;
+}
+
+// ===== Enrollment store =====
+
+bool sr_store_voice(RecordStore& store, const SrClassifier& cls, uint8_t voice_id) {
+  uint8_t rec[SR_REC_MAX];
+  const uint16_t len = cls.save_voice(voice_id, rec);
+  return len && store.put(voice_id, rec, len);
+}
+
+uint16_t sr_restore_voices(const RecordStore& store, SrClassifier& cls) {
+  cls.reset();
+  uint16_t n = 0;
+  for (uint32_t k = 0; k < STORE_KEYS; k++) {
+    uint16_t len = 0;
+    const uint8_t* rec = store.get((uint8_t)k, &len);
+    if (rec && cls.attach_voice(rec, len)) n++;
+  }
+  return n;
+}
+
+} // namespace ncomm
@@ -0,0 +1,176 @@
+#include "ncomm/ncomm_sr_pipeline.hpp"
+
+#include <cstring>
+
+#include "ncomm/ncomm_profile.h"
+
+namespace ncomm {
+
+bool sr_exit_early(const SrEarlyExit& p, float threshold, const SrDecision& d) {
+  if (!p.enabled) return false;
+  if (d.is_known && d.distance <= threshold - p.band) return true;
+  return d.distance >= threshold + p.band;
+}
+
+SrDecision sr_combine(SrClassifier& cls, SrCombine c, float* emb1, const float* emb2, const SrDecision& d1) {
+  SrDecision d = d1;
+  if (c == SrCombine::MEAN) {
+    float s = 0.0f;
+    for (uint32_t k = 0; k < SR_EMB_DIM; k++) {
+      emb1[k] += emb2[k];
+      s += emb1[k] * emb1[k];
+    }
+    // Opposite embeddings: keep packet 1 (classify() normalises anyway)
+    if (s > 0.0f) d = cls.classify(emb1);
+    return d;
+  }
+  const SrDecision d2 = cls.classify(emb2);
+  if (c == SrCombine::BEST) {
+    if (d2.distance < d.distance) d = d2;
+  } else {
+    const bool same = d.is_known && d2.is_known && d.voice_id == d2.voice_id;
+    if (d2.distance > d.distance) d = d2; // report the weaker packet
+    d.is_known = same;
+  }
+  return d;
+}
+
+void SrPipeline::init(MelStream* mel, VoiceIdEncoder* enc, SrClassifier* cls) {
+  mel_ = mel;
+  enc_ = enc;
+  cls_ = cls;
+  stats_ = {};
+  spec_drop_();
+}
+
+bool SrPipeline::embed_(const LoopedSpan& v, float* emb, SrResult* out, uint32_t* us) {
+  const uint32_t t0 = ncomm_cycles_now();
+  uint32_t hits = 0;
+  const uint32_t frames = mel_->looped(v, mel_buf_, MEL_WINDOW_FRAMES, &hits);
+  out->mel_frames = (uint8_t)(out->mel_frames + frames);
+  out->mel_hits = (uint8_t)(out->mel_hits + hits);
+  if (frames != MEL_WINDOW_FRAMES) return false;
+  mel_cmvn(mel_buf_, MEL_WINDOW_FRAMES, MEL_WINDOW_FRAMES, true);
+  if (!enc_->encode(mel_buf_, MEL_WINDOW_FRAMES, emb)) return false;
+  out->encoded++;
+  *us = ncomm_cycles_to_us(ncomm_cycles_now() - t0);
+  stats_.packet_us = *us;
+  return true;
+}
+
+SrPipeline::SpecSlot* SrPipeline::spec_find_(const LoopedSpan& v) {
+  if (!spec_live_) return nullptr;
+  for (SpecSlot& s : spec_) {
+    if (s.valid && s.pos == v.pos() && s.period == v.period()) return &s;
+  }
+  return nullptr;
+}
+
+uint32_t SrPipeline::spec_drop_() {
+  uint32_t n = 0;
+  for (SpecSlot& s : spec_) {
+    n += s.valid ? 1u : 0u;
+    s.valid = false;
+  }
+  spec_live_ = 0;
+  return n;
+}
+
+bool SrPipeline::packet_(const LoopedSpan& v, float* emb, SrResult* out, uint32_t* us) {
+  SpecSlot* s = spec_find_(v);
+  if (!s) return embed_(v, emb, out, us);
+  std::memcpy(emb, s->emb, sizeof(s->emb));
+  *us = s->us;
+  s->valid = false;
+  spec_live_--;
+  out->speculated++;
+  stats_.spec_used++;
+  return true;
+}
+
+uint8_t SrPipeline::speculate(const SpeechRing& ring, uint32_t pos, uint32_t n, bool ended) {
+  if (!mel_ || !enc_ || !cls_) return 0;
+  LoopedSpan pk[SR_MAX_PACKETS];
+  const uint8_t np = mel_sr_packets(ring, pos, n, mel_->next_pos(), pk);
+  for (uint8_t i = 0; i < np; i++) {
+    // A full window no longer changes as the segment grows; a looped
+    // (shorter) packet only once speech has stopped
+    if (pk[i].period() != MEL_WINDOW_SAMPLES && !ended) continue;
+    if (spec_find_(pk[i])) continue;
+    if (i == 1) {
+      // verify() will not need packet 2 if packet 1 exits early
+      const SpecSlot* p1 = spec_find_(pk[0]);
+      if (p1 && sr_exit_early(exit_, cls_->threshold(), cls_->classify(p1->emb))) return 0;
+    }
+    SpecSlot& s = spec_[spec_next_];
+    spec_next_ = (uint8_t)((spec_next_ + 1u) % SR_SPEC_SLOTS);
+    if (s.valid) {
+      s.valid = false;
+      spec_live_--;
+      stats_.spec_wasted++;
+    }
+    SrResult scratch;
+    if (!embed_(pk[i], s.emb, &scratch, &s.us)) return 0;
+    s.pos = pk[i].pos();
+    s.period = pk[i].period();
+    s.valid = true;
+    spec_live_++;
+    stats_.spec_packets++;
+    stats_.spec_us += s.us;
+    return 1;
+  }
+  return 0;
+}
+
+void SrPipeline::cancel() {
+  if (spec_live_) stats_.spec_cancelled += spec_drop_();
+}
+
+bool SrPipeline::verify(const SpeechRing& ring, uint32_t pos, uint32_t n, SrResult* out) {
+  const bool ok = decide_(ring, pos, n, out);
+  // Whatever was not taken belongs to a span the command did not end with
+  stats_.spec_wasted += spec_drop_();
+  return ok;
+}
+
+bool SrPipeline::decide_(const SpeechRing& ring, uint32_t pos, uint32_t n, SrResult* out) {
+  *out = SrResult{};
+  if (!mel_ || !enc_ || !cls_) return false;
+  const uint32_t t0 = ncomm_cycles_now();
+  stats_.runs++;
+
+  LoopedSpan pk[SR_MAX_PACKETS];
+  const uint8_t np = mel_sr_packets(ring, pos, n, mel_->next_pos(), pk);
+  if (!np) {
+    stats_.too_short++;
+    return false;
+  }
+  out->packets = np;
+  uint32_t p1_us = 0, p2_us = 0;
+  if (!packet_(pk[0], emb_[0], out, &p1_us)) {
+    stats_.failed++;
+    return false;
+  }
+  SrDecision d = cls_->classify(emb_[0]);
+  if (np == 2) {
+    stats_.two_packets++;
+    if (sr_exit_early(exit_, cls_->threshold(), d)) {
+      out->early_exit = true;
+      if (d.is_known) stats_.early_accept++;
+      else stats_.early_reject++;
+      stats_.saved_us += p1_us;
+    } else {
+      if (!packet_(pk[1], emb_[1], out, &p2_us)) {
+        stats_.failed++;
+        return false;
+      }
+      d = sr_combine(*cls_, combine_, emb_[0], emb_[1], d);
+    }
+  }
+  out->decision = d;
+  out->us = ncomm_cycles_to_us(ncomm_cycles_now() - t0);
+  if (d.is_known) stats_.known++;
+  return true;
+}
+
+} // namespace ncomm
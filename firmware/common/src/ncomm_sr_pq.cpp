@@ -0,0 +1,267 @@
+#include "ncomm/ncomm_sr_pq.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_FEATURE_DSP) && !defined(NCOMM_HOST)
+#include "stm32h7xx.h" // __SMLAD
+#define NCOMM_SR_PQ_SIMD 1
+#endif
+
+namespace ncomm {
+
+// ===== Placeholder codebook =====
+namespace pqph {
+
+static constexpr uint32_t CW_COUNT = (uint32_t)SR_PQ_M * SR_PQ_K * SR_PQ_SUB;
+
+constexpr uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352Du;
+  x ^= x >> 15;
+  x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x;
+}
+
+// Uniform in +-0.153 (std 1/sqrt(128), a unit embedding's component), Q15
+constexpr int16_t cw_at(uint32_t i) {
+  return (int16_t)(((int32_t)(hash32(i * 0x9E3779B9u + 0x5051u) >> 20) - 2048) * 5013 / 2048);
+}
+
+struct Codewords {
+  int16_t v[CW_COUNT];
+};
+
+constexpr Codewords make_codewords() {
+  Codewords c{};
+  for (uint32_t i = 0; i < CW_COUNT; i++) c.v[i] = cw_at(i);
+  return c;
+}
+
+static constexpr Codewords CW = make_codewords();
+
+} // namespace pqph
+
+static const PqCodebook s_pq_placeholder = {pqph::CW.v, false};
+
+const PqCodebook* pq_placeholder_codebook() { return &s_pq_placeholder; }
+
+// ===== Index =====
+
+static inline uint32_t rd32(const int16_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+static inline const int16_t* codeword(const PqCodebook* cb, uint32_t m, uint32_t c) {
+  return &cb->cw[(m * SR_PQ_K + c) * SR_PQ_SUB];
+}
+
+// Subspace m holds dims m, m + M, m + 2M, ...: out[m][i] = v[i * M + m]
+template <typename T>
+static inline void pq_gather(const T* v, T* out) {
+  for (uint32_t m = 0; m < SR_PQ_M; m++) {
+    for (uint32_t i = 0; i < SR_PQ_SUB; i++) out[m * SR_PQ_SUB + i] = v[i * SR_PQ_M + m];
+  }
+}
+
+void PqIndex::init(const PqCodebook* cb, uint8_t* codes, uint8_t* voice, uint16_t capacity) {
+  cb_ = cb;
+  codes_ = codes;
+  voice_ = voice;
+  cap_ = (cb && codes && voice) ? capacity : 0;
+  size_ = 0;
+}
+
+bool PqIndex::encode(const float* emb, uint8_t* code) const {
+  float e = 0.0f;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) e += emb[i] * emb[i];
+  if (!(e > 0.0f) || !cb_) return false;
+  const float g = 32767.0f / std::sqrt(e); // compare in the codebook's Q15 scale
+  float v[SR_EMB_DIM];
+  pq_gather(emb, v);
+  for (uint32_t m = 0; m < SR_PQ_M; m++) {
+    const float* x = &v[m * SR_PQ_SUB];
+    float best = 0.0f;
+    uint32_t arg = 0;
+    for (uint32_t c = 0; c < SR_PQ_K; c++) {
+      const int16_t* w = codeword(cb_, m, c);
+      float d = 0.0f;
+      for (uint32_t i = 0; i < SR_PQ_SUB; i++) {
+        const float t = x[i] * g - (float)w[i];
+        d += t * t;
+      }
+      if (c == 0 || d < best) {
+        best = d;
+        arg = c;
+      }
+    }
+    code[m] = (uint8_t)arg;
+  }
+  return true;
+}
+
+void PqIndex::decode(const uint8_t* code, float* emb) const {
+  for (uint32_t m = 0; m < SR_PQ_M; m++) {
+    const int16_t* w = codeword(cb_, m, code[m]);
+    for (uint32_t i = 0; i < SR_PQ_SUB; i++) emb[i * SR_PQ_M + m] = (float)w[i] * (1.0f / 32767.0f);
+  }
+}
+
+int32_t PqIndex::add(const float* emb, uint8_t voice_id) {
+  if (size_ >= cap_) return -1;
+  if (!encode(emb, &codes_[(uint32_t)size_ * SR_PQ_M])) return -1;
+  voice_[size_] = voice_id;
+  return size_++;
+}
+
+int32_t PqIndex::add_code(const uint8_t* code, uint8_t voice_id) {
+  if (size_ >= cap_ || !code) return -1;
+  std::memcpy(&codes_[(uint32_t)size_ * SR_PQ_M], code, SR_PQ_M);
+  voice_[size_] = voice_id;
+  return size_++;
+}
+
+uint16_t PqIndex::remove_voice(uint8_t voice_id) {
+  uint16_t w = 0;
+  for (uint16_t r = 0; r < size_; r++) {
+    if (voice_[r] == voice_id) continue;
+    if (w != r) {
+      std::memcpy(&codes_[(uint32_t)w * SR_PQ_M], &codes_[(uint32_t)r * SR_PQ_M], SR_PQ_M);
+      voice_[w] = voice_[r];
+    }
+    w++;
+  }
+  const uint16_t removed = (uint16_t)(size_ - w);
+  size_ = w;
+  return removed;
+}
+
+bool PqIndex::set_query(const float* emb) {
+  int16_t qn[SR_EMB_DIM], q[SR_EMB_DIM];
+  if (!cb_ || !EmbeddingIndex::quantize(emb, qn)) return false;
+  pq_gather(qn, q);
+  // lut[m][c] = q_m . cw[m][c]: Q30 -> Q15 (|q_m| |cw| <= 1, fits int16)
+  for (uint32_t m = 0; m < SR_PQ_M; m++) {
+    const int16_t* x = &q[m * SR_PQ_SUB];
+    int16_t* lut = &lut_[m * SR_PQ_K];
+    for (uint32_t c = 0; c < SR_PQ_K; c++) {
+      const int16_t* w = codeword(cb_, m, c);
+#if defined(NCOMM_SR_PQ_SIMD)
+      uint32_t a = 0;
+      for (uint32_t i = 0; i < SR_PQ_SUB; i += 2) a = __SMLAD(rd32(x + i), rd32(w + i), a);
+      int32_t acc = (int32_t)a;
+#else
+      int32_t acc = 0;
+      for (uint32_t i = 0; i < SR_PQ_SUB; i++) acc += (int32_t)x[i] * w[i];
+#endif
+      acc = (acc + (1 << 14)) >> 15;
+      lut[c] = (int16_t)(acc > 32767 ? 32767 : (acc < -32767 ? -32767 : acc));
+    }
+  }
+  return true;
+}
+
+inline int32_t PqIndex::score_(const uint8_t* code) const {
+  int32_t acc = 0;
+  for (uint32_t m = 0; m < SR_PQ_M; m++) acc += lut_[m * SR_PQ_K + code[m]];
+  return acc;
+}
+
+void PqIndex::score_all(int32_t* acc) const {
+  for (uint16_t i = 0; i < size_; i++) acc[i] = score_(code(i));
+}
+
+uint8_t PqIndex::top_k(uint8_t k, SrMatch* out) const {
+  if (!out) return 0;
+  SrTopK top(k);
+  for (uint16_t i = 0; i < size_; i++) top.offer(i, voice_[i], score_(code(i)));
+  for (uint8_t j = 0; j < top.size(); j++) {
+    out[j].slot = top.slot(j);
+    out[j].voice_id = top.voice(j);
+    out[j].cos = (float)top.score(j) * (1.0f / 32767.0f);
+    out[j].distance = 1.0f - out[j].cos;
+    out[j].cdf = 0.0f;
+  }
+  return top.size();
+}
+
+// ===== Classifier =====
+
+void PqWeibullClassifier::init(const PqCodebook* cb, uint8_t* codes, uint8_t* voice, uint16_t capacity,
+                               const SrParams& params) {
+  params_ = params;
+  index_.init(cb, codes, voice, capacity);
+  reset();
+}
+
+void PqWeibullClassifier::reset() {
+  index_.clear();
+  for (auto& w : weibull_) w = SrWeibull{};
+}
+
+bool PqWeibullClassifier::load_voice(const float* centroid, const SrWeibull& w, uint8_t voice_id) {
+  index_.remove_voice(voice_id);
+  if (index_.add(centroid, voice_id) < 0) return false;
+  weibull_[voice_id] = w;
+  return true;
+}
+
+bool PqWeibullClassifier::add_voice(const float* emb, uint32_t n, uint8_t voice_id) {
+  float c[SR_EMB_DIM];
+  uint8_t code[SR_PQ_M];
+  if (!sr_enroll_centroid(emb, n, c) || !index_.encode(c, code)) return false;
+  float r[SR_EMB_DIM];
+  index_.decode(code, r);
+  SrWeibull w;
+  sr_enroll_weibull(emb, n, r, &w);
+  index_.remove_voice(voice_id);
+  if (index_.add_code(code, voice_id) < 0) return false;
+  weibull_[voice_id] = w;
+  return true;
+}
+
+uint16_t PqWeibullClassifier::save_voice(uint8_t voice_id, uint8_t* rec) const {
+  for (uint16_t s = 0; s < index_.size(); s++) {
+    if (index_.voice(s) != voice_id) continue;
+    const SrVoiceRecord h = {SR_REC_PQ, voice_id, SR_PQ_M, weibull_[voice_id]};
+    std::memcpy(rec, &h, sizeof(h));
+    std::memcpy(rec + sizeof(h), index_.code(s), SR_PQ_M);
+    return (uint16_t)(sizeof(h) + SR_PQ_M);
+  }
+  return 0;
+}
+
+// 16 B: the code is copied into the index
+bool PqWeibullClassifier::attach_voice(const uint8_t* rec, uint16_t len) {
+  SrVoiceRecord h;
+  if (!rec || len < sizeof(h)) return false;
+  std::memcpy(&h, rec, sizeof(h));
+  if (h.format != SR_REC_PQ || h.bytes != SR_PQ_M || len < sizeof(h) + h.bytes) return false;
+  index_.remove_voice(h.voice_id);
+  if (index_.add_code(rec + sizeof(h), h.voice_id) < 0) return false;
+  weibull_[h.voice_id] = h.w;
+  return true;
+}
+
+uint8_t PqWeibullClassifier::top_k(const float* emb, uint8_t k, SrMatch* out) {
+  if (!index_.set_query(emb)) return 0;
+  const uint8_t n = index_.top_k(k, out);
+  for (uint8_t j = 0; j < n; j++) out[j].cdf = sr_weibull_cdf(weibull_[(uint8_t)out[j].voice_id], out[j].distance);
+  return n;
+}
+
+SrDecision PqWeibullClassifier::classify(const float* emb) {
+  SrDecision d;
+  SrMatch m;
+  if (top_k(emb, 1, &m) == 0) return d;
+  d.voice_id = m.voice_id;
+  d.distance = m.distance;
+  d.cdf = m.cdf;
+  d.is_known = (m.distance <= params_.d_t) && (m.cdf <= params_.cdf_t);
+  return d;
+}
+
+} // namespace ncomm
@@ -0,0 +1,245 @@
+#include "ncomm/ncomm_store.hpp"
+
+#include <cstring>
+
+#include "ncomm/ncomm_protocol.hpp" // crc16_ccitt_false
+
+namespace ncomm {
+
+// Sector header word: magic u32, version u16, word size u16, seq u32,
+// erases u32, zero pad, crc16 (bytes 0..29) at 30.
+// Record header word: magic u16, type u8, key u8, len u16, payload crc16,
+// zero pad, crc16 (bytes 0..29) at 30.
+static constexpr uint32_t SECTOR_MAGIC = 0x5345434Eu; // "NCES"
+static constexpr uint16_t SECTOR_VERSION = 1;
+static constexpr uint16_t RECORD_MAGIC = 0x4352u;     // "RC"
+static constexpr uint8_t REC_DATA = 1;
+static constexpr uint8_t REC_TOMBSTONE = 2;
+
+static inline void wr16(uint8_t* p, uint16_t v) { std::memcpy(p, &v, 2); }
+static inline void wr32(uint8_t* p, uint32_t v) { std::memcpy(p, &v, 4); }
+static inline uint16_t rd16(const uint8_t* p) {
+  uint16_t v;
+  std::memcpy(&v, p, 2);
+  return v;
+}
+static inline uint32_t rd32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+static bool word_erased(const uint8_t* p) {
+  for (uint32_t i = 0; i < STORE_WORD; i++) {
+    if (p[i] != 0xFFu) return false;
+  }
+  return true;
+}
+
+static bool word_crc_ok(const uint8_t* w) { return rd16(w + 30) == crc16_ccitt_false(w, 30); }
+
+static bool sector_header(const uint8_t* w, uint32_t* seq, uint32_t* erases) {
+  if (rd32(w) != SECTOR_MAGIC || rd16(w + 4) != SECTOR_VERSION || rd16(w + 6) != STORE_WORD) return false;
+  if (!word_crc_ok(w)) return false;
+  *seq = rd32(w + 8);
+  *erases = rd32(w + 12);
+  return true;
+}
+
+struct RecordHeader {
+  uint8_t type;
+  uint8_t key;
+  uint16_t len;
+  uint16_t crc;
+};
+
+static bool record_header(const uint8_t* w, RecordHeader* h) {
+  if (rd16(w) != RECORD_MAGIC || !word_crc_ok(w)) return false;
+  h->type = w[2];
+  h->key = w[3];
+  h->len = rd16(w + 4);
+  h->crc = rd16(w + 6);
+  return (h->type == REC_DATA || h->type == REC_TOMBSTONE) && h->len <= STORE_MAX_RECORD;
+}
+
+// ===== RecordStore =====
+
+bool RecordStore::mount(FlashDevice* dev) {
+  dev_ = dev;
+  if (!dev_) return false;
+  uint32_t seq[2] = {}, er[2] = {};
+  bool ok[2];
+  for (uint8_t s = 0; s < 2; s++) ok[s] = sector_header(dev_->base(s), &seq[s], &er[s]);
+  if (!ok[0] && !ok[1]) return format();
+
+  active_ = (ok[0] && ok[1]) ? (seq[1] > seq[0] ? 1u : 0u) : (ok[1] ? 1u : 0u);
+  seq_ = seq[active_];
+  // Sectors alternate: an unreadable header is one cycle behind the other
+  erases_[active_] = er[active_];
+  erases_[active_ ^ 1u] = ok[active_ ^ 1u] ? er[active_ ^ 1u] : er[active_];
+  index_(active_);
+  gen_++;
+  return true;
+}
+
+bool RecordStore::format() {
+  if (!dev_) return false;
+  for (uint8_t s = 0; s < 2; s++) {
+    if (!dev_->erase(s)) {
+      stats_.flash_errors++;
+      return false;
+    }
+    erases_[s]++;
+  }
+  if (!write_header_(0, seq_ + 1u, erases_[0])) return false;
+  active_ = 0;
+  seq_++;
+  index_(0);
+  gen_++;
+  return true;
+}
+
+bool RecordStore::write_header_(uint8_t sector, uint32_t seq, uint32_t erases) {
+  uint8_t w[STORE_WORD] = {};
+  wr32(w, SECTOR_MAGIC);
+  wr16(w + 4, SECTOR_VERSION);
+  wr16(w + 6, STORE_WORD);
+  wr32(w + 8, seq);
+  wr32(w + 12, erases);
+  wr16(w + 30, crc16_ccitt_false(w, 30));
+  if (dev_->program(sector, 0, w)) return true;
+  stats_.flash_errors++;
+  return false;
+}
+
+void RecordStore::index_(uint8_t sector) {
+  const uint8_t* b = dev_->base(sector);
+  const uint32_t size = dev_->sector_size();
+  for (auto& o : off_) o = 0;
+  count_ = 0;
+
+  // End of the last programmed word; records may end in 0xFF words, so the
+  // write position is the later of this and the end of the last record.
+  uint32_t tail = size;
+  while (tail > STORE_WORD && word_erased(b + tail - STORE_WORD)) tail -= STORE_WORD;
+
+  uint32_t o = STORE_WORD;
+  while (o < tail) {
+    RecordHeader h;
+    const uint32_t span = record_header(b + o, &h) ? store_record_span(h.len) : 0;
+    if (!span || o + span > size || crc16_ccitt_false(b + o + STORE_WORD, h.len) != h.crc) {
+      stats_.skipped_words++;
+      o += STORE_WORD;
+      continue;
+    }
+    if (h.type == REC_DATA) {
+      if (!off_[h.key]) count_++;
+      off_[h.key] = o;
+    } else if (off_[h.key]) {
+      off_[h.key] = 0;
+      count_--;
+    }
+    o += span;
+  }
+  wr_ = o;
+}
+
+bool RecordStore::append_(uint8_t sector, uint32_t* wr, uint8_t type, uint8_t key, const uint8_t* data,
+                          uint16_t len) {
+  const uint32_t span = store_record_span(len);
+  if (*wr + span > dev_->sector_size()) return false;
+  const uint32_t at = *wr;
+  *wr += span; // consumed even on failure: a word is programmed once
+
+  // Payload first, header word last (commit)
+  uint8_t w[STORE_WORD];
+  for (uint32_t p = 0; p < len; p += STORE_WORD) {
+    const uint32_t n = (len - p < STORE_WORD) ? len - p : STORE_WORD;
+    std::memcpy(w, data + p, n);
+    std::memset(w + n, 0, STORE_WORD - n);
+    if (!dev_->program(sector, at + STORE_WORD + p, w)) {
+      stats_.flash_errors++;
+      return false;
+    }
+  }
+  std::memset(w, 0, sizeof(w));
+  wr16(w, RECORD_MAGIC);
+  w[2] = type;
+  w[3] = key;
+  wr16(w + 4, len);
+  wr16(w + 6, crc16_ccitt_false(data, len));
+  wr16(w + 30, crc16_ccitt_false(w, 30));
+  if (dev_->program(sector, at, w)) return true;
+  stats_.flash_errors++;
+  return false;
+}
+
+uint32_t RecordStore::live_bytes_() const {
+  uint32_t n = 0;
+  const uint8_t* b = dev_->base(active_);
+  for (uint32_t k = 0; k < STORE_KEYS; k++) {
+    if (off_[k]) n += store_record_span(rd16(b + off_[k] + 4));
+  }
+  return n;
+}
+
+uint32_t RecordStore::free_bytes() const { return dev_ ? dev_->sector_size() - wr_ : 0; }
+
+bool RecordStore::compact_(uint32_t need) {
+  // The replaced record is copied too: until the new one is complete the
+  // old one must stay readable after a power cut.
+  if (STORE_WORD + live_bytes_() + need > dev_->sector_size()) return false;
+  const uint8_t other = active_ ^ 1u;
+  if (!dev_->erase(other)) {
+    stats_.flash_errors++;
+    return false;
+  }
+  erases_[other]++;
+
+  const uint8_t* b = dev_->base(active_);
+  uint32_t w = STORE_WORD;
+  for (uint32_t k = 0; k < STORE_KEYS; k++) {
+    if (!off_[k]) continue;
+    const uint8_t* h = b + off_[k];
+    if (!append_(other, &w, REC_DATA, (uint8_t)k, h + STORE_WORD, rd16(h + 4))) return false;
+  }
+  if (!write_header_(other, seq_ + 1u, erases_[other])) return false;
+
+  active_ = other;
+  seq_++;
+  index_(other);
+  gen_++;
+  stats_.compactions++;
+  return true;
+}
+
+bool RecordStore::put(uint8_t key, const void* data, uint16_t len) {
+  if (!dev_ || len > STORE_MAX_RECORD || (!data && len)) return false;
+  const uint32_t span = store_record_span(len);
+  if (wr_ + span > dev_->sector_size() && !compact_(span)) return false;
+  const uint32_t at = wr_;
+  if (!append_(active_, &wr_, REC_DATA, key, (const uint8_t*)data, len)) return false;
+  if (!off_[key]) count_++;
+  off_[key] = at;
+  stats_.puts++;
+  return true;
+}
+
+bool RecordStore::remove(uint8_t key) {
+  if (!dev_) return false;
+  if (!off_[key]) return true;
+  if (wr_ + STORE_WORD > dev_->sector_size() && !compact_(STORE_WORD)) return false;
+  if (!append_(active_, &wr_, REC_TOMBSTONE, key, nullptr, 0)) return false;
+  off_[key] = 0;
+  count_--;
+  return true;
+}
+
+const uint8_t* RecordStore::get(uint8_t key, uint16_t* len) const {
+  if (!dev_ || !off_[key]) return nullptr;
+  const uint8_t* h = dev_->base(active_) + off_[key];
+  if (len) *len = rd16(h + 4);
+  return h + STORE_WORD;
+}
+
+} // namespace ncomm
@@ -0,0 +1,325 @@
+#include "ncomm/ncomm_voiceid.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "ncomm/ncomm_kws.hpp" // kws_quantize_multiplier
+
+#if defined(__ARM_FEATURE_DSP) && !defined(NCOMM_HOST)
+#include "stm32h7xx.h" // __SXTB16, __SMLAD, __ROR
+#define NCOMM_VOICEID_SIMD 1
+#endif
+
+namespace ncomm {
+
+static_assert(voiceid_shape(VOICEID_TDNN_LAYERS - 1u).cout * 2u == VOICEID_POOL_DIM, "pool = mean + std");
+
+// ===== Kernels =====
+
+static inline uint32_t rd32(const int8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4); // LDR, unaligned access is fine on the M7
+  return v;
+}
+
+// 2 x 2 block: acc[r * 2 + c] += x_r . w_c over n bytes (n % 4 == 0).
+// CMSIS-NN arm_nn_mat_mult_kernel_s8 scheme: each 32-bit load is sign
+// extended once (SXTB16 of the even bytes and of the odd bytes after ROR 8)
+// and used twice, two SMLADs per pair of loaded words.
+static inline void dot_2x2_s8(const int8_t* x0, const int8_t* x1, const int8_t* w0, const int8_t* w1,
+                              uint32_t n, int32_t acc[4]) {
+#if defined(NCOMM_VOICEID_SIMD)
+  uint32_t a00 = (uint32_t)acc[0], a01 = (uint32_t)acc[1], a10 = (uint32_t)acc[2], a11 = (uint32_t)acc[3];
+  for (uint32_t i = 0; i < n; i += 4) {
+    const uint32_t u0 = rd32(w0 + i), u1 = rd32(w1 + i);
+    const uint32_t w0e = __SXTB16(u0), w0o = __SXTB16(__ROR(u0, 8));
+    const uint32_t w1e = __SXTB16(u1), w1o = __SXTB16(__ROR(u1, 8));
+    const uint32_t v0 = rd32(x0 + i), v1 = rd32(x1 + i);
+    const uint32_t x0e = __SXTB16(v0), x0o = __SXTB16(__ROR(v0, 8));
+    const uint32_t x1e = __SXTB16(v1), x1o = __SXTB16(__ROR(v1, 8));
+    a00 = __SMLAD(x0e, w0e, a00); a00 = __SMLAD(x0o, w0o, a00);
+    a01 = __SMLAD(x0e, w1e, a01); a01 = __SMLAD(x0o, w1o, a01);
+    a10 = __SMLAD(x1e, w0e, a10); a10 = __SMLAD(x1o, w0o, a10);
+    a11 = __SMLAD(x1e, w1e, a11); a11 = __SMLAD(x1o, w1o, a11);
+  }
+  acc[0] = (int32_t)a00; acc[1] = (int32_t)a01; acc[2] = (int32_t)a10; acc[3] = (int32_t)a11;
+#else
+  for (uint32_t i = 0; i < n; i++) {
+    acc[0] += (int32_t)x0[i] * w0[i];
+    acc[1] += (int32_t)x0[i] * w1[i];
+    acc[2] += (int32_t)x1[i] * w0[i];
+    acc[3] += (int32_t)x1[i] * w1[i];
+  }
+#endif
+}
+
+// One input row, two weight rows (FC)
+static inline void dot_1x2_s8(const int8_t* x, const int8_t* w0, const int8_t* w1, uint32_t n, int32_t acc[2]) {
+#if defined(NCOMM_VOICEID_SIMD)
+  uint32_t a0 = (uint32_t)acc[0], a1 = (uint32_t)acc[1];
+  for (uint32_t i = 0; i < n; i += 4) {
+    const uint32_t v = rd32(x + i);
+    const uint32_t xe = __SXTB16(v), xo = __SXTB16(__ROR(v, 8));
+    const uint32_t u0 = rd32(w0 + i), u1 = rd32(w1 + i);
+    a0 = __SMLAD(xe, __SXTB16(u0), a0); a0 = __SMLAD(xo, __SXTB16(__ROR(u0, 8)), a0);
+    a1 = __SMLAD(xe, __SXTB16(u1), a1); a1 = __SMLAD(xo, __SXTB16(__ROR(u1, 8)), a1);
+  }
+  acc[0] = (int32_t)a0; acc[1] = (int32_t)a1;
+#else
+  for (uint32_t i = 0; i < n; i++) {
+    acc[0] += (int32_t)x[i] * w0[i];
+    acc[1] += (int32_t)x[i] * w1[i];
+  }
+#endif
+}
+
+// acc * mult * 2^(shift - 31), rounded, then ReLU into int8 [0, 127]
+static inline int8_t requant_relu(int32_t acc, int32_t mult, int8_t shift) {
+  const int32_t s = 31 - shift; // 1 .. 61
+  const int64_t p = (int64_t)acc * mult + ((int64_t)1 << (s - 1));
+  int32_t v = (int32_t)(p >> s);
+  if (v < 0) v = 0;
+  if (v > 127) v = 127;
+  return (int8_t)v;
+}
+
+// Dilated 1-D convolution over [t_in][cin] -> [t_out][cout], valid padding.
+// Output-channel pairs outer, time pairs inner: the 2 x k x cin weight rows
+// (<= 768 B) stay in the D-cache while every frame is visited, so each
+// weight is fetched from flash once per inference.
+static void tdnn_s8(const int8_t* in, const VoiceIdShape& s, const VoiceIdLayer& l, int8_t* out) {
+  const uint32_t row = (uint32_t)s.k * s.cin;
+  for (uint32_t co = 0; co < s.cout; co += 2) {
+    const int8_t* w0 = &l.w[co * row];
+    const int8_t* w1 = w0 + row;
+    for (uint32_t t = 0; t < s.t_out; t += 2) {
+      int32_t acc[4] = {l.b[co], l.b[co + 1], l.b[co], l.b[co + 1]};
+      for (uint32_t k = 0; k < s.k; k++) {
+        const int8_t* x0 = &in[(t + k * s.dil) * s.cin];
+        dot_2x2_s8(x0, x0 + s.cin, w0 + k * s.cin, w1 + k * s.cin, s.cin, acc);
+      }
+      int8_t* o = &out[t * s.cout + co];
+      o[0] = requant_relu(acc[0], l.mult[co], l.shift[co]);
+      o[1] = requant_relu(acc[1], l.mult[co + 1], l.shift[co + 1]);
+      o[s.cout] = requant_relu(acc[2], l.mult[co], l.shift[co]);
+      o[s.cout + 1] = requant_relu(acc[3], l.mult[co + 1], l.shift[co + 1]);
+    }
+  }
+}
+
+static uint32_t isqrt32(uint32_t v) {
+  uint32_t r = 0, bit = 1u << 30;
+  while (bit > v) bit >>= 2;
+  while (bit) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return r;
+}
+
+// Mean and standard deviation over time, same scale as the input (integer:
+// identical on every platform). out[c] = mean, out[cout + c] = std.
+static void stats_pool_s8(const int8_t* in, uint32_t t_n, uint32_t c_n, int8_t* out) {
+  for (uint32_t c = 0; c < c_n; c++) {
+    int32_t s = 0, q = 0;
+    for (uint32_t t = 0; t < t_n; t++) {
+      const int32_t x = in[t * c_n + c];
+      s += x;
+      q += x * x;
+    }
+    const int32_t T = (int32_t)t_n;
+    out[c] = (int8_t)((s + T / 2) / T);
+    // std = sqrt(T q - s^2) / T; x16 inside the root for rounding
+    const uint32_t v = (uint32_t)(T * q - s * s);
+    const uint32_t r = isqrt32(v << 8);
+    const uint32_t sd = (r + 8u * t_n) / (16u * t_n);
+    out[c_n + c] = (int8_t)(sd > 127u ? 127u : sd);
+  }
+}
+
+static void l2_normalise(float* v, uint32_t n) {
+  float e = 0.0f;
+  for (uint32_t i = 0; i < n; i++) e += v[i] * v[i];
+  const float g = (e > 0.0f) ? 1.0f / std::sqrt(e) : 0.0f;
+  for (uint32_t i = 0; i < n; i++) v[i] *= g;
+}
+
+// ===== Encoder =====
+
+void VoiceIdEncoder::init(const VoiceIdModel* model) { model_ = model; }
+
+bool VoiceIdEncoder::encode(const float* mel, uint32_t stride, float* emb) {
+  if (!model_ || !mel || !emb) return false;
+  const VoiceIdModel& m = *model_;
+  int8_t* buf[2] = {arena_, arena_ + voiceid_buf_bytes(0)};
+
+  // Quantise the input, transposed to time-major
+  const float inv = 1.0f / m.in_scale;
+  for (uint32_t t = 0; t < MEL_WINDOW_FRAMES; t++) {
+    int8_t* x = &buf[0][t * MEL_BINS];
+    for (uint32_t k = 0; k < MEL_BINS; k++) {
+      float v = mel[k * stride + t] * inv;
+      v = (v > 127.0f) ? 127.0f : (v < -127.0f ? -127.0f : v);
+      x[k] = (int8_t)std::lround(v);
+    }
+  }
+
+  for (uint32_t l = 0; l < VOICEID_TDNN_LAYERS; l++) {
+    tdnn_s8(buf[l & 1u], voiceid_shape(l), m.tdnn[l], buf[(l + 1u) & 1u]);
+  }
+  constexpr VoiceIdShape last = voiceid_shape(VOICEID_TDNN_LAYERS - 1u);
+  int8_t* pool = buf[(VOICEID_TDNN_LAYERS + 1u) & 1u];
+  stats_pool_s8(buf[VOICEID_TDNN_LAYERS & 1u], last.t_out, last.cout, pool);
+
+  for (uint32_t c = 0; c < VOICEID_EMB_DIM; c += 2) {
+    const int8_t* w0 = &m.fc_w[c * VOICEID_POOL_DIM];
+    int32_t acc[2] = {m.fc_b[c], m.fc_b[c + 1]};
+    dot_1x2_s8(pool, w0, w0 + VOICEID_POOL_DIM, VOICEID_POOL_DIM, acc);
+    emb[c] = (float)acc[0] * m.fc_scale[c];
+    emb[c + 1] = (float)acc[1] * m.fc_scale[c + 1];
+  }
+  l2_normalise(emb, VOICEID_EMB_DIM);
+  return true;
+}
+
+uint32_t voiceid_weight_bytes() {
+  uint32_t n = (uint32_t)VOICEID_EMB_DIM * VOICEID_POOL_DIM;
+  for (uint32_t l = 0; l < VOICEID_TDNN_LAYERS; l++) {
+    const VoiceIdShape s = voiceid_shape(l);
+    n += (uint32_t)s.k * s.cin * s.cout;
+  }
+  return n;
+}
+
+// ===== Placeholder model =====
+// Weight i of layer L: q = hash(L, i) uniform in -127..127 (full int8 range,
+// sd 73.6), channel scale s_c = g_c * gain / (73.6 sqrt(fan_in)), g_c in
+// [0.75, 1.25] (per-channel spread), gain sqrt(2) behind a ReLU (He init) so
+// pre-activations stay near unit variance. The float reference in
+// test/test_voiceid.cpp is s_c * (q + u), u a sub-LSB residual in (-0.5, 0.5).
+// Activation scale 4/127 everywhere (clip at 4 sigma); the input is mel
+// after CMVN (unit variance).
+
+namespace ph {
+
+static constexpr uint32_t LAYERS = VOICEID_TDNN_LAYERS + 1u; // + FC
+static constexpr float ACT_SCALE = 4.0f / 127.0f;
+
+constexpr uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352Du;
+  x ^= x >> 15;
+  x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x;
+}
+
+constexpr int8_t q_at(uint32_t layer, uint32_t i) {
+  const int32_t v = (int32_t)(hash32(i * 0x9E3779B9u + layer * 0x85EBCA6Bu + 1u) >> 24) - 128;
+  return (int8_t)(v < -127 ? -127 : v);
+}
+
+constexpr double residual_at(uint32_t layer, uint32_t i) {
+  return ((double)(hash32(i * 0xC2B2AE35u + layer * 0x27D4EB2Fu + 7u) >> 8) / 16777216.0 - 0.5) * 0.98;
+}
+
+constexpr double sqrt_cx(double v) {
+  double r = v > 1.0 ? v : 1.0;
+  for (int i = 0; i < 40; i++) r = 0.5 * (r + v / r);
+  return r;
+}
+
+constexpr VoiceIdShape shape(uint32_t layer) {
+  return (layer < VOICEID_TDNN_LAYERS) ? voiceid_shape(layer)
+                                       : VoiceIdShape{1, 1, VOICEID_POOL_DIM, VOICEID_EMB_DIM, 1, 1};
+}
+
+constexpr uint32_t row(uint32_t layer) { return (uint32_t)shape(layer).k * shape(layer).cin; }
+constexpr uint32_t count(uint32_t layer) { return row(layer) * shape(layer).cout; }
+
+constexpr double channel_scale(uint32_t layer, uint32_t c) {
+  const double g = 0.75 + 0.5 * (double)(hash32(c * 0x165667B1u + layer * 0xD3A2646Cu + 3u) >> 8) / 16777216.0;
+  const double gain = (layer == 0) ? 1.0 : 1.41421356237;
+  return g * gain / (73.6 * sqrt_cx((double)row(layer)));
+}
+
+template <uint32_t L>
+struct Weights {
+  int8_t v[count(L)];
+};
+
+template <uint32_t L>
+constexpr Weights<L> make_weights() {
+  Weights<L> w{};
+  for (uint32_t i = 0; i < count(L); i++) w.v[i] = q_at(L, i);
+  return w;
+}
+
+template <uint32_t L>
+struct Scales {
+  float v[shape(L).cout];
+};
+
+template <uint32_t L>
+constexpr Scales<L> make_scales() {
+  Scales<L> s{};
+  for (uint32_t c = 0; c < shape(L).cout; c++) s.v[c] = (float)channel_scale(L, c);
+  return s;
+}
+
+// In flash (.rodata)
+static constexpr Weights<0> W0 = make_weights<0>();
+static constexpr Weights<1> W1 = make_weights<1>();
+static constexpr Weights<2> W2 = make_weights<2>();
+static constexpr Weights<3> W3 = make_weights<3>();
+static constexpr Weights<4> WFC = make_weights<4>();
+static constexpr Scales<0> S0 = make_scales<0>();
+static constexpr Scales<1> S1 = make_scales<1>();
+static constexpr Scales<2> S2 = make_scales<2>();
+static constexpr Scales<3> S3 = make_scales<3>();
+static constexpr Scales<4> SFC = make_scales<4>();
+static constexpr int32_t ZERO_BIAS[256] = {};
+
+static const int8_t* const W[LAYERS] = {W0.v, W1.v, W2.v, W3.v, WFC.v};
+static const float* const S[LAYERS] = {S0.v, S1.v, S2.v, S3.v, SFC.v};
+
+} // namespace ph
+
+struct VoiceIdPlaceholder {
+  int32_t mult[VOICEID_TDNN_LAYERS][256];
+  int8_t shift[VOICEID_TDNN_LAYERS][256];
+  float fc_scale[VOICEID_EMB_DIM];
+};
+
+static VoiceIdPlaceholder s_vid_ph;
+static VoiceIdModel s_vid_model;
+static bool s_vid_ready = false;
+
+const VoiceIdModel* voiceid_placeholder_model() {
+  if (s_vid_ready) return &s_vid_model;
+  VoiceIdModel& m = s_vid_model;
+  m.in_scale = ph::ACT_SCALE;
+  for (uint32_t l = 0; l < VOICEID_TDNN_LAYERS; l++) {
+    // in and out share ACT_SCALE: real multiplier = channel scale
+    for (uint32_t c = 0; c < voiceid_shape(l).cout; c++) {
+      kws_quantize_multiplier((double)ph::S[l][c], &s_vid_ph.mult[l][c], &s_vid_ph.shift[l][c]);
+    }
+    m.tdnn[l] = {ph::W[l], ph::ZERO_BIAS, s_vid_ph.mult[l], s_vid_ph.shift[l]};
+  }
+  for (uint32_t c = 0; c < VOICEID_EMB_DIM; c++) {
+    s_vid_ph.fc_scale[c] = ph::ACT_SCALE * ph::S[VOICEID_TDNN_LAYERS][c];
+  }
+  m.fc_w = ph::W[VOICEID_TDNN_LAYERS];
+  m.fc_b = ph::ZERO_BIAS;
+  m.fc_scale = s_vid_ph.fc_scale;
+  m.trained = false;
+  s_vid_ready = true;
+  return &s_vid_model;
+}
+
+} // namespace ncomm
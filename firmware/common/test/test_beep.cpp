@@ -0,0 +1,114 @@
+// Host test: BeepMixer onset and saturation (must be exact), render cost.
+#include "ncomm/ncomm_beep.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "ncomm/ncomm_profile.h"
+
+namespace ncomm {
+
+// ---- Render cost and onset ----
+// 16 kHz output in 256-sample chunks (one link chunk, 16 ms):
+//   tone_ns  : render() per chunk with a tone playing over a stream
+//   idle_ns  : render() per chunk with no tone (pass-through check)
+//   load_ppm : tone_ns against the 16 ms chunk, parts per million
+//   onset_bad: samples that differ between one render of a scheduled tone
+//              and chunked renders (1, 37, 240, 256-sample blocks, tone
+//              starting mid-block); 0 = sample-exact, block independent
+//   clip_bad : full-scale stream + tone samples that wrapped instead of
+//              saturating (0 expected)
+struct BeepBench {
+  uint32_t tone_ns = 0;
+  uint32_t idle_ns = 0;
+  uint32_t load_ppm = 0;
+  uint32_t onset_bad = 0;
+  uint32_t clip_bad = 0;
+};
+
+static constexpr uint32_t BB_CHUNK = 256;
+static constexpr uint32_t BB_SPAN = 8000;   // 500 ms rendered per onset case
+static constexpr uint32_t BB_BASE = 100000; // output position of the first sample
+static constexpr uint32_t BB_AT = 1237;     // tone start, mid-block for every block size
+
+static BeepMixer s_bench_mix;
+static int16_t s_bench_ref[BB_SPAN];
+static int16_t s_bench_buf[BB_SPAN];
+
+static int16_t bb_stream(uint32_t i) { return (int16_t)((int32_t)((i * 2654435761u) >> 20) - 2048); }
+
+void beep_bench(BeepBench* out) {
+  if (!out) return;
+  *out = BeepBench{};
+
+  // Onset: one render vs chunked renders of the same schedule
+  static const uint32_t BLOCKS[] = {1, 37, 240, 256};
+  s_bench_mix.init();
+  for (uint32_t i = 0; i < BB_SPAN; i++) s_bench_ref[i] = bb_stream(i);
+  s_bench_mix.start(BeepTone::SESSION_TIMEOUT, BB_BASE + BB_AT);
+  s_bench_mix.render(s_bench_ref, BB_SPAN, BB_BASE);
+  for (uint32_t i = 0; i < BB_AT; i++) out->onset_bad += s_bench_ref[i] != bb_stream(i) ? 1u : 0u;
+  out->onset_bad += s_bench_ref[BB_AT + 1u] == bb_stream(BB_AT + 1u) ? 1u : 0u;
+  for (uint32_t b : BLOCKS) {
+    s_bench_mix.init();
+    for (uint32_t i = 0; i < BB_SPAN; i++) s_bench_buf[i] = bb_stream(i);
+    s_bench_mix.start(BeepTone::SESSION_TIMEOUT, BB_BASE + BB_AT);
+    for (uint32_t i = 0; i < BB_SPAN; i += b) {
+      s_bench_mix.render(&s_bench_buf[i], BB_SPAN - i < b ? BB_SPAN - i : b, BB_BASE + i);
+    }
+    for (uint32_t i = 0; i < BB_SPAN; i++) out->onset_bad += s_bench_buf[i] != s_bench_ref[i] ? 1u : 0u;
+  }
+
+  // Clipping: full-level tone without ducking over +-30000
+  s_bench_mix.init();
+  BeepPreset& loud = s_bench_mix.presets()[(uint8_t)BeepTone::SR_REJECTED];
+  loud.level = 32767;
+  loud.duck = 32767;
+  std::memset(s_bench_ref, 0, sizeof(s_bench_ref));
+  s_bench_mix.start(BeepTone::SR_REJECTED, BB_BASE);
+  s_bench_mix.render(s_bench_ref, BB_SPAN, BB_BASE);
+  static const int32_t STREAM[] = {30000, -30000};
+  for (int32_t x : STREAM) {
+    for (uint32_t i = 0; i < BB_SPAN; i++) s_bench_buf[i] = (int16_t)x;
+    s_bench_mix.start(BeepTone::SR_REJECTED, BB_BASE);
+    s_bench_mix.render(s_bench_buf, BB_SPAN, BB_BASE);
+    for (uint32_t i = 0; i < BB_SPAN; i++) {
+      int32_t e = x + s_bench_ref[i];
+      e = e > 32767 ? 32767 : (e < -32768 ? -32768 : e);
+      out->clip_bad += s_bench_buf[i] != e ? 1u : 0u;
+    }
+  }
+
+  // Cost per 256-sample chunk: tone playing (one long note) / idle
+  static constexpr uint32_t CHUNKS = 100;
+  s_bench_mix.init();
+  BeepPreset& tone = s_bench_mix.presets()[(uint8_t)BeepTone::CMD_DETECTED];
+  tone.note[0] = BeepNote{1000, (uint16_t)(CHUNKS * 16u + 100u), 0};
+  s_bench_mix.start(BeepTone::CMD_DETECTED, BB_BASE);
+  uint64_t t_tone = 0, t_idle = 0;
+  for (uint32_t c = 0; c < CHUNKS; c++) {
+    for (uint32_t i = 0; i < BB_CHUNK; i++) s_bench_buf[i] = bb_stream(i + c);
+    const uint32_t t0 = ncomm_cycles_now();
+    s_bench_mix.render(s_bench_buf, BB_CHUNK, BB_BASE + c * BB_CHUNK);
+    t_tone += ncomm_cycles_now() - t0;
+  }
+  s_bench_mix.init();
+  for (uint32_t c = 0; c < CHUNKS; c++) {
+    const uint32_t t0 = ncomm_cycles_now();
+    s_bench_mix.render(s_bench_buf, BB_CHUNK, BB_BASE + c * BB_CHUNK);
+    t_idle += ncomm_cycles_now() - t0;
+  }
+  out->tone_ns = (uint32_t)(ncomm_cycles_to_ns(t_tone) / CHUNKS);
+  out->idle_ns = (uint32_t)(ncomm_cycles_to_ns(t_idle) / CHUNKS);
+  out->load_ppm = out->tone_ns / 16u; // 16 ms chunk = 16e6 ns
+}
+
+} // namespace ncomm
+
+int main() {
+  ncomm::BeepBench b;
+  ncomm::beep_bench(&b);
+  std::printf("beep tone=%u ns idle=%u ns load=%u ppm onset=%u clip=%u\n", b.tone_ns, b.idle_ns, b.load_ppm,
+              b.onset_bad, b.clip_bad);
+  return (b.onset_bad == 0 && b.clip_bad == 0) ? 0 : 1;
+}
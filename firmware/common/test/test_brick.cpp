@@ -0,0 +1,106 @@
+// Host test: BrickRepacker against the legacy float ring, ns per brick.
+#include "ncomm/ncomm_brick.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "ncomm/ncomm_profile.h"
+
+namespace ncomm {
+
+// ns per brick over the same synthetic 16 kHz input:
+//   legacy  = every frame int16 -> float into a 2 s float ring, 240 floats copied out
+//   repack  = BrickRepacker view + to_float of the brick only
+struct BrickBench {
+  uint32_t legacy_ns = 0;
+  uint32_t repack_ns = 0;
+  uint32_t split_pct = 0; // bricks spanning two frames (no copy either way)
+};
+
+static constexpr uint16_t BENCH_FRAME = 256;
+static constexpr uint32_t LEGACY_RING = 32000; // spec 7.2 sensoryBuffer, 2 s float
+
+static float s_legacy_ring[LEGACY_RING];
+static FrameBlock s_bench_blocks[BrickRepacker::MAX_FRAMES + 2];
+static int16_t s_bench_pcm[BENCH_FRAME];
+
+void brick_bench(BrickBench* out, uint32_t frames) {
+  if (!out) return;
+  if (frames == 0) frames = 1;
+
+  for (uint16_t i = 0; i < BENCH_FRAME; i++) {
+    s_bench_pcm[i] = (int16_t)((i * 2654435761u) >> 20); // deterministic noise
+  }
+
+  float brick_f[BRICK_SAMPLES];
+  volatile float sink = 0.0f;
+
+  // Legacy: convert every sample into the float ring, copy bricks out
+  uint64_t t_legacy = 0;
+  uint32_t wr = 0, rd = 0, bricks_legacy = 0;
+  for (uint32_t n = 0; n < frames; n++) {
+    const uint32_t t0 = ncomm_cycles_now();
+    for (uint16_t i = 0; i < BENCH_FRAME; i++) {
+      s_legacy_ring[(wr + i) % LEGACY_RING] = (float)s_bench_pcm[i];
+    }
+    wr += BENCH_FRAME;
+    while (wr - rd >= BRICK_SAMPLES) {
+      const uint32_t pos = rd % LEGACY_RING;
+      const uint32_t first = (LEGACY_RING - pos < BRICK_SAMPLES) ? LEGACY_RING - pos : BRICK_SAMPLES;
+      std::memcpy(brick_f, &s_legacy_ring[pos], first * sizeof(float));
+      std::memcpy(brick_f + first, s_legacy_ring, (BRICK_SAMPLES - first) * sizeof(float));
+      rd += BRICK_SAMPLES;
+      sink = sink + brick_f[n & 127u];
+      bricks_legacy++;
+    }
+    t_legacy += (uint32_t)(ncomm_cycles_now() - t0);
+  }
+
+  // Repacker: frame arrives in a pool block (alloc + header write, as in the
+  // ISR), brick views, float only for the brick handed to the engine
+  FramePool pool;
+  pool.init(s_bench_blocks, (uint8_t)(sizeof(s_bench_blocks) / sizeof(s_bench_blocks[0])));
+  BrickRepacker rp;
+  uint64_t t_repack = 0;
+  uint32_t bricks_repack = 0;
+  for (uint32_t n = 0; n < frames; n++) {
+    const uint32_t t0 = ncomm_cycles_now();
+    FrameBlock* b = pool.alloc();
+    if (!b) break;
+    uint8_t* p = b->payload;
+    p[0] = 0; p[1] = 1;
+    p[2] = (uint8_t)BENCH_FRAME; p[3] = (uint8_t)(BENCH_FRAME >> 8);
+    p[4] = (uint8_t)n; p[5] = (uint8_t)(n >> 8); p[6] = (uint8_t)(n >> 16); p[7] = (uint8_t)(n >> 24);
+    b->len = (uint16_t)(AUDIO_HDR_SIZE + 2u * BENCH_FRAME);
+    const uint32_t t1 = ncomm_cycles_now();
+    // stands in for the ISR writing the payload; not timed
+    std::memcpy(p + AUDIO_HDR_SIZE, s_bench_pcm, sizeof(s_bench_pcm));
+    const uint32_t t2 = ncomm_cycles_now();
+
+    rp.push(FrameRef::adopt(b));
+    BrickView v;
+    while (rp.next(&v)) {
+      to_float(v, brick_f);
+      sink = sink + brick_f[n & 127u];
+      bricks_repack++;
+    }
+    t_repack += (uint32_t)(t1 - t0) + (uint32_t)(ncomm_cycles_now() - t2);
+  }
+  const BrickRepacker::Stats st = rp.stats();
+  rp.reset();
+  (void)sink;
+
+  out->legacy_ns = bricks_legacy ? (uint32_t)(ncomm_cycles_to_ns(t_legacy) / bricks_legacy) : 0;
+  out->repack_ns = bricks_repack ? (uint32_t)(ncomm_cycles_to_ns(t_repack) / bricks_repack) : 0;
+  out->split_pct = st.bricks ? st.bricks_split * 100u / st.bricks : 0;
+}
+
+} // namespace ncomm
+
+int main() {
+  ncomm::BrickBench b;
+  ncomm::brick_bench(&b, 1024);
+  std::printf("brick legacy=%u ns repack=%u ns split=%u%%\n", b.legacy_ns, b.repack_ns, b.split_pct);
+  // 256-sample frames: 14 of every 16 bricks span two frames (87.5 %)
+  return b.split_pct == 87u ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+// Host test: TinyKws trigger / endpoint latency, real-time factor, RAM;
+// decoder and endpointer decisions against hand-computed positions.
+#include "ncomm/ncomm_kws.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+#include "ncomm/ncomm_profile.h"
+
+namespace ncomm {
+
+// Real-time factor, RAM and detection latency of TinyKws.
+//   rtf_permille : engine time / audio time x 1000 over synthetic speech-like
+//                  input
+//   infer_us     : mean DS-CNN inference (front end excluded)
+//   ram          : engine state (sizeof) + placeholder model tables in RAM
+//   trigger_ms   : posterior step (filler -> command at 0.95) to trigger,
+//                  decoder only
+//   endpoint_ms  : trigger to endpointed result when the speech stops at the
+//                  trigger (decoder + endpointer)
+struct KwsBench {
+  uint32_t rtf_permille = 0;
+  uint32_t infer_us = 0;
+  uint32_t ram = 0;
+  uint32_t trigger_ms = 0;
+  uint32_t endpoint_ms = 0;
+};
+
+static constexpr uint32_t SAMPLES_PER_MS = 16;
+
+static TinyKws s_bench_kws;
+
+void kws_bench(KwsBench* out, uint32_t seconds) {
+  if (!out) return;
+  if (seconds == 0) seconds = 1;
+
+  const KwsConfig cfg;
+  s_bench_kws.init(kws_placeholder_model(), cfg);
+
+  // Speech-like input: 400 ms voiced bursts (150 Hz harmonics, syllable
+  // envelope) every 700 ms over low noise
+  int16_t pcm[BRICK_SAMPLES];
+  BrickView v;
+  v.seg[0] = pcm;
+  v.len[0] = BRICK_SAMPLES;
+  v.segs = 1;
+  uint32_t seed = 1;
+  uint64_t t_all = 0, t_inf = 0, t_plain = 0;
+  uint32_t n_inf = 0, n_plain = 0;
+  KwsResult res;
+  const uint32_t bricks = seconds * 16000u / BRICK_SAMPLES;
+  for (uint32_t b = 0; b < bricks; b++) {
+    const uint32_t pos = b * BRICK_SAMPLES;
+    for (uint32_t i = 0; i < BRICK_SAMPLES; i++) {
+      const uint32_t n = pos + i;
+      const uint32_t ph = n % 11200u; // 700 ms
+      float x = 0.0f;
+      if (ph < 6400u) {
+        const float env = std::sin(3.14159265f * (float)ph / 6400.0f);
+        const float t = (float)n / 16000.0f;
+        for (uint32_t h = 1; h <= 8; h++) x += std::sin(6.2831853f * 150.0f * (float)h * t) / (float)h;
+        x *= 6000.0f * env;
+      }
+      seed = seed * 1664525u + 1013904223u;
+      x += (float)((int32_t)(seed >> 24) - 128);
+      pcm[i] = (int16_t)x;
+    }
+    const uint32_t before = s_bench_kws.inferences();
+    const uint32_t t0 = ncomm_cycles_now();
+    (void)s_bench_kws.process(v, pos, &res);
+    const uint32_t dt = ncomm_cycles_now() - t0;
+    t_all += dt;
+    if (s_bench_kws.inferences() != before) { t_inf += dt; n_inf++; }
+    else { t_plain += dt; n_plain++; }
+  }
+  const uint64_t audio_ns = (uint64_t)bricks * BRICK_SAMPLES * 1000000000ull / 16000u;
+  out->rtf_permille = (uint32_t)(ncomm_cycles_to_ns(t_all) * 1000u / audio_ns);
+  if (n_inf && n_plain) {
+    const uint64_t a = ncomm_cycles_to_ns(t_inf) / n_inf, p = ncomm_cycles_to_ns(t_plain) / n_plain;
+    out->infer_us = (uint32_t)((a > p ? a - p : 0) / 1000u);
+  }
+  out->ram = s_bench_kws.ram_bytes() + kws_placeholder_model_bytes();
+
+  // Trigger latency: the decoder sees a clean posterior step
+  const uint32_t period = cfg.infer_every * BRICK_SAMPLES;
+  KwsDecoder dec;
+  dec.init(cfg);
+  const float filler[KWS_CLASSES] = {0.96f, 0.01f, 0.01f, 0.01f, 0.01f};
+  const float cmd[KWS_CLASSES] = {0.02f, 0.95f, 0.01f, 0.01f, 0.01f};
+  uint32_t p = 0;
+  float score = 0.0f;
+  for (uint32_t k = 0; k < 32; k++, p += period) (void)dec.push(filler, p, &score);
+  uint32_t steps = 0;
+  while (steps < 64) {
+    steps++;
+    const uint8_t c = dec.push(cmd, p, &score);
+    p += period;
+    if (c) break;
+  }
+  out->trigger_ms = steps * period / SAMPLES_PER_MS;
+
+  // Endpoint latency: speech stops at the trigger, frames until the result
+  KwsEndpointer ep;
+  ep.init(cfg, BRICK_SAMPLES);
+  p = 0;
+  for (uint32_t k = 0; k < 64; k++, p += BRICK_SAMPLES) ep.push(0.0f, p);
+  for (uint32_t k = 0; k < 40; k++, p += BRICK_SAMPLES) ep.push(30.0f, p);
+  ep.trigger(1, 0.9f, p);
+  uint32_t frames = 0;
+  while (frames < 256) {
+    frames++;
+    ep.push(0.0f, p);
+    p += BRICK_SAMPLES;
+    if (ep.done(&res)) break;
+  }
+  out->endpoint_ms = frames * BRICK_SAMPLES / SAMPLES_PER_MS;
+}
+
+// Decoder and endpointer against hand-computed positions, with a test
+// configuration (not the defaults) so the expectations do not restate
+// KwsConfig; returns the failures.
+uint32_t kws_decision_checks() {
+  uint32_t bad = 0;
+  KwsConfig cfg;
+  cfg.trigger = 0.7f;
+  cfg.smooth = 4;
+  cfg.refractory_ms = 500;
+  cfg.candidate = 0.5f;
+  cfg.hangover_ms = 150; // 10 bricks
+  cfg.max_tail_ms = 600; // 40 bricks
+  cfg.backoff_ms = 100;  // 1600 samples
+  const uint32_t period = 2 * BRICK_SAMPLES;
+  const float filler[KWS_CLASSES] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+  const float cmd3[KWS_CLASSES] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  const float weak2[KWS_CLASSES] = {0.4f, 0.0f, 0.6f, 0.0f, 0.0f};
+
+  // Filler never triggers; a clean command averages 1/4, 2/4, 3/4: candidate
+  // from the 2nd inference (0.5), trigger on the 3rd (0.75 >= 0.7)
+  KwsDecoder dec;
+  dec.init(cfg);
+  uint32_t p = 0;
+  float score = 0.0f;
+  for (uint32_t k = 0; k < 50; k++, p += period) bad += dec.push(filler, p, &score) == 0 ? 0u : 1u;
+  bad += dec.candidate() == 0 ? 0u : 1u;
+  bad += dec.push(cmd3, p, &score) == 0 && dec.candidate() == 0 ? 0u : 1u;
+  p += period;
+  bad += dec.push(cmd3, p, &score) == 0 && dec.candidate() == 3 ? 0u : 1u;
+  p += period;
+  const uint32_t t_trig = p;
+  bad += dec.push(cmd3, p, &score) == 3 && std::fabs(score - 0.75f) < 1e-6f ? 0u : 1u;
+  bad += dec.candidate() == 0 ? 0u : 1u; // locked
+
+  // Refractory 500 ms = 8000 samples: held command retriggers at the first
+  // inference at or after t_trig + 8000, i.e. 17 inferences (8160) later
+  uint32_t retrig = 0;
+  for (uint32_t k = 1; k <= 20 && !retrig; k++) {
+    if (dec.push(cmd3, t_trig + k * period, &score) == 3) retrig = k;
+  }
+  bad += retrig == 17u ? 0u : 1u;
+
+  // Held below the trigger, above the candidate level: candidate only
+  dec.reset();
+  uint32_t trig = 0;
+  for (uint32_t k = 0; k < 50; k++, p += period) trig += dec.push(weak2, p, &score) ? 1u : 0u;
+  bad += trig == 0 && dec.candidate() == 2 && std::fabs(score - 0.6f) < 1e-6f ? 0u : 1u;
+
+  // Endpointer: a first word on bricks 10..19, 20 quiet bricks (> hangover),
+  // the command on bricks 40..59 with a 5-brick stop (< hangover) at 50..54,
+  // trigger on brick 59. Start: brick 40 less the backoff; end: the first
+  // quiet brick (60), reported after 10 quiet bricks (brick 69).
+  auto speech = [](uint32_t b) { return (b >= 10 && b < 20) || (b >= 40 && b < 50) || (b >= 55 && b < 60); };
+  for (int tail_speech = 0; tail_speech < 2; tail_speech++) {
+    KwsEndpointer ep;
+    ep.init(cfg, BRICK_SAMPLES);
+    for (uint32_t b = 0; b < 60; b++) ep.push(speech(b) ? 30.0f : 0.0f, b * BRICK_SAMPLES);
+    ep.trigger(3, 0.5f, 59 * BRICK_SAMPLES);
+    KwsResult res;
+    uint32_t at = 0;
+    for (uint32_t b = 60; b < 200 && !at; b++) {
+      ep.push(tail_speech ? 30.0f : 0.0f, b * BRICK_SAMPLES);
+      if (ep.done(&res)) at = b;
+    }
+    // Talking on: cut 40 bricks after the trigger, end after brick 99
+    const uint32_t want_at = tail_speech ? 99u : 69u;
+    const uint32_t want_end = tail_speech ? 100u * BRICK_SAMPLES : 60u * BRICK_SAMPLES;
+    bad += at == want_at ? 0u : 1u;
+    bad += res.cmd_id == 3 && res.score == 128 && res.trigger_pos == 59u * BRICK_SAMPLES ? 0u : 1u;
+    bad += res.seg_start == 40u * BRICK_SAMPLES - 1600u && res.seg_end == want_end ? 0u : 1u;
+  }
+  return bad;
+}
+
+} // namespace ncomm
+
+int main() {
+  ncomm::KwsBench b;
+  ncomm::kws_bench(&b, 10);
+  std::printf("kws rtf=%u permille infer=%u us ram=%u B trig=%u ms ep=%u ms\n", b.rtf_permille, b.infer_us, b.ram,
+              b.trigger_ms, b.endpoint_ms);
+  // 4 inferences x 30 ms to trigger, 150 ms hangover to the endpoint; host
+  // rtf is 15..25 permille, 50 leaves room for a slow runner but not for a
+  // regression of the inference cost
+  const uint32_t dec_bad = ncomm::kws_decision_checks();
+  std::printf("kws decision bad=%u\n", dec_bad);
+  return (dec_bad == 0 && b.trigger_ms == 120u && b.endpoint_ms == 150u && b.rtf_permille <= 50u) ? 0 : 1;
+}
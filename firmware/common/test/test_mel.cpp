@@ -0,0 +1,333 @@
+// Host test: both mel front ends against a double-precision reference, the
+// float one (MCU2) no slower than the fixed-point one, MelStream and looped
+// SR packets bitwise against batch compute, ns per frame.
+#include "ncomm/ncomm_mel.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "ncomm/ncomm_profile.h"
+
+namespace ncomm {
+
+// ---- Golden comparison + time per frame ----
+// Reference: the same definition in double precision (direct DFT, exact
+// window and filterbank). Inputs: noise at -6 / -40 / -80 dBFS, two tones,
+// a 100..7000 Hz chirp, voiced bursts, full-scale square wave, digital
+// silence; 24 frames each (8000 samples).
+//   max_err_mn  : max |MelFrontEnd - reference| over all bins, milli-nats
+//   rms_err_mn  : RMS of the same
+//   cmvn_err_mn : max error after per-utterance CMVN (encoder input)
+//   q31_err_mn / q31_cmvn_mn : the same two maxima for MelFrontEndQ31
+//   float_ns / fixed_ns : per frame, MelFrontEnd / MelFrontEndQ31, best of
+//                         TIME_PASSES passes over all signals
+//   ram / q31_ram : tables + buffers
+// Streaming (MelStream over a SpeechRing fed in 256-sample chunks, VAD off
+// then on; segment of 8000 samples starting 1000 before the onset):
+//   stream_bad  : floats where segment() differs from compute() at the same
+//                 grid positions (bitwise; 0 expected)
+//   stream_hits : frames of that segment already cached at decision time
+//   decision_ns : segment() for the SR window (gather only)
+//   batch_ns    : compute() for the same window (cost without streaming)
+//   stream_ram  : MelStream frame ring
+// SR packets (mel_sr_packets() on that ring: scenarios A, B, B without
+// looping, C, C with a short rest, B across the ring wrap), each packet
+// against the physical looping copy (spec 6.5.3 algorithm, 256-sample
+// chunks into an 8000-sample window, then compute() on the copy):
+//   loop_bad    : floats where the view differs from the copy (bitwise;
+//                 compute() on the view and MelStream::looped()), plus
+//                 packet count mismatches; 0 expected
+//   loop_packets / loop_frames / loop_hits : packets, frames, cache hits
+//   copy_bytes  : bytes the copies wrote (the view writes none)
+//   copy_ram    : window buffer the copy needs (the view: none)
+//   copy_ns / view_ns / looped_ns : per packet, copy + frames / frames
+//                 through the view / MelStream::looped()
+struct MelBench {
+  uint32_t max_err_mn = 0;
+  uint32_t rms_err_mn = 0;
+  uint32_t cmvn_err_mn = 0;
+  uint32_t q31_err_mn = 0;
+  uint32_t q31_cmvn_mn = 0;
+  uint32_t float_ns = 0;
+  uint32_t fixed_ns = 0;
+  uint32_t ram = 0;
+  uint32_t q31_ram = 0;
+  uint32_t stream_bad = 0;
+  uint32_t stream_hits = 0;
+  uint32_t decision_ns = 0;
+  uint32_t batch_ns = 0;
+  uint32_t stream_ram = 0;
+  uint32_t loop_bad = 0;
+  uint32_t loop_packets = 0;
+  uint32_t loop_frames = 0;
+  uint32_t loop_hits = 0;
+  uint32_t copy_bytes = 0;
+  uint32_t copy_ram = 0;
+  uint32_t copy_ns = 0;
+  uint32_t view_ns = 0;
+  uint32_t looped_ns = 0;
+};
+
+static constexpr double SAMPLE_RATE = 16000.0;
+static constexpr double PI = 3.14159265358979323846;
+static constexpr uint32_t SIGNALS = 8;
+static constexpr uint32_t F = MEL_WINDOW_FRAMES;
+static constexpr uint32_t TIME_PASSES = 5;
+
+static MelFrontEnd s_mel;
+static MelFrontEndQ31 s_mel_q31;
+static int16_t s_sigs[SIGNALS][MEL_WINDOW_SAMPLES];
+static int16_t s_sig[MEL_WINDOW_SAMPLES];
+static double s_cos[MEL_NFFT];
+static double s_sin[MEL_NFFT];
+static double s_ref_w[MEL_BINS][MEL_NFFT / 2 + 1];
+static double s_ref_norm[MEL_BINS];
+static float s_fix[MEL_BINS * F];
+static float s_q31[MEL_BINS * F];
+static float s_ref[MEL_BINS * F];
+static MelStream s_stream;
+static int16_t s_ring_buf[16384];
+static SpeechRing s_ring;
+
+static void make_signal(uint32_t kind, int16_t* x) {
+  uint32_t seed = 0x6D656C00u + kind;
+  for (uint32_t n = 0; n < MEL_WINDOW_SAMPLES; n++) {
+    const double t = n / SAMPLE_RATE;
+    seed = seed * 1664525u + 1013904223u;
+    const double r = ((double)(seed >> 8) / 8388608.0) - 1.0; // +-1
+    double v = 0.0;
+    switch (kind) {
+      case 0: v = 0.5 * r; break;                         // -6 dBFS noise
+      case 1: v = 0.01 * r; break;                        // -40 dBFS
+      case 2: v = 0.0001 * r * 3.0; break;                // ~-80 dBFS (a few LSB)
+      case 3: v = 0.3 * std::sin(2 * PI * 440 * t) + 0.1 * std::sin(2 * PI * 3000 * t); break;
+      case 4: v = 0.5 * std::sin(2 * PI * (100.0 * t + 0.5 * 13800.0 * t * t)); break; // 100..7000 Hz
+      case 5: {
+        const double env = std::fabs(std::sin(PI * t / 0.25));
+        for (int h = 1; h <= 10; h++) v += std::sin(2 * PI * 140.0 * h * t) / h;
+        v = 0.2 * env * v + 0.002 * r;
+        break;
+      }
+      case 6: v = (std::sin(2 * PI * 250 * t) >= 0.0) ? 0.99997 : -1.0; break;
+      default: v = 0.0; break;
+    }
+    long q = std::lround(v * 32768.0);
+    if (q > 32767) q = 32767;
+    if (q < -32768) q = -32768;
+    x[n] = (int16_t)q;
+  }
+}
+
+static void reference_frame(const int16_t* x, float* out, uint32_t stride) {
+  static double pw[MEL_NFFT / 2 + 1];
+  static double xw[MEL_NFFT];
+  for (uint32_t i = 0; i < MEL_NFFT; i++) {
+    xw[i] = (x[i] / 32768.0) * (0.5 - 0.5 * std::cos(2.0 * PI * i / MEL_NFFT));
+  }
+  for (uint32_t k = 0; k <= MEL_NFFT / 2u; k++) {
+    double re = 0.0, im = 0.0;
+    uint32_t idx = 0;
+    for (uint32_t i = 0; i < MEL_NFFT; i++) {
+      re += xw[i] * s_cos[idx];
+      im -= xw[i] * s_sin[idx];
+      idx = (idx + k) & (MEL_NFFT - 1u);
+    }
+    pw[k] = re * re + im * im;
+  }
+  for (uint32_t m = 0; m < MEL_BINS; m++) {
+    double e = 0.0;
+    for (uint32_t k = 0; k <= MEL_NFFT / 2u; k++) e += s_ref_w[m][k] * pw[k];
+    out[m * stride] = (float)std::log(e * s_ref_norm[m] + (double)MEL_LOG_EPS);
+  }
+}
+
+// Max |a - b| over [MEL_BINS][F]
+static double max_diff(const float* a, const float* b) {
+  double m = 0.0;
+  for (uint32_t i = 0; i < MEL_BINS * F; i++) {
+    const double d = std::fabs((double)a[i] - (double)b[i]);
+    if (d > m) m = d;
+  }
+  return m;
+}
+
+// Per-frame time of fe over all signals, best of TIME_PASSES
+template <class FE>
+static uint64_t time_frames(FE& fe) {
+  uint64_t best = ~0ull;
+  for (uint32_t pass = 0; pass < TIME_PASSES; pass++) {
+    uint64_t t = 0;
+    for (uint32_t sig = 0; sig < SIGNALS; sig++) {
+      const uint32_t t0 = ncomm_cycles_now();
+      for (uint32_t f = 0; f < F; f++) fe.frame(&s_sigs[sig][f * MEL_HOP], MEL_NFFT, nullptr, s_fix + f, F);
+      t += (uint32_t)(ncomm_cycles_now() - t0);
+    }
+    if (t < best) best = t;
+  }
+  return ncomm_cycles_to_ns(best) / (SIGNALS * F);
+}
+
+void mel_bench(MelBench* out) {
+  if (!out) return;
+  s_mel.init();
+  s_mel_q31.init();
+  for (uint32_t i = 0; i < MEL_NFFT; i++) {
+    s_cos[i] = std::cos(2.0 * PI * i / MEL_NFFT);
+    s_sin[i] = std::sin(2.0 * PI * i / MEL_NFFT);
+  }
+  for (uint32_t m = 0; m < MEL_BINS; m++) {
+    for (uint32_t k = 0; k <= MEL_NFFT / 2u; k++) s_ref_w[m][k] = mel_slaney_weight(m, k, &s_ref_norm[m]);
+  }
+
+  double max_err = 0.0, sq = 0.0, max_cmvn = 0.0, q31_err = 0.0, q31_cmvn = 0.0;
+  uint32_t n_err = 0;
+  for (uint32_t sig = 0; sig < SIGNALS; sig++) {
+    make_signal(sig, s_sigs[sig]);
+    for (uint32_t f = 0; f < F; f++) {
+      const int16_t* x = &s_sigs[sig][f * MEL_HOP];
+      s_mel.frame(x, MEL_NFFT, nullptr, s_fix + f, F);
+      s_mel_q31.frame(x, MEL_NFFT, nullptr, s_q31 + f, F);
+      reference_frame(x, s_ref + f, F);
+    }
+    for (uint32_t i = 0; i < MEL_BINS * F; i++) {
+      const double d = std::fabs((double)s_fix[i] - (double)s_ref[i]);
+      if (d > max_err) max_err = d;
+      sq += d * d;
+      n_err++;
+    }
+    const double dq = max_diff(s_q31, s_ref);
+    if (dq > q31_err) q31_err = dq;
+    mel_cmvn(s_fix, F, F, true);
+    mel_cmvn(s_q31, F, F, true);
+    mel_cmvn(s_ref, F, F, true);
+    const double dc = max_diff(s_fix, s_ref);
+    if (dc > max_cmvn) max_cmvn = dc;
+    const double dqc = max_diff(s_q31, s_ref);
+    if (dqc > q31_cmvn) q31_cmvn = dqc;
+  }
+
+  out->max_err_mn = (uint32_t)(max_err * 1000.0 + 0.5);
+  out->rms_err_mn = (uint32_t)(std::sqrt(sq / (double)n_err) * 1000.0 + 0.5);
+  out->cmvn_err_mn = (uint32_t)(max_cmvn * 1000.0 + 0.5);
+  out->q31_err_mn = (uint32_t)(q31_err * 1000.0 + 0.5);
+  out->q31_cmvn_mn = (uint32_t)(q31_cmvn * 1000.0 + 0.5);
+  out->float_ns = (uint32_t)time_frames(s_mel);
+  out->fixed_ns = (uint32_t)time_frames(s_mel_q31);
+  out->ram = s_mel.ram_bytes();
+  out->q31_ram = s_mel_q31.ram_bytes();
+
+  // Streaming: 500 ms background (VAD off), 500 ms speech + 125 ms hangover (on)
+  s_ring.init(s_ring_buf, 16384);
+  s_stream.init(&s_mel);
+  const uint32_t onset = MEL_WINDOW_SAMPLES;
+  for (uint32_t part = 0; part < 3; part++) {
+    make_signal(part == 1 ? 5u : 1u, s_sig);
+    const uint32_t len = (part == 2) ? 2000u : MEL_WINDOW_SAMPLES;
+    for (uint32_t at = 0; at < len; at += 256) {
+      const uint32_t n = (len - at < 256u) ? len - at : 256u;
+      s_ring.write(&s_sig[at], n);
+      s_stream.update(s_ring, part > 0);
+    }
+  }
+  const uint32_t pos = onset - 1000u + 137u;
+  const uint32_t grid = (pos + MEL_HOP - 1u) / MEL_HOP * MEL_HOP; // stream grid starts at 0
+  uint32_t hits = 0;
+  const uint32_t t0 = ncomm_cycles_now();
+  const uint32_t got = s_stream.segment(s_ring, pos, MEL_WINDOW_SAMPLES, s_fix, F, &hits);
+  const uint32_t t1 = ncomm_cycles_now();
+  const uint32_t want = s_mel.compute(s_ring, grid, pos + MEL_WINDOW_SAMPLES - grid, s_ref, F);
+  const uint32_t t2 = ncomm_cycles_now();
+  uint32_t bad = (got == want) ? 0u : MEL_BINS * F;
+  for (uint32_t k = 0; k < MEL_BINS && !bad; k++) {
+    for (uint32_t i = 0; i < got; i++) {
+      if (std::memcmp(&s_fix[k * F + i], &s_ref[k * F + i], sizeof(float)) != 0) bad++;
+    }
+  }
+  out->stream_bad = bad;
+  out->stream_hits = hits;
+  out->decision_ns = (uint32_t)ncomm_cycles_to_ns((uint32_t)(t1 - t0));
+  out->batch_ns = (uint32_t)ncomm_cycles_to_ns((uint32_t)(t2 - t1));
+  out->stream_ram = s_stream.ram_bytes();
+
+  // SR packets: looped views vs the physical looping copy (ring head 18000,
+  // grid through 0; the last case wraps the 16384-sample ring)
+  struct LoopCase {
+    uint32_t pos, n;
+    uint8_t packets;
+  };
+  static constexpr LoopCase cases[] = {
+      {14100, 3900, 0}, {9137, 4300, 1}, {8500, 7000, 1}, {9000, 8000, 1},
+      {3100, 14500, 2}, {3100, 9000, 1}, {12000, 4500, 1},
+  };
+  uint64_t t_copy = 0, t_view = 0, t_looped = 0;
+  uint32_t loop_bad = 0, packets = 0, frames = 0, loop_hits = 0, copy_bytes = 0;
+  for (const LoopCase& c : cases) {
+    LoopedSpan pk[SR_MAX_PACKETS];
+    const uint8_t np = mel_sr_packets(s_ring, c.pos, c.n, s_stream.next_pos(), pk);
+    if (np != c.packets) loop_bad++;
+    for (uint32_t k = 0; k < np; k++) {
+      const LoopedSpan& v = pk[k];
+      uint32_t t0 = ncomm_cycles_now();
+      for (uint32_t copy_index = 0, at = 0; at < MEL_WINDOW_SAMPLES;) {
+        uint32_t m = MEL_WINDOW_SAMPLES - at;
+        if (m > 256u) m = 256u;
+        if (m > v.period() - copy_index) m = v.period() - copy_index;
+        s_ring.read(v.pos() + copy_index, &s_sig[at], m);
+        at += m;
+        copy_index += m;
+        if (copy_index >= v.period()) copy_index = 0;
+      }
+      for (uint32_t f = 0; f < F; f++) s_mel.frame(&s_sig[f * MEL_HOP], MEL_NFFT, nullptr, s_ref + f, F);
+      uint32_t t1 = ncomm_cycles_now();
+      t_copy += (uint32_t)(t1 - t0);
+      copy_bytes += MEL_WINDOW_SAMPLES * sizeof(int16_t);
+
+      for (uint32_t pass = 0; pass < 2; pass++) {
+        uint32_t h = 0;
+        t0 = ncomm_cycles_now();
+        const uint32_t got = pass ? s_stream.looped(v, s_fix, F, &h) : s_mel.compute(v, s_fix, F);
+        t1 = ncomm_cycles_now();
+        (pass ? t_looped : t_view) += (uint32_t)(t1 - t0);
+        if (got != F) loop_bad += MEL_BINS * F;
+        for (uint32_t i = 0; i < MEL_BINS * F; i++) {
+          if (std::memcmp(&s_fix[i], &s_ref[i], sizeof(float)) != 0) loop_bad++;
+        }
+        if (pass) loop_hits += h;
+      }
+      packets++;
+      frames += F;
+    }
+  }
+  out->loop_bad = loop_bad;
+  out->loop_packets = packets;
+  out->loop_frames = frames;
+  out->loop_hits = loop_hits;
+  out->copy_bytes = copy_bytes;
+  out->copy_ram = MEL_WINDOW_SAMPLES * sizeof(int16_t);
+  if (packets) {
+    out->copy_ns = (uint32_t)(ncomm_cycles_to_ns(t_copy) / packets);
+    out->view_ns = (uint32_t)(ncomm_cycles_to_ns(t_view) / packets);
+    out->looped_ns = (uint32_t)(ncomm_cycles_to_ns(t_looped) / packets);
+  }
+}
+
+} // namespace ncomm
+
+int main() {
+  static ncomm::MelBench b;
+  ncomm::mel_bench(&b);
+  std::printf("mel err=%u/%u/%u mnat float=%u ns ram=%u B | q31 err=%u/%u mnat fixed=%u ns ram=%u B\n", b.max_err_mn,
+              b.rms_err_mn, b.cmvn_err_mn, b.float_ns, b.ram, b.q31_err_mn, b.q31_cmvn_mn, b.fixed_ns, b.q31_ram);
+  std::printf("mel stream bad=%u hits=%u/%u decision=%u ns batch=%u ns ram=%u B\n", b.stream_bad, b.stream_hits,
+              (unsigned)ncomm::MEL_WINDOW_FRAMES, b.decision_ns, b.batch_ns, b.stream_ram);
+  std::printf("mel loop bad=%u pk=%u hits=%u/%u copyB=%u copyRam=%u copy=%u ns view=%u ns looped=%u ns\n", b.loop_bad,
+              b.loop_packets, b.loop_hits, b.loop_frames, b.copy_bytes, b.copy_ram, b.copy_ns, b.view_ns,
+              b.looped_ns);
+  // Tolerance of the model input: 0.02 nat, 0.05 nat after CMVN (both paths);
+  // MCU2 runs MelFrontEnd, so it must not be slower than the fixed-point path
+  const bool ok = b.max_err_mn <= 20u && b.cmvn_err_mn <= 50u && b.q31_err_mn <= 20u && b.q31_cmvn_mn <= 50u &&
+                  b.float_ns <= b.fixed_ns && b.stream_bad == 0 && b.loop_bad == 0;
+  if (b.float_ns > b.fixed_ns) std::printf("mel FAIL: MelFrontEnd slower than MelFrontEndQ31\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+// Host test: PlayoutBuffer (jitter buffer + ASRC) under simulated link timing.
+#include "ncomm/ncomm_playout.hpp"
+
+#include <cstdio>
+
+namespace ncomm {
+
+// ---- Simulation: jitter buffer under link timing ----
+// 16 kHz chunks (256 samples) pushed on a 16 ms grid of the source clock
+// with per-chunk delivery jitter (uniform 0..jitter_ms, plus a 40 ms stall
+// every 2 s for the bursty row), pulled in 128-sample DAC blocks, 300 s per
+// row, with a 1 s stream stop at 15 s (a PTT release; the source position
+// freezes like the link frame_index). The drift rows run the source clock
+// ppm off the DAC, with the ASRC on and off:
+//   jitter_ms / bursty / ppm / asrc : scenario
+//   underruns, concealed_ms, trimmed_ms, trims, stops
+//   target_ms            : final target
+//   lat_avg_ms / lat_max_ms : arrival -> DAC
+//   est_ppb              : final drift estimate
+static constexpr uint8_t PLAYOUT_SIM_ROWS = 9;
+
+struct PlayoutSimRow {
+  uint32_t jitter_ms = 0;
+  bool bursty = false;
+  int32_t ppm = 0;
+  bool asrc = true;
+  uint32_t underruns = 0;
+  uint32_t concealed_ms = 0;
+  uint32_t trimmed_ms = 0;
+  uint32_t trims = 0;
+  uint32_t stops = 0;
+  uint32_t target_ms = 0;
+  uint32_t lat_avg_ms = 0;
+  uint32_t lat_max_ms = 0;
+  int32_t est_ppb = 0;
+};
+
+static constexpr uint32_t PS_CHUNK = 256;
+static constexpr uint32_t PS_BLOCK = 128;
+static constexpr uint32_t PS_SECONDS = 300;
+static constexpr uint32_t PS_STOP_FROM = 15 * 16000; // stream stop [15 s, 16 s)
+static constexpr uint32_t PS_STOP_TO = 16 * 16000;
+
+struct PsScenario {
+  uint8_t jitter_ms;
+  bool bursty;
+  int16_t ppm;
+  bool asrc;
+};
+
+static const PsScenario PS_ROWS[PLAYOUT_SIM_ROWS] = {
+    {0, false, 0, true},    {4, false, 0, true},     {8, false, 0, true},
+    {16, false, 0, true},   {8, true, 0, true},      {4, false, 100, false},
+    {4, false, 100, true},  {4, false, -100, false}, {4, false, -100, true},
+};
+
+static inline uint32_t ps_lcg(uint32_t* s) {
+  *s = *s * 1664525u + 1013904223u;
+  return *s;
+}
+
+void playout_sim(PlayoutSimRow* rows) {
+  if (!rows) return;
+  static PlayoutBuffer pb;
+  int16_t chunk[PS_CHUNK];
+  int16_t block[PS_BLOCK];
+  for (uint32_t r = 0; r < PLAYOUT_SIM_ROWS; r++) {
+    const PsScenario& sc = PS_ROWS[r];
+    PlayoutSimRow& row = rows[r];
+    row = PlayoutSimRow{};
+    row.jitter_ms = sc.jitter_ms;
+    row.bursty = sc.bursty;
+    row.ppm = sc.ppm;
+    row.asrc = sc.asrc;
+    PlayoutConfig cfg;
+    cfg.asrc = sc.asrc;
+    pb.init(cfg);
+    uint32_t seed = 0x504C4159u + r;
+    // Output samples per source sample
+    const double rate = 1.0 / (1.0 + sc.ppm * 1e-6);
+    const uint32_t end = PS_SECONDS * 16000u;
+    uint32_t c = 0;          // next chunk (source clock)
+    uint32_t sent = 0;       // chunks sent: the source position
+    uint32_t next_at = (uint32_t)((double)PS_CHUNK * rate); // its arrival (output clock)
+    uint32_t last_at = 0;
+    for (uint32_t t = 0; t < end; t += PS_BLOCK) {
+      // Chunks that arrived by now; a chunk is sent once MCU1 captured it
+      while (next_at <= t) {
+        const uint32_t cap = c * PS_CHUNK;
+        if (cap < PS_STOP_FROM || cap >= PS_STOP_TO) {
+          for (uint32_t i = 0; i < PS_CHUNK; i++) chunk[i] = (int16_t)(cap + i);
+          pb.push(chunk, PS_CHUNK, next_at, sent * PS_CHUNK);
+          sent++;
+        }
+        c++;
+        uint32_t at = (uint32_t)((double)((c + 1u) * PS_CHUNK) * rate);
+        if (sc.jitter_ms) at += ps_lcg(&seed) % (sc.jitter_ms * 16u + 1u);
+        if (sc.bursty && (c % 125u) == 60u) at += 40u * 16u;
+        if (at < last_at) at = last_at; // the link delivers in order
+        last_at = next_at = at;
+      }
+      // The DMA half being refilled plays after the one playing now
+      pb.pull(block, PS_BLOCK, t + PS_BLOCK);
+    }
+    const PlayoutBuffer::Stats& st = pb.stats();
+    row.underruns = st.underruns;
+    row.concealed_ms = st.concealed / 16u;
+    row.trimmed_ms = st.trimmed / 16u;
+    row.trims = st.trims;
+    row.stops = st.stops;
+    row.target_ms = pb.target() / 16u;
+    row.lat_avg_ms = st.lat_avg_us / 1000u;
+    row.lat_max_ms = st.lat_max_us / 1000u;
+    row.est_ppb = st.drift_ppb;
+  }
+}
+
+} // namespace ncomm
+
+int main() {
+  ncomm::PlayoutSimRow rows[ncomm::PLAYOUT_SIM_ROWS];
+  ncomm::playout_sim(rows);
+  std::printf("jit burst   ppm asrc under conc_ms trim_ms trims stops target lat_avg lat_max est_ppb\n");
+  bool ok = true;
+  for (const ncomm::PlayoutSimRow& r : rows) {
+    std::printf("%3u %5s %5d %4s %5u %7u %7u %5u %5u %6u %7u %7u %7d\n", r.jitter_ms, r.bursty ? "yes" : "no", r.ppm,
+                r.asrc ? "on" : "off", r.underruns, r.concealed_ms, r.trimmed_ms, r.trims, r.stops, r.target_ms,
+                r.lat_avg_ms, r.lat_max_ms, r.est_ppb);
+    // One stream stop per run; steady jitter (and drift with the ASRC on)
+    // plays out without an underrun; the drift estimate within 2 ppm
+    ok = ok && r.stops == 1u;
+    if (!r.bursty && (r.asrc || r.ppm == 0)) ok = ok && r.underruns == 0;
+    if (r.asrc && r.ppm != 0) {
+      const int32_t err = r.est_ppb - r.ppm * 1000;
+      ok = ok && err > -2000 && err < 2000;
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// Host test: bitwise check that lazy conversion equals convert-on-receipt.
+// The same frames go into a float ring (legacy) and a SpeechRing, then
+// windows at many positions are compared through read_float() and
+// read_windowed().
+#include "ncomm/ncomm_speech.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace ncomm {
+
+static constexpr uint32_t LEGACY_RING = 32000; // spec 7.2 InputBuffer, 2 s float
+static constexpr uint16_t ST_FRAME = 256;
+static constexpr uint32_t ST_WIN = 1024;       // longest consumer read (mel NFFT)
+
+static float s_legacy[LEGACY_RING];
+static int16_t s_ring_buf[SPEECH_RING_SAMPLES];
+
+static bool same_bits(float a, float b) {
+  uint32_t x, y;
+  std::memcpy(&x, &a, 4);
+  std::memcpy(&y, &b, 4);
+  return x == y;
+}
+
+// Mismatching samples (0 = identical)
+uint32_t speech_ring_selftest() {
+  SpeechRing ring;
+  ring.init(s_ring_buf, SPEECH_RING_SAMPLES);
+
+  static float window[ST_WIN];
+  for (uint32_t i = 0; i < ST_WIN; i++) {
+    // Hann-like, odd values on purpose (no exact products)
+    const float x = (float)i / (float)(ST_WIN - 1u);
+    window[i] = 4.0f * x * (1.0f - x) + 1e-3f;
+  }
+  static float legacy_out[ST_WIN];
+  static float lazy_out[ST_WIN];
+  int16_t frame[ST_FRAME];
+
+  const float scales[2] = {1.0f, 1.0f / 32768.0f};
+  uint32_t seed = 0x12345678u;
+  uint32_t legacy_wr = 0;
+  uint32_t bad = 0;
+
+  // ~8.5 s of input: both rings wrap several times; covers full scale
+  for (uint32_t f = 0; f < 530u; f++) {
+    for (uint16_t i = 0; i < ST_FRAME; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      frame[i] = (int16_t)(seed >> 16);
+    }
+    if (f == 7u) { frame[0] = INT16_MIN; frame[1] = INT16_MAX; frame[2] = 0; frame[3] = -1; }
+
+    // legacy: convert on receipt
+    for (uint16_t i = 0; i < ST_FRAME; i++) s_legacy[(legacy_wr + i) % LEGACY_RING] = (float)frame[i];
+    legacy_wr += ST_FRAME;
+    // lazy: store as received
+    ring.write(frame, ST_FRAME);
+
+    // reads at a few lags, including ones across the wrap of either ring
+    const uint32_t lags[3] = {ST_WIN, 9000u, LEGACY_RING - 5u};
+    for (uint32_t l = 0; l < 3u; l++) {
+      if (lags[l] > legacy_wr) continue;
+      const uint32_t pos = ring.head() - lags[l];
+      const uint32_t n = (lags[l] < ST_WIN) ? lags[l] : ST_WIN;
+      const float scale = scales[(f + l) & 1u];
+
+      for (uint32_t i = 0; i < n; i++) legacy_out[i] = s_legacy[(pos + i) % LEGACY_RING] * scale;
+      if (ring.read_float(pos, lazy_out, n, scale) != n) bad += n;
+      for (uint32_t i = 0; i < n; i++) bad += !same_bits(legacy_out[i], lazy_out[i]);
+
+      for (uint32_t i = 0; i < n; i++) legacy_out[i] = (s_legacy[(pos + i) % LEGACY_RING] * scale) * window[i];
+      if (ring.read_windowed(pos, window, lazy_out, n, scale) != n) bad += n;
+      for (uint32_t i = 0; i < n; i++) bad += !same_bits(legacy_out[i], lazy_out[i]);
+    }
+  }
+
+  // out of range
+  if (ring.available(ring.head() - SPEECH_RING_SAMPLES - 1u) != 0) bad++;
+  if (ring.available(ring.head() + 1u) != 0) bad++;
+  return bad;
+}
+
+} // namespace ncomm
+
+int main() {
+  const uint32_t bad = ncomm::speech_ring_selftest();
+  std::printf("speech selftest bad=%u\n", bad);
+  return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// Host test: Q15 embedding index against float scoring, 1:N query time.
+#include "ncomm/ncomm_sr.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+#include "ncomm/ncomm_profile.h"
+
+namespace ncomm {
+
+// ---- 1:N scoring, N = 1 .. 256 ----
+// Random unit templates, one query; top_k(5) on the Q15 index against the
+// same scoring in float (128-float templates, scalar loop).
+//   q15_ns / f32_ns : per query at N = SR_BENCH_N[i]
+//   max_err_e5      : max |cos Q15 - cos float| x 10^5 over all pairs
+//   topk_agree      : queries whose top-5 voices match the float ranking (of 64)
+//   bytes_per_tpl   : index RAM per template (Q15 row + voice id)
+static constexpr uint8_t SR_BENCH_POINTS = 5;
+static constexpr uint16_t SR_BENCH_N[SR_BENCH_POINTS] = {1, 4, 16, 64, 256};
+
+struct SrBench {
+  uint32_t q15_ns[SR_BENCH_POINTS] = {};
+  uint32_t f32_ns[SR_BENCH_POINTS] = {};
+  uint32_t max_err_e5 = 0;
+  uint32_t topk_agree = 0;
+  uint32_t bytes_per_tpl = 0;
+};
+
+static constexpr float Q15_SQ = 32767.0f * 32767.0f;
+static constexpr uint32_t BENCH_QUERIES = 64;
+static constexpr uint8_t BENCH_K = 5;
+
+static int16_t s_b_rows[SR_MAX_TEMPLATES * SR_EMB_DIM];
+static uint8_t s_b_voice[SR_MAX_TEMPLATES];
+static float s_b_f32[SR_MAX_TEMPLATES][SR_EMB_DIM];
+static float s_b_query[BENCH_QUERIES][SR_EMB_DIM];
+static EmbeddingIndex s_b_index;
+
+static void random_unit(float* v, uint32_t* seed) {
+  float e = 0.0f;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) {
+    // sum of 4 uniforms: near-Gaussian components
+    float s = 0.0f;
+    for (int j = 0; j < 4; j++) {
+      *seed = *seed * 1664525u + 1013904223u;
+      s += (float)(*seed >> 8) / 16777216.0f - 0.5f;
+    }
+    v[i] = s;
+    e += s * s;
+  }
+  const float g = 1.0f / std::sqrt(e);
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) v[i] *= g;
+}
+
+// Float baseline: same top-k (best per voice), scalar dot over floats
+static uint8_t f32_top_k(const float* q, uint16_t n, uint8_t k, int16_t* voice_out) {
+  float best[SR_TOPK_MAX];
+  uint8_t m = 0;
+  for (uint16_t s = 0; s < n; s++) {
+    float acc = 0.0f;
+    for (uint32_t i = 0; i < SR_EMB_DIM; i++) acc += q[i] * s_b_f32[s][i];
+    const int16_t v = s_b_voice[s];
+    uint8_t at = m;
+    for (uint8_t j = 0; j < m; j++) {
+      if (voice_out[j] == v) { at = j; break; }
+    }
+    if (at < m) {
+      if (acc <= best[at]) continue;
+    } else if (m < k) {
+      at = m++;
+    } else {
+      if (acc <= best[m - 1]) continue;
+      at = (uint8_t)(m - 1);
+    }
+    while (at > 0 && best[at - 1] < acc) {
+      best[at] = best[at - 1];
+      voice_out[at] = voice_out[at - 1];
+      at--;
+    }
+    best[at] = acc;
+    voice_out[at] = v;
+  }
+  return m;
+}
+
+void sr_bench(SrBench* out) {
+  if (!out) return;
+
+  // Templates: 2 per voice (voice = slot / 2), all unit length
+  uint32_t seed = 0x53523432u;
+  s_b_index.init(s_b_rows, s_b_voice, SR_MAX_TEMPLATES);
+  for (uint16_t s = 0; s < SR_MAX_TEMPLATES; s++) {
+    random_unit(s_b_f32[s], &seed);
+    s_b_index.add(s_b_f32[s], (uint8_t)(s / 2u));
+  }
+  for (uint32_t q = 0; q < BENCH_QUERIES; q++) random_unit(s_b_query[q], &seed);
+
+  // Accuracy over all pairs
+  static int32_t acc[SR_MAX_TEMPLATES];
+  int16_t qq[SR_EMB_DIM];
+  float max_err = 0.0f;
+  for (uint32_t q = 0; q < BENCH_QUERIES; q++) {
+    EmbeddingIndex::quantize(s_b_query[q], qq);
+    s_b_index.score_all(qq, acc);
+    for (uint16_t s = 0; s < SR_MAX_TEMPLATES; s++) {
+      float ref = 0.0f;
+      for (uint32_t i = 0; i < SR_EMB_DIM; i++) ref += s_b_query[q][i] * s_b_f32[s][i];
+      const float e = std::fabs((float)acc[s] / Q15_SQ - ref);
+      if (e > max_err) max_err = e;
+    }
+  }
+
+  // Timing: full query (quantise + top-k) vs float top-k, N = 1 .. 256;
+  // ranking agreement at the largest N
+  uint32_t agree = 0;
+  for (uint8_t p = 0; p < SR_BENCH_POINTS; p++) {
+    const uint16_t n = SR_BENCH_N[p];
+    s_b_index.clear();
+    for (uint16_t s = 0; s < n; s++) s_b_index.add(s_b_f32[s], (uint8_t)(s / 2u));
+    uint64_t t_q = 0, t_f = 0;
+    for (uint32_t q = 0; q < BENCH_QUERIES; q++) {
+      SrMatch m[BENCH_K];
+      int16_t fv[BENCH_K];
+      const uint32_t t0 = ncomm_cycles_now();
+      EmbeddingIndex::quantize(s_b_query[q], qq);
+      const uint8_t got = s_b_index.top_k(qq, BENCH_K, m);
+      const uint32_t t1 = ncomm_cycles_now();
+      const uint8_t fgot = f32_top_k(s_b_query[q], n, BENCH_K, fv);
+      const uint32_t t2 = ncomm_cycles_now();
+      t_q += (uint32_t)(t1 - t0);
+      t_f += (uint32_t)(t2 - t1);
+      if (p == SR_BENCH_POINTS - 1u) {
+        bool same = (got == fgot);
+        for (uint8_t j = 0; same && j < got; j++) same = (m[j].voice_id == fv[j]);
+        agree += same ? 1u : 0u;
+      }
+    }
+    out->q15_ns[p] = (uint32_t)(ncomm_cycles_to_ns(t_q) / BENCH_QUERIES);
+    out->f32_ns[p] = (uint32_t)(ncomm_cycles_to_ns(t_f) / BENCH_QUERIES);
+  }
+  out->topk_agree = agree;
+  out->max_err_e5 = (uint32_t)(max_err * 100000.0f + 0.5f);
+  out->bytes_per_tpl = SR_EMB_DIM * (uint32_t)sizeof(int16_t) + 1u;
+}
+
+} // namespace ncomm
+
+int main() {
+  ncomm::SrBench b;
+  ncomm::sr_bench(&b);
+  std::printf("sr n=1/4/16/64/256 q15=%u/%u/%u/%u/%u ns f32=%u/%u/%u/%u/%u ns err=%u e-5 agree=%u tpl=%u B\n",
+              b.q15_ns[0], b.q15_ns[1], b.q15_ns[2], b.q15_ns[3], b.q15_ns[4], b.f32_ns[0], b.f32_ns[1], b.f32_ns[2],
+              b.f32_ns[3], b.f32_ns[4], b.max_err_e5, b.topk_agree, b.bytes_per_tpl);
+  // Q15 rounding stays far below the threshold margins; same top-5 as float
+  return (b.max_err_e5 <= 10u && b.topk_agree == 64u) ? 0 : 1;
+}
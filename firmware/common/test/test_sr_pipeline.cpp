@@ -0,0 +1,397 @@
+// Host test: scenario C early exit against the two-packet decision, and
+// speculative encoding (same decisions, latency saved) on a replayed MCU2 loop.
+#include "ncomm/ncomm_sr_pipeline.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+#include "ncomm/ncomm_kws.hpp"
+
+namespace ncomm {
+
+// ---- Evaluation: early exit vs the two-packet decision ----
+// Synthetic scenario C trials on the real classifier (CosineWeibullClassifier,
+// default threshold): 5 voices enrolled from 20 utterances, genuine trials of
+// those voices and impostor trials of unenrolled speakers; each trial is two
+// packet embeddings of the same speaker. Per band (row 0: policy off):
+//   fire_pm : trials decided on packet 1, permille
+//   flip_pm : decisions (known / voice) that differ from the two-packet one
+//   frr_pm / far_pm : genuine rejected or misidentified / impostors accepted
+//   saved_us: mean encoder time saved per trial (fires x packet_us)
+// packet_us is measured on SrPipeline (placeholder encoder, same cost).
+static constexpr uint8_t SR_EXIT_EVAL_ROWS = 6;
+static constexpr float SR_EXIT_EVAL_BAND[SR_EXIT_EVAL_ROWS] = {0.0f, 0.05f, 0.10f, 0.15f, 0.20f, 0.30f};
+
+struct SrExitEvalRow {
+  uint32_t band_e3 = 0; // 0 = off
+  uint32_t fire_pm = 0;
+  uint32_t flip_pm = 0;
+  uint32_t frr_pm = 0;
+  uint32_t far_pm = 0;
+  uint32_t saved_us = 0;
+};
+
+static constexpr uint32_t EX_VOICES = 5;
+static constexpr uint32_t EX_ENROLL = 20;
+static constexpr uint32_t EX_GENUINE = 400; // per voice
+static constexpr uint32_t EX_IMPOSTOR = 2000;
+static constexpr float EX_NOISE = 1.4f;           // within-speaker / speaker norm, per packet
+static constexpr float EX_IMPOSTOR_SPREAD = 2.0f; // impostor speaker around an enrolled one
+
+static inline uint32_t lcg(uint32_t* s) {
+  *s = *s * 1664525u + 1013904223u;
+  return *s;
+}
+
+static float ex_gauss(uint32_t* seed) {
+  float s = 0.0f;
+  for (int j = 0; j < 12; j++) s += (float)(lcg(seed) >> 8) / 16777216.0f;
+  return s - 6.0f;
+}
+
+static void ex_normalise(float* v) {
+  float e = 0.0f;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) e += v[i] * v[i];
+  const float g = 1.0f / std::sqrt(e);
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) v[i] *= g;
+}
+
+// Anisotropic unit directions (energy in the leading dims, as in d-vectors)
+static void ex_direction(float* v, uint32_t* seed) {
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) v[i] = ex_gauss(seed) * std::exp(-(float)i / 64.0f);
+  ex_normalise(v);
+}
+
+static void ex_utterance(const float* spk, float* v, uint32_t* seed) {
+  ex_direction(v, seed);
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) v[i] = spk[i] + EX_NOISE * v[i];
+  ex_normalise(v);
+}
+
+// Encoder cost of one packet: SrPipeline on a scenario C segment of a
+// synthetic voiced signal, policy off (both packets encoded)
+static uint32_t ex_packet_us() {
+  static int16_t ring_buf[32768];
+  static SpeechRing ring;
+  static MelFrontEnd fe;
+  static MelStream stream;
+  static VoiceIdEncoder enc;
+  static int16_t rows[EX_VOICES * SR_EMB_DIM];
+  static uint8_t vid[EX_VOICES];
+  static CosineWeibullClassifier cls;
+  static SrPipeline pipe;
+  ring.init(ring_buf, 32768);
+  fe.init();
+  stream.init(&fe);
+  enc.init(voiceid_placeholder_model());
+  cls.init(rows, vid, EX_VOICES);
+  pipe.init(&stream, &enc, &cls);
+  uint32_t seed = 0x53524558u;
+  int16_t chunk[256];
+  for (uint32_t c = 0; c < 100; c++) {
+    for (uint32_t i = 0; i < 256; i++) {
+      const float t = (float)(c * 256u + i) / 16000.0f;
+      chunk[i] = (int16_t)(6000.0f * std::sin(6.2831853f * 140.0f * t) + (float)((int32_t)(lcg(&seed) >> 22) - 512));
+    }
+    ring.write(chunk, 256);
+    stream.update(ring, c >= 20);
+  }
+  uint32_t best = 0xFFFFFFFFu;
+  for (uint32_t r = 0; r < 5; r++) {
+    SrResult res;
+    pipe.verify(ring, 256u * 24u, 14000, &res);
+    if (res.encoded == 2 && pipe.stats().packet_us < best) best = pipe.stats().packet_us;
+  }
+  return best == 0xFFFFFFFFu ? 0u : best;
+}
+
+static bool ex_same(const SrDecision& a, const SrDecision& b) {
+  return a.is_known == b.is_known && (!a.is_known || a.voice_id == b.voice_id);
+}
+
+// Returns packet_us.
+uint32_t sr_exit_eval(SrExitEvalRow* rows) {
+  if (!rows) return 0;
+  static int16_t q15[EX_VOICES * SR_EMB_DIM];
+  static uint8_t vid[EX_VOICES];
+  static CosineWeibullClassifier cls;
+  static float spk[EX_VOICES][SR_EMB_DIM];
+  static float utt[EX_ENROLL][SR_EMB_DIM];
+  cls.init(q15, vid, EX_VOICES);
+  uint32_t seed = 0x45584954u;
+  for (uint32_t v = 0; v < EX_VOICES; v++) {
+    ex_direction(spk[v], &seed);
+    for (uint32_t u = 0; u < EX_ENROLL; u++) ex_utterance(spk[v], utt[u], &seed);
+    cls.add_voice(&utt[0][0], EX_ENROLL, (uint8_t)v);
+  }
+  const uint32_t packet_us = ex_packet_us();
+
+  uint32_t fires[SR_EXIT_EVAL_ROWS] = {}, flips[SR_EXIT_EVAL_ROWS] = {};
+  uint32_t fr[SR_EXIT_EVAL_ROWS] = {}, fa[SR_EXIT_EVAL_ROWS] = {};
+  const uint32_t trials = EX_VOICES * EX_GENUINE + EX_IMPOSTOR;
+  float other[SR_EMB_DIM], e1[SR_EMB_DIM], e2[SR_EMB_DIM], scratch[SR_EMB_DIM];
+  for (uint32_t t = 0; t < trials; t++) {
+    const bool genuine = t < EX_VOICES * EX_GENUINE;
+    const uint32_t v = t % EX_VOICES;
+    const float* who = spk[v];
+    if (!genuine) {
+      // Impostor near an enrolled voice (the hard case for a threshold)
+      ex_direction(other, &seed);
+      for (uint32_t k = 0; k < SR_EMB_DIM; k++) other[k] = spk[v][k] + EX_IMPOSTOR_SPREAD * other[k];
+      ex_normalise(other);
+      who = other;
+    }
+    ex_utterance(who, e1, &seed);
+    ex_utterance(who, e2, &seed);
+    const SrDecision d1 = cls.classify(e1);
+    for (uint32_t k = 0; k < SR_EMB_DIM; k++) scratch[k] = e1[k];
+    const SrDecision full = sr_combine(cls, SrCombine::MEAN, scratch, e2, d1);
+    for (uint32_t r = 0; r < SR_EXIT_EVAL_ROWS; r++) {
+      SrEarlyExit p;
+      p.enabled = r > 0;
+      p.band = SR_EXIT_EVAL_BAND[r];
+      const bool fire = sr_exit_early(p, cls.threshold(), d1);
+      const SrDecision d = fire ? d1 : full;
+      fires[r] += fire ? 1u : 0u;
+      flips[r] += ex_same(d, full) ? 0u : 1u;
+      if (genuine) fr[r] += (d.is_known && d.voice_id == (int16_t)v) ? 0u : 1u;
+      else fa[r] += d.is_known ? 1u : 0u;
+    }
+  }
+  for (uint32_t r = 0; r < SR_EXIT_EVAL_ROWS; r++) {
+    rows[r].band_e3 = r ? (uint32_t)(SR_EXIT_EVAL_BAND[r] * 1000.0f + 0.5f) : 0u;
+    rows[r].fire_pm = fires[r] * 1000u / trials;
+    rows[r].flip_pm = flips[r] * 1000u / trials;
+    rows[r].frr_pm = fr[r] * 1000u / (EX_VOICES * EX_GENUINE);
+    rows[r].far_pm = fa[r] * 1000u / EX_IMPOSTOR;
+    rows[r].saved_us = (uint32_t)((uint64_t)fires[r] * packet_us / trials);
+  }
+  return packet_us;
+}
+
+// ---- Simulator: command-to-session latency with speculation ----
+// Brick-by-brick replay of the MCU2 loop on synthetic utterances (voiced
+// speech with a syllable envelope over noise): SpeechRing, MelStream, a
+// scripted KWS engine (the real KwsEndpointer on the brick energies,
+// KwsDecoder on posteriors that rise over the word) and SrPipeline, each
+// utterance once without and once with speculation (speculate() / cancel()
+// after every brick, as the main loop does). Per utterance:
+//   speech_ms   : speech length (SR_SPEC_SIM_MS; the mid-pause utterance
+//                 has a 100 ms gap, the non-command one never triggers)
+//   packets     : packets of the final segment
+//   base_us     : verify() after the KWS result, no speculation
+//   spec_us     : verify() with speculation (the command-to-session latency
+//                 that SR adds; KWS endpointing itself is unchanged)
+//   encoded     : encoder passes left in verify() with speculation
+//   spec_work_us: speculative encoder time spent before the result
+//   wasted      : speculative packets not used (changed span, cancelled)
+//   mismatch    : decisions (known / voice / distance) differing from the
+//                 run without speculation; 0 expected
+static constexpr uint8_t SR_SPEC_SIM_ROWS = 6;
+static constexpr uint16_t SR_SPEC_SIM_MS[SR_SPEC_SIM_ROWS] = {200, 450, 600, 800, 800, 450};
+
+struct SrSpecSimRow {
+  uint32_t speech_ms = 0;
+  bool command = true;
+  uint32_t packets = 0;
+  uint32_t base_us = 0;
+  uint32_t spec_us = 0;
+  uint32_t encoded = 0;
+  uint32_t spec_work_us = 0;
+  uint32_t wasted = 0;
+  uint32_t mismatch = 0;
+};
+
+static constexpr uint32_t SS_LEAD_BRICKS = 40; // 600 ms noise before the word (floor settles)
+static constexpr uint32_t SS_TAIL_BRICKS = 60; // 900 ms after it
+static constexpr uint32_t SS_PAUSE_MS = 100;   // mid-word gap (< hangover)
+static constexpr uint32_t SS_REPEATS = 3;      // timing: best of
+
+// KWS with scripted posteriors: the real endpointer on the brick energy, the
+// decoder on a command posterior rising from speech start to peak at 80 % of
+// the word, then decaying.
+class SimKws final : public KwsEngine {
+public:
+  void init(const KwsConfig& cfg, uint32_t speech_from, uint32_t speech_samples, float peak) {
+    cfg_ = cfg;
+    from_ = speech_from;
+    len_ = speech_samples;
+    peak_ = peak;
+    reset();
+  }
+  void reset() override {
+    dec_.init(cfg_);
+    ep_.init(cfg_, BRICK_SAMPLES);
+    bricks_ = 0;
+  }
+  bool process(const BrickView& brick, uint32_t pos, KwsResult* out) override {
+    float e = 0.0f;
+    for (uint16_t i = 0; i < brick.len[0]; i++) e += (float)brick.seg[0][i] * (float)brick.seg[0][i];
+    ep_.push(10.0f * std::log10(e / (float)BRICK_SAMPLES + 1e-3f), pos);
+    if ((++bricks_ % cfg_.infer_every) == 0) {
+      const uint32_t end = pos + BRICK_SAMPLES;
+      float p = 0.05f;
+      if ((int32_t)(end - from_) > 0) {
+        const float t = (float)(end - from_) / (0.8f * (float)len_);
+        p = t <= 1.0f ? 0.05f + (peak_ - 0.05f) * t : peak_ - 0.5f * (t - 1.0f);
+        if (p < 0.05f) p = 0.05f;
+      }
+      float post[KWS_CLASSES] = {};
+      post[1] = p;
+      post[0] = 1.0f - p;
+      float score = 0.0f;
+      const uint8_t cmd = dec_.push(post, end, &score);
+      if (cmd && !ep_.active()) ep_.trigger(cmd, score, end);
+    }
+    return ep_.done(out);
+  }
+  bool pending(KwsPending* out) const override { return ep_.pending(dec_.candidate(), out); }
+  const char* name() const override { return "sim"; }
+  uint32_t ram_bytes() const override { return (uint32_t)sizeof(*this); }
+
+private:
+  KwsConfig cfg_{};
+  KwsDecoder dec_;
+  KwsEndpointer ep_;
+  uint32_t from_ = 0;
+  uint32_t len_ = 0;
+  float peak_ = 0.0f;
+  uint32_t bricks_ = 0;
+};
+
+struct SsRun {
+  bool result = false;
+  SrResult sr;
+  uint32_t spec_work_us = 0;
+  uint32_t wasted = 0;
+};
+
+// Noise, then voiced speech (120 Hz + harmonics, 5 Hz syllable envelope)
+// with an optional gap in the middle, then noise.
+static int16_t ss_sample(uint32_t i, uint32_t speech_from, uint32_t speech_n, bool pause, uint32_t* seed) {
+  float x = (float)((int32_t)(lcg(seed) >> 23) - 256);
+  const uint32_t gap0 = speech_from + speech_n / 2u, gap1 = gap0 + SS_PAUSE_MS * 16u;
+  const uint32_t end = speech_from + speech_n + (pause ? SS_PAUSE_MS * 16u : 0u);
+  if (i >= speech_from && i < end && !(pause && i >= gap0 && i < gap1)) {
+    const float t = (float)(i - speech_from) / 16000.0f;
+    const float env = 0.65f - 0.35f * std::cos(6.2831853f * 5.0f * t);
+    const float ph = 6.2831853f * (120.0f * t + 0.8f * std::sin(6.2831853f * 3.0f * t));
+    x += 5000.0f * env * (std::sin(ph) + 0.5f * std::sin(2.0f * ph) + 0.25f * std::sin(3.0f * ph));
+  }
+  return (int16_t)x;
+}
+
+static void ss_run(uint32_t speech_ms, bool pause, bool command, bool spec, SsRun* r) {
+  static int16_t ring_buf[32768];
+  static SpeechRing ring;
+  static MelFrontEnd fe;
+  static MelStream stream;
+  static VoiceIdEncoder enc;
+  static int16_t rows[EX_VOICES * SR_EMB_DIM];
+  static uint8_t vid[EX_VOICES];
+  static CosineWeibullClassifier cls;
+  static float utt[EX_ENROLL][SR_EMB_DIM];
+  static SrPipeline pipe;
+  static SimKws kws;
+  ring.init(ring_buf, 32768);
+  fe.init();
+  stream.init(&fe);
+  stream.reset(0);
+  enc.init(voiceid_placeholder_model());
+  cls.init(rows, vid, EX_VOICES);
+  uint32_t seed = 0x53504543u;
+  float spk[SR_EMB_DIM];
+  for (uint32_t v = 0; v < EX_VOICES; v++) {
+    ex_direction(spk, &seed);
+    for (uint32_t u = 0; u < EX_ENROLL; u++) ex_utterance(spk, utt[u], &seed);
+    cls.add_voice(&utt[0][0], EX_ENROLL, (uint8_t)v);
+  }
+  pipe.init(&stream, &enc, &cls);
+  pipe.early_exit().enabled = true; // as on the target
+  const uint32_t from = SS_LEAD_BRICKS * BRICK_SAMPLES;
+  const uint32_t n = speech_ms * 16u;
+  kws.init(KwsConfig{}, from, n + (pause ? SS_PAUSE_MS * 16u : 0u), command ? 0.95f : 0.65f);
+
+  *r = SsRun{};
+  const uint32_t bricks = SS_LEAD_BRICKS + (n + SS_PAUSE_MS * 16u) / BRICK_SAMPLES + SS_TAIL_BRICKS;
+  int16_t chunk[BRICK_SAMPLES];
+  for (uint32_t b = 0; b < bricks && !r->result; b++) {
+    for (uint32_t i = 0; i < BRICK_SAMPLES; i++) chunk[i] = ss_sample(b * BRICK_SAMPLES + i, from, n, pause, &seed);
+    ring.write(chunk, BRICK_SAMPLES);
+    stream.update(ring, true);
+    BrickView brick;
+    brick.seg[0] = chunk;
+    brick.len[0] = BRICK_SAMPLES;
+    brick.segs = 1;
+    KwsResult res;
+    if (kws.process(brick, b * BRICK_SAMPLES, &res)) {
+      r->result = true;
+      pipe.verify(ring, res.seg_start, res.seg_end - res.seg_start, &r->sr);
+      break;
+    }
+    if (!spec) continue;
+    KwsPending pd;
+    if (kws.pending(&pd)) pipe.speculate(ring, pd.seg_start, pd.seg_end - pd.seg_start, pd.ended);
+    else pipe.cancel();
+  }
+  if (!r->result) pipe.cancel();
+  const SrPipeline::Stats& st = pipe.stats();
+  r->spec_work_us = st.spec_us;
+  r->wasted = st.spec_wasted + st.spec_cancelled;
+}
+
+void sr_spec_sim(SrSpecSimRow* rows) {
+  if (!rows) return;
+  for (uint32_t u = 0; u < SR_SPEC_SIM_ROWS; u++) {
+    SrSpecSimRow& row = rows[u];
+    row = SrSpecSimRow{};
+    row.speech_ms = SR_SPEC_SIM_MS[u];
+    row.command = u + 1u < SR_SPEC_SIM_ROWS;
+    const bool pause = u + 2u == SR_SPEC_SIM_ROWS;
+    row.base_us = row.spec_us = row.spec_work_us = 0xFFFFFFFFu;
+    for (uint32_t k = 0; k < SS_REPEATS; k++) {
+      SsRun base, spec;
+      ss_run(row.speech_ms, pause, row.command, false, &base);
+      ss_run(row.speech_ms, pause, row.command, true, &spec);
+      if (base.result != spec.result) {
+        row.mismatch++;
+        continue;
+      }
+      const SrDecision& a = base.sr.decision;
+      const SrDecision& b = spec.sr.decision;
+      if (a.is_known != b.is_known || a.voice_id != b.voice_id || a.distance != b.distance) row.mismatch++;
+      row.packets = base.sr.packets;
+      row.encoded = spec.sr.encoded;
+      row.wasted = spec.wasted;
+      if (base.sr.us < row.base_us) row.base_us = base.sr.us;
+      if (spec.sr.us < row.spec_us) row.spec_us = spec.sr.us;
+      if (spec.spec_work_us < row.spec_work_us) row.spec_work_us = spec.spec_work_us;
+    }
+    if (!row.command) row.base_us = row.spec_us = 0;
+  }
+}
+
+} // namespace ncomm
+
+int main() {
+  ncomm::SrExitEvalRow ex[ncomm::SR_EXIT_EVAL_ROWS];
+  const uint32_t packet_us = ncomm::sr_exit_eval(ex);
+  std::printf("early exit, packet %u us\nband_e3 fire_pm flip_pm frr_pm far_pm saved_us\n", packet_us);
+  bool ok = true;
+  for (const ncomm::SrExitEvalRow& r : ex) {
+    std::printf("%7u %7u %7u %6u %6u %8u\n", r.band_e3, r.fire_pm, r.flip_pm, r.frr_pm, r.far_pm, r.saved_us);
+    // The default band (SrEarlyExit::band) decides like both packets
+    if (r.band_e3 == (uint32_t)(ncomm::SrEarlyExit{}.band * 1000.0f + 0.5f)) ok = ok && r.flip_pm == 0;
+  }
+
+  ncomm::SrSpecSimRow sim[ncomm::SR_SPEC_SIM_ROWS];
+  ncomm::sr_spec_sim(sim);
+  std::printf("speculation\nspeech_ms cmd packets base_us spec_us encoded work_us wasted mismatch\n");
+  for (const ncomm::SrSpecSimRow& r : sim) {
+    std::printf("%9u %3s %7u %7u %7u %7u %7u %6u %8u\n", r.speech_ms, r.command ? "yes" : "no", r.packets, r.base_us,
+                r.spec_us, r.encoded, r.spec_work_us, r.wasted, r.mismatch);
+    // Same decisions as without speculation, no encoder pass left after KWS
+    ok = ok && r.mismatch == 0 && r.encoded == 0;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,470 @@
+// Host test: PQ templates (accuracy per template size, firmware PqIndex
+// against its float reference and against a hand-built codebook) and PQ scan
+// time against the Q15 index.
+#include "ncomm/ncomm_sr_pq.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "ncomm/ncomm_profile.h"
+
+namespace ncomm {
+
+// ---- Timing: PQ scan vs the Q15 index ----
+// Random unit templates (placeholder codebook: timing only).
+//   lut_ns            : distance table per query
+//   pq_ns / q15_ns    : full query (table / quantise + top-5) at N = SR_PQ_BENCH_N[i];
+//                       q15_ns 0 above SR_MAX_TEMPLATES
+//   bytes_per_tpl     : PQ code + voice id
+//   db_bytes          : SR_PQ_DB_BYTES
+static constexpr uint8_t SR_PQ_BENCH_POINTS = 4;
+static constexpr uint16_t SR_PQ_BENCH_N[SR_PQ_BENCH_POINTS] = {16, 64, 256, 1024};
+
+struct SrPqBench {
+  uint32_t lut_ns = 0;
+  uint32_t pq_ns[SR_PQ_BENCH_POINTS] = {};
+  uint32_t q15_ns[SR_PQ_BENCH_POINTS] = {};
+  uint32_t bytes_per_tpl = 0;
+  uint32_t db_bytes = 0;
+};
+
+static constexpr uint32_t BENCH_QUERIES = 32;
+static constexpr uint8_t BENCH_K = 5;
+
+static uint8_t s_pb_codes[SR_PQ_MAX_TEMPLATES * SR_PQ_M];
+static uint8_t s_pb_voice[SR_PQ_MAX_TEMPLATES];
+static int16_t s_pb_rows[SR_MAX_TEMPLATES * SR_EMB_DIM];
+static uint8_t s_pb_rvoice[SR_MAX_TEMPLATES];
+static PqIndex s_pb_pq;
+static EmbeddingIndex s_pb_q15;
+
+static inline uint32_t lcg(uint32_t* s) {
+  *s = *s * 1664525u + 1013904223u;
+  return *s;
+}
+
+// Near-Gaussian components (sum of 4 uniforms); unit length
+static void random_unit(float* v, uint32_t* seed) {
+  float e = 0.0f;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) {
+    float s = 0.0f;
+    for (int j = 0; j < 4; j++) s += (float)(lcg(seed) >> 8) / 16777216.0f - 0.5f;
+    v[i] = s;
+    e += s * s;
+  }
+  const float g = 1.0f / std::sqrt(e);
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) v[i] *= g;
+}
+
+void sr_pq_bench(SrPqBench* out) {
+  if (!out) return;
+
+  static float queries[BENCH_QUERIES][SR_EMB_DIM];
+  uint32_t seed = 0x50513433u;
+  for (uint32_t q = 0; q < BENCH_QUERIES; q++) random_unit(queries[q], &seed);
+
+  int16_t qq[SR_EMB_DIM];
+  float v[SR_EMB_DIM];
+  uint64_t t_lut = 0;
+  for (uint8_t p = 0; p < SR_PQ_BENCH_POINTS; p++) {
+    // Same N templates (4 per voice) in both indexes; Q15 stops at SR_MAX_TEMPLATES
+    const uint16_t n = SR_PQ_BENCH_N[p];
+    const bool q15 = (n <= SR_MAX_TEMPLATES);
+    s_pb_pq.init(pq_placeholder_codebook(), s_pb_codes, s_pb_voice, SR_PQ_MAX_TEMPLATES);
+    s_pb_q15.init(s_pb_rows, s_pb_rvoice, SR_MAX_TEMPLATES);
+    seed = 0x54504C53u;
+    for (uint16_t s = 0; s < n; s++) {
+      random_unit(v, &seed);
+      s_pb_pq.add(v, (uint8_t)(s / 4u));
+      if (q15) s_pb_q15.add(v, (uint8_t)(s / 4u));
+    }
+
+    uint64_t t_pq = 0, t_q = 0;
+    for (uint32_t q = 0; q < BENCH_QUERIES; q++) {
+      SrMatch m[BENCH_K];
+      const uint32_t t0 = ncomm_cycles_now();
+      s_pb_pq.set_query(queries[q]);
+      const uint32_t t1 = ncomm_cycles_now();
+      (void)s_pb_pq.top_k(BENCH_K, m);
+      const uint32_t t2 = ncomm_cycles_now();
+      t_lut += (uint32_t)(t1 - t0);
+      t_pq += (uint32_t)(t2 - t0);
+      if (!q15) continue;
+      const uint32_t t3 = ncomm_cycles_now();
+      EmbeddingIndex::quantize(queries[q], qq);
+      (void)s_pb_q15.top_k(qq, BENCH_K, m);
+      t_q += (uint32_t)(ncomm_cycles_now() - t3);
+    }
+    out->pq_ns[p] = (uint32_t)(ncomm_cycles_to_ns(t_pq) / BENCH_QUERIES);
+    out->q15_ns[p] = q15 ? (uint32_t)(ncomm_cycles_to_ns(t_q) / BENCH_QUERIES) : 0u;
+  }
+  out->lut_ns = (uint32_t)(ncomm_cycles_to_ns(t_lut) / (BENCH_QUERIES * SR_PQ_BENCH_POINTS));
+  out->bytes_per_tpl = SR_PQ_M + 1u;
+  out->db_bytes = SR_PQ_DB_BYTES;
+}
+
+// ---- Evaluation: accuracy vs template size ----
+// Synthetic speaker corpus (anisotropic unit d-vectors, per-utterance noise):
+// codebooks trained by k-means on the enrollment centroids of 4000 held-out
+// speakers, 256 enrolled speakers (centroid of 20 utterances), 10 test
+// utterances each. Per template format:
+//   bytes        : template bytes (code / vector)
+//   speakers_20k : voices in 20 KB (template + voice id + Weibull)
+//   top1_pm      : 1:256 identification accuracy, permille
+//   eer_e4       : verification EER (own vs other centroids) x 10^4
+//   drift_e4     : mean |cos - cos float| x 10^4
+// Rows: float, Q15 index, PQ M = 32 / 16 / 8 (float reference), PQ M = 16 on
+// PqIndex with the trained codebook in Q15 (the firmware path).
+static constexpr uint8_t SR_PQ_EVAL_ROWS = 6;
+
+struct SrPqEvalRow {
+  const char* name = "";
+  uint32_t bytes = 0;
+  uint32_t speakers_20k = 0;
+  uint32_t top1_pm = 0;
+  uint32_t eer_e4 = 0;
+  uint32_t drift_e4 = 0;
+};
+
+static constexpr uint32_t EV_TRAIN_SPK = 4000; // codebook training: held-out centroids
+static constexpr uint32_t EV_SPK = 256;        // enrolled
+static constexpr uint32_t EV_ENROLL = 20;      // EMBEDDINGS_PER_CENTROID_COUNT
+static constexpr uint32_t EV_TEST = 10;
+static constexpr uint32_t EV_TRAIN = EV_TRAIN_SPK;
+static constexpr float EV_NOISE = 1.6f;        // within-speaker / speaker norm
+static constexpr uint32_t EV_KMEANS_ITERS = 10;
+static constexpr uint32_t EV_CB = (uint32_t)SR_PQ_K * SR_EMB_DIM; // codebook floats, any M
+
+static float s_ev_train[EV_TRAIN][SR_EMB_DIM];
+static float s_ev_centroid[EV_SPK][SR_EMB_DIM];
+static float s_ev_test[EV_SPK * EV_TEST][SR_EMB_DIM];
+static float s_ev_tpl[EV_SPK][SR_EMB_DIM]; // template as a format stores it
+static float s_ev_cb[EV_CB];
+static int16_t s_ev_cb_q15[EV_CB];
+static float s_ev_ref[EV_SPK * EV_TEST][EV_SPK]; // float scores
+static float s_ev_score[EV_SPK * EV_TEST][EV_SPK];
+
+static float ev_gauss(uint32_t* seed) {
+  float s = 0.0f;
+  for (int j = 0; j < 12; j++) s += (float)(lcg(seed) >> 8) / 16777216.0f;
+  return s - 6.0f;
+}
+
+static void ev_normalise(float* v) {
+  float e = 0.0f;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) e += v[i] * v[i];
+  const float g = 1.0f / std::sqrt(e);
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) v[i] *= g;
+}
+
+// Anisotropic direction: component variance decays over the embedding, as in
+// trained d-vectors (energy concentrated in the leading dims)
+static void ev_direction(float* v, uint32_t* seed) {
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) v[i] = ev_gauss(seed) * std::exp(-(float)i / 64.0f);
+  ev_normalise(v);
+}
+
+static void ev_utterance(const float* spk, float* v, uint32_t* seed) {
+  ev_direction(v, seed);
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) v[i] = spk[i] + EV_NOISE * v[i];
+  ev_normalise(v);
+}
+
+// Subspace m of v as the firmware lays it out (dims m, m + M, ...)
+static void ev_sub(const float* v, uint32_t m_count, uint32_t m, float* out) {
+  for (uint32_t i = 0; i < SR_EMB_DIM / m_count; i++) out[i] = v[i * m_count + m];
+}
+
+// Lloyd k-means per subspace of the training set; codebook [m][k][sub]
+static void ev_train_pq(uint32_t m_count, float* cb) {
+  const uint32_t sub = SR_EMB_DIM / m_count;
+  static float xs[EV_TRAIN][SR_EMB_DIM];
+  static uint16_t assign[EV_TRAIN];
+  static float sum[SR_PQ_K * SR_EMB_DIM];
+  static uint32_t cnt[SR_PQ_K];
+  uint32_t seed = 0x4B4D4541u;
+  for (uint32_t m = 0; m < m_count; m++) {
+    float* c = &cb[m * SR_PQ_K * sub];
+    for (uint32_t t = 0; t < EV_TRAIN; t++) ev_sub(s_ev_train[t], m_count, m, xs[t]);
+    for (uint32_t k = 0; k < SR_PQ_K; k++) std::memcpy(&c[k * sub], xs[lcg(&seed) % EV_TRAIN], sub * sizeof(float));
+    for (uint32_t it = 0; it < EV_KMEANS_ITERS; it++) {
+      for (uint32_t t = 0; t < EV_TRAIN; t++) {
+        const float* x = xs[t];
+        float best = 0.0f;
+        for (uint32_t k = 0; k < SR_PQ_K; k++) {
+          float d = 0.0f;
+          for (uint32_t i = 0; i < sub; i++) d += (x[i] - c[k * sub + i]) * (x[i] - c[k * sub + i]);
+          if (k == 0 || d < best) {
+            best = d;
+            assign[t] = (uint16_t)k;
+          }
+        }
+      }
+      std::memset(sum, 0, SR_PQ_K * sub * sizeof(float));
+      std::memset(cnt, 0, sizeof(cnt));
+      for (uint32_t t = 0; t < EV_TRAIN; t++) {
+        for (uint32_t i = 0; i < sub; i++) sum[assign[t] * sub + i] += xs[t][i];
+        cnt[assign[t]]++;
+      }
+      for (uint32_t k = 0; k < SR_PQ_K; k++) {
+        if (cnt[k]) {
+          for (uint32_t i = 0; i < sub; i++) c[k * sub + i] = sum[k * sub + i] / (float)cnt[k];
+        } else { // empty cluster: reseed on a training point
+          std::memcpy(&c[k * sub], xs[lcg(&seed) % EV_TRAIN], sub * sizeof(float));
+        }
+      }
+    }
+  }
+}
+
+// Reconstruction of v through a float codebook (nearest codeword per subspace)
+static void ev_pq_roundtrip(uint32_t m_count, const float* cb, const float* v, float* out) {
+  const uint32_t sub = SR_EMB_DIM / m_count;
+  for (uint32_t m = 0; m < m_count; m++) {
+    const float* c = &cb[m * SR_PQ_K * sub];
+    float x[SR_EMB_DIM];
+    ev_sub(v, m_count, m, x);
+    float best = 0.0f;
+    uint32_t arg = 0;
+    for (uint32_t k = 0; k < SR_PQ_K; k++) {
+      float d = 0.0f;
+      for (uint32_t i = 0; i < sub; i++) d += (x[i] - c[k * sub + i]) * (x[i] - c[k * sub + i]);
+      if (k == 0 || d < best) {
+        best = d;
+        arg = k;
+      }
+    }
+    for (uint32_t i = 0; i < sub; i++) out[i * m_count + m] = c[arg * sub + i];
+  }
+}
+
+static void ev_score_templates(float (*score)[EV_SPK]) {
+  for (uint32_t q = 0; q < EV_SPK * EV_TEST; q++) {
+    for (uint32_t s = 0; s < EV_SPK; s++) {
+      float acc = 0.0f;
+      for (uint32_t i = 0; i < SR_EMB_DIM; i++) acc += s_ev_test[q][i] * s_ev_tpl[s][i];
+      score[q][s] = acc;
+    }
+  }
+}
+
+static void ev_metrics(const char* name, uint32_t bytes, SrPqEvalRow* row) {
+  static float tar[EV_SPK * EV_TEST];
+  static float non[EV_SPK * EV_TEST * (EV_SPK - 1)];
+  uint32_t nt = 0, nn = 0, top1 = 0;
+  double drift = 0.0;
+  for (uint32_t q = 0; q < EV_SPK * EV_TEST; q++) {
+    const uint32_t own = q / EV_TEST;
+    uint32_t arg = 0;
+    for (uint32_t s = 0; s < EV_SPK; s++) {
+      const float v = s_ev_score[q][s];
+      if (v > s_ev_score[q][arg]) arg = s;
+      if (s == own) tar[nt++] = v;
+      else non[nn++] = v;
+      drift += std::fabs((double)v - (double)s_ev_ref[q][s]);
+    }
+    top1 += (arg == own) ? 1u : 0u;
+  }
+  // EER: threshold sweep over the sorted target scores
+  std::sort(tar, tar + nt);
+  std::sort(non, non + nn);
+  double eer = 1.0, gap = 2.0;
+  uint32_t j = 0;
+  for (uint32_t i = 0; i < nt; i++) {
+    while (j < nn && non[j] < tar[i]) j++;
+    const double frr = (double)i / nt, far = (double)(nn - j) / nn;
+    if (std::fabs(far - frr) < gap) {
+      gap = std::fabs(far - frr);
+      eer = 0.5 * (far + frr);
+    }
+  }
+  row->name = name;
+  row->bytes = bytes;
+  row->speakers_20k = 20480u / (bytes + 1u + (uint32_t)sizeof(SrWeibull));
+  row->top1_pm = (uint32_t)((top1 * 1000u + nt / 2u) / nt);
+  row->eer_e4 = (uint32_t)(eer * 10000.0 + 0.5);
+  row->drift_e4 = (uint32_t)(drift / ((double)nt + nn) * 10000.0 + 0.5);
+}
+
+void sr_pq_eval(SrPqEvalRow* rows) {
+  if (!rows) return;
+  // Corpus: training speakers, enrolled speakers (centroid of 20), test utterances
+  uint32_t seed = 0x45564131u;
+  float spk[SR_EMB_DIM], utt[EV_ENROLL][SR_EMB_DIM];
+  for (uint32_t s = 0; s < EV_TRAIN_SPK; s++) {
+    ev_direction(spk, &seed);
+    for (uint32_t u = 0; u < EV_ENROLL; u++) ev_utterance(spk, utt[u], &seed);
+    sr_enroll_centroid(&utt[0][0], EV_ENROLL, s_ev_train[s]);
+  }
+  for (uint32_t s = 0; s < EV_SPK; s++) {
+    ev_direction(spk, &seed);
+    for (uint32_t u = 0; u < EV_ENROLL; u++) ev_utterance(spk, utt[u], &seed);
+    sr_enroll_centroid(&utt[0][0], EV_ENROLL, s_ev_centroid[s]);
+    for (uint32_t u = 0; u < EV_TEST; u++) ev_utterance(spk, s_ev_test[s * EV_TEST + u], &seed);
+  }
+
+  // float
+  std::memcpy(s_ev_tpl, s_ev_centroid, sizeof(s_ev_tpl));
+  ev_score_templates(s_ev_ref);
+  std::memcpy(s_ev_score, s_ev_ref, sizeof(s_ev_score));
+  ev_metrics("f32", SR_EMB_DIM * 4u, &rows[0]);
+
+  // Q15 index
+  {
+    static int16_t q15[EV_SPK * SR_EMB_DIM];
+    static uint8_t vid[EV_SPK];
+    static int32_t acc[EV_SPK];
+    EmbeddingIndex idx;
+    idx.init(q15, vid, EV_SPK);
+    for (uint32_t s = 0; s < EV_SPK; s++) idx.add(s_ev_centroid[s], (uint8_t)s);
+    int16_t qq[SR_EMB_DIM];
+    for (uint32_t q = 0; q < EV_SPK * EV_TEST; q++) {
+      EmbeddingIndex::quantize(s_ev_test[q], qq);
+      idx.score_all(qq, acc);
+      for (uint32_t s = 0; s < EV_SPK; s++) s_ev_score[q][s] = (float)acc[s] / (32767.0f * 32767.0f);
+    }
+    ev_metrics("q15", SR_EMB_DIM * 2u, &rows[1]);
+  }
+
+  // PQ, float reference: score = q . reconstruction
+  static const char* const PQ_NAME[3] = {"pq32", "pq16", "pq8"};
+  static const uint32_t PQ_M[3] = {32, 16, 8};
+  for (uint32_t r = 0; r < 3; r++) {
+    ev_train_pq(PQ_M[r], s_ev_cb);
+    for (uint32_t s = 0; s < EV_SPK; s++) ev_pq_roundtrip(PQ_M[r], s_ev_cb, s_ev_centroid[s], s_ev_tpl[s]);
+    ev_score_templates(s_ev_score);
+    ev_metrics(PQ_NAME[r], PQ_M[r], &rows[2 + r]);
+    if (PQ_M[r] != SR_PQ_M) continue;
+    for (uint32_t i = 0; i < EV_CB; i++) {
+      const long v = std::lround(s_ev_cb[i] * 32767.0f);
+      s_ev_cb_q15[i] = (int16_t)(v > 32767 ? 32767 : (v < -32767 ? -32767 : v));
+    }
+  }
+
+  // PQ M = 16 on the firmware index (Q15 codebook, int16 distance table)
+  {
+    static const PqCodebook cb = {s_ev_cb_q15, true};
+    static uint8_t codes[EV_SPK * SR_PQ_M];
+    static uint8_t vid[EV_SPK];
+    static PqIndex idx;
+    static int32_t acc[EV_SPK];
+    idx.init(&cb, codes, vid, EV_SPK);
+    for (uint32_t s = 0; s < EV_SPK; s++) idx.add(s_ev_centroid[s], (uint8_t)s);
+    for (uint32_t q = 0; q < EV_SPK * EV_TEST; q++) {
+      idx.set_query(s_ev_test[q]);
+      idx.score_all(acc);
+      for (uint32_t s = 0; s < EV_SPK; s++) s_ev_score[q][s] = (float)acc[s] / 32767.0f;
+    }
+    ev_metrics("pq16 fw", SR_PQ_M, &rows[5]);
+  }
+}
+
+// ---- PqIndex against hand-computed expectations ----
+// Codebook with codeword c < 8 = +e_c / 4 and 8 <= c < 16 = -e_(c-8) / 4 in
+// every subspace (rest zero); template v has +-1/4 on element (v (m + 1)) % 8
+// of subspace m, i.e. it is a unit vector its code reproduces exactly. Codes,
+// reconstruction, scores (exact dot products), ranking and removal are
+// checked against values computed here in double; returns the failures.
+static constexpr uint32_t HB_VOICES = 8;
+static int16_t s_hb_cw[SR_PQ_M * SR_PQ_K * SR_PQ_SUB];
+
+static void hb_template(uint32_t v, float* emb, uint8_t* code) {
+  std::memset(emb, 0, SR_EMB_DIM * sizeof(float));
+  for (uint32_t m = 0; m < SR_PQ_M; m++) {
+    const uint32_t e = (v * (m + 1u)) % 8u;
+    const bool neg = (v + m) % 3u == 0u;
+    emb[e * SR_PQ_M + m] = neg ? -0.25f : 0.25f;
+    code[m] = (uint8_t)(e + (neg ? 8u : 0u));
+  }
+}
+
+uint32_t sr_pq_hand_checks() {
+  uint32_t bad = 0;
+  std::memset(s_hb_cw, 0, sizeof(s_hb_cw));
+  for (uint32_t m = 0; m < SR_PQ_M; m++) {
+    for (uint32_t e = 0; e < 8; e++) {
+      s_hb_cw[(m * SR_PQ_K + e) * SR_PQ_SUB + e] = 8192;
+      s_hb_cw[(m * SR_PQ_K + 8u + e) * SR_PQ_SUB + e] = -8192;
+    }
+  }
+  static const PqCodebook cb = {s_hb_cw, true};
+  static uint8_t codes[HB_VOICES * SR_PQ_M];
+  static uint8_t vid[HB_VOICES];
+  static PqIndex idx;
+  idx.init(&cb, codes, vid, HB_VOICES);
+
+  static float tpl[HB_VOICES][SR_EMB_DIM];
+  for (uint32_t v = 0; v < HB_VOICES; v++) {
+    uint8_t want[SR_PQ_M], got[SR_PQ_M];
+    float rec[SR_EMB_DIM];
+    hb_template(v, tpl[v], want);
+    bad += idx.encode(tpl[v], got) && std::memcmp(got, want, SR_PQ_M) == 0 ? 0u : 1u;
+    idx.decode(want, rec);
+    float err = 0.0f;
+    for (uint32_t i = 0; i < SR_EMB_DIM; i++) err = std::max(err, std::fabs(rec[i] - tpl[v][i]));
+    bad += err < 1e-4f ? 0u : 1u;
+    bad += idx.add(tpl[v], (uint8_t)v) == (int32_t)v ? 0u : 1u;
+  }
+
+  // Query between voices 3 and 5: exact cosines in double
+  float q[SR_EMB_DIM];
+  double qn = 0.0;
+  for (uint32_t i = 0; i < SR_EMB_DIM; i++) {
+    q[i] = tpl[3][i] + 0.5f * tpl[5][i];
+    qn += (double)q[i] * q[i];
+  }
+  double want[HB_VOICES];
+  for (uint32_t v = 0; v < HB_VOICES; v++) {
+    double d = 0.0;
+    for (uint32_t i = 0; i < SR_EMB_DIM; i++) d += (double)q[i] * tpl[v][i];
+    want[v] = d / std::sqrt(qn);
+  }
+  bad += idx.set_query(q) ? 0u : 1u;
+  int32_t acc[HB_VOICES];
+  idx.score_all(acc);
+  for (uint32_t v = 0; v < HB_VOICES; v++) bad += std::fabs(acc[v] / 32767.0 - want[v]) < 2e-3 ? 0u : 1u;
+
+  uint32_t order[HB_VOICES];
+  for (uint32_t v = 0; v < HB_VOICES; v++) order[v] = v;
+  std::stable_sort(order, order + HB_VOICES, [&](uint32_t a, uint32_t b) { return want[a] > want[b]; });
+  bad += order[0] == 3u && order[1] == 5u ? 0u : 1u; // the construction, not the index
+  SrMatch top[2];
+  bad += idx.top_k(2, top) == 2 ? 0u : 1u;
+  for (uint32_t j = 0; j < 2; j++) {
+    bad += top[j].voice_id == (int16_t)order[j] ? 0u : 1u;
+    bad += std::fabs(top[j].cos - want[order[j]]) < 2e-3 ? 0u : 1u;
+  }
+
+  bad += idx.remove_voice(3) == 1u && idx.size() == HB_VOICES - 1u ? 0u : 1u;
+  bad += idx.top_k(1, top) == 1 && top[0].voice_id == 5 ? 0u : 1u;
+  return bad;
+}
+
+} // namespace ncomm
+
+int main() {
+  ncomm::SrPqBench b;
+  ncomm::sr_pq_bench(&b);
+  std::printf("sr pq n=16/64/256/1024 lut=%u ns pq=%u/%u/%u/%u ns q15=%u/%u/%u/%u ns tpl=%u B db=%u B\n", b.lut_ns,
+              b.pq_ns[0], b.pq_ns[1], b.pq_ns[2], b.pq_ns[3], b.q15_ns[0], b.q15_ns[1], b.q15_ns[2], b.q15_ns[3],
+              b.bytes_per_tpl, b.db_bytes);
+
+  static ncomm::SrPqEvalRow rows[ncomm::SR_PQ_EVAL_ROWS];
+  ncomm::sr_pq_eval(rows);
+  std::printf("format   bytes  spk/20KB  top1_pm  eer_e4  drift_e4\n");
+  for (const ncomm::SrPqEvalRow& r : rows) {
+    std::printf("%-8s %5u %9u %8u %7u %9u\n", r.name, r.bytes, r.speakers_20k, r.top1_pm, r.eer_e4, r.drift_e4);
+  }
+  // The Q15 index scores like float; the firmware PQ path (Q15 codebook,
+  // int16 table) like its float reference; 256 voices fit in 20 KB; the
+  // hand-built index matches exact codes and cosines
+  auto near = [](uint32_t a, uint32_t b, uint32_t tol) { return (a > b ? a - b : b - a) <= tol; };
+  const ncomm::SrPqEvalRow &f32 = rows[0], &q15 = rows[1], &pq16 = rows[3], &fw = rows[5];
+  const uint32_t hand_bad = ncomm::sr_pq_hand_checks();
+  std::printf("sr pq hand-built index bad=%u\n", hand_bad);
+  const bool ok = hand_bad == 0 && near(q15.top1_pm, f32.top1_pm, 2) && near(q15.eer_e4, f32.eer_e4, 5) &&
+                  near(fw.top1_pm, pq16.top1_pm, 5) && near(fw.eer_e4, pq16.eer_e4, 10) && fw.speakers_20k >= 256u;
+  return ok ? 0 : 1;
+}
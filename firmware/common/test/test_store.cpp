@@ -0,0 +1,315 @@
+// Host test: RecordStore on simulated NOR flash, including power cuts.
+#include "ncomm/ncomm_store.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace ncomm {
+
+// Simulated flash in a file, memory mapped. NOR semantics:
+// erase sets 0xFF, program only accepts erased words. cut_after(n) simulates
+// a power cut: the n-th following program/erase writes half a word (or half
+// a sector) and every later one fails until cut_after(0).
+class FileFlash final : public FlashDevice {
+public:
+  bool open(const char* path, uint32_t sector_size);
+  void close();
+  void cut_after(uint32_t ops) {
+    cut_ = ops;
+    dead_ = false;
+  }
+  uint8_t* image() { return map_; } // both sectors, writable (tests)
+
+  const uint8_t* base(uint8_t sector) const override { return map_ + (uint32_t)(sector & 1u) * size_; }
+  uint32_t sector_size() const override { return size_; }
+  bool erase(uint8_t sector) override;
+  bool program(uint8_t sector, uint32_t offset, const uint8_t* word) override;
+
+private:
+  int fd_ = -1;
+  uint8_t* map_ = nullptr;
+  uint32_t size_ = 0;
+  uint32_t cut_ = 0;
+  bool dead_ = false;
+
+  bool tick_();
+};
+
+static bool word_erased(const uint8_t* p) {
+  for (uint32_t i = 0; i < STORE_WORD; i++) {
+    if (p[i] != 0xFFu) return false;
+  }
+  return true;
+}
+
+bool FileFlash::open(const char* path, uint32_t sector_size) {
+  close();
+  if (!path || !sector_size || sector_size % STORE_WORD) return false;
+  fd_ = ::open(path, O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) return false;
+  struct stat st;
+  const uint32_t bytes = 2u * sector_size;
+  const bool fresh = (fstat(fd_, &st) != 0 || (uint64_t)st.st_size != bytes);
+  if (fresh && ftruncate(fd_, bytes) != 0) {
+    close();
+    return false;
+  }
+  void* m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (m == MAP_FAILED) {
+    close();
+    return false;
+  }
+  map_ = (uint8_t*)m;
+  size_ = sector_size;
+  if (fresh) std::memset(map_, 0xFF, bytes); // a new part comes erased
+  cut_ = 0;
+  dead_ = false;
+  return true;
+}
+
+void FileFlash::close() {
+  if (map_) {
+    msync(map_, 2u * size_, MS_SYNC);
+    munmap(map_, 2u * size_);
+  }
+  if (fd_ >= 0) ::close(fd_);
+  map_ = nullptr;
+  fd_ = -1;
+  size_ = 0;
+}
+
+// false once the supply is gone; the operation that hits the cut is torn
+bool FileFlash::tick_() {
+  if (dead_) return false;
+  if (cut_ && --cut_ == 0) dead_ = true;
+  return true;
+}
+
+bool FileFlash::erase(uint8_t sector) {
+  if (!map_ || !tick_()) return false;
+  uint8_t* s = map_ + (uint32_t)(sector & 1u) * size_;
+  std::memset(s, 0xFF, dead_ ? size_ / 2u : size_);
+  return !dead_;
+}
+
+bool FileFlash::program(uint8_t sector, uint32_t offset, const uint8_t* word) {
+  if (!map_ || offset % STORE_WORD || offset + STORE_WORD > size_) return false;
+  uint8_t* w = map_ + (uint32_t)(sector & 1u) * size_ + offset;
+  if (!word_erased(w)) return false; // ECC flash: one program per word
+  if (!tick_()) return false;
+  std::memcpy(w, word, dead_ ? STORE_WORD / 2u : STORE_WORD);
+  return !dead_;
+}
+
+static constexpr uint8_t ST_KEYS = 10;
+static constexpr uint16_t ST_MAX = 300;
+
+struct StoreModel {
+  uint8_t data[ST_KEYS][ST_MAX];
+  uint16_t len[ST_KEYS];
+  bool present[ST_KEYS];
+};
+
+// ff: trailing bytes set to 0xFF (payload words that look erased)
+static void st_fill(uint8_t* p, uint16_t len, uint32_t tag, uint16_t ff = 0) {
+  for (uint16_t i = 0; i < len; i++) p[i] = (uint8_t)((tag * 131u + i * 7u) ^ (i >> 3));
+  std::memset(p + len - (ff < len ? ff : len), 0xFF, ff < len ? ff : len);
+}
+
+static bool st_same(const RecordStore& st, const StoreModel& m, uint8_t k) {
+  uint16_t len = 0;
+  const uint8_t* p = st.get(k, &len);
+  if (!m.present[k]) return p == nullptr;
+  return p && len == m.len[k] && std::memcmp(p, m.data[k], len) == 0;
+}
+
+static uint32_t st_check(const RecordStore& st, const StoreModel& m) {
+  uint32_t bad = 0;
+  uint16_t n = 0;
+  for (uint8_t k = 0; k < ST_KEYS; k++) {
+    bad += st_same(st, m, k) ? 0u : 1u;
+    n += m.present[k] ? 1u : 0u;
+  }
+  return bad + (st.count() == n ? 0u : 1u);
+}
+
+static bool st_put(RecordStore& st, StoreModel& m, uint8_t k, uint16_t len, uint32_t tag, uint16_t ff = 0) {
+  uint8_t buf[ST_MAX];
+  st_fill(buf, len, tag, ff);
+  if (!st.put(k, buf, len)) return false;
+  std::memcpy(m.data[k], buf, len);
+  m.len[k] = len;
+  m.present[k] = true;
+  return true;
+}
+
+// Store scenarios on a FileFlash at path (put / replace / remove, remount,
+// compaction cycles, power cuts during append and compaction, payloads and
+// torn records ending in 0xFF words); returns the number of failed checks.
+uint32_t store_selftest(const char* path) {
+  static FileFlash flash;
+  static StoreModel m;
+  uint32_t bad = 0;
+  if (path) unlink(path);
+  if (!flash.open(path, 8192)) return 1;
+  std::memset(&m, 0, sizeof(m));
+
+  {
+    RecordStore st;
+    bad += st.mount(&flash) && st.count() == 0 ? 0u : 1u;
+    for (uint8_t k = 0; k < ST_KEYS; k++) bad += st_put(st, m, k, (uint16_t)(20u + k * 25u), k) ? 0u : 1u;
+    bad += st_put(st, m, 3, 268, 1003) ? 0u : 1u; // replace
+    bad += st.remove(5) ? 0u : 1u;
+    m.present[5] = false;
+    bad += st_check(st, m);
+  }
+  {
+    RecordStore st; // reset: contents survive
+    bad += st.mount(&flash) ? 0u : 1u;
+    bad += st_check(st, m);
+
+    // Churn through many compactions; sectors wear evenly
+    uint32_t seed = 0x53544F52u;
+    for (uint32_t i = 0; i < 400; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      const uint8_t k = (uint8_t)((seed >> 8) % ST_KEYS);
+      const uint16_t len = (uint16_t)((seed >> 16) % ST_MAX);
+      bad += st_put(st, m, k, len, 2000u + i) ? 0u : 1u;
+    }
+    bad += st_check(st, m);
+    bad += st.stats().compactions > 10 ? 0u : 1u;
+    const uint32_t e0 = st.erase_count(0), e1 = st.erase_count(1);
+    bad += (e0 > e1 ? e0 - e1 : e1 - e0) <= 1u ? 0u : 1u;
+  }
+
+  // Power cut at every flash operation of a put, incl. one that compacts:
+  // after remount the key holds the old or the new record, never a mix, the
+  // other keys are intact and the store keeps working.
+  static uint8_t image[2 * 8192];
+  for (int pass = 0; pass < 2; pass++) {
+    {
+      RecordStore st;
+      st.mount(&flash);
+      if (pass == 1) { // fill up to just before a compaction
+        for (uint32_t i = 0; st.free_bytes() >= store_record_span(ST_MAX); i++) {
+          st_put(st, m, (uint8_t)(i % ST_KEYS), ST_MAX, 3000u + i);
+        }
+      }
+    }
+    std::memcpy(image, flash.image(), sizeof(image));
+    const StoreModel before = m;
+    for (uint32_t cut = 1; cut < 400; cut++) {
+      std::memcpy(flash.image(), image, sizeof(image));
+      m = before;
+      bool done;
+      {
+        RecordStore st;
+        st.mount(&flash);
+        flash.cut_after(cut);
+        done = st_put(st, m, 7, ST_MAX, 4000u + cut);
+        flash.cut_after(0);
+      }
+      RecordStore st;
+      bad += st.mount(&flash) ? 0u : 1u;
+      StoreModel old = before;
+      const bool is_new = st_same(st, m, 7), is_old = st_same(st, old, 7);
+      bad += (is_new || (!done && is_old)) ? 0u : 1u;
+      if (!is_new) m = before;
+      bad += st_check(st, m);
+      bad += st_put(st, m, 8, 40, 5000u + cut) ? 0u : 1u; // writable after recovery
+      if (done) break;
+    }
+    m = before;
+    std::memcpy(flash.image(), image, sizeof(image));
+  }
+
+  // Payloads ending in 0xFF words: mount finds the write position from the
+  // last programmed word, so a record whose tail looks erased must still be
+  // stepped over whole, and a torn one must not hide the words after it.
+  // Sector 8192: header word, then 100 B (160 B span) and 128 B (160 B).
+  {
+    RecordStore st;
+    bad += st.mount(&flash) && st.format() ? 0u : 1u;
+    std::memset(&m, 0, sizeof(m));
+    bad += st_put(st, m, 1, 100, 6001) ? 0u : 1u;
+    bad += st_put(st, m, 2, 128, 6002, 64) ? 0u : 1u; // last two words 0xFF
+    bad += st.free_bytes() == 8192u - 32u - 160u - 160u ? 0u : 1u;
+  }
+  {
+    RecordStore st;
+    bad += st.mount(&flash) && st.stats().skipped_words == 0 ? 0u : 1u;
+    bad += st.free_bytes() == 7840u ? 0u : 1u;
+    bad += st_check(st, m);
+
+    // Power cut before the header: two data words, two 0xFF words, no header
+    uint8_t buf[128];
+    st_fill(buf, 128, 6003, 64);
+    const uint32_t at = 8192u - 7840u;
+    for (uint32_t w = 0; w < 4; w++) bad += flash.program(0, at + 32u + w * 32u, buf + w * 32u) ? 0u : 1u;
+  }
+  {
+    // Skipped: the empty header word and the two data words; the 0xFF words
+    // are still erased and taken by the next record
+    RecordStore st;
+    bad += st.mount(&flash) && st.stats().skipped_words == 3 ? 0u : 1u;
+    bad += st.free_bytes() == 7840u - 96u ? 0u : 1u;
+    bad += st_check(st, m);
+    bad += st_put(st, m, 4, 40, 6004) ? 0u : 1u;
+  }
+  {
+    RecordStore st;
+    bad += st.mount(&flash) && st.stats().skipped_words == 3 ? 0u : 1u;
+    bad += st.free_bytes() == 7840u - 96u - 96u ? 0u : 1u;
+    bad += st_check(st, m);
+  }
+
+  // Power cut at every operation of a put whose payload ends in 0xFF words
+  // (or is all 0xFF): old or new after remount, and a record appended after
+  // the recovery is still found by the next mount.
+  std::memcpy(image, flash.image(), sizeof(image));
+  const StoreModel ff_before = m;
+  for (uint16_t ff = 64; ff <= 128; ff = (uint16_t)(ff + 64)) {
+    for (uint32_t cut = 1; cut < 16; cut++) {
+      std::memcpy(flash.image(), image, sizeof(image));
+      m = ff_before;
+      bool done;
+      {
+        RecordStore st;
+        st.mount(&flash);
+        flash.cut_after(cut);
+        done = st_put(st, m, 2, 128, 7000u + cut, ff);
+        flash.cut_after(0);
+      }
+      {
+        RecordStore st;
+        bad += st.mount(&flash) ? 0u : 1u;
+        StoreModel old = ff_before;
+        const bool is_new = st_same(st, m, 2), is_old = st_same(st, old, 2);
+        bad += (is_new || (!done && is_old)) ? 0u : 1u;
+        if (!is_new) m = ff_before;
+        bad += st_check(st, m);
+        bad += st_put(st, m, 5, 40, 7100u + cut) ? 0u : 1u;
+      }
+      RecordStore st;
+      bad += st.mount(&flash) ? 0u : 1u;
+      bad += st_check(st, m);
+      if (done) break;
+    }
+  }
+
+  flash.close();
+  return bad;
+}
+
+} // namespace ncomm
+
+int main() {
+  const uint32_t bad = ncomm::store_selftest("store_flash.bin");
+  std::printf("store selftest bad=%u\n", bad);
+  return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+// Host test: int8 VoiceID encoder against its float model.
+#include "ncomm/ncomm_voiceid.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+#include "ncomm/ncomm_profile.h"
+
+namespace ncomm {
+
+// ---- int8 engine vs the float model ----
+// Float model = the placeholder's float weights (int8 weights + sub-LSB
+// residual, i.e. the int8 model is exactly its per-channel quantisation),
+// float activations, same graph. Inputs: 6 synthetic voices (f0 100..300 Hz,
+// different formants) through MelFrontEnd + mel_cmvn.
+//   int8_us / float_us : per embedding
+//   ram        : VoiceIdEncoder (arena)
+//   flash      : int8 weights + biases / requant tables
+//   flash_f32  : float model weights (what a float model would need)
+//   dist_e4    : max over voices of 1 - cos(int8 emb, float emb), x 10^4
+//   drift_mil  : max over voice pairs of |score int8 - score float| x 1000
+//                (score = cosine similarity, what SR thresholds)
+struct VoiceIdBench {
+  uint32_t int8_us = 0;
+  uint32_t float_us = 0;
+  uint32_t ram = 0;
+  uint32_t flash = 0;
+  uint32_t flash_f32 = 0;
+  uint32_t dist_e4 = 0;
+  uint32_t drift_mil = 0;
+};
+
+// Float weights s_c * (q + u) of the placeholder (ncomm_voiceid.cpp): q is
+// read from the int8 model, s_c and u are the same hashes.
+namespace ph {
+
+static constexpr uint32_t LAYERS = VOICEID_TDNN_LAYERS + 1u; // + FC
+
+constexpr uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352Du;
+  x ^= x >> 15;
+  x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x;
+}
+
+constexpr double residual_at(uint32_t layer, uint32_t i) {
+  return ((double)(hash32(i * 0xC2B2AE35u + layer * 0x27D4EB2Fu + 7u) >> 8) / 16777216.0 - 0.5) * 0.98;
+}
+
+constexpr VoiceIdShape shape(uint32_t layer) {
+  return (layer < VOICEID_TDNN_LAYERS) ? voiceid_shape(layer)
+                                       : VoiceIdShape{1, 1, VOICEID_POOL_DIM, VOICEID_EMB_DIM, 1, 1};
+}
+
+constexpr uint32_t row(uint32_t layer) { return (uint32_t)shape(layer).k * shape(layer).cin; }
+constexpr uint32_t count(uint32_t layer) { return row(layer) * shape(layer).cout; }
+
+static double channel_scale(uint32_t layer, uint32_t c) {
+  const double g = 0.75 + 0.5 * (double)(hash32(c * 0x165667B1u + layer * 0xD3A2646Cu + 3u) >> 8) / 16777216.0;
+  const double gain = (layer == 0) ? 1.0 : 1.41421356237;
+  return g * gain / (73.6 * std::sqrt((double)row(layer)));
+}
+
+static float s_f0[count(0)], s_f1[count(1)], s_f2[count(2)], s_f3[count(3)], s_ffc[count(4)];
+static float* const F[LAYERS] = {s_f0, s_f1, s_f2, s_f3, s_ffc};
+
+static void make_float_weights(const VoiceIdModel* m) {
+  for (uint32_t l = 0; l < LAYERS; l++) {
+    const int8_t* q = (l < VOICEID_TDNN_LAYERS) ? m->tdnn[l].w : m->fc_w;
+    for (uint32_t i = 0; i < count(l); i++) {
+      F[l][i] = (float)(channel_scale(l, i / row(l)) * ((double)q[i] + residual_at(l, i)));
+    }
+  }
+}
+
+} // namespace ph
+
+static constexpr uint32_t VOICES = 6;
+
+static void l2_normalise(float* v, uint32_t n) {
+  float e = 0.0f;
+  for (uint32_t i = 0; i < n; i++) e += v[i] * v[i];
+  const float g = e > 0.0f ? 1.0f / std::sqrt(e) : 0.0f;
+  for (uint32_t i = 0; i < n; i++) v[i] *= g;
+}
+
+// Float reference graph: same layout, float activations, ReLU without clip
+static float s_fa[2][MEL_WINDOW_FRAMES * 256];
+
+static void float_encode(const float* mel, uint32_t stride, float* emb) {
+  for (uint32_t t = 0; t < MEL_WINDOW_FRAMES; t++) {
+    for (uint32_t k = 0; k < MEL_BINS; k++) s_fa[0][t * MEL_BINS + k] = mel[k * stride + t];
+  }
+  for (uint32_t l = 0; l < VOICEID_TDNN_LAYERS; l++) {
+    const VoiceIdShape s = voiceid_shape(l);
+    const float* in = s_fa[l & 1u];
+    float* out = s_fa[(l + 1u) & 1u];
+    const uint32_t row = (uint32_t)s.k * s.cin;
+    for (uint32_t co = 0; co < s.cout; co++) {
+      const float* w = &ph::F[l][co * row];
+      for (uint32_t t = 0; t < s.t_out; t++) {
+        float acc = 0.0f;
+        for (uint32_t k = 0; k < s.k; k++) {
+          const float* x = &in[(t + k * s.dil) * s.cin];
+          const float* wk = &w[k * s.cin];
+          for (uint32_t i = 0; i < s.cin; i++) acc += x[i] * wk[i];
+        }
+        out[t * s.cout + co] = acc > 0.0f ? acc : 0.0f;
+      }
+    }
+  }
+  constexpr VoiceIdShape last = voiceid_shape(VOICEID_TDNN_LAYERS - 1u);
+  const float* in = s_fa[VOICEID_TDNN_LAYERS & 1u];
+  float pool[VOICEID_POOL_DIM];
+  for (uint32_t c = 0; c < last.cout; c++) {
+    float s = 0.0f, q = 0.0f;
+    for (uint32_t t = 0; t < last.t_out; t++) {
+      const float x = in[t * last.cout + c];
+      s += x;
+      q += x * x;
+    }
+    const float mu = s / (float)last.t_out;
+    const float var = q / (float)last.t_out - mu * mu;
+    pool[c] = mu;
+    pool[last.cout + c] = std::sqrt(var > 0.0f ? var : 0.0f);
+  }
+  for (uint32_t c = 0; c < VOICEID_EMB_DIM; c++) {
+    const float* w = &ph::F[VOICEID_TDNN_LAYERS][c * VOICEID_POOL_DIM];
+    float acc = 0.0f;
+    for (uint32_t i = 0; i < VOICEID_POOL_DIM; i++) acc += pool[i] * w[i];
+    emb[c] = acc;
+  }
+  l2_normalise(emb, VOICEID_EMB_DIM);
+}
+
+// Voiced 500 ms: harmonics of f0 (slight vibrato) shaped by three formant
+// peaks, syllable envelope, low noise floor
+static void make_voice(uint32_t v, int16_t* x) {
+  static const float formants[VOICES][3] = {
+      {700, 1200, 2600}, {500, 1700, 2500}, {350, 2300, 3000},
+      {600, 1000, 2400}, {450, 1900, 2800}, {300, 900, 2200}};
+  const float f0 = 100.0f + 40.0f * (float)v;
+  const float two_pi = 6.28318531f;
+  uint32_t seed = 0x766F6963u + v;
+  float phase = 0.0f;
+  for (uint32_t n = 0; n < MEL_WINDOW_SAMPLES; n++) {
+    const float t = (float)n / 16000.0f;
+    const float f = f0 * (1.0f + 0.02f * std::sin(two_pi * 5.0f * t));
+    phase += two_pi * f / 16000.0f;
+    if (phase > two_pi) phase -= two_pi;
+    float s = 0.0f;
+    for (uint32_t h = 1; h * f0 < 4000.0f; h++) {
+      const float fh = (float)h * f0;
+      float a = 0.0f;
+      for (uint32_t k = 0; k < 3; k++) {
+        const float d = (fh - formants[v][k]) / (80.0f + 40.0f * (float)k);
+        a += 1.0f / (1.0f + d * d);
+      }
+      s += a * std::sin((float)h * phase) / (float)h;
+    }
+    const float env = 0.4f + 0.6f * std::fabs(std::sin(3.14159265f * t / 0.25f));
+    seed = seed * 1664525u + 1013904223u;
+    const float noise = (float)((int32_t)(seed >> 20) - 2048) * 0.25f;
+    x[n] = (int16_t)(3000.0f * env * s + noise);
+  }
+}
+
+static MelFrontEnd s_vid_mel;
+static VoiceIdEncoder s_vid_enc;
+static int16_t s_vid_pcm[MEL_WINDOW_SAMPLES];
+static float s_vid_feat[VOICES][MEL_BINS * MEL_WINDOW_FRAMES];
+static float s_emb_q[VOICES][VOICEID_EMB_DIM];
+static float s_emb_f[VOICES][VOICEID_EMB_DIM];
+
+static float dot(const float* a, const float* b, uint32_t n) {
+  float s = 0.0f;
+  for (uint32_t i = 0; i < n; i++) s += a[i] * b[i];
+  return s;
+}
+
+void voiceid_bench(VoiceIdBench* out) {
+  if (!out) return;
+  s_vid_mel.init();
+  s_vid_enc.init(voiceid_placeholder_model());
+  ph::make_float_weights(voiceid_placeholder_model());
+
+  constexpr uint32_t F = MEL_WINDOW_FRAMES;
+  for (uint32_t v = 0; v < VOICES; v++) {
+    make_voice(v, s_vid_pcm);
+    for (uint32_t f = 0; f < F; f++) {
+      s_vid_mel.frame(&s_vid_pcm[f * MEL_HOP], MEL_NFFT, nullptr, &s_vid_feat[v][f], F);
+    }
+    mel_cmvn(s_vid_feat[v], F, F, true);
+  }
+
+  constexpr uint32_t ROUNDS = 3;
+  uint64_t t_q = 0, t_f = 0;
+  for (uint32_t r = 0; r < ROUNDS; r++) {
+    for (uint32_t v = 0; v < VOICES; v++) {
+      const uint32_t t0 = ncomm_cycles_now();
+      s_vid_enc.encode(s_vid_feat[v], F, s_emb_q[v]);
+      const uint32_t t1 = ncomm_cycles_now();
+      float_encode(s_vid_feat[v], F, s_emb_f[v]);
+      const uint32_t t2 = ncomm_cycles_now();
+      t_q += (uint32_t)(t1 - t0);
+      t_f += (uint32_t)(t2 - t1);
+    }
+  }
+
+  float min_cos = 1.0f, drift = 0.0f;
+  for (uint32_t a = 0; a < VOICES; a++) {
+    const float c = dot(s_emb_q[a], s_emb_f[a], VOICEID_EMB_DIM);
+    if (c < min_cos) min_cos = c;
+    for (uint32_t b = a + 1; b < VOICES; b++) {
+      const float d = std::fabs(dot(s_emb_q[a], s_emb_q[b], VOICEID_EMB_DIM) -
+                                dot(s_emb_f[a], s_emb_f[b], VOICEID_EMB_DIM));
+      if (d > drift) drift = d;
+    }
+  }
+
+  uint32_t channels = VOICEID_EMB_DIM;
+  for (uint32_t l = 0; l < VOICEID_TDNN_LAYERS; l++) channels += voiceid_shape(l).cout;
+  out->int8_us = (uint32_t)(ncomm_cycles_to_ns(t_q) / (ROUNDS * VOICES) / 1000u);
+  out->float_us = (uint32_t)(ncomm_cycles_to_ns(t_f) / (ROUNDS * VOICES) / 1000u);
+  out->ram = s_vid_enc.ram_bytes();
+  out->flash = voiceid_weight_bytes() + channels * (4u + 4u + 1u); // bias, mult, shift
+  out->flash_f32 = voiceid_weight_bytes() * (uint32_t)sizeof(float);
+  out->dist_e4 = (uint32_t)((1.0f - min_cos) * 10000.0f + 0.5f);
+  out->drift_mil = (uint32_t)(drift * 1000.0f + 0.5f);
+}
+
+} // namespace ncomm
+
+int main() {
+  ncomm::VoiceIdBench b;
+  ncomm::voiceid_bench(&b);
+  std::printf("voiceid int8=%u us float=%u us ram=%u B flash=%u B f32=%u B dist=%u e-4 drift=%u e-3\n", b.int8_us,
+              b.float_us, b.ram, b.flash, b.flash_f32, b.dist_e4, b.drift_mil);
+  // Quantisation error well below SR score resolution
+  return (b.dist_e4 <= 10u && b.drift_mil <= 10u) ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MCU1 application: protocol handling, VAD, playout and link streaming.
+// Registers its handlers with ncomm_sched; call after ncomm_sched_init()
+// and ncomm_uart_init(). Also used by CMD_RESET_STATE.
+void ncomm_app_init(void);
+
+#ifdef __cplusplus
+}
+#endif
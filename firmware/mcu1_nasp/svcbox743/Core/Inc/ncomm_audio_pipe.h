@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "ncomm/ncomm_meter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MCU1 capture pipeline: In1 (MIC) + In2 (SPK/RX) processed chunk by chunk
+// in a single interleaved pass.
+//
+// DMA (DFSDM, 24-bit in int32) lands in RAM_D2, double-buffered (half/full).
+// When both channels of one half are in, ncomm_pipe_poll() runs one loop that
+// per sample does: capture conversion -> gain/HPF/clip -> VAD energy + meters, for MIC
+// and RX together, writing int16 into 32-byte aligned DTCM work buffers.
+// Framing reads from DTCM, so the D2 landing zone is touched exactly once.
+
+#define NCOMM_PIPE_CHUNK_SAMPLES 256 // 16 ms @ 16 kHz
+
+// DFSDM data register: 24-bit sample in [31:8]; keep the top 16 bits.
+#define NCOMM_PIPE_RAW_SHIFT 16
+
+typedef struct {
+    const int16_t* mic;     // processed In1 (HPF + clip control), DTCM
+    const int16_t* rx;      // processed In2 (gain + noise gate), DTCM
+    uint16_t samples;
+    uint32_t mic_abs_sum;   // VAD energy (sum |x|) of mic
+    uint32_t rx_abs_sum;
+    uint8_t  rx_gated;      // 1 = In2 below gate level, rx output is zero
+    uint8_t  rx_missing;    // 1 = In2 has no capture filter, rx is silence
+    ncomm_meter_t mic_meter; // In1 peak / sum of squares over this chunk (post HPF)
+    ncomm_meter_t rx_meter;  // In2, post gain, pre gate
+    uint32_t chunk_index;
+    uint32_t cycles;        // cycles spent in the fused pass (DWT)
+} ncomm_pipe_chunk_t;
+
+typedef struct {
+    uint32_t chunks;
+    uint32_t overruns;      // a half was overwritten before it was processed
+    uint32_t rx_missing;    // chunks captured without In2 (rx filter NULL)
+    uint32_t cycles_last;
+    uint32_t cycles_max;
+} ncomm_pipe_stats_t;
+
+void ncomm_pipe_init(void);
+
+// Arm circular DMA on the DFSDM filters (DMA1 Stream0 = mic, Stream2 = rx).
+// rx may be NULL while In2 is not wired; the RX channel then reads as
+// silence. ncomm_pipe_init() stops a running capture first, so call this
+// again after a re-init.
+bool ncomm_pipe_start_capture(DFSDM_Filter_HandleTypeDef* mic, DFSDM_Filter_HandleTypeDef* rx);
+void ncomm_pipe_stop_capture(void);
+bool ncomm_pipe_capture_running(void);
+// False while DMA capture runs without an In2 filter (injected chunks carry both)
+bool ncomm_pipe_rx_captured(void);
+
+// DMA1_Stream0_IRQHandler (rx = 0) / DMA1_Stream2_IRQHandler (rx = 1)
+void ncomm_pipe_dma_irq(uint8_t rx);
+
+// Synthetic source (MVP generator / bench): writes int16 samples into the
+// next landing half in raw DFSDM format, exactly as the DMA would.
+void ncomm_pipe_inject(const int16_t* mic, const int16_t* rx, uint16_t n);
+
+// Process one ready chunk (if any). Returns false when nothing is pending.
+bool ncomm_pipe_poll(ncomm_pipe_chunk_t* out);
+
+// In2 gain (Q12, 4096 = 0 dB) and gate level as average |x| (default ~ -50 dBFS)
+void ncomm_pipe_set_rx_gain(uint16_t gain_q12, uint16_t gate_avg_abs);
+
+const ncomm_pipe_stats_t* ncomm_pipe_stats(void);
+
+#if defined(NCOMM_PIPE_BENCH)
+// Cycles per 16 ms chunk on the same input: legacy per-channel multi-pass
+// processing over AXI-SRAM buffers vs. the fused single pass. Runs on its own
+// landing and work buffers (synthetic input) and leaves the live capture state
+// alone. Board numbers: EVT_INFO "PIPE two= fused=" on a NCOMM_PIPE_BENCH build.
+typedef struct {
+    uint32_t two_pass_cycles;
+    uint32_t fused_cycles;
+} ncomm_pipe_bench_t;
+
+void ncomm_pipe_bench(ncomm_pipe_bench_t* out, uint16_t iterations);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,7 +2,7 @@
 
 #include <cstdint>
 
-struct UART_HandleTypeDef;
+#include "main.h" // UART_HandleTypeDef (HAL typedef, cannot be forward-declared as a struct)
 
 namespace ncomm::mcu1 {
 
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "ncomm/ncomm_meter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MCU1 audio outputs on I2S2 (master TX, 16 kHz, 32-bit slots, Philips):
+//   left  slot -> TX_AUDIO_OUT  (radio mic input)
+//   right slot -> RX_STREAM_OUT (headset)
+//
+// Circular DMA over two periods of NCOMM_PLAYOUT_PERIOD frames in RAM_D2.
+// Each half-transfer / transfer-complete callback converts the next period
+// from the per-channel jitter buffers (int16) to 32-bit slots.
+//
+// Latency budget (samples @ 16 kHz, bound <= 2 chunks = 512):
+//   jitter margin (32..128) + chunk burst (256) + DMA (<= 2 periods = 128)
+// The writer enforces it: samples past 512 - DMA queue are dropped (overruns).
+
+#define NCOMM_PLAYOUT_PERIOD 64 // frames per DMA half (4 ms)
+
+typedef enum {
+    NCOMM_OUT_RADIO   = 0, // TX_AUDIO_OUT
+    NCOMM_OUT_HEADSET = 1, // RX_STREAM_OUT
+    NCOMM_OUT_COUNT
+} ncomm_out_t;
+
+typedef struct {
+    uint32_t underruns;     // samples padded with silence (reader found buffer short)
+    uint32_t overruns;      // samples dropped by the writer (depth bound reached)
+    uint32_t trims;         // samples skipped by the adaptive depth control
+    uint16_t margin;        // current target minimum fill (samples)
+    uint16_t fill_min;      // min fill seen in the last window
+    uint16_t latency_max;   // worst fill + DMA queue in the last window (samples)
+} ncomm_playout_ch_stats_t;
+
+typedef struct {
+    uint32_t periods;
+    ncomm_playout_ch_stats_t ch[NCOMM_OUT_COUNT];
+} ncomm_playout_stats_t;
+
+// Configure the SPI2_TX DMA stream and start circular playout (once).
+bool ncomm_playout_init(I2S_HandleTypeDef* hi2s);
+
+// Drop buffered audio (mode change / CMD_RESET_STATE).
+void ncomm_playout_reset(void);
+
+// Queue one chunk of 16 kHz PCM. Main-loop context only (single producer).
+void ncomm_playout_write(ncomm_out_t ch, const int16_t* pcm, uint16_t n);
+
+const ncomm_playout_stats_t* ncomm_playout_stats(void);
+
+// Output peak / sum of squares since the last call, measured on the rendered
+// periods (silence padding included). Copies and clears; out may be NULL.
+void ncomm_playout_levels(ncomm_meter_t out[NCOMM_OUT_COUNT]);
+
+// DMA1_Stream1 IRQ entry (called from stm32h7xx_it.c)
+void ncomm_playout_dma_irq(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MCU1 run loop: ISRs post event bits, the main context dispatches handlers
+// in priority order (lowest bit first, re-evaluated after every handler) and
+// sleeps in WFI when nothing is pending.
+//
+// Accounting (1 s windows, cycles):
+//   idle    = window - awake cycles (CYCCNT net of WFI), window from SysTick
+//   latency = post (first set of the bit) -> handler start
+//   run     = handler duration
+
+typedef enum {
+    NCOMM_EV_AUDIO   = 0, // capture chunk ready (DFSDM half / injected)
+    NCOMM_EV_UART_RX = 1, // bytes in the link RX ring
+    NCOMM_EV_TICK    = 2, // SysTick, 1 ms
+    NCOMM_EV_COUNT
+} ncomm_event_t;
+
+typedef void (*ncomm_handler_t)(void);
+
+typedef struct {
+    uint32_t count;
+    uint32_t lat_max;   // cycles
+    uint32_t run_max;   // cycles
+} ncomm_sched_ev_stats_t;
+
+typedef struct {
+    uint32_t window_cycles;
+    uint32_t idle_cycles;
+    uint16_t idle_x100;      // idle percentage * 100 (9750 = 97.50 %)
+    uint32_t lat_max;        // worst over all events, cycles
+    uint32_t run_max;
+    ncomm_sched_ev_stats_t ev[NCOMM_EV_COUNT];
+} ncomm_sched_stats_t;
+
+void ncomm_sched_init(void);
+void ncomm_sched_register(ncomm_event_t ev, ncomm_handler_t fn);
+
+// ISR-safe.
+void ncomm_sched_post(ncomm_event_t ev);
+
+// Dispatch every pending event, then sleep until the next interrupt.
+void ncomm_sched_run_once(void);
+
+// Last completed window.
+const ncomm_sched_stats_t* ncomm_sched_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MCU1 <-> MCU2 link transport (framing per UART_Protocol_Spec_v1.4.0).
+// TX is blocking; RX is interrupt driven into a byte ring and posts
+// NCOMM_EV_UART_RX to the scheduler.
+
+// Select the link UART and enable its RXNE interrupt.
+void ncomm_uart_init(UART_HandleTypeDef* huart);
+
+void ncomm_uart_send(uint8_t ver, uint8_t type, uint8_t flags, const uint8_t* payload, uint16_t len);
+
+// Main context: next received byte, false if the ring is empty.
+bool ncomm_uart_rx_pop(uint8_t* out);
+
+// USARTx_IRQHandler entry; ignores handles other than the link UART.
+void ncomm_uart_irq(UART_HandleTypeDef* huart);
+
+typedef struct {
+    uint32_t rx_bytes;
+    uint32_t rx_overflow;  // bytes dropped, ring full
+    uint32_t rx_errors;    // ORE / FE / NE / PE
+} ncomm_uart_stats_t;
+
+const ncomm_uart_stats_t* ncomm_uart_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,12 +12,14 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "dma.h"
+#include "dfsdm.h"
 #include "gpio.h"
 #include "spi.h"
 #include "i2s.h"
 #include "usart.h"
 
 #include "ncomm_mcu1.hpp"
+#include "ncomm/ncomm_profile.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -56,6 +58,7 @@ int main(void)
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_DMA_Init();
+  MX_DFSDM1_Init();
   MX_SPI1_Init();
   MX_I2S2_Init();
   MX_USART3_UART_Init();
@@ -64,6 +67,9 @@ int main(void)
   /* USER CODE BEGIN 2 */
   // MCU1 <-> MCU2 link for MVP0 is expected on UART @ 1M.
   // In this project MCU1 UART4 is configured as 1,000,000 baud (see usart.c).
+  // Audio DMA streams are set up by the capture / playout modules (DMA1
+  // clock: MX_DMA_Init).
+  ncomm_cycles_init(); // DWT cycle counter: scheduler load, profiler, benches
   ncomm::mcu1::Init(&huart4);
   /* USER CODE END 2 */
 
@@ -71,7 +77,7 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-    ncomm::mcu1::Loop();
+    ncomm::mcu1::Loop(); // dispatch pending events, then WFI
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
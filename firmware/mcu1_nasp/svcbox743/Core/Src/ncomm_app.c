@@ -5,11 +5,19 @@
 
 #include "main.h"
 #include "usart.h"
-
-void ncomm_uart_send(uint8_t ver, uint8_t type, uint8_t flags, const uint8_t* payload, uint16_t len);
+#include "i2s.h"
+#include "dfsdm.h"
+#include "ncomm_app.h"
+#include "ncomm_audio_pipe.h"
+#include "ncomm_playout.h"
+#include "ncomm_sched.h"
+#include "ncomm_uart.h"
+#include "ncomm/ncomm_resample.h"
+#include "ncomm/ncomm_mem.h"
+#include "ncomm/ncomm_profile.h"
 
 // ===== Protocol constants (match UART_Protocol_Spec_v1.4.0) =====
-#define NCOMM_VER 0x10
+#define NCOMM_VER 0x01
 
 // Commands (MCU2->MCU1)
 #define CMD_PING            0x01
@@ -22,17 +30,28 @@ void ncomm_uart_send(uint8_t ver, uint8_t type, uint8_t flags, const uint8_t* pa
 // Events (MCU1->MCU2)
 #define EVT_PONG            0x80
 #define EVT_INFO            0x81
-#define EVT_MODE_ACK        0x90
-#define EVT_STREAMS_ACK     0x91
-#define EVT_RESET_ACK       0x92
-#define EVT_VAD_CONFIG_ACK  0x93
-#define EVT_VAD_STATUS      0xA0
-#define EVT_AUDIO_FRAME     0xA1
-
-// stream_id in EVT_AUDIO_FRAME payload (we keep it simple for MVP)
+#define EVT_MODE_ACK        0x82
+#define EVT_STREAMS_ACK     0x83
+#define EVT_VAD             0x84
+#define EVT_RESET_ACK       0x85
+#define EVT_VAD_CONFIG_ACK  0x86
+#define EVT_AUDIO_RX_FRAME  0x90
+#define EVT_AUDIO_TX_FRAME  0x91
+#define EVT_VAD_MAP         0xA2
+#define EVT_AUDIO_LEVELS    0xA3
+#define EVT_PROFILE         0xA4
+
+// stream_id in the audio frame payload (redundant with TYPE, kept for MCU2's brick repacker)
 #define STREAM_ID_RX_STREAM_OUT  0x01
 #define STREAM_ID_TX_AUDIO_OUT   0x02
 
+// Link budget (spec 8.3): UART4 1 Mbaud 8N1 ~ 100 kB/s, i.e. 1600 B per
+// 16 ms chunk. Audio frames may take 3/4 of it; the rest is left for
+// control, VAD/levels events and EVT_PROFILE.
+#define LINK_BYTES_PER_CHUNK   1600u
+#define LINK_AUDIO_BUDGET      (LINK_BYTES_PER_CHUNK * 3u / 4u)
+#define LINK_FRAME_OVERHEAD    (10u + 8u) // framing + audio header
+
 // ===== MVP runtime config =====
 typedef enum {
     MODE_STANDBY = 0,
@@ -51,40 +70,66 @@ static struct {
     uint8_t vad_evt_enable;
 
     uint16_t frame_samples; // default 256 (16ms@16k)
+    uint8_t stream_rx_rate; // ncomm_rate_t, default 16k
+    uint8_t stream_tx_rate;
 
     // VAD config
     uint8_t vad_start_marker; // consecutive true
     uint8_t vad_stop_marker;  // consecutive false
     uint16_t vad_chunk_ms;    // 16
-    uint16_t vad_preroll_ms;  // unused in MVP
+    uint16_t vad_preroll_ms;  // 160 (10 chunks)
+    uint8_t vad_map_decim;    // EVT_VAD_MAP every N chunks; 0 = on change only
 
-    // counters
-    uint32_t audio_frame_index;
+    // counters; frame_index runs per stream (MCU2 drift fit counts chunks of that stream)
+    uint32_t rx_frame_index;
+    uint32_t tx_frame_index;
+    uint32_t budget_rejects; // CMD_SET_STREAMS with RX dropped to fit LINK_AUDIO_BUDGET
     uint8_t  vad_true_run;
     uint8_t  vad_false_run;
     uint8_t  vad_state; // 0/1
+
+    // VAD map / buffer state (EVT_VAD_MAP), shift registers: bit0 = newest chunk
+    uint64_t vad_map;       // raw per-chunk decision
+    uint64_t vad_state_map; // latched state
+    uint8_t  vad_start_age; // chunks since last start edge, 0xFF = outside the map
+    uint8_t  vad_stop_age;
+    uint8_t  vad_map_count; // chunks since last EVT_VAD_MAP
+    uint8_t  vad_evt_force; // resend state + map after (re)enable
+    uint8_t  preroll_fill;  // chunks held for the pre-roll (0 after handover at start)
+
+    // Level meters (EVT_AUDIO_LEVELS): In1/In2 summed from the capture chunks
+    uint8_t  levels_decim;  // chunks per record; 0 = off
+    uint8_t  levels_count;
+    ncomm_meter_t lvl_in[2];
 } g;
 
+// Per-stream decimators (16k -> stream rate), kept across chunks
+static ncomm_resampler_t rs_rx;
+static ncomm_resampler_t rs_tx;
+
+static uint8_t sanitize_rate(uint8_t r) {
+    return (r == NCOMM_RATE_8K || r == NCOMM_RATE_12K) ? r : NCOMM_RATE_16K;
+}
+
+// Link bytes of one audio frame at rate r (frame_samples in 16k units)
+static uint32_t stream_link_bytes(uint8_t r, uint16_t frame_samples) {
+    uint32_t n = (uint32_t)frame_samples * ncomm_rate_chunk_samples((ncomm_rate_t)r) / NCOMM_PIPE_CHUNK_SAMPLES;
+    return LINK_FRAME_OVERHEAD + 2u * n;
+}
+
 // ===== UART RX minimal parser (SOF resync) =====
 #define RX_BUF_SZ 1024
-static uint8_t rxbuf[RX_BUF_SZ];
+static uint8_t rxbuf[RX_BUF_SZ] NCOMM_FAST_DATA;
 static uint16_t rxlen = 0;
 
-static bool uart_rx_poll_byte(uint8_t* out) {
-    // non-blocking read 1 byte
-    if (__HAL_UART_GET_FLAG(&huart3, UART_FLAG_RXNE) != RESET) {
-        *out = (uint8_t)(huart3.Instance->RDR & 0xFF);
-        return true;
-    }
-    return false;
-}
-
 // CRC helper (declared in ncomm_crc16.c)
 uint16_t ncomm_crc16_ccitt_false(const uint8_t* data, size_t len);
 
 // Try parse one packet from rxbuf; on success consume and return true.
-static bool try_parse_packet(uint8_t* out_type, uint8_t* out_flags, uint8_t* out_seq,
-                             uint8_t* payload, uint16_t* out_len) {
+NCOMM_FAST_CODE static bool try_parse_packet(uint8_t* out_type, uint8_t* out_flags, uint8_t* out_seq,
+                                             uint8_t* payload, uint16_t* out_len) {
+    NCOMM_PROF_BEGIN(NCOMM_PZ_PARSER); // recorded for accepted packets only
+
     // Need at least SOF + fixed header + CRC
     if (rxlen < 10) return false;
 
@@ -148,6 +193,7 @@ static bool try_parse_packet(uint8_t* out_type, uint8_t* out_flags, uint8_t* out
     // consume packet
     memmove(rxbuf, rxbuf + total, rxlen - total);
     rxlen -= total;
+    NCOMM_PROF_END(NCOMM_PZ_PARSER);
     return true;
 }
 
@@ -162,14 +208,9 @@ static int16_t gen_sample_sine(uint32_t n) {
     return (int16_t)(s * 12000.0f);
 }
 
-static uint8_t compute_vad_stub(const int16_t* pcm, uint16_t n) {
-    // simple energy threshold
-    uint32_t acc = 0;
-    for (uint16_t i = 0; i < n; i++) {
-        int32_t x = pcm[i];
-        acc += (uint32_t)(x < 0 ? -x : x);
-    }
-    uint32_t avg = acc / (n ? n : 1);
+NCOMM_FAST_CODE static uint8_t compute_vad_stub(uint32_t abs_sum, uint16_t n) {
+    // simple energy threshold; sum |x| comes from the fused capture pass
+    uint32_t avg = abs_sum / (n ? n : 1);
     return (avg > 800) ? 1 : 0;
 }
 
@@ -179,15 +220,221 @@ static void send_info(void) {
     ncomm_uart_send(NCOMM_VER, EVT_INFO, 0x00, (const uint8_t*)msg, (uint16_t)sizeof(msg)-1);
 }
 
-static void send_vad_status(uint8_t vad_now) {
-    // EVT_VAD_STATUS payload (example: 4 bytes)
-    // [0]=vad_state [1]=true_run [2]=false_run [3]=reserved
-    uint8_t p[4] = { vad_now, g.vad_true_run, g.vad_false_run, 0 };
-    ncomm_uart_send(NCOMM_VER, EVT_VAD_STATUS, 0x00, p, sizeof(p));
+static char* u32_to_dec(char* out, uint32_t v) {
+    char tmp[11];
+    int n = 0;
+    if (v == 0) { *out++ = '0'; *out = 0; return out; }
+    while (v && n < 10) { tmp[n++] = (char)('0' + (v % 10)); v /= 10; }
+    while (n--) { *out++ = tmp[n]; }
+    *out = 0;
+    return out;
+}
+
+static void send_sched_info(void) {
+    // ascii EVT_INFO: "SCHED idle=<%*100> lat=<cycles> run=<cycles>" (last 1 s window)
+    const ncomm_sched_stats_t* st = ncomm_sched_stats();
+    char msg[64];
+    char* p = msg;
+    memcpy(p, "SCHED idle=", 11); p += 11; p = u32_to_dec(p, st->idle_x100);
+    memcpy(p, " lat=", 5); p += 5; p = u32_to_dec(p, st->lat_max);
+    memcpy(p, " run=", 5); p += 5; p = u32_to_dec(p, st->run_max);
+    ncomm_uart_send(NCOMM_VER, EVT_INFO, 0x00, (const uint8_t*)msg, (uint16_t)(p - msg));
+}
+
+static void send_stream_info(void) {
+    // ascii EVT_INFO: "STREAMS rx=<frames> tx=<frames> budget_rej=<n> in2_missing=<chunks>"
+    char msg[96];
+    char* p = msg;
+    memcpy(p, "STREAMS rx=", 11); p += 11; p = u32_to_dec(p, g.rx_frame_index);
+    memcpy(p, " tx=", 4); p += 4; p = u32_to_dec(p, g.tx_frame_index);
+    memcpy(p, " budget_rej=", 12); p += 12; p = u32_to_dec(p, g.budget_rejects);
+    memcpy(p, " in2_missing=", 13); p += 13; p = u32_to_dec(p, ncomm_pipe_stats()->rx_missing);
+    ncomm_uart_send(NCOMM_VER, EVT_INFO, 0x00, (const uint8_t*)msg, (uint16_t)(p - msg));
+}
+
+#if defined(NCOMM_PIPE_BENCH)
+static void send_pipe_bench(void) {
+    // ascii EVT_INFO: "PIPE two=<cycles> fused=<cycles>" per 16ms chunk
+    ncomm_pipe_bench_t b;
+    ncomm_pipe_bench(&b, 64);
+
+    char msg[48];
+    char* p = msg;
+    memcpy(p, "PIPE two=", 9); p += 9; p = u32_to_dec(p, b.two_pass_cycles);
+    memcpy(p, " fused=", 7); p += 7; p = u32_to_dec(p, b.fused_cycles);
+    ncomm_uart_send(NCOMM_VER, EVT_INFO, 0x00, (const uint8_t*)msg, (uint16_t)(p - msg));
+}
+#endif
+
+#if defined(NCOMM_MEM_BENCH)
+static void send_mem_bench(void) {
+    // ascii EVT_INFO: "MEM cold=<cycles> flash=<cycles> itcm=<cycles>" per chunk kernel
+    ncomm_mem_bench_t b;
+    ncomm_mem_bench(&b, 64);
+
+    char msg[64];
+    char* p = msg;
+    memcpy(p, "MEM cold=", 9); p += 9; p = u32_to_dec(p, b.flash_cold);
+    memcpy(p, " flash=", 7); p += 7; p = u32_to_dec(p, b.flash_warm);
+    memcpy(p, " itcm=", 6); p += 6; p = u32_to_dec(p, b.itcm);
+    ncomm_uart_send(NCOMM_VER, EVT_INFO, 0x00, (const uint8_t*)msg, (uint16_t)(p - msg));
+}
+#endif
+
+#if defined(NCOMM_PROFILE)
+static void send_profile_1s(void) {
+    // binary EVT_PROFILE: per-zone min/avg/max/p99 cycles over the last window
+    static uint32_t last_ms = 0;
+    const uint32_t now = HAL_GetTick();
+    if ((now - last_ms) < 1000) return;
+    const uint16_t window_ms = (uint16_t)(now - last_ms);
+    last_ms = now;
+
+    uint8_t buf[NCOMM_PROF_MAX_PAYLOAD];
+    const uint16_t len = ncomm_prof_snapshot(buf, sizeof(buf), window_ms);
+    if (len) ncomm_uart_send(NCOMM_VER, EVT_PROFILE, 0x00, buf, len);
+}
+#endif
+
+static inline void wr_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static void send_vad(uint8_t vad_now, uint32_t chunk_index) {
+    // EVT_VAD payload (8 bytes), see spec 6.2:
+    // vad_flag(1) vad_conf(1, 0 = n/a) hangover_ms(2, 0 = n/a) chunk_index(4)
+    uint8_t p[8] = { vad_now, 0, 0, 0 };
+    wr_le32(&p[4], chunk_index);
+    ncomm_uart_send(NCOMM_VER, EVT_VAD, 0x00, p, sizeof(p));
+}
+
+static uint8_t preroll_cap_chunks(void) {
+    if (g.vad_chunk_ms == 0) return 0;
+    uint16_t n = (uint16_t)(g.vad_preroll_ms / g.vad_chunk_ms);
+    return (uint8_t)((n > 64) ? 64 : n);
+}
+
+static void send_vad_map(uint32_t chunk_index, uint8_t reason) {
+    // EVT_VAD_MAP payload (28 bytes), see spec 6.3:
+    // chunk_index(4) vad_map(8) state_map(8) preroll_fill(1) preroll_cap(1)
+    // start_age(1) stop_age(1) true_run(1) false_run(1) flags(1) reserved(1)
+    uint8_t p[28];
+    wr_le32(&p[0], chunk_index);
+    wr_le32(&p[4], (uint32_t)g.vad_map);
+    wr_le32(&p[8], (uint32_t)(g.vad_map >> 32));
+    wr_le32(&p[12], (uint32_t)g.vad_state_map);
+    wr_le32(&p[16], (uint32_t)(g.vad_state_map >> 32));
+    p[20] = g.preroll_fill;
+    p[21] = preroll_cap_chunks();
+    p[22] = g.vad_start_age;
+    p[23] = g.vad_stop_age;
+    p[24] = g.vad_true_run;
+    p[25] = g.vad_false_run;
+    p[26] = (uint8_t)(g.vad_state | reason);
+    p[27] = 0;
+    ncomm_uart_send(NCOMM_VER, EVT_VAD_MAP, 0x00, p, sizeof(p));
+}
+
+#define VAD_MAP_ON_CHANGE 0x02
+#define VAD_MAP_PERIODIC  0x04
+
+static inline uint8_t age_step(uint8_t a) {
+    return (a >= 63u) ? 0xFF : (uint8_t)(a + 1u);
+}
+
+static inline uint8_t run_step(uint8_t r) {
+    return (r == 0xFF) ? r : (uint8_t)(r + 1u);
+}
+
+// O(1) per chunk: shift both maps, age the edge markers, track pre-roll fill,
+// then emit EVT_VAD / EVT_VAD_MAP only on change or by decimation.
+static void vad_update(uint8_t vad_now, uint32_t chunk_index) {
+    const uint8_t prev = g.vad_state;
+
+    if (vad_now) { g.vad_true_run = run_step(g.vad_true_run); g.vad_false_run = 0; }
+    else         { g.vad_false_run = run_step(g.vad_false_run); g.vad_true_run = 0; }
+
+    // latch state with markers
+    if (!g.vad_state && g.vad_true_run >= g.vad_start_marker) g.vad_state = 1;
+    if ( g.vad_state && g.vad_false_run >= g.vad_stop_marker) g.vad_state = 0;
+
+    g.vad_map = (g.vad_map << 1) | vad_now;
+    g.vad_state_map = (g.vad_state_map << 1) | g.vad_state;
+    g.vad_start_age = age_step(g.vad_start_age);
+    g.vad_stop_age = age_step(g.vad_stop_age);
+
+    const bool changed = (g.vad_state != prev);
+    if (changed) {
+        if (g.vad_state) g.vad_start_age = 0;
+        else g.vad_stop_age = 0;
+    }
+
+    // Pre-roll window refills while idle and is handed over at VAD start
+    if (g.vad_state) g.preroll_fill = 0;
+    else if (g.preroll_fill < preroll_cap_chunks()) g.preroll_fill++;
+
+    if (!g.vad_evt_enable) return;
+
+    const bool force = g.vad_evt_force;
+    g.vad_evt_force = 0;
+    if (changed || force) send_vad(g.vad_state, chunk_index);
+
+    g.vad_map_count = run_step(g.vad_map_count);
+    const bool periodic = g.vad_map_decim && g.vad_map_count >= g.vad_map_decim;
+    if (changed || force || periodic) {
+        send_vad_map(chunk_index, (changed || force) ? VAD_MAP_ON_CHANGE : VAD_MAP_PERIODIC);
+        g.vad_map_count = 0;
+    }
+}
+
+static inline void wr_le16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+}
+
+static void levels_clear(void) {
+    memset(g.lvl_in, 0, sizeof(g.lvl_in));
+    ncomm_playout_levels(NULL);
+    g.levels_count = 0;
+}
+
+// Accumulate the In1/In2 meters of one chunk; every levels_decim chunks send
+// EVT_AUDIO_LEVELS with all four ports (spec 6.3):
+// chunk_index(4) window_chunks(1) flags(1) reserved(2)
+// then peak(2) rms(2) for In1, In2, Out1 (radio), Out2 (headset)
+static void levels_update(const ncomm_pipe_chunk_t* c) {
+    if (!g.levels_decim) return;
+
+    for (uint8_t k = 0; k < 2; k++) {
+        const ncomm_meter_t* m = k ? &c->rx_meter : &c->mic_meter;
+        if (m->peak > g.lvl_in[k].peak) g.lvl_in[k].peak = m->peak;
+        g.lvl_in[k].sumsq += m->sumsq;
+        g.lvl_in[k].n += m->n;
+    }
+    if (++g.levels_count < g.levels_decim) return;
+
+    ncomm_meter_t out[NCOMM_OUT_COUNT];
+    ncomm_playout_levels(out);
+    const ncomm_meter_t* ports[4] = { &g.lvl_in[0], &g.lvl_in[1],
+                                      &out[NCOMM_OUT_RADIO], &out[NCOMM_OUT_HEADSET] };
+
+    uint8_t p[24];
+    wr_le32(&p[0], c->chunk_index);
+    p[4] = g.levels_count;
+    p[5] = (uint8_t)(c->rx_gated | (c->rx_missing << 1));
+    p[6] = 0;
+    p[7] = 0;
+    for (uint8_t k = 0; k < 4; k++) {
+        wr_le16(&p[8 + 4 * k], (uint16_t)ports[k]->peak);
+        wr_le16(&p[10 + 4 * k], ncomm_meter_rms(ports[k]));
+    }
+    ncomm_uart_send(NCOMM_VER, EVT_AUDIO_LEVELS, 0x00, p, sizeof(p));
+
+    memset(g.lvl_in, 0, sizeof(g.lvl_in));
+    g.levels_count = 0;
 }
 
 static void send_audio_frame(uint8_t stream_id, const int16_t* pcm, uint16_t samples) {
-    // EVT_AUDIO_FRAME payload (per spec section 6.2 audio)
+    // AUDIO_RX_FRAME / AUDIO_TX_FRAME payload (per spec section 6.2 audio)
     // We'll use:
     // u8 stream_id
     // u8 channels (1)
@@ -206,7 +453,7 @@ static void send_audio_frame(uint8_t stream_id, const int16_t* pcm, uint16_t sam
     buf[1] = 1; // mono
     buf[2] = (uint8_t)(samples & 0xFF);
     buf[3] = (uint8_t)((samples >> 8) & 0xFF);
-    uint32_t idx = g.audio_frame_index++;
+    uint32_t idx = (stream_id == STREAM_ID_TX_AUDIO_OUT) ? g.tx_frame_index++ : g.rx_frame_index++;
     buf[4] = (uint8_t)(idx & 0xFF);
     buf[5] = (uint8_t)((idx >> 8) & 0xFF);
     buf[6] = (uint8_t)((idx >> 16) & 0xFF);
@@ -214,24 +461,15 @@ static void send_audio_frame(uint8_t stream_id, const int16_t* pcm, uint16_t sam
 
     memcpy(&buf[8], pcm, pcm_bytes);
 
-    ncomm_uart_send(NCOMM_VER, EVT_AUDIO_FRAME, 0x00, buf, total);
+    const uint8_t type = (stream_id == STREAM_ID_TX_AUDIO_OUT) ? EVT_AUDIO_TX_FRAME : EVT_AUDIO_RX_FRAME;
+    ncomm_uart_send(NCOMM_VER, type, 0x00, buf, total);
 }
 
-// ===== Public API called from main.c =====
-void ncomm_app_init(void) {
-    memset(&g, 0, sizeof(g));
-    g.mode = MODE_STANDBY;
-    g.frame_samples = 256;
-    g.vad_start_marker = 3; // default (your policy)
-    g.vad_stop_marker  = 3;
-    g.vad_chunk_ms     = 16;
-    g.vad_preroll_ms   = 0;
-}
-
-void ncomm_app_tick(void) {
-    // RX bytes into rxbuf
+// ===== Event handlers (ncomm_sched) =====
+// NCOMM_EV_UART_RX: move ring bytes into rxbuf, parse and dispatch commands
+static void on_uart_rx(void) {
     uint8_t b;
-    while (uart_rx_poll_byte(&b)) {
+    while (ncomm_uart_rx_pop(&b)) {
         if (rxlen < RX_BUF_SZ) rxbuf[rxlen++] = b;
         else { rxlen = 0; } // overflow -> drop
     }
@@ -248,9 +486,18 @@ void ncomm_app_tick(void) {
                 break;
             case CMD_GET_INFO:
                 send_info();
+                send_sched_info();
+                send_stream_info();
+#if defined(NCOMM_PIPE_BENCH)
+                send_pipe_bench();
+#endif
+#if defined(NCOMM_MEM_BENCH)
+                send_mem_bench();
+#endif
                 break;
             case CMD_SET_MODE:
                 if (plen >= 8) {
+                    if (payload[0] != (uint8_t)g.mode) ncomm_playout_reset();
                     g.mode = (ncomm_mode_t)payload[0];
                     g.ptt  = payload[1];
                     g.rx_ve_enable = payload[2];
@@ -262,11 +509,37 @@ void ncomm_app_tick(void) {
                 if (plen >= 8) {
                     g.stream_rx_enable = payload[0];
                     g.stream_tx_enable = payload[1];
+                    if (payload[2] && !g.vad_evt_enable) g.vad_evt_force = 1;
                     g.vad_evt_enable   = payload[2];
                     g.frame_samples    = (uint16_t)payload[3] | ((uint16_t)payload[4] << 8);
                     if (g.frame_samples == 0) g.frame_samples = 256;
+                    // [5]=rx_rate [6]=tx_rate (0=16k, 1=8k, 2=12k); frame_samples stays in 16k units
+                    uint8_t rx_rate = sanitize_rate(payload[5]);
+                    uint8_t tx_rate = sanitize_rate(payload[6]);
+                    if (rx_rate != g.stream_rx_rate) ncomm_resampler_init_decim(&rs_rx, rx_rate);
+                    if (tx_rate != g.stream_tx_rate) ncomm_resampler_init_decim(&rs_tx, tx_rate);
+                    g.stream_rx_rate = rx_rate;
+                    g.stream_tx_rate = tx_rate;
+                    // [7]=levels_decim: EVT_AUDIO_LEVELS every N chunks, 0 = off
+                    if (payload[7] && !g.levels_decim) levels_clear();
+                    g.levels_decim = payload[7];
+                    // Spec 8.3/8.5: RX + TX together only within the link budget;
+                    // otherwise keep TX (radio / KWS source) and drop RX (ACK shows it)
+                    if (g.stream_rx_enable && g.stream_tx_enable &&
+                        stream_link_bytes(rx_rate, g.frame_samples) +
+                        stream_link_bytes(tx_rate, g.frame_samples) > LINK_AUDIO_BUDGET) {
+                        g.stream_rx_enable = 0;
+                        g.budget_rejects++;
+                    }
+                }
+                {
+                    // ACK mirrors applied values; [8] source_flags: bit0 = In2 not captured
+                    uint8_t ack[9] = { g.stream_rx_enable, g.stream_tx_enable, g.vad_evt_enable,
+                                       (uint8_t)(g.frame_samples & 0xFF), (uint8_t)(g.frame_samples >> 8),
+                                       g.stream_rx_rate, g.stream_tx_rate, g.levels_decim,
+                                       (uint8_t)(ncomm_pipe_rx_captured() ? 0 : 1) };
+                    ncomm_uart_send(NCOMM_VER, EVT_STREAMS_ACK, 0x00, ack, sizeof(ack));
                 }
-                ncomm_uart_send(NCOMM_VER, EVT_STREAMS_ACK, 0x00, NULL, 0);
                 break;
             case CMD_RESET_STATE:
                 ncomm_app_init();
@@ -278,6 +551,8 @@ void ncomm_app_tick(void) {
                     g.vad_stop_marker  = payload[1];
                     g.vad_chunk_ms     = (uint16_t)payload[2] | ((uint16_t)payload[3] << 8);
                     g.vad_preroll_ms   = (uint16_t)payload[4] | ((uint16_t)payload[5] << 8);
+                    g.vad_map_decim    = payload[6];
+                    if (g.preroll_fill > preroll_cap_chunks()) g.preroll_fill = preroll_cap_chunks();
                 }
                 ncomm_uart_send(NCOMM_VER, EVT_VAD_CONFIG_ACK, 0x00, NULL, 0);
                 break;
@@ -286,41 +561,116 @@ void ncomm_app_tick(void) {
                 break;
         }
     }
+}
 
-    // ===== Produce one 16ms chunk worth of audio each tick (simple pacing) =====
-    // MVP pacing: crude delay by SysTick time.
-    static uint32_t last_ms = 0;
-    uint32_t now = HAL_GetTick();
-    if ((now - last_ms) < 16) return;
-    last_ms = now;
+// NCOMM_EV_TICK (1 ms): synth pacing and periodic telemetry
+static void on_tick(void) {
+    // Without DMA capture the MVP generator feeds the same pipeline
+    // (SysTick pacing, MIC and RX get the same tone).
+    if (!ncomm_pipe_capture_running()) {
+        static uint32_t last_ms = 0;
+        uint32_t now = HAL_GetTick();
+        if ((now - last_ms) >= 16) {
+            last_ms = now;
+            static int16_t synth[NCOMM_PIPE_CHUNK_SAMPLES];
+            static uint32_t synth_n = 0;
+            for (uint16_t i = 0; i < NCOMM_PIPE_CHUNK_SAMPLES; i++) {
+                synth[i] = gen_sample_sine(synth_n++);
+            }
+            ncomm_pipe_inject(synth, synth, NCOMM_PIPE_CHUNK_SAMPLES);
+        }
+    }
 
-    // generate frame
+#if defined(NCOMM_PROFILE)
+    send_profile_1s();
+#endif
+}
+
+// One 16 ms chunk: VAD, local playout, link streaming
+static void process_chunk(const ncomm_pipe_chunk_t* c) {
     uint16_t N = g.frame_samples;
-    if (N > 256) N = 256; // MVP cap for buffer
-    static int16_t pcm[256];
-    for (uint16_t i = 0; i < N; i++) {
-        pcm[i] = gen_sample_sine(g.audio_frame_index * N + i);
-    }
+    if (N > c->samples) N = c->samples; // MVP cap for buffer
 
     // VAD stub always computed on "MIC_RAW conceptual"
-    uint8_t vad_now = compute_vad_stub(pcm, N);
-    if (vad_now) { g.vad_true_run++; g.vad_false_run = 0; }
-    else         { g.vad_false_run++; g.vad_true_run = 0; }
+    NCOMM_PROF_BEGIN(NCOMM_PZ_VAD);
+    uint8_t vad_now = compute_vad_stub(c->mic_abs_sum, c->samples);
+    NCOMM_PROF_END(NCOMM_PZ_VAD);
 
-    // latch state with markers
-    if (!g.vad_state && g.vad_true_run >= g.vad_start_marker) g.vad_state = 1;
-    if ( g.vad_state && g.vad_false_run >= g.vad_stop_marker) g.vad_state = 0;
+    vad_update(vad_now, c->chunk_index);
+
+    // playout below only queues; Out1/Out2 levels lag In1/In2 by the jitter buffer depth
+    levels_update(c);
+
+    // local playout (16 kHz, independent of link rate):
+    // TX+PTT: In1 -> radio; RX/STANDBY: In2 -> headset monitor
+    if (g.mode == MODE_TX && g.ptt) {
+        ncomm_playout_write(NCOMM_OUT_RADIO, c->mic, c->samples);
+    } else if (g.mode != MODE_TX) {
+        ncomm_playout_write(NCOMM_OUT_HEADSET, c->rx, c->samples);
+    }
 
-    if (g.vad_evt_enable) send_vad_status(g.vad_state);
-
-    // audio streaming rule:
-    // RX: send RX_STREAM_OUT if enabled
-    // TX: send TX_AUDIO_OUT only if stream_tx_enable && ptt==ON
-    if (g.mode == MODE_RX && g.stream_rx_enable) {
-        send_audio_frame(STREAM_ID_RX_STREAM_OUT, pcm, N);
-    } else if (g.mode == MODE_TX && g.stream_tx_enable && g.ptt) {
-        send_audio_frame(STREAM_ID_TX_AUDIO_OUT, pcm, N);
-    } else {
-        // standby: no audio frames
+    // audio streaming rule (spec 8.4), both streams may go in the same chunk:
+    // RX_STREAM_OUT (In2) if enabled, except while transmitting
+    // TX_AUDIO_OUT (In1) if enabled; in TX mode only with ptt==ON
+    // (STANDBY/RX: mic stream for KWS on MCU2)
+    // CMD_SET_STREAMS already held the pair to LINK_AUDIO_BUDGET.
+    // Lower-rate streams go through their decimator (whole chunk, so the
+    // filter history stays continuous); frame_samples is scaled to the rate.
+    const uint8_t tx_keyed = (g.mode == MODE_TX && g.ptt);
+    if (g.stream_rx_enable && !tx_keyed) {
+        static int16_t pcm_rx[NCOMM_PIPE_CHUNK_SAMPLES];
+        NCOMM_PROF_BEGIN(NCOMM_PZ_RESAMPLE);
+        uint16_t n = ncomm_resampler_process(&rs_rx, c->rx, c->samples, pcm_rx, NCOMM_PIPE_CHUNK_SAMPLES);
+        NCOMM_PROF_END(NCOMM_PZ_RESAMPLE);
+        uint16_t cap = (uint16_t)((uint32_t)N * n / c->samples);
+        send_audio_frame(STREAM_ID_RX_STREAM_OUT, pcm_rx, cap);
     }
+    if (g.stream_tx_enable && (g.mode != MODE_TX || g.ptt)) {
+        static int16_t pcm_tx[NCOMM_PIPE_CHUNK_SAMPLES];
+        NCOMM_PROF_BEGIN(NCOMM_PZ_RESAMPLE);
+        uint16_t n = ncomm_resampler_process(&rs_tx, c->mic, c->samples, pcm_tx, NCOMM_PIPE_CHUNK_SAMPLES);
+        NCOMM_PROF_END(NCOMM_PZ_RESAMPLE);
+        uint16_t cap = (uint16_t)((uint32_t)N * n / c->samples);
+        send_audio_frame(STREAM_ID_TX_AUDIO_OUT, pcm_tx, cap);
+    }
+}
+
+// NCOMM_EV_AUDIO: capture half ready (DFSDM DMA or injected)
+static void on_audio(void) {
+    ncomm_pipe_chunk_t chunk;
+    while (ncomm_pipe_poll(&chunk)) process_chunk(&chunk);
+}
+
+// ===== Public API (ncomm_app.h) =====
+void ncomm_app_init(void) {
+    memset(&g, 0, sizeof(g));
+    g.mode = MODE_STANDBY;
+    g.frame_samples = 256;
+    g.vad_start_marker = 3; // default (your policy)
+    g.vad_stop_marker  = 3;
+    g.vad_chunk_ms     = 16;
+    g.vad_preroll_ms   = 160;
+    g.vad_start_age    = 0xFF;
+    g.vad_stop_age     = 0xFF;
+    g.stream_rx_rate   = NCOMM_RATE_16K;
+    g.stream_tx_rate   = NCOMM_RATE_16K;
+
+    ncomm_resampler_init_decim(&rs_rx, g.stream_rx_rate);
+    ncomm_resampler_init_decim(&rs_tx, g.stream_tx_rate);
+#if defined(NCOMM_PROFILE)
+    ncomm_prof_init();
+#endif
+    ncomm_pipe_init();
+    // In1 on DFSDM1 filter0. In2 has no DFSDM filter/channel in dfsdm.c yet
+    // (pin not assigned on this board): RX_STREAM_OUT and the headset monitor
+    // carry silence. MCU2 sees it in EVT_STREAMS_ACK source_flags and the
+    // EVT_AUDIO_LEVELS flags, and the chunks count as in2_missing. If the DMA
+    // does not start, the MVP generator feeds the pipeline instead.
+    (void)ncomm_pipe_start_capture(&hdfsdm1_filter0, NULL);
+    ncomm_playout_init(&hi2s2); // starts once; later calls only reset
+    ncomm_playout_reset();
+
+    ncomm_sched_register(NCOMM_EV_AUDIO, on_audio);
+    ncomm_sched_register(NCOMM_EV_UART_RX, on_uart_rx);
+    ncomm_sched_register(NCOMM_EV_TICK, on_tick);
 }
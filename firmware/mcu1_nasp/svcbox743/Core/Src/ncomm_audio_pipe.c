@@ -0,0 +1,420 @@
+#include "ncomm_audio_pipe.h"
+
+#include <string.h>
+
+#include "ncomm/ncomm_mem.h"
+#include "ncomm/ncomm_profile.h"
+#include "ncomm_sched.h"
+
+#define CHUNK NCOMM_PIPE_CHUNK_SAMPLES
+
+// In1 DC-block high-pass: y = x - x1 + a*y1, a = 0.995 (fc ~13 Hz @ 16 kHz)
+#define HP_A_Q15 32604
+
+#define RX_GAIN_Q12_DEFAULT 4096
+#define RX_GATE_DEFAULT     104   // avg |x| at -50 dBFS
+
+// Half buffer ready bits
+#define READY_MIC 0x01u
+#define READY_RX  0x02u
+
+// ===== Buffers =====
+// Landing zones: D2 SRAM. Work buffers: DTCM (no cache, single cycle).
+static int32_t s_land_mic[2 * CHUNK] NCOMM_DMA_BUF;
+static int32_t s_land_rx[2 * CHUNK]  NCOMM_DMA_BUF;
+
+static int16_t s_mic_w[CHUNK] NCOMM_FAST_DATA;
+static int16_t s_rx_w[CHUNK]  NCOMM_FAST_DATA;
+
+// Capture DMA (DFSDM -> D2), outside `s` so a re-init never clears a
+// handle the HAL is still using
+static DMA_HandleTypeDef s_hdma_mic;
+static DMA_HandleTypeDef s_hdma_rx;
+
+// ===== State =====
+static struct {
+    DFSDM_Filter_HandleTypeDef* mic_flt;
+    DFSDM_Filter_HandleTypeDef* rx_flt;
+    bool running;
+
+    volatile uint8_t half_ready[2];
+    uint8_t ready_mask;
+    uint8_t next_half;
+    uint8_t inject_half;
+
+    // In1 HPF state
+    int32_t hp_x1;
+    int32_t hp_y1;
+
+    // In2 gain / gate
+    int32_t rx_gain_q12;
+    uint32_t rx_gate_level;
+    bool rx_gate_closed;
+
+    uint32_t chunk_index;
+    ncomm_pipe_stats_t stats;
+} s;
+
+// ===== Helpers =====
+static inline int16_t sat16(int32_t v) {
+#if defined(__ARM_FEATURE_SAT)
+    return (int16_t)__SSAT(v, 16);
+#else
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+#endif
+}
+
+static inline uint32_t abs16(int16_t v) {
+    return (uint32_t)(v < 0 ? -(int32_t)v : (int32_t)v);
+}
+
+static void mark_ready(uint8_t half, uint8_t bit) {
+    if (s.half_ready[half] & bit) s.stats.overruns++;
+    s.half_ready[half] |= bit;
+    if ((s.half_ready[half] & s.ready_mask) == s.ready_mask) ncomm_sched_post(NCOMM_EV_AUDIO);
+}
+
+// ===== Fused single pass =====
+// One loop over both channels: conversion, In1 HPF + clip, In2 gain + gate,
+// VAD energy and peak/RMS meters for both. Each landing word is read once,
+// each DTCM word written once. Two samples per iteration so the meters run on
+// packed pairs (n is even).
+NCOMM_FAST_CODE static void process_fused(const int32_t* mic_raw, const int32_t* rx_raw, uint16_t n,
+                          int16_t* mic_w, int16_t* rx_w, ncomm_pipe_chunk_t* out) {
+    int32_t hp_x1 = s.hp_x1;
+    int32_t hp_y1 = s.hp_y1;
+    const int32_t gain = s.rx_gain_q12;
+    const bool gate = s.rx_gate_closed;
+
+    uint32_t mic_acc = 0;
+    uint32_t rx_acc = 0;
+    uint32_t mic_pk2 = 0, rx_pk2 = 0;
+    int64_t mic_ss = 0, rx_ss = 0;
+
+    for (uint16_t i = 0; i < n; i += 2) {
+        int16_t m[2];
+        int16_t r[2];
+        for (uint16_t k = 0; k < 2; k++) {
+            const int32_t x = mic_raw[i + k] >> NCOMM_PIPE_RAW_SHIFT;
+            const int32_t y = x - hp_x1 + (int32_t)(((int64_t)HP_A_Q15 * hp_y1) >> 15);
+            hp_x1 = x;
+            hp_y1 = y;
+            m[k] = sat16(y);
+            mic_w[i + k] = m[k];
+            mic_acc += abs16(m[k]);
+
+            r[k] = sat16(((rx_raw[i + k] >> NCOMM_PIPE_RAW_SHIFT) * gain) >> 12);
+            rx_acc += abs16(r[k]); // measured before the gate so it can reopen
+            rx_w[i + k] = gate ? 0 : r[k];
+        }
+
+        const uint32_t mp = ncomm_meter_pack(m[0], m[1]);
+        const uint32_t rp = ncomm_meter_pack(r[0], r[1]);
+        mic_pk2 = ncomm_meter_pk2(mic_pk2, mp);
+        mic_ss = ncomm_meter_ss2(mic_ss, mp);
+        rx_pk2 = ncomm_meter_pk2(rx_pk2, rp);
+        rx_ss = ncomm_meter_ss2(rx_ss, rp);
+    }
+
+    memset(&out->mic_meter, 0, sizeof(out->mic_meter));
+    memset(&out->rx_meter, 0, sizeof(out->rx_meter));
+    ncomm_meter_add(&out->mic_meter, mic_pk2, mic_ss, n);
+    ncomm_meter_add(&out->rx_meter, rx_pk2, rx_ss, n);
+
+    s.hp_x1 = hp_x1;
+    s.hp_y1 = hp_y1;
+
+    // Gate decision applies from the next chunk (no second pass over rx).
+    // Reopen at +6 dB above the close level (hysteresis).
+    const uint32_t rx_avg = rx_acc / n;
+    if (s.rx_gate_closed) {
+        if (rx_avg >= 2u * s.rx_gate_level) s.rx_gate_closed = false;
+    } else {
+        if (rx_avg < s.rx_gate_level) s.rx_gate_closed = true;
+    }
+
+    out->mic = mic_w;
+    out->rx = rx_w;
+    out->samples = n;
+    out->mic_abs_sum = mic_acc;
+    out->rx_abs_sum = rx_acc;
+    out->rx_gated = gate ? 1 : 0;
+}
+
+static uint32_t dfsdm_dma_request(const DFSDM_Filter_HandleTypeDef* flt) {
+    if (flt->Instance == DFSDM1_Filter1) return DMA_REQUEST_DFSDM1_FLT1;
+    if (flt->Instance == DFSDM1_Filter2) return DMA_REQUEST_DFSDM1_FLT2;
+    if (flt->Instance == DFSDM1_Filter3) return DMA_REQUEST_DFSDM1_FLT3;
+    return DMA_REQUEST_DFSDM1_FLT0;
+}
+
+// Circular word DMA from the filter's regular data register (clock:
+// MX_DMA_Init). Cube leaves regular DMA off (DmaMode) and RDMAEN is only
+// writable with the filter disabled.
+static bool dma_setup(DFSDM_Filter_HandleTypeDef* flt, DMA_HandleTypeDef* hdma,
+                      DMA_Stream_TypeDef* stream, IRQn_Type irq) {
+    hdma->Instance = stream;
+    hdma->Init.Request = dfsdm_dma_request(flt);
+    hdma->Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma->Init.Mode = DMA_CIRCULAR;
+    hdma->Init.Priority = DMA_PRIORITY_HIGH;
+    hdma->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(hdma) != HAL_OK) return false;
+    __HAL_LINKDMA(flt, hdmaReg, *hdma);
+
+    if (!(flt->Instance->FLTCR1 & DFSDM_FLTCR1_RDMAEN)) {
+        flt->Instance->FLTCR1 &= ~DFSDM_FLTCR1_DFEN;
+        flt->Instance->FLTCR1 |= DFSDM_FLTCR1_RDMAEN;
+        flt->Instance->FLTCR1 |= DFSDM_FLTCR1_DFEN;
+        flt->Init.RegularParam.DmaMode = ENABLE;
+    }
+
+    HAL_NVIC_SetPriority(irq, 1, 0);
+    HAL_NVIC_EnableIRQ(irq);
+    return true;
+}
+
+// ===== Public API =====
+void ncomm_pipe_init(void) {
+    __HAL_RCC_D2SRAM1_CLK_ENABLE();
+    __HAL_RCC_D2SRAM2_CLK_ENABLE();
+
+    // Re-init (CMD_RESET_STATE): no DMA may write the landing zones or the
+    // ready bits while they are cleared
+    ncomm_pipe_stop_capture();
+
+    memset(&s, 0, sizeof(s));
+    memset(s_land_mic, 0, sizeof(s_land_mic));
+    memset(s_land_rx, 0, sizeof(s_land_rx));
+    SCB_CleanDCache_by_Addr((uint32_t*)s_land_mic, sizeof(s_land_mic));
+    SCB_CleanDCache_by_Addr((uint32_t*)s_land_rx, sizeof(s_land_rx));
+
+    s.rx_gain_q12 = RX_GAIN_Q12_DEFAULT;
+    s.rx_gate_level = RX_GATE_DEFAULT;
+    s.ready_mask = READY_MIC | READY_RX;
+}
+
+bool ncomm_pipe_start_capture(DFSDM_Filter_HandleTypeDef* mic, DFSDM_Filter_HandleTypeDef* rx) {
+    if (!mic) return false;
+
+    s.mic_flt = mic;
+    s.rx_flt = rx;
+    s.half_ready[0] = s.half_ready[1] = 0;
+    s.next_half = 0;
+    s.ready_mask = READY_MIC | (rx ? READY_RX : 0);
+
+    if (!dma_setup(mic, &s_hdma_mic, DMA1_Stream0, DMA1_Stream0_IRQn)) return false;
+    if (rx && !dma_setup(rx, &s_hdma_rx, DMA1_Stream2, DMA1_Stream2_IRQn)) return false;
+
+    if (HAL_DFSDM_FilterRegularStart_DMA(mic, s_land_mic, 2 * CHUNK) != HAL_OK) return false;
+    if (rx && HAL_DFSDM_FilterRegularStart_DMA(rx, s_land_rx, 2 * CHUNK) != HAL_OK) {
+        (void)HAL_DFSDM_FilterRegularStop_DMA(mic);
+        return false;
+    }
+
+    s.running = true;
+    return true;
+}
+
+void ncomm_pipe_stop_capture(void) {
+    if (!s.running) return;
+    (void)HAL_DFSDM_FilterRegularStop_DMA(s.mic_flt);
+    if (s.rx_flt) (void)HAL_DFSDM_FilterRegularStop_DMA(s.rx_flt);
+    s.running = false;
+}
+
+bool ncomm_pipe_capture_running(void) {
+    return s.running;
+}
+
+bool ncomm_pipe_rx_captured(void) {
+    return !s.running || s.rx_flt != NULL;
+}
+
+void ncomm_pipe_dma_irq(uint8_t rx) {
+    HAL_DMA_IRQHandler(rx ? &s_hdma_rx : &s_hdma_mic);
+}
+
+void ncomm_pipe_inject(const int16_t* mic, const int16_t* rx, uint16_t n) {
+    if (s.running) return;
+    if (n > CHUNK) n = CHUNK;
+
+    const uint8_t half = s.inject_half;
+    int32_t* dm = &s_land_mic[half * CHUNK];
+    int32_t* dr = &s_land_rx[half * CHUNK];
+    for (uint16_t i = 0; i < CHUNK; i++) {
+        const int32_t vm = (i < n && mic) ? mic[i] : 0;
+        const int32_t vr = (i < n && rx) ? rx[i] : 0;
+        dm[i] = (int32_t)((uint32_t)vm << NCOMM_PIPE_RAW_SHIFT);
+        dr[i] = (int32_t)((uint32_t)vr << NCOMM_PIPE_RAW_SHIFT);
+    }
+    // Push to D2 so the consumer's invalidate sees what the "DMA" wrote
+    SCB_CleanDCache_by_Addr((uint32_t*)dm, CHUNK * sizeof(int32_t));
+    SCB_CleanDCache_by_Addr((uint32_t*)dr, CHUNK * sizeof(int32_t));
+
+    mark_ready(half, READY_MIC | READY_RX);
+    s.inject_half ^= 1;
+}
+
+bool ncomm_pipe_poll(ncomm_pipe_chunk_t* out) {
+    const uint8_t half = s.next_half;
+    if ((s.half_ready[half] & s.ready_mask) != s.ready_mask) return false;
+
+    const int32_t* mic_raw = &s_land_mic[half * CHUNK];
+    const int32_t* rx_raw = &s_land_rx[half * CHUNK];
+
+    const uint32_t t0 = ncomm_cycles_now();
+
+    SCB_InvalidateDCache_by_Addr((void*)mic_raw, CHUNK * sizeof(int32_t));
+    SCB_InvalidateDCache_by_Addr((void*)rx_raw, CHUNK * sizeof(int32_t));
+
+    process_fused(mic_raw, rx_raw, CHUNK, s_mic_w, s_rx_w, out);
+
+    const uint32_t dt = ncomm_cycles_now() - t0;
+#if defined(NCOMM_PROFILE)
+    ncomm_prof_record(NCOMM_PZ_VE, dt);
+#endif
+
+    __disable_irq();
+    s.half_ready[half] = 0;
+    __enable_irq();
+    s.next_half ^= 1;
+
+    out->chunk_index = s.chunk_index++;
+    out->cycles = dt;
+    out->rx_missing = ncomm_pipe_rx_captured() ? 0 : 1;
+
+    s.stats.chunks++;
+    if (out->rx_missing) s.stats.rx_missing++;
+    s.stats.cycles_last = dt;
+    if (dt > s.stats.cycles_max) s.stats.cycles_max = dt;
+    return true;
+}
+
+void ncomm_pipe_set_rx_gain(uint16_t gain_q12, uint16_t gate_avg_abs) {
+    s.rx_gain_q12 = gain_q12;
+    s.rx_gate_level = gate_avg_abs;
+}
+
+const ncomm_pipe_stats_t* ncomm_pipe_stats(void) {
+    return &s.stats;
+}
+
+// ===== DMA callbacks (DFSDM regular conversion, circular) =====
+void HAL_DFSDM_FilterRegConvHalfCpltCallback(DFSDM_Filter_HandleTypeDef* hdfsdm_filter) {
+    if (hdfsdm_filter == s.mic_flt) mark_ready(0, READY_MIC);
+    else if (hdfsdm_filter == s.rx_flt) mark_ready(0, READY_RX);
+}
+
+void HAL_DFSDM_FilterRegConvCpltCallback(DFSDM_Filter_HandleTypeDef* hdfsdm_filter) {
+    if (hdfsdm_filter == s.mic_flt) mark_ready(1, READY_MIC);
+    else if (hdfsdm_filter == s.rx_flt) mark_ready(1, READY_RX);
+}
+
+#if defined(NCOMM_PIPE_BENCH)
+// ===== Bench: legacy multi-pass vs fused =====
+// "Before": each channel handled on its own, conversion into an AXI-SRAM
+// int16 buffer, then filter/gain in place, then a separate VAD energy pass.
+static int16_t s_bench_mic_d1[CHUNK] __attribute__((aligned(32)));
+static int16_t s_bench_rx_d1[CHUNK]  __attribute__((aligned(32)));
+
+static uint32_t bench_two_pass(const int32_t* mic_raw, const int32_t* rx_raw) {
+    int32_t hp_x1 = 0, hp_y1 = 0;
+    uint32_t acc;
+
+    // MIC: convert
+    SCB_InvalidateDCache_by_Addr((void*)mic_raw, CHUNK * sizeof(int32_t));
+    for (uint16_t i = 0; i < CHUNK; i++) s_bench_mic_d1[i] = sat16(mic_raw[i] >> NCOMM_PIPE_RAW_SHIFT);
+    // MIC: HPF + clip
+    for (uint16_t i = 0; i < CHUNK; i++) {
+        const int32_t x = s_bench_mic_d1[i];
+        const int32_t y = x - hp_x1 + (int32_t)(((int64_t)HP_A_Q15 * hp_y1) >> 15);
+        hp_x1 = x;
+        hp_y1 = y;
+        s_bench_mic_d1[i] = sat16(y);
+    }
+    // MIC: VAD energy
+    acc = 0;
+    for (uint16_t i = 0; i < CHUNK; i++) acc += abs16(s_bench_mic_d1[i]);
+    uint32_t sink = acc;
+
+    // RX: convert
+    SCB_InvalidateDCache_by_Addr((void*)rx_raw, CHUNK * sizeof(int32_t));
+    for (uint16_t i = 0; i < CHUNK; i++) s_bench_rx_d1[i] = sat16(rx_raw[i] >> NCOMM_PIPE_RAW_SHIFT);
+    // RX: gain
+    for (uint16_t i = 0; i < CHUNK; i++) s_bench_rx_d1[i] = sat16((s_bench_rx_d1[i] * s.rx_gain_q12) >> 12);
+    // RX: level + gate
+    acc = 0;
+    for (uint16_t i = 0; i < CHUNK; i++) acc += abs16(s_bench_rx_d1[i]);
+    if (acc / CHUNK < s.rx_gate_level) memset(s_bench_rx_d1, 0, sizeof(s_bench_rx_d1));
+
+    return sink + acc;
+}
+
+// Private landing zones (D2, like the DMA targets) and DTCM work buffers,
+// filled with a synthetic mic tone + rx noise
+static int32_t s_bench_land_mic[2 * CHUNK] NCOMM_DMA_BUF;
+static int32_t s_bench_land_rx[2 * CHUNK]  NCOMM_DMA_BUF;
+static int16_t s_bench_mic_w[CHUNK] NCOMM_FAST_DATA;
+static int16_t s_bench_rx_w[CHUNK]  NCOMM_FAST_DATA;
+
+static void bench_fill(void) {
+    uint32_t seed = 0x50495045u;
+    for (uint16_t i = 0; i < 2 * CHUNK; i++) {
+        // 500 Hz triangle mic at -12 dBFS peak, rx noise at ~-36 dBFS peak
+        const int32_t ph = (int32_t)(i % 32u) - 16;
+        const int32_t vm = (ph < 0 ? -ph : ph) * 1024 - 8192;
+        seed = seed * 1664525u + 1013904223u;
+        const int32_t vr = (int32_t)(seed >> 22) - 512;
+        s_bench_land_mic[i] = (int32_t)((uint32_t)vm << NCOMM_PIPE_RAW_SHIFT);
+        s_bench_land_rx[i] = (int32_t)((uint32_t)vr << NCOMM_PIPE_RAW_SHIFT);
+    }
+    SCB_CleanDCache_by_Addr((uint32_t*)s_bench_land_mic, sizeof(s_bench_land_mic));
+    SCB_CleanDCache_by_Addr((uint32_t*)s_bench_land_rx, sizeof(s_bench_land_rx));
+}
+
+void ncomm_pipe_bench(ncomm_pipe_bench_t* out, uint16_t iterations) {
+    if (!out) return;
+    if (iterations == 0) iterations = 1;
+
+    bench_fill();
+
+    // The fused pass carries HPF/gate state in `s`: save and restore it
+    const int32_t hp_x1 = s.hp_x1, hp_y1 = s.hp_y1;
+    const bool gate = s.rx_gate_closed;
+
+    uint64_t t_two = 0, t_fused = 0;
+    volatile uint32_t sink = 0;
+    ncomm_pipe_chunk_t chunk;
+
+    for (uint16_t it = 0; it < iterations; it++) {
+        const int32_t* mic_raw = &s_bench_land_mic[(it & 1) * CHUNK];
+        const int32_t* rx_raw = &s_bench_land_rx[(it & 1) * CHUNK];
+
+        uint32_t t0 = ncomm_cycles_now();
+        sink += bench_two_pass(mic_raw, rx_raw);
+        t_two += ncomm_cycles_now() - t0;
+
+        t0 = ncomm_cycles_now();
+        SCB_InvalidateDCache_by_Addr((void*)mic_raw, CHUNK * sizeof(int32_t));
+        SCB_InvalidateDCache_by_Addr((void*)rx_raw, CHUNK * sizeof(int32_t));
+        process_fused(mic_raw, rx_raw, CHUNK, s_bench_mic_w, s_bench_rx_w, &chunk);
+        t_fused += ncomm_cycles_now() - t0;
+        sink += chunk.mic_abs_sum;
+    }
+    (void)sink;
+
+    s.hp_x1 = hp_x1;
+    s.hp_y1 = hp_y1;
+    s.rx_gate_closed = gate;
+
+    out->two_pass_cycles = (uint32_t)(t_two / iterations);
+    out->fused_cycles = (uint32_t)(t_fused / iterations);
+}
+#endif // NCOMM_PIPE_BENCH
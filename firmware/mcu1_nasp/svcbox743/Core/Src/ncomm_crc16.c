@@ -1,7 +1,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
-uint16_t ncomm_crc16_ccitt_false(const uint8_t* data, size_t len) {
+#include "ncomm/ncomm_mem.h"
+
+NCOMM_FAST_CODE uint16_t ncomm_crc16_ccitt_false(const uint8_t* data, size_t len) {
     uint16_t crc = 0xFFFF;
     for (size_t i = 0; i < len; i++) {
         crc ^= (uint16_t)data[i] << 8;
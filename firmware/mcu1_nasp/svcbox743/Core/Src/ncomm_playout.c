@@ -0,0 +1,258 @@
+#include "ncomm_playout.h"
+
+#include <string.h>
+
+#include "ncomm/ncomm_mem.h"
+#include "ncomm/ncomm_profile.h"
+
+#define PERIOD NCOMM_PLAYOUT_PERIOD
+
+// ===== Jitter buffer =====
+// SPSC ring per output: main loop writes whole chunks, DMA ISR reads periods.
+#define JB_CAP  1024u            // 4 chunks, power of two
+#define JB_MASK (JB_CAP - 1u)
+// Hard depth bound: ring fill + DMA queue (2 periods) never exceeds 2 chunks.
+// The writer drops what does not fit; trimming alone cannot shed a backlog fast.
+#define JB_DEPTH_MAX (512u - 2u * PERIOD)
+
+// Adaptive depth: keep the minimum fill (sampled after each period) near
+// `margin`. Underrun -> grow margin; a quiet window with surplus -> trim one
+// sample per period until the surplus is gone; long stable runs -> shrink.
+#define MARGIN_MIN      32u
+#define MARGIN_MAX      128u
+#define MARGIN_STEP_UP  32u
+#define MARGIN_STEP_DN  16u
+#define TRIM_HYST       32u
+#define WINDOW_PERIODS  250u     // 1 s
+#define STABLE_WINDOWS  10u
+
+typedef struct {
+    int16_t buf[JB_CAP];
+    volatile uint32_t wr;        // producer index (main)
+    volatile uint32_t rd;        // consumer index (ISR)
+
+    // consumer-owned
+    bool primed;
+    uint16_t margin;
+    uint16_t trim_budget;
+    uint16_t win_min;
+    uint16_t win_max;
+    uint16_t win_periods;
+    uint16_t stable_windows;
+    bool win_underrun;
+} jbuf_t;
+
+static jbuf_t s_jb[NCOMM_OUT_COUNT];
+
+// DMA: [half][frame][L,R] 32-bit slots
+static int32_t s_dma[2 * PERIOD * 2] NCOMM_DMA_BUF;
+
+static DMA_HandleTypeDef s_hdma_tx;
+static I2S_HandleTypeDef* s_hi2s = NULL;
+static bool s_started = false;
+static ncomm_playout_stats_t s_stats;
+
+// Output level meters, accumulated by the ISR, taken by ncomm_playout_levels()
+static ncomm_meter_t s_meter[NCOMM_OUT_COUNT];
+
+static void jb_reset(jbuf_t* jb) {
+    jb->rd = jb->wr;
+    jb->primed = false;
+    jb->margin = MARGIN_MIN;
+    jb->trim_budget = 0;
+    jb->win_min = 0xFFFF;
+    jb->win_max = 0;
+    jb->win_periods = 0;
+    jb->stable_windows = 0;
+    jb->win_underrun = false;
+}
+
+// ISR: take up to PERIOD samples from jb into out[] (stride 2 = one slot).
+// The output meter runs on the same pass (padding counts as silence).
+NCOMM_FAST_CODE static void jb_read_period(jbuf_t* jb, ncomm_playout_ch_stats_t* st, ncomm_meter_t* meter,
+                                           int32_t* out) {
+    uint32_t rd = jb->rd;
+    uint32_t fill = jb->wr - rd;
+
+    if (!jb->primed) {
+        // Start (or restart after running dry) only once margin + one period is queued
+        if (fill < (uint32_t)jb->margin + PERIOD) {
+            for (uint16_t i = 0; i < PERIOD; i++) out[2 * i] = 0;
+            meter->n += PERIOD;
+            return;
+        }
+        jb->primed = true;
+    }
+
+    // Adaptive trim: drop one sample per period while surplus remains
+    if (jb->trim_budget && fill > PERIOD + 1u) {
+        rd++;
+        fill--;
+        jb->trim_budget--;
+        st->trims++;
+    }
+
+    const uint32_t avail = (fill < PERIOD) ? fill : PERIOD;
+    uint32_t pk2 = 0;
+    int64_t ss = 0;
+    uint32_t i = 0;
+    for (; i + 1u < avail; i += 2) {
+        const int16_t a = jb->buf[(rd + i) & JB_MASK];
+        const int16_t b = jb->buf[(rd + i + 1u) & JB_MASK];
+        out[2 * i] = (int32_t)((uint32_t)(uint16_t)a << 16);
+        out[2 * i + 2] = (int32_t)((uint32_t)(uint16_t)b << 16);
+        const uint32_t pair = ncomm_meter_pack(a, b);
+        pk2 = ncomm_meter_pk2(pk2, pair);
+        ss = ncomm_meter_ss2(ss, pair);
+    }
+    ncomm_meter_add(meter, pk2, ss, i);
+    if (i < avail) {
+        const int16_t a = jb->buf[(rd + i) & JB_MASK];
+        out[2 * i] = (int32_t)((uint32_t)(uint16_t)a << 16);
+        ncomm_meter_add1(meter, a);
+    }
+    for (i = avail; i < PERIOD; i++) out[2 * i] = 0;
+    meter->n += PERIOD - avail;
+    rd += avail;
+    __DMB();
+    jb->rd = rd;
+
+    if (avail < PERIOD) {
+        st->underruns += PERIOD - avail;
+        jb->win_underrun = true;
+        jb->primed = false;
+        jb->trim_budget = 0;
+        jb->margin = (uint16_t)((jb->margin + MARGIN_STEP_UP > MARGIN_MAX) ? MARGIN_MAX : jb->margin + MARGIN_STEP_UP);
+    }
+
+    const uint16_t left = (uint16_t)(fill - avail);
+    if (left < jb->win_min) jb->win_min = left;
+    if (fill > jb->win_max) jb->win_max = (uint16_t)fill;
+
+    if (++jb->win_periods >= WINDOW_PERIODS) {
+        st->fill_min = (jb->win_min == 0xFFFF) ? 0 : jb->win_min;
+        st->latency_max = (uint16_t)(jb->win_max + 2u * PERIOD);
+
+        if (jb->win_underrun) {
+            jb->stable_windows = 0;
+        } else {
+            if (jb->win_min != 0xFFFF && jb->win_min > jb->margin + TRIM_HYST) {
+                jb->trim_budget = (uint16_t)(jb->win_min - jb->margin);
+            }
+            if (++jb->stable_windows >= STABLE_WINDOWS) {
+                jb->stable_windows = 0;
+                if (jb->margin >= MARGIN_MIN + MARGIN_STEP_DN) jb->margin = (uint16_t)(jb->margin - MARGIN_STEP_DN);
+            }
+        }
+        st->margin = jb->margin;
+
+        jb->win_min = 0xFFFF;
+        jb->win_max = 0;
+        jb->win_periods = 0;
+        jb->win_underrun = false;
+    }
+}
+
+// ISR: render one DMA half (16-bit PCM -> 32-bit I2S slots, MSB aligned)
+NCOMM_FAST_CODE static void render_half(uint8_t half) {
+    NCOMM_PROF_BEGIN(NCOMM_PZ_PLAYOUT);
+    int32_t* dst = &s_dma[half * PERIOD * 2];
+    jb_read_period(&s_jb[NCOMM_OUT_RADIO], &s_stats.ch[NCOMM_OUT_RADIO], &s_meter[NCOMM_OUT_RADIO], dst);
+    jb_read_period(&s_jb[NCOMM_OUT_HEADSET], &s_stats.ch[NCOMM_OUT_HEADSET], &s_meter[NCOMM_OUT_HEADSET], dst + 1);
+    SCB_CleanDCache_by_Addr((uint32_t*)dst, PERIOD * 2 * sizeof(int32_t));
+    s_stats.periods++;
+    NCOMM_PROF_END(NCOMM_PZ_PLAYOUT);
+}
+
+// ===== Public API =====
+bool ncomm_playout_init(I2S_HandleTypeDef* hi2s) {
+    if (s_started) return true;
+    if (!hi2s) return false;
+    s_hi2s = hi2s;
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    memset(s_meter, 0, sizeof(s_meter));
+    for (uint8_t c = 0; c < NCOMM_OUT_COUNT; c++) {
+        memset(&s_jb[c], 0, sizeof(s_jb[c]));
+        jb_reset(&s_jb[c]);
+        s_stats.ch[c].margin = s_jb[c].margin;
+    }
+    memset(s_dma, 0, sizeof(s_dma));
+    SCB_CleanDCache_by_Addr((uint32_t*)s_dma, sizeof(s_dma));
+
+    // SPI2_TX on DMA1 Stream1, circular, 32-bit both sides (clock: MX_DMA_Init)
+    s_hdma_tx.Instance = DMA1_Stream1;
+    s_hdma_tx.Init.Request = DMA_REQUEST_SPI2_TX;
+    s_hdma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    s_hdma_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    s_hdma_tx.Init.MemInc = DMA_MINC_ENABLE;
+    s_hdma_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    s_hdma_tx.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    s_hdma_tx.Init.Mode = DMA_CIRCULAR;
+    s_hdma_tx.Init.Priority = DMA_PRIORITY_HIGH;
+    s_hdma_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&s_hdma_tx) != HAL_OK) return false;
+    __HAL_LINKDMA(hi2s, hdmatx, s_hdma_tx);
+
+    HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+
+    // Size is in 32-bit data items for I2S_DATAFORMAT_32B
+    if (HAL_I2S_Transmit_DMA(hi2s, (uint16_t*)s_dma, (uint16_t)(2 * PERIOD * 2)) != HAL_OK) return false;
+
+    s_started = true;
+    return true;
+}
+
+void ncomm_playout_reset(void) {
+    __disable_irq();
+    for (uint8_t c = 0; c < NCOMM_OUT_COUNT; c++) jb_reset(&s_jb[c]);
+    __enable_irq();
+}
+
+void ncomm_playout_write(ncomm_out_t ch, const int16_t* pcm, uint16_t n) {
+    if (ch >= NCOMM_OUT_COUNT || !pcm || !s_started) return;
+    jbuf_t* jb = &s_jb[ch];
+
+    const uint32_t wr = jb->wr;
+    const uint32_t fill = wr - jb->rd;
+    const uint32_t free = (fill < JB_DEPTH_MAX) ? JB_DEPTH_MAX - fill : 0;
+    if (n > free) {
+        s_stats.ch[ch].overruns += n - free;
+        n = (uint16_t)free;
+    }
+
+    const uint32_t pos = wr & JB_MASK;
+    const uint32_t first = (n < JB_CAP - pos) ? n : JB_CAP - pos;
+    memcpy(&jb->buf[pos], pcm, first * sizeof(int16_t));
+    if (n > first) memcpy(&jb->buf[0], pcm + first, (n - first) * sizeof(int16_t));
+
+    __DMB();
+    jb->wr = wr + n;
+}
+
+const ncomm_playout_stats_t* ncomm_playout_stats(void) {
+    return &s_stats;
+}
+
+void ncomm_playout_levels(ncomm_meter_t out[NCOMM_OUT_COUNT]) {
+    __disable_irq();
+    for (uint8_t c = 0; c < NCOMM_OUT_COUNT; c++) {
+        if (out) out[c] = s_meter[c];
+        memset(&s_meter[c], 0, sizeof(s_meter[c]));
+    }
+    __enable_irq();
+}
+
+void ncomm_playout_dma_irq(void) {
+    HAL_DMA_IRQHandler(&s_hdma_tx);
+}
+
+// ===== HAL I2S callbacks =====
+void HAL_I2S_TxHalfCpltCallback(I2S_HandleTypeDef* hi2s) {
+    if (hi2s == s_hi2s) render_half(0);
+}
+
+void HAL_I2S_TxCpltCallback(I2S_HandleTypeDef* hi2s) {
+    if (hi2s == s_hi2s) render_half(1);
+}
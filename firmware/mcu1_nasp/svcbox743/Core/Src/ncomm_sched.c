@@ -0,0 +1,117 @@
+#include "ncomm_sched.h"
+
+#include <string.h>
+
+#include "main.h"
+#include "ncomm/ncomm_profile.h"
+
+static struct {
+    volatile uint32_t pending;
+    uint32_t post_cyc[NCOMM_EV_COUNT];
+    ncomm_handler_t handlers[NCOMM_EV_COUNT];
+
+    uint32_t window_ms;
+    uint32_t window_cyc;
+    uint32_t wfi_cycles;     // CYCCNT advance across WFI (0 if the core clock stops)
+    ncomm_sched_stats_t cur;
+    ncomm_sched_stats_t last;
+} s;
+
+void ncomm_sched_init(void) {
+    __disable_irq();
+    memset(&s, 0, sizeof(s));
+    __enable_irq();
+    s.window_ms = HAL_GetTick();
+    s.window_cyc = ncomm_cycles_now();
+}
+
+void ncomm_sched_register(ncomm_event_t ev, ncomm_handler_t fn) {
+    if (ev < NCOMM_EV_COUNT) s.handlers[ev] = fn;
+}
+
+void ncomm_sched_post(ncomm_event_t ev) {
+    if (ev >= NCOMM_EV_COUNT) return;
+    const uint32_t bit = 1u << ev;
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!(s.pending & bit)) {
+        s.post_cyc[ev] = ncomm_cycles_now();
+        s.pending |= bit;
+    }
+    __set_PRIMASK(primask);
+}
+
+// Take the highest-priority pending event; returns NCOMM_EV_COUNT if none.
+static uint32_t take_next(uint32_t* posted_at) {
+    __disable_irq();
+    const uint32_t p = s.pending;
+    if (!p) {
+        __enable_irq();
+        return NCOMM_EV_COUNT;
+    }
+    const uint32_t ev = __CLZ(__RBIT(p)); // lowest set bit
+    s.pending = p & ~(1u << ev);
+    *posted_at = s.post_cyc[ev];
+    __enable_irq();
+    return ev;
+}
+
+// CYCCNT stops while the core sleeps in WFI (unless a debugger keeps the clock
+// on), so wall time comes from SysTick and awake time is CYCCNT minus whatever
+// it advanced inside WFI.
+static void roll_window(void) {
+    const uint32_t ms = HAL_GetTick() - s.window_ms;
+    if (ms < 1000) return;
+
+    const uint32_t cyc = ncomm_cycles_now();
+    const uint64_t wall = (uint64_t)ms * (SystemCoreClock / 1000u);
+    const uint64_t awake = (uint64_t)(cyc - s.window_cyc) - s.wfi_cycles;
+    const uint64_t idle = (awake < wall) ? wall - awake : 0;
+
+    s.cur.window_cycles = (uint32_t)((wall > 0xFFFFFFFFu) ? 0xFFFFFFFFu : wall);
+    s.cur.idle_cycles = (uint32_t)((idle > 0xFFFFFFFFu) ? 0xFFFFFFFFu : idle);
+    s.cur.idle_x100 = (uint16_t)((idle * 10000u) / wall);
+    s.last = s.cur;
+
+    memset(&s.cur, 0, sizeof(s.cur));
+    s.wfi_cycles = 0;
+    s.window_ms += ms;
+    s.window_cyc = cyc;
+}
+
+void ncomm_sched_run_once(void) {
+    uint32_t posted_at = 0;
+    uint32_t ev;
+    while ((ev = take_next(&posted_at)) < NCOMM_EV_COUNT) {
+        const uint32_t t0 = ncomm_cycles_now();
+        if (s.handlers[ev]) s.handlers[ev]();
+        const uint32_t t1 = ncomm_cycles_now();
+
+        ncomm_sched_ev_stats_t* st = &s.cur.ev[ev];
+        const uint32_t lat = t0 - posted_at;
+        const uint32_t run = t1 - t0;
+        st->count++;
+        if (lat > st->lat_max) st->lat_max = lat;
+        if (run > st->run_max) st->run_max = run;
+        if (lat > s.cur.lat_max) s.cur.lat_max = lat;
+        if (run > s.cur.run_max) s.cur.run_max = run;
+    }
+
+    // Sleep with PRIMASK set: a pending IRQ still wakes WFI, and is taken
+    // right after __enable_irq(), so the post cannot slip in between the
+    // check and the WFI. The wake-up ISR runs outside the idle measurement.
+    __disable_irq();
+    if (!s.pending) {
+        const uint32_t t0 = ncomm_cycles_now();
+        __DSB();
+        __WFI();
+        s.wfi_cycles += ncomm_cycles_now() - t0;
+    }
+    __enable_irq();
+
+    roll_window();
+}
+
+const ncomm_sched_stats_t* ncomm_sched_stats(void) {
+    return &s.last;
+}
@@ -4,6 +4,8 @@
 
 #include "usart.h"   // huart3
 #include "main.h"
+#include "ncomm_uart.h"
+#include "ncomm_sched.h"
 
 extern uint16_t ncomm_crc16_ccitt_false(const uint8_t* data, size_t len);
 
@@ -15,9 +17,70 @@ extern uint16_t ncomm_crc16_ccitt_false(const uint8_t* data, size_t len);
 
 static uint8_t g_tx_seq = 0;
 
+static UART_HandleTypeDef* g_link = &huart3;
+
+// RX ring: ISR producer, main-loop consumer
+#define RX_RING_SZ 1024u // power of two
+static uint8_t g_rx_ring[RX_RING_SZ];
+static volatile uint16_t g_rx_wr = 0;
+static volatile uint16_t g_rx_rd = 0;
+static ncomm_uart_stats_t g_stats;
+
+void ncomm_uart_init(UART_HandleTypeDef* huart) {
+    if (huart) g_link = huart;
+    g_rx_wr = g_rx_rd = 0;
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    IRQn_Type irq = USART3_IRQn;
+    if (g_link->Instance == UART4) irq = UART4_IRQn;
+    HAL_NVIC_SetPriority(irq, 2, 0);
+    HAL_NVIC_EnableIRQ(irq);
+    __HAL_UART_ENABLE_IT(g_link, UART_IT_RXNE);
+}
+
+void ncomm_uart_irq(UART_HandleTypeDef* huart) {
+    if (huart != g_link) {
+        HAL_UART_IRQHandler(huart);
+        return;
+    }
+    USART_TypeDef* u = huart->Instance;
+    const uint32_t isr = u->ISR;
+    if (isr & (USART_ISR_ORE | USART_ISR_FE | USART_ISR_NE | USART_ISR_PE)) {
+        u->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NECF | USART_ICR_PECF;
+        g_stats.rx_errors++;
+    }
+
+    bool got = false;
+    while (u->ISR & USART_ISR_RXNE_RXFNE) {
+        const uint8_t b = (uint8_t)(u->RDR & 0xFF);
+        const uint16_t wr = g_rx_wr;
+        if ((uint16_t)(wr - g_rx_rd) < RX_RING_SZ) {
+            g_rx_ring[wr & (RX_RING_SZ - 1u)] = b;
+            g_rx_wr = (uint16_t)(wr + 1u);
+        } else {
+            g_stats.rx_overflow++;
+        }
+        g_stats.rx_bytes++;
+        got = true;
+    }
+    if (got) ncomm_sched_post(NCOMM_EV_UART_RX);
+}
+
+bool ncomm_uart_rx_pop(uint8_t* out) {
+    const uint16_t rd = g_rx_rd;
+    if (rd == g_rx_wr) return false;
+    *out = g_rx_ring[rd & (RX_RING_SZ - 1u)];
+    g_rx_rd = (uint16_t)(rd + 1u);
+    return true;
+}
+
+const ncomm_uart_stats_t* ncomm_uart_stats(void) {
+    return &g_stats;
+}
+
 // Blocking send (OK for MVP). Later we can switch to DMA.
 static inline void uart_send_bytes(const uint8_t* p, uint16_t n) {
-    (void)HAL_UART_Transmit(&huart3, (uint8_t*)p, n, 100);
+    (void)HAL_UART_Transmit(g_link, (uint8_t*)p, n, 100);
 }
 
 void ncomm_uart_send(uint8_t ver, uint8_t type, uint8_t flags, const uint8_t* payload, uint16_t len) {
@@ -22,6 +22,11 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "usart.h"
+#include "ncomm_audio_pipe.h"
+#include "ncomm_playout.h"
+#include "ncomm_sched.h"
+#include "ncomm_uart.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -188,6 +193,7 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+  ncomm_sched_post(NCOMM_EV_TICK);
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -243,4 +249,44 @@ void DFSDM1_FLT0_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA1 stream0 global interrupt (DFSDM1 mic capture).
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+  ncomm_pipe_dma_irq(0);
+}
+
+/**
+  * @brief This function handles DMA1 stream2 global interrupt (DFSDM1 rx capture).
+  */
+void DMA1_Stream2_IRQHandler(void)
+{
+  ncomm_pipe_dma_irq(1);
+}
+
+/**
+  * @brief This function handles DMA1 stream1 global interrupt (SPI2_TX / I2S2 playout).
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  ncomm_playout_dma_irq();
+}
+
+/**
+  * @brief This function handles USART3 global interrupt (link RX ring).
+  */
+void USART3_IRQHandler(void)
+{
+  ncomm_uart_irq(&huart3);
+}
+
+/**
+  * @brief This function handles UART4 global interrupt (link RX ring).
+  */
+void UART4_IRQHandler(void)
+{
+  ncomm_uart_irq(&huart4);
+}
+
 /* USER CODE END 1 */
@@ -93,6 +93,9 @@ LoopFillZerobss:
   cmp r2, r4
   bcc FillZerobss
 
+/* Copy ITCM code / DTCM tables, zero DTCM bss (ncomm_mem.c) */
+  bl ncomm_mem_init
+
 /* Call static constructors */
     bl __libc_init_array
 /* Call the application's entry point.*/
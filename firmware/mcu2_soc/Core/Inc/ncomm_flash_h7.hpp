@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include "ncomm/ncomm_store.hpp"
+
+// Enrollment store sectors: bank 2, sectors 6 and 7 (0x081C0000 / 0x081E0000,
+// 128 KB each), reserved in the linker script (ENROLL region). Code runs from
+// bank 1, so it keeps executing while bank 2 programs / erases; only store
+// reads stall. A word torn by a power cut can raise an ECC error when read:
+// the store checks CRCs, and mount skips such words.
+class FlashH7 final : public ncomm::FlashDevice {
+public:
+  static constexpr uint32_t SECTOR_SIZE = 0x20000;
+
+  const uint8_t* base(uint8_t sector) const override;
+  uint32_t sector_size() const override { return SECTOR_SIZE; }
+  bool erase(uint8_t sector) override;
+  bool program(uint8_t sector, uint32_t offset, const uint8_t* word) override;
+};
@@ -2,13 +2,29 @@
 
 #include <cstdint>
 #include "usart.h"
-#include "firmware/common/include/ncomm/ncomm_protocol.hpp"
+#include "ncomm/ncomm_protocol.hpp"
+#include "ncomm/ncomm_resample.h"
+#include "ncomm/ncomm_profile.h"
+#include "ncomm/ncomm_spsc.hpp"
+#include "ncomm/ncomm_frame_pool.hpp"
+#include "ncomm/ncomm_brick.hpp"
+#include "ncomm/ncomm_speech.hpp"
+
+class PlayoutH7;
 
 // MCU2 MVP-0:
 // - UART link to MCU1: USART3 @ 1M
 // - UART link to MCU3/UI: UART4 @ 500k (optional now)
 // - Parse UART v1.4.0 frames from MCU1
 // - Send PING / SET_STREAM (mapped to CMD_SET_MODE + CMD_SET_STREAMS)
+//
+// Contexts: on_rx_byte() runs in the USART3 RX ISR and only parses and
+// publishes CRC-valid frames into a lock-free SPSC queue; poll() in the main
+// loop dispatches them (handle_frame_ and everything below it is main-loop only).
+//
+// Frames live in a fixed pool of FRAME_POOL_BLOCKS refcounted blocks: the ISR
+// parses straight into a block and every consumer that keeps a frame holds an
+// ncomm::FrameRef, so one audio frame fans out without copies.
 
 class NcommMcu2 {
 public:
@@ -17,12 +33,63 @@ public:
   // Call from HAL_UART_RxCpltCallback (byte-by-byte)
   void on_rx_byte(uint8_t b);
 
+  // Main loop: dispatch all frames queued by the RX ISR
+  void poll();
+
   // Public getter for the last byte stored by RX IT (needed by main/callback)
   uint8_t last_rx_byte() const { return rx_byte_; }
 
   // Commands to MCU1
   void send_ping();
-  void set_stream(ncomm::StreamSelect sel); // MCU2 API requested: MIC_RAW vs RX_RAW
+  void set_stream(ncomm::StreamSelect sel); // MCU2 API requested: MIC_RAW, RX_RAW or both
+
+  // Per-stream link rate (ncomm_rate_t). Applied with the next set_stream();
+  // low-priority monitoring can run at 8 kHz and take half the link.
+  void set_stream_rates(uint8_t rx_rate, uint8_t tx_rate);
+
+  // EVT_AUDIO_LEVELS period in 16 ms chunks (0 = off). Applied with the next set_stream().
+  void set_levels_decim(uint8_t chunks) { levels_decim_req_ = chunks; }
+
+  // Last received chunk of a stream (0=RX, 1=TX), interpolated back to 16 kHz
+  // for DAC playout. Returns nullptr until a frame was received.
+  const int16_t* audio_16k(uint8_t stream_idx, uint16_t* samples) const;
+
+  // DAC playout: each 16 kHz chunk is also queued to its output (TX ->
+  // radio, RX -> headset) as it is dispatched. nullptr = no playout.
+  void set_playout(PlayoutH7* out) { playout_ = out; }
+
+  // Last received audio frame of a stream as sent on the link (audio header +
+  // PCM at the stream rate), for forwarding / recording. Copy to keep it.
+  // MCU1 captures no In2 (EVT_STREAMS_ACK source_flags bit0): RX_STREAM_OUT
+  // and the headset monitor are silence, not a quiet channel
+  bool rx_source_missing() const { return rx_source_missing_; }
+
+  const ncomm::FrameRef& audio_frame(uint8_t stream_idx) const { return last_audio_[stream_idx & 1u]; }
+
+  // KWS input: 240-sample bricks over the 16 kHz TX_AUDIO_OUT frames (views
+  // into the frame pool). Drain with kws_bricks().next() from the main loop.
+  ncomm::BrickRepacker& kws_bricks() { return kws_bricks_; }
+
+  // Rolling speech buffer: the same 16 kHz TX audio as int16, last ~2 s by
+  // absolute sample position (SR segments, mel front end). Storage is a static
+  // 64 KB array in AXI SRAM; convert with read_float()/read_windowed().
+  const ncomm::SpeechRing& speech() const { return speech_; }
+
+  // VAD state from MCU1: last EVT_VAD vad_flag or EVT_VAD_MAP flags bit0.
+  // Gates streaming SR features (ncomm::MelStream).
+  bool vad_on() const { return vad_on_; }
+
+  // Last EVT_VAD_MAP from MCU1 (64-chunk VAD bitmap + pre-roll/marker state)
+  const ncomm::VadMap& vad_map() const { return vad_map_; }
+
+  // Last EVT_AUDIO_LEVELS from MCU1 (peak/RMS of In1/In2/Out1/Out2)
+  const ncomm::AudioLevels& audio_levels() const { return levels_; }
+
+  // Last EVT_PROFILE payload from MCU1 (layout in ncomm_profile.h), nullptr if none
+  const uint8_t* mcu1_profile(uint16_t* len) const {
+    if (len) *len = mcu1_prof_.size();
+    return mcu1_prof_.data();
+  }
 
   // Optional: periodic housekeeping (timeouts, stats)
   void tick_1ms();
@@ -31,6 +98,7 @@ public:
     uint32_t rx_bytes = 0;
     uint32_t rx_frames_ok = 0;
     uint32_t rx_frames_bad_crc = 0;
+    uint32_t rx_frames_dropped = 0; // CRC ok, but read without a pool block
 
     uint32_t tx_frames = 0;
 
@@ -45,13 +113,32 @@ public:
     uint32_t ack_vad_cfg = 0;
 
     uint32_t evt_error = 0;
+
+    uint32_t audio_bad_len = 0; // samples does not match the applied stream rate
+    uint32_t audio_rx_no_source = 0; // RX_STREAM_OUT frames while MCU1 has no In2 capture
+    uint32_t profile = 0;
+    uint32_t vad_map = 0;
+    uint32_t levels = 0;
+
+    uint32_t rxq_high_water = 0; // max frames waiting for poll()
+    uint32_t rxq_drops = 0;      // CRC-valid frames lost to a full queue
+    uint32_t pool_exhausted = 0; // frames dropped: no free pool block at header time
+    uint32_t pool_in_use_max = 0;
   };
 
   const Stats& stats() const { return stats_; }
-  void stats_reset() { stats_ = {}; }
+  void stats_reset() {
+    stats_ = {};
+    rxq_.reset_stats();
+    pool_.stats_reset();
+  }
 
 
 private:
+  // Blocks held at most: parser 1 + queue + last audio 2 + profile 1 + KWS repacker 4
+  static constexpr uint8_t FRAME_POOL_BLOCKS = 16;
+  static constexpr uint32_t RX_QUEUE_DEPTH = FRAME_POOL_BLOCKS; // push never fails with a block in hand
+
   UART_HandleTypeDef* uart_mcu1_ = nullptr;
   UART_HandleTypeDef* uart_ui_   = nullptr;
 
@@ -62,7 +149,8 @@ private:
   uint8_t header_[ncomm::HEADER_SIZE]{};
   uint16_t hdr_pos_ = 0;
 
-  uint8_t payload_[ncomm::MAX_PAYLOAD]{};
+  ncomm::FrameBlock* rx_blk_ = nullptr; // block being filled by the ISR
+  uint16_t crc_calc_ = 0;
   uint16_t payload_len_ = 0;
   uint16_t payload_pos_ = 0;
 
@@ -75,8 +163,35 @@ private:
 
   uint8_t tx_msg_id_ = 1;
 
+  ncomm::FrameBlock blocks_[FRAME_POOL_BLOCKS];
+  ncomm::FramePool pool_;
+  ncomm::SpscQueue<ncomm::FrameBlock*, RX_QUEUE_DEPTH> rxq_;
+
+  // Stream rates: requested (sent in CMD_SET_STREAMS) and applied (from ACK)
+  uint8_t rate_req_[2] = {NCOMM_RATE_16K, NCOMM_RATE_16K};
+  uint8_t rate_applied_[2] = {NCOMM_RATE_16K, NCOMM_RATE_16K};
+  ncomm_resampler_t interp_[2]{};
+  int16_t pcm16_[2][256]{};
+  uint16_t pcm16_len_[2]{};
+  PlayoutH7* playout_ = nullptr;
+  bool rx_source_missing_ = false;
+  bool tx_to_radio_ = false; // TX stream is radio audio (MIC_RAW), not the STANDBY KWS mic
+
+  ncomm::VadMap vad_map_{};
+  bool vad_on_ = false;
+  ncomm::AudioLevels levels_{};
+  uint8_t levels_decim_req_ = 0;
+
+  ncomm::FrameRef last_audio_[2];
+  ncomm::FrameRef mcu1_prof_; // last EVT_PROFILE, held in its pool block
+  ncomm::BrickRepacker kws_bricks_;
+  ncomm::SpeechRing speech_;
+
+  void apply_stream_rates_(uint8_t rx_rate, uint8_t tx_rate);
+  void on_audio_frame_(uint8_t stream_idx, const ncomm::FrameRef& f);
+
   void arm_rx_it_();
-  void handle_frame_(uint8_t msg_type, const uint8_t* payload, uint16_t len);
+  void handle_frame_(const ncomm::FrameRef& f);
 
   // low-level send
   bool send_frame_(uint8_t msg_type, const uint8_t* payload, uint16_t len);
@@ -85,6 +200,8 @@ private:
   void send_cmd_set_mode_(ncomm::Mode mode, ncomm::Ptt ptt,
                           uint8_t rx_ve_enable, uint8_t tx_ve_enable);
   void send_cmd_set_streams_(uint8_t stream_rx_enable, uint8_t stream_tx_enable,
-                             uint8_t mic_to_mcu2_source, uint8_t reserved0 = 0);
+                             uint8_t vad_evt_enable, uint16_t frame_samples = 0,
+                             uint8_t rx_rate = NCOMM_RATE_16K, uint8_t tx_rate = NCOMM_RATE_16K,
+                             uint8_t levels_decim = 0);
   Stats stats_{};
 };
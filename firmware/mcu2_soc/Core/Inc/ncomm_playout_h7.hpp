@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include "main.h"
+#include "ncomm/ncomm_playout.hpp"
+#include "ncomm/ncomm_beep.hpp"
+
+// MCU2 DAC outputs on I2S2 (master TX, 16 kHz, 32-bit slots, Philips), the
+// same slot map as MCU1:
+//   left  slot -> TX_AUDIO_OUT  (radio)
+//   right slot -> RX_STREAM_OUT (headset), beep tones mixed in
+//
+// Circular DMA (SPI2_TX, DMA1 Stream1) over two halves of PERIOD frames in
+// RAM_D2. Each half-transfer / transfer-complete callback pulls the next
+// period from the per-channel ncomm::PlayoutBuffer (adaptive depth,
+// concealment, latency tags) and converts it to 32-bit slots.
+//
+// Output clock: now() is the number of frames sent since start(); chunks are
+// stamped with it when queued, and each period knows the position its first
+// frame reaches the DAC, so buffer latencies are counted in DAC samples.
+// The same clock times the drift fit against the MCU1 capture position, and
+// each buffer resamples (ASRC) to hold its depth.
+//
+// Contexts: write() from the main loop (single producer), everything else
+// from the DMA ISR (priority 1, below the link UART).
+class PlayoutH7 {
+public:
+  static constexpr uint32_t PERIOD = 64; // frames per DMA half (4 ms)
+
+  enum Out : uint8_t {
+    RADIO = 0,   // TX_AUDIO_OUT
+    HEADSET = 1, // RX_STREAM_OUT
+    OUT_COUNT
+  };
+
+  // Configure the SPI2_TX DMA stream and start circular playout (once).
+  // beep (optional) is rendered into the headset channel.
+  bool init(I2S_HandleTypeDef* hi2s, ncomm::BeepMixer* beep = nullptr);
+
+  // Queue one chunk of 16 kHz PCM; src = MCU1 capture position of pcm[0]
+  // (drift estimation / ASRC), or ncomm::PLAYOUT_NO_SRC. Main-loop context only.
+  void write(Out ch, const int16_t* pcm, uint16_t n, uint32_t src = ncomm::PLAYOUT_NO_SRC);
+
+  // Output sample position of the frame leaving the DMA now.
+  uint32_t now() const;
+
+  const ncomm::PlayoutBuffer& out(Out ch) const { return jb_[ch]; }
+  uint32_t periods() const { return halves_; }
+
+  // From HAL_I2S_TxHalfCpltCallback (half 0) / HAL_I2S_TxCpltCallback (half 1)
+  void on_half(uint8_t half);
+  void dma_irq();
+  I2S_HandleTypeDef* i2s() const { return hi2s_; }
+
+private:
+  ncomm::PlayoutBuffer jb_[OUT_COUNT];
+  ncomm::BeepMixer* beep_ = nullptr;
+  I2S_HandleTypeDef* hi2s_ = nullptr;
+  DMA_HandleTypeDef hdma_tx_{};
+  volatile uint32_t halves_ = 0; // DMA halves completed
+  bool started_ = false;
+};
+
+// DMA1_Stream1_IRQHandler entry (stm32h7xx_it.c), defined next to the
+// instance in main.cpp
+extern "C" void ncomm_playout_dma_irq(void);
@@ -10,16 +10,68 @@
 #include "main.h"
 #include "dma.h"
 #include "gpio.h"
+#include "i2s.h"
 #include "usart.h"
 
 /* USER CODE BEGIN Includes */
 #include "ncomm_mcu2.hpp"
+#include "ncomm_flash_h7.hpp"
+#include "ncomm_playout_h7.hpp"
+#include "ncomm/ncomm_mem.h"
+#include "ncomm/ncomm_profile.h"
+#include "ncomm/ncomm_kws.hpp"
+#include "ncomm/ncomm_mel.hpp"
+#include "ncomm/ncomm_voiceid.hpp"
+#include "ncomm/ncomm_sr.hpp"
+#include "ncomm/ncomm_sr_pq.hpp"
+#include "ncomm/ncomm_sr_pipeline.hpp"
+#include "ncomm/ncomm_store.hpp"
+#include "ncomm/ncomm_beep.hpp"
 #include <cstring>
 /* USER CODE END Includes */
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
-static NcommMcu2 g_mcu2;
+// Parser state + audio buffers in DTCM. .dtcm_data, not the zero-filled
+// .dtcm_bss: the member defaults (tx_msg_id_, VadMap ages, ...) are non-zero.
+static NcommMcu2 g_mcu2 NCOMM_FAST_INIT;
+// KWS engine: plain static (AXI SRAM). Not .dtcm_bss: that section is zero
+// filled after load and would lose the vtable pointer of a statically
+// initialised object.
+static ncomm::TinyKws g_tiny_kws;
+static ncomm::KwsEngine* g_kws = nullptr;
+// SR features: log-mel frames computed while VAD is on (AXI SRAM, ~50 KB)
+static ncomm::MelFrontEnd g_mel;
+static ncomm::MelStream g_mel_stream;
+// SR encoder: int8 engine, weights read in place from flash; 5 KB arena
+static ncomm::VoiceIdEncoder g_voiceid;
+#if defined(NCOMM_SR_PQ)
+// SR templates: PQ codes, 17 B each (19 KB DB at 1024 templates, SR spec 14)
+static uint8_t g_sr_codes[ncomm::SR_PQ_MAX_TEMPLATES * ncomm::SR_PQ_M];
+static uint8_t g_sr_voice[ncomm::SR_PQ_MAX_TEMPLATES];
+static ncomm::PqWeibullClassifier g_sr_cls;
+#else
+// SR templates: Q15 rows scored in one pass (AXI SRAM, 64 KB at 256 templates)
+static int16_t g_sr_rows[ncomm::SR_MAX_TEMPLATES * ncomm::SR_EMB_DIM];
+static uint8_t g_sr_voice[ncomm::SR_MAX_TEMPLATES];
+static ncomm::CosineWeibullClassifier g_sr_cls;
+#endif
+static ncomm::SrClassifier* g_sr = nullptr;
+// SR decision on each KWS command: packets read through looped views (no
+// voice buffer), mel + encoder scratch ~7 KB
+static ncomm::SrPipeline g_sr_pipe;
+// SR enrollment: record store in bank 2 (sectors 6-7); Q15 voices are scored
+// from flash in place, re-attached when the store moves records.
+static FlashH7 g_flash;
+static ncomm::RecordStore g_store;
+static uint32_t g_sr_gen = 0;
+// Beep feedback (architecture 4.2): tones queued here, synthesised and mixed
+// by the headset output block by block (no vtable, so DTCM is fine; .dtcm_data
+// keeps the BeepPreset defaults)
+static ncomm::BeepMixer g_beep NCOMM_FAST_INIT;
+// DAC output (I2S2 circular DMA): radio + headset jitter buffers, ~17 KB in
+// AXI SRAM; the DMA halves themselves are in RAM_D2
+static PlayoutH7 g_playout;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -48,6 +100,17 @@ static char* u32_to_dec(char* out, uint32_t v) {
   return out;
 }
 
+// Parts per billion as signed ppm with one decimal ("-12.3")
+static char* ppb_to_ppm(char* out, int32_t ppb) {
+  if (ppb < 0) *out++ = '-';
+  const uint32_t tenths = ((ppb < 0 ? 0u - (uint32_t)ppb : (uint32_t)ppb) + 50000u) / 100000u;
+  out = u32_to_dec(out, tenths / 10u);
+  *out++ = '.';
+  *out++ = char('0' + tenths % 10u);
+  *out = 0;
+  return out;
+}
+
 static void log_mcu2_stats_1s(NcommMcu2& mcu2) {
   static uint32_t last_ms = 0;
   const uint32_t now = HAL_GetTick();
@@ -56,15 +119,16 @@ static void log_mcu2_stats_1s(NcommMcu2& mcu2) {
 
   const auto& st = mcu2.stats();
 
-  char line[240];
+  char line[304];
   char* p = line;
 
-  // "t=12345 rxB=.. ok=.. crcBad=.. tx=.. pong=.. vad=.. aRx=.. aTx=.. ackM=.. ackS=.. ackV=.. err=..\r\n"
+  // "t=12345 rxB=.. ok=.. crcBad=.. drop=.. tx=.. pong=.. vad=.. aRx=.. aTx=.. ackM=.. ackS=.. ackV=.. err=.. qHw=.. qDrop=.. poolEx=.. poolMax=..\r\n"
   memcpy(p, "t=", 2); p += 2; p = u32_to_dec(p, now);
 
   memcpy(p, " rxB=", 5); p += 5; p = u32_to_dec(p, st.rx_bytes);
   memcpy(p, " ok=", 4); p += 4; p = u32_to_dec(p, st.rx_frames_ok);
   memcpy(p, " crcBad=", 8); p += 8; p = u32_to_dec(p, st.rx_frames_bad_crc);
+  memcpy(p, " drop=", 6); p += 6; p = u32_to_dec(p, st.rx_frames_dropped);
 
   memcpy(p, " tx=", 4); p += 4; p = u32_to_dec(p, st.tx_frames);
 
@@ -79,10 +143,269 @@ static void log_mcu2_stats_1s(NcommMcu2& mcu2) {
   memcpy(p, " ackV=", 6); p += 6; p = u32_to_dec(p, st.ack_vad_cfg);
 
   memcpy(p, " err=", 5); p += 5; p = u32_to_dec(p, st.evt_error);
+  memcpy(p, " qHw=", 5); p += 5; p = u32_to_dec(p, st.rxq_high_water);
+  memcpy(p, " qDrop=", 7); p += 7; p = u32_to_dec(p, st.rxq_drops);
+  memcpy(p, " poolEx=", 8); p += 8; p = u32_to_dec(p, st.pool_exhausted);
+  memcpy(p, " poolMax=", 9); p += 9; p = u32_to_dec(p, st.pool_in_use_max);
+
+  memcpy(p, "\r\n", 2); p += 2;
+  *p = 0;
+
+  uart4_write_str(line);
+}
+
+#if defined(NCOMM_PROFILE)
+static char* prof_rec_to_text(char* p, const char* zone, const ncomm_prof_rec_t& r) {
+  *p++ = ' ';
+  const size_t n = strlen(zone);
+  memcpy(p, zone, n); p += n;
+  memcpy(p, " n=", 3); p += 3; p = u32_to_dec(p, r.count);
+  memcpy(p, " avg=", 5); p += 5; p = u32_to_dec(p, r.avg);
+  memcpy(p, " p99=", 5); p += 5; p = u32_to_dec(p, r.p99);
+  memcpy(p, " max=", 5); p += 5; p = u32_to_dec(p, r.max);
+  return p;
+}
+
+// "prof mcu2 <zone> n=.. avg=.. p99=.. max=.. | mcu1 <zone> ..." (cycles, 1 s window)
+static void log_profile_1s(NcommMcu2& mcu2) {
+  static uint32_t last_ms = 0;
+  const uint32_t now = HAL_GetTick();
+  if ((now - last_ms) < 1000) return;
+  last_ms = now;
+
+  static char line[960]; // 14 zones x ~62 chars worst case
+  char* p = line;
+  memcpy(p, "prof mcu2", 9); p += 9;
+
+  for (uint8_t z = 0; z < NCOMM_PZ_COUNT; z++) {
+    ncomm_prof_rec_t r;
+    ncomm_prof_get(z, &r);
+    if (r.count) p = prof_rec_to_text(p, ncomm_prof_zone_name(z), r);
+  }
+  ncomm_prof_reset();
+
+  uint16_t len = 0;
+  const uint8_t* pl = mcu2.mcu1_profile(&len);
+  if (pl && pl[0] == NCOMM_PROF_VER) {
+    memcpy(p, " | mcu1", 7); p += 7;
+    const uint8_t zones = pl[1];
+    for (uint8_t i = 0; i < zones && NCOMM_PROF_HDR_SIZE + (i + 1u) * NCOMM_PROF_REC_SIZE <= len; i++) {
+      const uint8_t* q = pl + NCOMM_PROF_HDR_SIZE + i * NCOMM_PROF_REC_SIZE;
+      ncomm_prof_rec_t r;
+      r.count = (uint32_t)q[2] | ((uint32_t)q[3] << 8);
+      memcpy(&r.min, &q[4], 4);
+      memcpy(&r.avg, &q[8], 4);
+      memcpy(&r.max, &q[12], 4);
+      memcpy(&r.p99, &q[16], 4);
+      p = prof_rec_to_text(p, ncomm_prof_zone_name(q[0]), r);
+    }
+  }
+
+  memcpy(p, "\r\n", 2); p += 2;
+  *p = 0;
+  uart4_write_str(line);
+}
+#endif
+
+// KWS input: the engine takes 240-sample bricks and converts them itself
+// (ncomm::to_float). The repacker and the speech ring see the same frames, so
+// a brick starts (pending + 240) samples before the ring head.
+static void feed_kws(NcommMcu2& mcu2) {
+  ncomm::BrickView brick;
+  while (mcu2.kws_bricks().next(&brick)) {
+    if (!g_kws) continue;
+    const uint32_t pos = mcu2.speech().head() - mcu2.kws_bricks().pending() - ncomm::BRICK_SAMPLES;
+    ncomm::KwsResult res;
+    bool hit;
+    {
+      NCOMM_PROF_SCOPE(NCOMM_PZ_KWS);
+      hit = g_kws->process(brick, pos, &res);
+    }
+    if (!hit) continue;
+    // Start commands get the SR result tone right after this one
+    const bool disconnect = res.cmd_id == ncomm::KWS_COMMANDS;
+    g_beep.start(disconnect ? ncomm::BeepTone::SESSION_CLOSED : ncomm::BeepTone::CMD_DETECTED);
+
+    // "kws cmd=<1..4> score=<0..255> seg=<start> len=<samples> mel=<cached>/<frames>"
+    char line[160];
+    char* p = line;
+    memcpy(p, "kws cmd=", 8); p += 8; p = u32_to_dec(p, res.cmd_id);
+    memcpy(p, " score=", 7); p += 7; p = u32_to_dec(p, res.score);
+    memcpy(p, " seg=", 5); p += 5; p = u32_to_dec(p, res.seg_start);
+    memcpy(p, " len=", 5); p += 5; p = u32_to_dec(p, res.seg_end - res.seg_start);
+    // SR features of the segment already streamed / total
+    const uint32_t len = res.seg_end - res.seg_start;
+    memcpy(p, " mel=", 5); p += 5; p = u32_to_dec(p, g_mel_stream.cached(res.seg_start, len));
+    *p++ = '/'; p = u32_to_dec(p, ncomm::mel_frames(len));
+    memcpy(p, "\r\n", 2); p += 2;
+    *p = 0;
+    uart4_write_str(line);
+
+    // "sr pk=<0..2> known=<0|1> voice=<id> d=<distance x1000> mel=<hits>/<frames>
+    //     us=<verify> exit=<0|1> early=<accepts>+<rejects>/<two-packet runs> saved=<ms>
+    //     spec=<packets from the speculative cache>"
+    ncomm::SrResult sr;
+    {
+      NCOMM_PROF_SCOPE(NCOMM_PZ_SR);
+      g_sr_pipe.verify(mcu2.speech(), res.seg_start, len, &sr);
+    }
+    if (!disconnect) {
+      g_beep.start(sr.decision.is_known ? ncomm::BeepTone::SR_CONFIRMED : ncomm::BeepTone::SR_REJECTED);
+    }
+    p = line;
+    memcpy(p, "sr pk=", 6); p += 6; p = u32_to_dec(p, sr.packets);
+    memcpy(p, " known=", 7); p += 7; *p++ = sr.decision.is_known ? '1' : '0';
+    memcpy(p, " voice=", 7); p += 7;
+    if (sr.decision.voice_id < 0) *p++ = '-';
+    else p = u32_to_dec(p, (uint32_t)sr.decision.voice_id);
+    memcpy(p, " d=", 3); p += 3; p = u32_to_dec(p, (uint32_t)(sr.decision.distance * 1000.0f + 0.5f));
+    memcpy(p, " mel=", 5); p += 5; p = u32_to_dec(p, sr.mel_hits);
+    *p++ = '/'; p = u32_to_dec(p, sr.mel_frames);
+    const ncomm::SrPipeline::Stats& st = g_sr_pipe.stats();
+    memcpy(p, " us=", 4); p += 4; p = u32_to_dec(p, sr.us);
+    memcpy(p, " exit=", 6); p += 6; *p++ = sr.early_exit ? '1' : '0';
+    memcpy(p, " early=", 7); p += 7; p = u32_to_dec(p, st.early_accept);
+    *p++ = '+'; p = u32_to_dec(p, st.early_reject);
+    *p++ = '/'; p = u32_to_dec(p, st.two_packets);
+    memcpy(p, " saved=", 7); p += 7; p = u32_to_dec(p, st.saved_us / 1000u);
+    memcpy(p, " spec=", 6); p += 6; p = u32_to_dec(p, sr.speculated);
+    memcpy(p, "\r\n", 2); p += 2;
+    *p = 0;
+    uart4_write_str(line);
+  }
+
+  // SR ahead of the KWS result: encode the final packets of the command still
+  // being decided (one encoder pass per loop), drop them if it goes away
+  if (!g_kws) return;
+  ncomm::KwsPending pd;
+  if (g_kws->pending(&pd)) {
+    NCOMM_PROF_SCOPE(NCOMM_PZ_SR);
+    g_sr_pipe.speculate(mcu2.speech(), pd.seg_start, pd.seg_end - pd.seg_start, pd.ended);
+  } else {
+    g_sr_pipe.cancel();
+  }
+}
+
+// SR features follow the speech ring while MCU1 reports VAD on (a few frames
+// per pass), so an SR decision only gathers them: g_mel_stream.segment().
+static void feed_mel(NcommMcu2& mcu2) {
+  NCOMM_PROF_SCOPE(NCOMM_PZ_SR);
+  g_mel_stream.update(mcu2.speech(), mcu2.vad_on());
+}
+
+static void mel_init(const NcommMcu2& mcu2) {
+  g_mel.init();
+  g_mel_stream.init(&g_mel);
+  g_mel_stream.reset(mcu2.speech().head());
+}
 
+static void voiceid_init() {
+  const ncomm::VoiceIdModel* model = ncomm::voiceid_placeholder_model();
+  g_voiceid.init(model);
+  if (!model->trained) uart4_write_str("sr: voiceid int8, placeholder model (embeddings meaningless)\r\n");
+}
+
+static void sr_init() {
+#if defined(NCOMM_SR_PQ)
+  const ncomm::PqCodebook* cb = ncomm::pq_placeholder_codebook();
+  g_sr_cls.init(cb, g_sr_codes, g_sr_voice, ncomm::SR_PQ_MAX_TEMPLATES);
+  if (!cb->trained) uart4_write_str("sr: pq templates, placeholder codebook\r\n");
+#else
+  g_sr_cls.init(g_sr_rows, g_sr_voice, ncomm::SR_MAX_TEMPLATES);
+#endif
+  g_sr = &g_sr_cls;
+  g_sr_pipe.init(&g_mel_stream, &g_voiceid, g_sr);
+  g_sr_pipe.early_exit().enabled = true; // scenario C: skip packet 2 outside +-0.20 of SR_THRESHOLD
+
+  if (!g_store.mount(&g_flash)) {
+    uart4_write_str("sr: store mount failed\r\n");
+    return;
+  }
+  const uint16_t n = ncomm::sr_restore_voices(g_store, *g_sr);
+  g_sr_gen = g_store.generation();
+  char line[96];
+  char* p = line;
+  memcpy(p, "sr: store ", 10); p += 10;
+  p = u32_to_dec(p, n);
+  memcpy(p, " voices, free=", 14); p += 14;
+  p = u32_to_dec(p, g_store.free_bytes());
+  memcpy(p, " erases=", 8); p += 8;
+  p = u32_to_dec(p, g_store.erase_count(0));
+  *p++ = '/'; p = u32_to_dec(p, g_store.erase_count(1));
+  memcpy(p, " skipped=", 9); p += 9;
+  p = u32_to_dec(p, g_store.stats().skipped_words);
   memcpy(p, "\r\n", 2); p += 2;
   *p = 0;
+  uart4_write_str(line);
+}
+
+// Enrollment writes go through ncomm::sr_store_voice(); a compaction moves
+// every record, so the in-place templates are re-attached.
+static void sr_sync_store() {
+  if (!g_sr || g_store.generation() == g_sr_gen) return;
+  ncomm::sr_restore_voices(g_store, *g_sr);
+  g_sr_gen = g_store.generation();
+}
+
+static void kws_init() {
+  const ncomm::KwsModel* model = ncomm::kws_placeholder_model();
+  g_tiny_kws.init(model);
+  g_kws = &g_tiny_kws; // Sensory adapter: another ncomm::KwsEngine here
+  if (!model->trained) uart4_write_str("kws: tinykws, placeholder model (no detections)\r\n");
+}
 
+// "ram dtcm mcu2=<B> axi speech=<B> speech_f32=<B>": the main static buffers
+// (speech_f32 = the same 2 s kept as float, for comparison)
+static void log_ram_budget(const NcommMcu2& mcu2) {
+  char line[96];
+  char* p = line;
+  memcpy(p, "ram dtcm mcu2=", 14); p += 14; p = u32_to_dec(p, (uint32_t)sizeof(NcommMcu2));
+  memcpy(p, " axi speech=", 12); p += 12;
+  p = u32_to_dec(p, mcu2.speech().capacity() * (uint32_t)sizeof(int16_t));
+  memcpy(p, " speech_f32=", 12); p += 12;
+  p = u32_to_dec(p, mcu2.speech().capacity() * (uint32_t)sizeof(float));
+  memcpy(p, "\r\n", 2); p += 2;
+  *p = 0;
+  uart4_write_str(line);
+}
+
+static char* playout_to_text(char* p, const char* name, const ncomm::PlayoutBuffer& jb) {
+  const ncomm::PlayoutBuffer::Stats& st = jb.stats();
+  *p++ = ' ';
+  const size_t n = strlen(name);
+  memcpy(p, name, n); p += n;
+  memcpy(p, " d=", 3); p += 3; p = u32_to_dec(p, jb.depth());
+  memcpy(p, " tgt=", 5); p += 5; p = u32_to_dec(p, jb.target());
+  memcpy(p, " und=", 5); p += 5; p = u32_to_dec(p, st.underruns);
+  memcpy(p, " conc=", 6); p += 6; p = u32_to_dec(p, st.concealed);
+  memcpy(p, " trim=", 6); p += 6; p = u32_to_dec(p, st.trimmed);
+  memcpy(p, " ovf=", 5); p += 5; p = u32_to_dec(p, st.overflow);
+  memcpy(p, " stop=", 6); p += 6; p = u32_to_dec(p, st.stops);
+  memcpy(p, " lat=", 5); p += 5; p = u32_to_dec(p, st.lat_avg_us);
+  *p++ = '/'; p = u32_to_dec(p, st.lat_max_us);
+  memcpy(p, " ppm=", 5); p += 5; p = ppb_to_ppm(p, st.drift_ppb);
+  *p++ = '/'; p = ppb_to_ppm(p, st.ratio_ppb);
+  return p;
+}
+
+// "play n=<periods> radio d=<samples> tgt=<samples> und=.. conc=<samples>
+//     trim=<samples> ovf=<samples> stop=.. lat=<avg us>/<max us>
+//     ppm=<drift>/<rate> headset ..."
+// (lat: chunk arrival -> DAC; drift: MCU1 capture clock against the DAC,
+// rate: ASRC read rate incl. the depth correction; see ncomm_playout.hpp)
+static void log_playout_1s() {
+  static uint32_t last_ms = 0;
+  const uint32_t now = HAL_GetTick();
+  if ((now - last_ms) < 1000) return;
+  last_ms = now;
+
+  char line[256];
+  char* p = line;
+  memcpy(p, "play n=", 7); p += 7; p = u32_to_dec(p, g_playout.periods());
+  p = playout_to_text(p, "radio", g_playout.out(PlayoutH7::RADIO));
+  p = playout_to_text(p, "headset", g_playout.out(PlayoutH7::HEADSET));
+  memcpy(p, "\r\n", 2); p += 2;
+  *p = 0;
   uart4_write_str(line);
 }
 
@@ -104,11 +427,27 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
   if (huart == &huart3)
   {
-    // One byte received from MCU1 link -> consume it.
+    // One byte received from MCU1 link -> parse; complete frames are queued for poll().
     g_mcu2.on_rx_byte(g_mcu2.last_rx_byte());
   }
 }
 
+// I2S2 playout: refill the DMA half just sent
+void HAL_I2S_TxHalfCpltCallback(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == g_playout.i2s()) g_playout.on_half(0);
+}
+
+void HAL_I2S_TxCpltCallback(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == g_playout.i2s()) g_playout.on_half(1);
+}
+
+extern "C" void ncomm_playout_dma_irq(void)
+{
+  g_playout.dma_irq();
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -122,15 +461,28 @@ int main(void)
 
   MX_GPIO_Init();
   MX_DMA_Init();
+  MX_I2S2_Init();         // DAC out, started by g_playout
   MX_USART3_UART_Init();  // MCU1 link @1M
   MX_UART4_Init();        // UI/log @500k
 
   /* USER CODE BEGIN 2 */
+  ncomm_cycles_init(); // DWT cycle counter: SR timing, profiler
 
+#if defined(NCOMM_PROFILE)
+  ncomm_prof_init();
+#endif
   g_mcu2.init(&huart3, &huart4);
 
   uart4_write_str("\r\nMCU2 MVP0: init ok\r\n");
-  uart4_write_str("Log format: t=.. rxB=.. ok=.. crcBad=.. tx=.. pong=.. vad=.. aRx=.. aTx=.. ackM=.. ackS=.. ackV=.. err=..\r\n");
+  log_ram_budget(g_mcu2);
+  g_beep.init();
+  if (g_playout.init(&hi2s2, &g_beep)) g_mcu2.set_playout(&g_playout);
+  else uart4_write_str("playout: I2S2 DMA start failed\r\n");
+  kws_init();
+  mel_init(g_mcu2);
+  voiceid_init();
+  sr_init();
+  uart4_write_str("Log format: t=.. rxB=.. ok=.. crcBad=.. tx=.. pong=.. vad=.. aRx=.. aTx=.. ackM=.. ackS=.. ackV=.. err=.. qHw=.. qDrop=.. poolEx=.. poolMax=..\r\n");
 
   // Optional: choose stream (only if MCU1 supports CMD_SET_MODE/CMD_SET_STREAMS)
   // g_mcu2.set_stream(ncomm::StreamSelect::STREAM_MIC_RAW);
@@ -139,7 +491,15 @@ int main(void)
 
   while (1)
   {
+    g_mcu2.poll();
+    feed_mel(g_mcu2);
+    feed_kws(g_mcu2);
+    sr_sync_store();
     log_mcu2_stats_1s(g_mcu2);
+    log_playout_1s();
+#if defined(NCOMM_PROFILE)
+    log_profile_1s(g_mcu2);
+#endif
     send_ping_every_2s(g_mcu2);
   }
 }
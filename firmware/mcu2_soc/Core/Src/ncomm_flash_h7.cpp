@@ -0,0 +1,56 @@
+#include "ncomm_flash_h7.hpp"
+
+#include <cstring>
+#include "main.h"
+
+// Linker script (ENROLL region)
+extern "C" uint8_t _enroll_start[];
+
+namespace {
+
+constexpr uint32_t kFirstSector = FLASH_SECTOR_6; // bank 2 numbering
+
+// Reads go through the D-cache when it is enabled: drop stale lines after
+// the flash content changed under them.
+void invalidate(const uint8_t* p, uint32_t len) {
+#if defined(SCB_CCR_DC_Msk)
+  if (SCB->CCR & SCB_CCR_DC_Msk) SCB_InvalidateDCache_by_Addr((void*)p, (int32_t)len);
+#else
+  (void)p;
+  (void)len;
+#endif
+}
+
+} // namespace
+
+const uint8_t* FlashH7::base(uint8_t sector) const {
+  return _enroll_start + (uint32_t)(sector & 1u) * SECTOR_SIZE;
+}
+
+bool FlashH7::erase(uint8_t sector) {
+  FLASH_EraseInitTypeDef e{};
+  e.TypeErase = FLASH_TYPEERASE_SECTORS;
+  e.Banks = FLASH_BANK_2;
+  e.Sector = kFirstSector + (sector & 1u);
+  e.NbSectors = 1;
+  e.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+  uint32_t bad = 0;
+  HAL_FLASH_Unlock();
+  const bool ok = HAL_FLASHEx_Erase(&e, &bad) == HAL_OK;
+  HAL_FLASH_Lock();
+  invalidate(base(sector), SECTOR_SIZE);
+  return ok;
+}
+
+bool FlashH7::program(uint8_t sector, uint32_t offset, const uint8_t* word) {
+  if (offset % ncomm::STORE_WORD || offset + ncomm::STORE_WORD > SECTOR_SIZE) return false;
+  // HAL reads the source as 32-bit words
+  uint32_t buf[ncomm::STORE_WORD / 4];
+  std::memcpy(buf, word, sizeof(buf));
+  const uint8_t* dst = base(sector) + offset;
+  HAL_FLASH_Unlock();
+  const bool ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_FLASHWORD, (uint32_t)(uintptr_t)dst, (uint32_t)(uintptr_t)buf) == HAL_OK;
+  HAL_FLASH_Lock();
+  invalidate(dst, ncomm::STORE_WORD);
+  return ok;
+}
@@ -1,9 +1,22 @@
 #include "ncomm_mcu2.hpp"
+#include "ncomm_playout_h7.hpp"
 #include <cstring>
 
+#include "ncomm/ncomm_mem.h"
+
 static inline uint16_t le16(const uint8_t* p) { return (uint16_t)p[0] | ((uint16_t)p[1] << 8); }
+static inline uint32_t le32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
 static inline void wr_le16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)(v & 0xFF); p[1] = (uint8_t)(v >> 8); }
 
+static constexpr uint8_t STREAM_IDX_RX = 0;
+static constexpr uint8_t STREAM_IDX_TX = 1;
+
+// Rolling speech buffer storage: plain .bss, i.e. AXI SRAM (RAM_D1). Kept as
+// received int16 (64 KB) instead of 32000 floats (128 KB).
+static int16_t s_speech_pcm[ncomm::SPEECH_RING_SAMPLES];
+
 void NcommMcu2::init(UART_HandleTypeDef* uart_mcu1, UART_HandleTypeDef* uart_ui) {
   uart_mcu1_ = uart_mcu1;
   uart_ui_   = uart_ui;
@@ -14,6 +27,12 @@ void NcommMcu2::init(UART_HandleTypeDef* uart_mcu1, UART_HandleTypeDef* uart_ui)
   payload_pos_ = 0;
   crc_rx_ = 0;
 
+  pool_.init(blocks_, FRAME_POOL_BLOCKS);
+  rx_blk_ = nullptr;
+  speech_.init(s_speech_pcm, ncomm::SPEECH_RING_SAMPLES);
+
+  apply_stream_rates_(NCOMM_RATE_16K, NCOMM_RATE_16K);
+
   // Do not auto-reset stats here (sometimes useful to preserve across soft reset)
   // stats_reset();
 
@@ -31,7 +50,7 @@ void NcommMcu2::tick_1ms() {
   // reserved for watchdog/timeouts later
 }
 
-void NcommMcu2::on_rx_byte(uint8_t b) {
+NCOMM_FAST_CODE void NcommMcu2::on_rx_byte(uint8_t b) {
   stats_.rx_bytes++;
 
   switch (st_) {
@@ -43,6 +62,7 @@ void NcommMcu2::on_rx_byte(uint8_t b) {
       if (b == ncomm::SOF1) {
         st_ = RxState::HEADER;
         hdr_pos_ = 0;
+        crc_calc_ = ncomm::CRC16_INIT;
       } else {
         st_ = RxState::SOF0;
       }
@@ -50,24 +70,32 @@ void NcommMcu2::on_rx_byte(uint8_t b) {
 
     case RxState::HEADER:
       header_[hdr_pos_++] = b;
+      crc_calc_ = ncomm::crc16_ccitt_false_update(crc_calc_, b);
       if (hdr_pos_ >= ncomm::HEADER_SIZE) {
-        msg_type_ = header_[0];
-        msg_id_   = header_[1];
-        payload_len_ = le16(&header_[2]);
+        // [VER][TYPE][FLAGS][SEQ][LEN LE]; FLAGS is not used by MCU1 events
+        msg_type_ = header_[1];
+        msg_id_   = header_[3];
+        payload_len_ = le16(&header_[4]);
 
-        if (payload_len_ > ncomm::MAX_PAYLOAD) {
+        if (header_[0] != ncomm::PROTO_VER || payload_len_ > ncomm::MAX_PAYLOAD) {
           // drop frame
           st_ = RxState::SOF0;
           break;
         }
 
+        // Parse straight into a pool block. The parser keeps its block across
+        // bad frames; with the pool exhausted the frame is read and dropped.
+        if (!rx_blk_) rx_blk_ = pool_.alloc();
+
         payload_pos_ = 0;
         st_ = (payload_len_ == 0) ? RxState::CRC0 : RxState::PAYLOAD;
       }
       break;
 
     case RxState::PAYLOAD:
-      payload_[payload_pos_++] = b;
+      if (rx_blk_) rx_blk_->payload[payload_pos_] = b;
+      payload_pos_++;
+      crc_calc_ = ncomm::crc16_ccitt_false_update(crc_calc_, b);
       if (payload_pos_ >= payload_len_) {
         st_ = RxState::CRC0;
       }
@@ -81,16 +109,19 @@ void NcommMcu2::on_rx_byte(uint8_t b) {
     case RxState::CRC1: {
       crc_rx_ |= (uint16_t)b << 8;
 
-      // validate CRC over header+payload
-      uint8_t tmp[ncomm::HEADER_SIZE + ncomm::MAX_PAYLOAD];
-      memcpy(tmp, header_, ncomm::HEADER_SIZE);
-      if (payload_len_ > 0) memcpy(tmp + ncomm::HEADER_SIZE, payload_, payload_len_);
-
-      const uint16_t crc_calc = ncomm::crc16_ccitt_false(tmp, ncomm::HEADER_SIZE + payload_len_);
-
-      if (crc_calc == crc_rx_) {
-        stats_.rx_frames_ok++;
-        handle_frame_(msg_type_, payload_, payload_len_);
+      // CRC over header+payload was accumulated byte by byte
+      if (crc_calc_ == crc_rx_) {
+        // Publish only; dispatch happens in poll(). The queue is as deep as
+        // the pool, so a push with a block in hand cannot fail.
+        if (rx_blk_) {
+          stats_.rx_frames_ok++;
+          rx_blk_->msg_type = msg_type_;
+          rx_blk_->msg_id = msg_id_;
+          rx_blk_->len = payload_len_;
+          if (rxq_.push(rx_blk_)) rx_blk_ = nullptr;
+        } else {
+          stats_.rx_frames_dropped++;
+        }
       } else {
         stats_.rx_frames_bad_crc++;
       }
@@ -104,18 +135,33 @@ void NcommMcu2::on_rx_byte(uint8_t b) {
   arm_rx_it_();
 }
 
+void NcommMcu2::poll() {
+  ncomm::FrameBlock* b = nullptr;
+  while (rxq_.pop(&b)) {
+    // Adopt the ISR's reference; consumers that keep the frame copy the handle
+    const ncomm::FrameRef f = ncomm::FrameRef::adopt(b);
+    handle_frame_(f);
+  }
+  stats_.rxq_high_water = rxq_.high_water();
+  stats_.rxq_drops = rxq_.drops();
+  stats_.pool_exhausted = pool_.stats().exhausted;
+  stats_.pool_in_use_max = pool_.stats().in_use_max;
+}
+
 bool NcommMcu2::send_frame_(uint8_t msg_type, const uint8_t* payload, uint16_t len) {
   if (!uart_mcu1_) return false;
   if (len > ncomm::MAX_PAYLOAD) return false;
 
-  // Build [SOF0 SOF1][type id lenLE][payload][crcLE]
+  // Build [SOF0 SOF1][ver type flags seq lenLE][payload][crcLE]
   uint8_t buf[2 + ncomm::HEADER_SIZE + ncomm::MAX_PAYLOAD + ncomm::CRC_SIZE];
   size_t pos = 0;
 
   buf[pos++] = ncomm::SOF0;
   buf[pos++] = ncomm::SOF1;
 
+  buf[pos++] = ncomm::PROTO_VER;
   buf[pos++] = msg_type;
+  buf[pos++] = 0; // FLAGS
   buf[pos++] = tx_msg_id_++;
 
   wr_le16(&buf[pos], len);
@@ -126,7 +172,7 @@ bool NcommMcu2::send_frame_(uint8_t msg_type, const uint8_t* payload, uint16_t l
     pos += len;
   }
 
-  // CRC over header+payload (starting at msg_type)
+  // CRC over header+payload (starting at VER)
   const uint16_t crc = ncomm::crc16_ccitt_false(&buf[2], ncomm::HEADER_SIZE + len);
   buf[pos++] = (uint8_t)(crc & 0xFF);
   buf[pos++] = (uint8_t)(crc >> 8);
@@ -153,13 +199,18 @@ void NcommMcu2::send_cmd_set_mode_(ncomm::Mode mode, ncomm::Ptt ptt,
 }
 
 void NcommMcu2::send_cmd_set_streams_(uint8_t stream_rx_enable, uint8_t stream_tx_enable,
-                                     uint8_t mic_to_mcu2_source, uint8_t reserved0) {
-  // Payload(8): stream_rx_enable, stream_tx_enable, mic_to_mcu2_source, reserved0, reserved[4]
+                                     uint8_t vad_evt_enable, uint16_t frame_samples,
+                                     uint8_t rx_rate, uint8_t tx_rate, uint8_t levels_decim) {
+  // Payload(8): stream_rx_enable, stream_tx_enable, vad_evt_enable, frame_samples(2 LE),
+  //             rx_rate, tx_rate, levels_decim
   uint8_t p[8]{};
   p[0] = stream_rx_enable;
   p[1] = stream_tx_enable;
-  p[2] = mic_to_mcu2_source; // 0=MIC_RAW, 1=MIC_VE (per spec table)
-  p[3] = reserved0;
+  p[2] = vad_evt_enable;
+  wr_le16(&p[3], frame_samples); // 16 kHz units, 0 = MCU1 default (256)
+  p[5] = rx_rate; // 0=16k, 1=8k, 2=12k
+  p[6] = tx_rate;
+  p[7] = levels_decim; // EVT_AUDIO_LEVELS every N chunks, 0 = off
 
   send_frame_((uint8_t)ncomm::MsgType::CMD_SET_STREAMS, p, sizeof(p));
 }
@@ -168,24 +219,92 @@ void NcommMcu2::set_stream(ncomm::StreamSelect sel) {
   // MVP policy:
   // - STREAM_MIC_RAW: want TX_AUDIO_OUT frames → enable TX stream, disable RX stream
   // - STREAM_RX_RAW:  want RX_STREAM_OUT frames → enable RX stream, disable TX stream
+  // - STREAM_RX_MIC:  IDLE (MCU1 STANDBY), both streams (RX monitoring + mic for KWS); MCU1
+  //                   drops RX in the ACK if the pair exceeds the link budget
   //
   // VE disabled in MVP: rx_ve_enable=0, tx_ve_enable=0
-  // mic_to_mcu2_source: 0 (MIC_RAW) for MVP
+  // VAD events on, default frame size
+
+  const uint8_t rx_rate = rate_req_[STREAM_IDX_RX];
+  const uint8_t tx_rate = rate_req_[STREAM_IDX_TX];
 
+  tx_to_radio_ = (sel == ncomm::StreamSelect::STREAM_MIC_RAW);
   if (sel == ncomm::StreamSelect::STREAM_MIC_RAW) {
     send_cmd_set_mode_(ncomm::Mode::TX, ncomm::Ptt::ON, 0, 0);
-    send_cmd_set_streams_(0, 1, 0);
+    send_cmd_set_streams_(0, 1, 1, 0, rx_rate, tx_rate, levels_decim_req_);
+  } else if (sel == ncomm::StreamSelect::STREAM_RX_MIC) {
+    send_cmd_set_mode_(ncomm::Mode::IDLE, ncomm::Ptt::OFF, 0, 0);
+    send_cmd_set_streams_(1, 1, 1, 0, rx_rate, tx_rate, levels_decim_req_);
   } else {
     send_cmd_set_mode_(ncomm::Mode::RX, ncomm::Ptt::OFF, 0, 0);
-    send_cmd_set_streams_(1, 0, 0);
+    send_cmd_set_streams_(1, 0, 1, 0, rx_rate, tx_rate, levels_decim_req_);
+  }
+}
+
+void NcommMcu2::set_stream_rates(uint8_t rx_rate, uint8_t tx_rate) {
+  rate_req_[STREAM_IDX_RX] = rx_rate;
+  rate_req_[STREAM_IDX_TX] = tx_rate;
+}
+
+void NcommMcu2::apply_stream_rates_(uint8_t rx_rate, uint8_t tx_rate) {
+  const uint8_t rates[2] = {rx_rate, tx_rate};
+  for (uint8_t i = 0; i < 2; i++) {
+    if (rates[i] != rate_applied_[i] || interp_[i].L == 0) {
+      ncomm_resampler_init_interp(&interp_[i], rates[i]);
+      rate_applied_[i] = rates[i];
+    }
   }
 }
 
-void NcommMcu2::handle_frame_(uint8_t msg_type, const uint8_t* payload, uint16_t len) {
-  (void)payload;
-  (void)len;
+void NcommMcu2::on_audio_frame_(uint8_t stream_idx, const ncomm::FrameRef& f) {
+  const uint8_t* payload = f.data();
+  const uint16_t len = f.size();
+  if (len < ncomm::AUDIO_HDR_SIZE) return;
 
-  switch ((ncomm::MsgType)msg_type) {
+  const uint16_t samples = le16(&payload[2]);
+  if (len < ncomm::AUDIO_HDR_SIZE + 2u * samples ||
+      samples > ncomm_rate_chunk_samples(rate_applied_[stream_idx])) {
+    stats_.audio_bad_len++;
+    return;
+  }
+
+  // PCM is LE int16 at an even offset; pool payloads are 4-byte aligned
+  const int16_t* pcm = reinterpret_cast<const int16_t*>(payload + ncomm::AUDIO_HDR_SIZE);
+
+  last_audio_[stream_idx] = f;
+  if (stream_idx == STREAM_IDX_RX && rx_source_missing_) stats_.audio_rx_no_source++;
+  if (stream_idx == STREAM_IDX_TX && rate_applied_[stream_idx] == NCOMM_RATE_16K) {
+    kws_bricks_.push(f);
+    speech_.write(pcm, samples);
+  }
+
+  {
+    NCOMM_PROF_SCOPE(NCOMM_PZ_RESAMPLE);
+    pcm16_len_[stream_idx] = ncomm_resampler_process(&interp_[stream_idx], pcm, samples,
+                                                     pcm16_[stream_idx], 256);
+  }
+  if (playout_ && (stream_idx == STREAM_IDX_RX || tx_to_radio_)) {
+    // Drift fit source position: MCU1 numbers each stream's frames from its
+    // own counter (one frame per 16 ms capture chunk of that stream, RX and
+    // TX may share a chunk), so frame_index counts 16 kHz chunks of this
+    // output; it freezes while the stream is off
+    const uint32_t src = le32(&payload[4]) * 256u;
+    playout_->write(stream_idx == STREAM_IDX_TX ? PlayoutH7::RADIO : PlayoutH7::HEADSET,
+                    pcm16_[stream_idx], pcm16_len_[stream_idx], src);
+  }
+}
+
+const int16_t* NcommMcu2::audio_16k(uint8_t stream_idx, uint16_t* samples) const {
+  if (stream_idx > STREAM_IDX_TX || pcm16_len_[stream_idx] == 0) return nullptr;
+  if (samples) *samples = pcm16_len_[stream_idx];
+  return pcm16_[stream_idx];
+}
+
+void NcommMcu2::handle_frame_(const ncomm::FrameRef& f) {
+  NCOMM_PROF_SCOPE(NCOMM_PZ_PARSER);
+  const uint8_t* payload = f.data();
+  const uint16_t len = f.size();
+  switch ((ncomm::MsgType)f->msg_type) {
 
     case ncomm::MsgType::EVT_PONG:
       stats_.pong++;
@@ -194,15 +313,18 @@ void NcommMcu2::handle_frame_(uint8_t msg_type, const uint8_t* payload, uint16_t
     case ncomm::MsgType::EVT_VAD:
       // Payload(8): vad_flag(1), vad_conf(1), hangover_ms(2), chunk_index(4)
       stats_.vad++;
+      if (len >= 1) vad_on_ = payload[0] != 0;
       break;
 
     case ncomm::MsgType::EVT_RX_AUDIO_FRAME:
-      // Payload: stream_id(1), reserved(1), frame_len_u16(2), PCM...
+      // Payload: stream_id(1), channels(1), samples(2), frame_index(4), PCM...
       stats_.audio_rx++;
+      on_audio_frame_(STREAM_IDX_RX, f);
       break;
 
     case ncomm::MsgType::EVT_TX_AUDIO_FRAME:
       stats_.audio_tx++;
+      on_audio_frame_(STREAM_IDX_TX, f);
       break;
 
     case ncomm::MsgType::EVT_MODE_ACK:
@@ -210,7 +332,11 @@ void NcommMcu2::handle_frame_(uint8_t msg_type, const uint8_t* payload, uint16_t
       break;
 
     case ncomm::MsgType::EVT_STREAMS_ACK:
+      // Payload(8) mirrors CMD_SET_STREAMS with applied values; [5]/[6] = rates,
+      // [8] source_flags (optional): bit0 = In2 not captured
       stats_.ack_streams++;
+      if (len >= 8) apply_stream_rates_(payload[5], payload[6]);
+      rx_source_missing_ = (len >= 9) && (payload[8] & 0x01u);
       break;
 
     case ncomm::MsgType::EVT_VAD_CFG_ACK:
@@ -221,6 +347,44 @@ void NcommMcu2::handle_frame_(uint8_t msg_type, const uint8_t* payload, uint16_t
       stats_.evt_error++;
       break;
 
+    case ncomm::MsgType::EVT_VAD_MAP:
+      stats_.vad_map++;
+      if (len >= ncomm::VAD_MAP_SIZE) {
+        vad_map_.chunk_index  = le32(&payload[0]);
+        vad_map_.vad_map      = (uint64_t)le32(&payload[4]) | ((uint64_t)le32(&payload[8]) << 32);
+        vad_map_.state_map    = (uint64_t)le32(&payload[12]) | ((uint64_t)le32(&payload[16]) << 32);
+        vad_map_.preroll_fill = payload[20];
+        vad_map_.preroll_cap  = payload[21];
+        vad_map_.start_age    = payload[22];
+        vad_map_.stop_age     = payload[23];
+        vad_map_.true_run     = payload[24];
+        vad_map_.false_run    = payload[25];
+        vad_map_.flags        = payload[26];
+        vad_on_ = (vad_map_.flags & 0x01u) != 0;
+      }
+      break;
+
+    case ncomm::MsgType::EVT_AUDIO_LEVELS:
+      stats_.levels++;
+      if (len >= ncomm::AUDIO_LEVELS_SIZE) {
+        levels_.chunk_index   = le32(&payload[0]);
+        levels_.window_chunks = payload[4];
+        levels_.flags         = payload[5];
+        rx_source_missing_    = (levels_.flags & 0x02u) != 0;
+        for (uint8_t k = 0; k < ncomm::LEVEL_PORTS; k++) {
+          levels_.peak[k] = le16(&payload[8 + 4 * k]);
+          levels_.rms[k]  = le16(&payload[10 + 4 * k]);
+        }
+      }
+      break;
+
+    case ncomm::MsgType::EVT_PROFILE:
+      stats_.profile++;
+      if (len >= NCOMM_PROF_HDR_SIZE && len <= NCOMM_PROF_MAX_PAYLOAD) {
+        mcu1_prof_ = f;
+      }
+      break;
+
     default:
       break;
   }
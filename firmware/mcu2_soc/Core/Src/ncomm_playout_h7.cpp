@@ -0,0 +1,96 @@
+#include "ncomm_playout_h7.hpp"
+
+#include <cstring>
+
+#include "ncomm/ncomm_mem.h"
+#include "ncomm/ncomm_profile.h"
+
+static constexpr uint32_t DMA_WORDS = 2u * PlayoutH7::PERIOD * 2u;
+
+// DMA: [half][frame][L,R] 32-bit slots
+static uint32_t s_dma[DMA_WORDS] NCOMM_DMA_BUF;
+
+static void clean_dcache(const void* p, uint32_t len) {
+#if defined(SCB_CCR_DC_Msk)
+  if (SCB->CCR & SCB_CCR_DC_Msk) SCB_CleanDCache_by_Addr((uint32_t*)(uintptr_t)p, (int32_t)len);
+#else
+  (void)p;
+  (void)len;
+#endif
+}
+
+bool PlayoutH7::init(I2S_HandleTypeDef* hi2s, ncomm::BeepMixer* beep) {
+  if (started_) return true;
+  if (!hi2s) return false;
+  hi2s_ = hi2s;
+  beep_ = beep;
+  for (uint8_t c = 0; c < OUT_COUNT; c++) jb_[c].init();
+  halves_ = 0;
+
+  std::memset(s_dma, 0, sizeof(s_dma));
+  clean_dcache(s_dma, sizeof(s_dma));
+
+  // SPI2_TX on DMA1 Stream1, circular, 32-bit both sides (clock: MX_DMA_Init)
+  hdma_tx_.Instance = DMA1_Stream1;
+  hdma_tx_.Init.Request = DMA_REQUEST_SPI2_TX;
+  hdma_tx_.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_tx_.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_tx_.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_tx_.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma_tx_.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  hdma_tx_.Init.Mode = DMA_CIRCULAR;
+  hdma_tx_.Init.Priority = DMA_PRIORITY_HIGH;
+  hdma_tx_.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_DMA_Init(&hdma_tx_) != HAL_OK) return false;
+  __HAL_LINKDMA(hi2s, hdmatx, hdma_tx_);
+
+  HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+
+  // Size is in 32-bit data items for I2S_DATAFORMAT_32B
+  if (HAL_I2S_Transmit_DMA(hi2s, (uint16_t*)s_dma, (uint16_t)DMA_WORDS) != HAL_OK) return false;
+
+  started_ = true;
+  return true;
+}
+
+void PlayoutH7::write(Out ch, const int16_t* pcm, uint16_t n, uint32_t src) {
+  if (ch >= OUT_COUNT || !pcm || !started_) return;
+  jb_[ch].push(pcm, n, now(), src);
+}
+
+uint32_t PlayoutH7::now() const {
+  if (!started_) return 0;
+  uint32_t h, ndtr;
+  do {
+    h = halves_;
+    ndtr = __HAL_DMA_GET_COUNTER(&hdma_tx_);
+  } while (h != halves_);
+  const uint32_t frame = ((DMA_WORDS - ndtr) / 2u) % (2u * PERIOD);
+  // The DMA may already be in the next half with its callback still pending
+  const uint32_t base = (frame / PERIOD) == (h & 1u) ? h : h + 1u;
+  return base * PERIOD + frame % PERIOD;
+}
+
+// ISR: the DMA just finished `half` and is sending the other one, so the
+// half refilled here starts one period after the current half.
+NCOMM_FAST_CODE void PlayoutH7::on_half(uint8_t half) {
+  NCOMM_PROF_SCOPE(NCOMM_PZ_PLAYOUT);
+  const uint32_t h = halves_ + 1u;
+  halves_ = h;
+  const uint32_t pos = (h + 1u) * PERIOD;
+
+  int16_t radio[PERIOD];
+  int16_t headset[PERIOD];
+  jb_[RADIO].pull(radio, PERIOD, pos);
+  jb_[HEADSET].pull(headset, PERIOD, pos);
+  if (beep_) beep_->render(headset, PERIOD, pos);
+
+  uint32_t* dst = &s_dma[(half & 1u) * PERIOD * 2u];
+  ncomm::playout_pack_i2s32(radio, headset, dst, PERIOD);
+  clean_dcache(dst, PERIOD * 2u * sizeof(uint32_t));
+}
+
+void PlayoutH7::dma_irq() {
+  HAL_DMA_IRQHandler(&hdma_tx_);
+}
@@ -46,6 +46,7 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
+void ncomm_playout_dma_irq(void); // main.cpp (PlayoutH7)
 
 /* USER CODE END PFP */
 
@@ -58,6 +59,7 @@
 extern DFSDM_Filter_HandleTypeDef hdfsdm1_filter0;
 extern SPI_HandleTypeDef hspi3;
 /* USER CODE BEGIN EV */
+extern UART_HandleTypeDef huart3;
 
 /* USER CODE END EV */
 
@@ -243,4 +245,20 @@ void DFSDM1_FLT0_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA1 stream1 global interrupt (SPI2_TX / I2S2 playout).
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  ncomm_playout_dma_irq();
+}
+
+/**
+  * @brief This function handles USART3 global interrupt (MCU1 link, byte RX).
+  */
+void USART3_IRQHandler(void)
+{
+  HAL_UART_IRQHandler(&huart3);
+}
+
 /* USER CODE END 1 */
@@ -189,7 +189,10 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
   /* USER CODE BEGIN USART3_MspInit 1 */
-
+    // MCU1 link RX is byte-by-byte (HAL_UART_Receive_IT): priority 0, above
+    // the I2S playout DMA (1) so a DMA half never delays the next byte.
+    HAL_NVIC_SetPriority(USART3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(USART3_IRQn);
   /* USER CODE END USART3_MspInit 1 */
   }
 }
@@ -230,7 +233,7 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
     HAL_GPIO_DeInit(GPIOB, GPIO_PIN_10|GPIO_PIN_11);
 
   /* USER CODE BEGIN USART3_MspDeInit 1 */
-
+    HAL_NVIC_DisableIRQ(USART3_IRQn);
   /* USER CODE END USART3_MspDeInit 1 */
   }
 }